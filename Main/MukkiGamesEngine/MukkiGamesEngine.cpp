@@ -3,6 +3,9 @@
 
 #include "MukkiGamesEngine.h"
 #include "Renderer/VulkanRenderer.h"
+#include "vulkan/Resources/SceneBVHBenchmark.h"
+#include "vulkan/utils/ImageCompare.h"
+#include <cstdio>
 
 
 int main(int argc, char* argv[])
@@ -22,17 +25,73 @@ int main(int argc, char* argv[])
 			config.windowHeight = std::stoi(argv[++i]);
 		} else if (arg == "--title" && i + 1 < argc) {
 			config.windowTitle = argv[++i];
+		} else if (arg == "--frames-in-flight" && i + 1 < argc) {
+			config.framesInFlight = std::stoi(argv[++i]);
+		} else if (arg == "--present-mode" && i + 1 < argc) {
+			config.presentMode = argv[++i];
+		} else if (arg == "--fps-limit" && i + 1 < argc) {
+			config.targetFps = std::stof(argv[++i]);
+		} else if (arg == "--jit-input") {
+			config.justInTimeInput = true;
+		} else if (arg == "--no-async-compute") {
+			config.asyncCompute = false;
+		} else if (arg == "--render-mode" && i + 1 < argc) {
+			config.renderMode = argv[++i];
+		} else if (arg == "--headless") {
+			config.headless = true;
+		} else if (arg == "--frames" && i + 1 < argc) {
+			config.maxFrames = std::stoi(argv[++i]);
+		} else if (arg == "--readback" && i + 1 < argc) {
+			config.readbackPath = argv[++i];
+		} else if (arg == "--golden" && i + 1 < argc) {
+			config.goldenPath = argv[++i];
+		} else if (arg == "--golden-tolerance" && i + 1 < argc) {
+			config.goldenTolerance = std::stoi(argv[++i]);
+		} else if (arg == "--golden-max-mismatch" && i + 1 < argc) {
+			config.goldenMaxMismatchPercent = std::stof(argv[++i]);
+		} else if (arg == "--benchmark" && i + 1 < argc) {
+			config.benchmarkPath = argv[++i];
+		} else if (arg == "--pipeline-cache" && i + 1 < argc) {
+			config.pipelineCachePath = argv[++i];
+		} else if (arg == "--no-pipeline-cache") {
+			config.pipelineCachePath.clear();
+		} else if (arg == "--no-prewarm-modes") {
+			config.prewarmModes = false;
+		} else if (arg == "--mode-idle-release" && i + 1 < argc) {
+			config.modeIdleReleaseSeconds = std::stof(argv[++i]);
+		} else if (arg == "--bvh-benchmark") {
+			// CPU-only; runs without creating a window or device
+			std::string outputPath = (i + 1 < argc && argv[i + 1][0] != '-') ? argv[++i] : "bvh_benchmark.json";
+			return runSceneBVHBenchmark(outputPath) ? 0 : 1;
 		}
 	}
 
+	if (!config.goldenPath.empty()) {
+		if (config.readbackPath.empty()) {
+			config.readbackPath = "readback.ppm";
+		}
+		// A run that never reads back (not headless, crashed) must not pass on an older file
+		std::remove(config.readbackPath.c_str());
+	}
+
 	if (backend == "vulkan") {
 		VulkanRenderer renderer;
 		renderer.init(config);
 		renderer.run();
 		renderer.shutdown();
+		if (!config.goldenPath.empty()) {
+			return compareToGolden(config.readbackPath, config.goldenPath, config.goldenTolerance,
+				config.goldenMaxMismatchPercent) ? 0 : 1;
+		}
 	} else {
 		std::cout << "Unknown backend: " << backend << std::endl;
-		std::cout << "Usage: ./exe --backend vulkan [--scene <path>] [--width <w>] [--height <h>] [--title <title>]" << std::endl;
+		std::cout << "Usage: ./exe --backend vulkan [--scene <path>] [--width <w>] [--height <h>] [--title <title>] [--frames-in-flight <1-3>]"
+			" [--present-mode fifo|mailbox|immediate|fifo_relaxed] [--fps-limit <fps>] [--jit-input]"
+			" [--no-async-compute] [--render-mode graphics|compute|raytracing] [--headless] [--frames <n>]"
+			" [--readback <file.ppm>] [--golden <file.ppm>] [--golden-tolerance <0-255>] [--golden-max-mismatch <percent>]"
+			" [--benchmark <script.json>]"
+			" [--pipeline-cache <file> | --no-pipeline-cache] [--no-prewarm-modes] [--mode-idle-release <seconds>]"
+			" [--bvh-benchmark [file.json]]" << std::endl;
 	}
 
 	return 0;
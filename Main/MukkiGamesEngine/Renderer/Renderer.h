@@ -18,6 +18,40 @@ struct RenderConfig {
     int windowHeight=600;
     std::string windowTitle="Mukki Games Engine";
     std::string scenePath;
+    // 1-3; more overlaps CPU and GPU work at the cost of input latency
+    int framesInFlight = 2;
+    // fifo, mailbox, immediate or fifo_relaxed; falls back to fifo when unsupported
+    std::string presentMode = "mailbox";
+    // 0 = unlimited
+    float targetFps = 0.0f;
+    bool justInTimeInput = false;
+    // Run compute dispatches on a dedicated compute queue when the GPU has one
+    bool asyncCompute = true;
+    // graphics, compute or raytracing
+    std::string renderMode = "graphics";
+    // No window or surface: renders windowWidgth x windowHeight offscreen images and never presents
+    bool headless = false;
+    // Exit after this many frames; 0 = until the window closes (headless runs default to 100)
+    int maxFrames = 0;
+    // Headless only: the last frame is written here as a binary PPM
+    std::string readbackPath;
+    // Headless only: the readback is compared against this PPM after the run, and the process
+    // exits with 1 when they differ (see ImageCompare.h); readbackPath defaults to readback.ppm
+    std::string goldenPath;
+    // Largest per-channel difference a pixel may have and still match
+    int goldenTolerance = 2;
+    // Share of the pixels allowed to exceed goldenTolerance
+    float goldenMaxMismatchPercent = 0.1f;
+    // Scripted benchmark (see Benchmark.h); its scene, render mode and frame count win
+    std::string benchmarkPath;
+    // Pipeline cache persisted between runs; empty keeps it in memory only
+    std::string pipelineCachePath = "pipeline_cache.bin";
+    // Ray tracing and compute are set up on first use; with this their pipelines are compiled
+    // in the background once the first frame is out, so the first switch does not stall on them
+    bool prewarmModes = true;
+    // Ray tracing scene data (BLAS/TLAS, geometry buffers) is released after the mode has been
+    // unused this long; 0 keeps it until shutdown
+    float modeIdleReleaseSeconds = 30.0f;
 };
 
 
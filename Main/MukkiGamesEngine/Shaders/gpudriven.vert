@@ -0,0 +1,59 @@
+#version 450
+
+// shader.vert for GPU-driven draws: the model and normal matrices come from the instance's
+// transform slot instead of the UBO, which is shared by every instance of the group
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec2 inTexCoord;
+layout(location = 3) in vec3 inNormal;
+layout(set = 0, binding = 0) uniform UniformBufferObject {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+    mat4 normalMatrix;
+    mat4 lightSpaceMatrix;
+    vec4 viewPos;
+} ubo;
+
+struct Instance {
+    vec4 center;
+    vec4 extent;
+    uint transformIndex;
+    uint groupIndex;
+    uint commandBase;
+    uint firstIndex;
+    uint indexCount;
+    int vertexOffset;
+    uint pad0;
+    uint pad1;
+};
+
+struct Transform {
+    mat4 model;
+    mat4 normalMatrix;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer Instances { Instance instances[]; };
+layout(std430, set = 1, binding = 1) readonly buffer Transforms { Transform transforms[]; };
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) out vec3 fragNormal;
+layout(location = 3) out vec3 fragWorldPos;
+layout(location = 4) out vec4 fragLightSpacePos;
+void main() {
+    // The cull shader stores the instance index as the draw's firstInstance
+    Transform transform = transforms[instances[gl_InstanceIndex].transformIndex];
+
+    vec4 worldPos = transform.model * vec4(inPosition, 1.0);
+    fragWorldPos = worldPos.xyz;
+    fragLightSpacePos = ubo.lightSpaceMatrix * worldPos;
+
+    gl_Position = ubo.proj * ubo.view * worldPos;
+
+    fragColor = inColor;
+    fragTexCoord = inTexCoord;
+
+    fragNormal = mat3(transform.normalMatrix) * inNormal;
+}
@@ -1,7 +1,6 @@
 #include "CommandBufferManager.h"
 #include "uiManager/uiManager.h"
 #include "Resources/ObjectLoader.h"
-#include "Resources/SkyBox.h"
 #include <stdexcept>
 #include <array>
 #include <vector>
@@ -67,8 +66,6 @@ void CommandBufferManager::recordCommandBuffer(
 	VkPipelineLayout pipelineLayout,
 	VkBuffer vertexBuffer,
 	VkBuffer indexBuffer,
- VkImage swapChainImage,
- VkImageLayout swapChainOldLayout,
 	const std::vector<VkDescriptorSet>& descriptorSets,
 	uint32_t currentFrame,
 	uint32_t indexCount,
@@ -85,40 +82,8 @@ void CommandBufferManager::recordCommandBuffer(
 		firstCall = false;
 	}
 
-	VkCommandBufferBeginInfo beginInfo{};
-	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-
-	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
-		throw std::runtime_error("failed to begin recording command buffer!");
-	}
-
-	VkImageMemoryBarrier swapBarrier{};
-	swapBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    swapBarrier.oldLayout = swapChainOldLayout;
-	swapBarrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-	swapBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	swapBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	swapBarrier.image = swapChainImage;
-	swapBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	swapBarrier.subresourceRange.baseMipLevel = 0;
-	swapBarrier.subresourceRange.levelCount = 1;
-	swapBarrier.subresourceRange.baseArrayLayer = 0;
-	swapBarrier.subresourceRange.layerCount = 1;
-	swapBarrier.srcAccessMask = 0;
-	swapBarrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-	vkCmdPipelineBarrier(
-		commandBuffer,
-		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-		0,
-		0, nullptr,
-		0, nullptr,
-		1, &swapBarrier
-	);
-
- 
-
+	// The frame's command buffer is begun and ended by the caller, and the frame graph has
+	// already moved the swapchain image to COLOR_ATTACHMENT_OPTIMAL
 	VkRenderPassBeginInfo renderPassInfo{};
 	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
 	renderPassInfo.renderPass = renderPass;
@@ -181,49 +146,14 @@ void CommandBufferManager::recordCommandBuffer(
 	vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
 	uiManager.render(commandBuffer);
 	vkCmdEndRenderPass(commandBuffer);
-
-	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
-		throw std::runtime_error("failed to record command buffer!");
-	}
 }
 
 void CommandBufferManager::beginModelRenderPass(
 	VkCommandBuffer commandBuffer,
 	VkRenderPass renderPass,
 	VkFramebuffer framebuffer,
-	VkExtent2D extent,
-	VkPipeline graphicsPipeline,
-	VkPipelineLayout pipelineLayout,
-	SkyBox* skybox,
-	VkImage swapChainImage,
-	VkImageLayout swapChainOldLayout,
-	uint32_t currentFrame)
+	VkExtent2D extent)
 {
-	VkImageMemoryBarrier swapBarrier{};
-	swapBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    swapBarrier.oldLayout = swapChainOldLayout;
-	swapBarrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-	swapBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	swapBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	swapBarrier.image = swapChainImage;
-	swapBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	swapBarrier.subresourceRange.baseMipLevel = 0;
-	swapBarrier.subresourceRange.levelCount = 1;
-	swapBarrier.subresourceRange.baseArrayLayer = 0;
-	swapBarrier.subresourceRange.layerCount = 1;
-	swapBarrier.srcAccessMask = 0;
-	swapBarrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-	vkCmdPipelineBarrier(
-		commandBuffer,
-		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-		0,
-		0, nullptr,
-		0, nullptr,
-		1, &swapBarrier
-	);
-
 	VkRenderPassBeginInfo renderPassInfo{};
 	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
 	renderPassInfo.renderPass = renderPass;
@@ -238,9 +168,13 @@ void CommandBufferManager::beginModelRenderPass(
 	renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 	renderPassInfo.pClearValues = clearValues.data();
 
-	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+	// Skybox, model draws and UI are recorded into secondary command buffers
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+}
 
+void CommandBufferManager::setViewportAndScissor(VkCommandBuffer commandBuffer, VkExtent2D extent)
+{
+	// Dynamic state is not inherited by secondary command buffers, each one sets its own
 	VkViewport viewport{};
 	viewport.x = 0.0f;
 	viewport.y = 0.0f;
@@ -254,34 +188,44 @@ void CommandBufferManager::beginModelRenderPass(
 	scissor.offset = { 0, 0 };
 	scissor.extent = extent;
 	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
-
-	if (skybox) {
-		skybox->s_recordCommandBuffer(commandBuffer, currentFrame);
-	}
 }
 
 void CommandBufferManager::recordModelDrawCommands(
 	VkCommandBuffer commandBuffer,
 	const Model& model,
+	const GpuResourcePool& resources,
 	VkPipelineLayout pipelineLayout,
 	VkPipeline graphicsPipeline,
 	VkPipeline transparentPipeline,
 	VkPipeline additivePipeline,
 	const glm::vec3& cameraPosition,
 	const std::vector<std::vector<VkDescriptorSet>>& materialDescriptorSets,
-	uint32_t currentFrame)
+	uint32_t currentFrame,
+	const uint8_t* primitiveVisibility,
+	bool drawOpaque)
 {
-	VkBuffer vertexBuffers[] = { model.vertexBuffer };
+	auto isVisible = [primitiveVisibility](const Mesh& mesh, size_t primitiveIndex) {
+		return !primitiveVisibility || primitiveVisibility[mesh.primitiveOffset + primitiveIndex] != 0;
+	};
+
+	VkBuffer vertexBuffers[] = { resources.getVkBuffer(model.vertexBuffer) };
+	VkBuffer indexBuffer = resources.getVkBuffer(model.indexBuffer);
+	if (vertexBuffers[0] == VK_NULL_HANDLE || indexBuffer == VK_NULL_HANDLE) {
+		return;
+	}
 	VkDeviceSize offsets[] = { 0 };
 	vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-	vkCmdBindIndexBuffer(commandBuffer, model.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+	vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
 
 	VkPipeline currentPipeline = VK_NULL_HANDLE;
 
 	// First pass: Render all opaque meshes
 	for (const auto& mesh : model.opaqueMeshIndices) {
+		if (!drawOpaque) break;
 		const auto& meshRef = model.meshes[mesh];
-		for (const auto& primitive : meshRef.primitives) {
+		for (size_t p = 0; p < meshRef.primitives.size(); p++) {
+			if (!isVisible(meshRef, p)) continue;
+			const auto& primitive = meshRef.primitives[p];
 			int32_t matIndex = primitive.materialIndex >= 0 ? primitive.materialIndex : 0;
 
 			if (currentPipeline != graphicsPipeline) {
@@ -316,8 +260,9 @@ void CommandBufferManager::recordModelDrawCommands(
 		for (const auto& meshIdx : model.transparentMeshIndices) {
 			const auto& meshRef = model.meshes[meshIdx];
 			bool hasNonEmissivePrimitive = false;
-			for (const auto& primitive : meshRef.primitives) {
-				int32_t matIndex = primitive.materialIndex >= 0 ? primitive.materialIndex : 0;
+			for (size_t p = 0; p < meshRef.primitives.size(); p++) {
+				if (!isVisible(meshRef, p)) continue;
+				int32_t matIndex = meshRef.primitives[p].materialIndex >= 0 ? meshRef.primitives[p].materialIndex : 0;
 				if (matIndex < static_cast<int32_t>(model.materials.size()) &&
 					!model.materials[matIndex].isEmissive) {
 					hasNonEmissivePrimitive = true;
@@ -345,7 +290,9 @@ void CommandBufferManager::recordModelDrawCommands(
 
 		for (const auto& td : transparentDraws) {
 			const auto& meshRef = model.meshes[td.meshIndex];
-			for (const auto& primitive : meshRef.primitives) {
+			for (size_t p = 0; p < meshRef.primitives.size(); p++) {
+				if (!isVisible(meshRef, p)) continue;
+				const auto& primitive = meshRef.primitives[p];
 				int32_t matIndex = primitive.materialIndex >= 0 ? primitive.materialIndex : 0;
 
 				if (matIndex >= static_cast<int32_t>(model.materials.size()) ||
@@ -378,7 +325,9 @@ void CommandBufferManager::recordModelDrawCommands(
 	// Third pass: Render emissive/light flare meshes with additive blending
 	for (const auto& mesh : model.transparentMeshIndices) {
 		const auto& meshRef = model.meshes[mesh];
-		for (const auto& primitive : meshRef.primitives) {
+		for (size_t p = 0; p < meshRef.primitives.size(); p++) {
+			if (!isVisible(meshRef, p)) continue;
+			const auto& primitive = meshRef.primitives[p];
 			int32_t matIndex = primitive.materialIndex >= 0 ? primitive.materialIndex : 0;
 
 			if (matIndex >= static_cast<int32_t>(model.materials.size()) ||
@@ -5,8 +5,8 @@
 #include <glm/glm.hpp>
 #include "Core/VkDevice.h"
 class UIManager;
-class SkyBox;
 struct Model;
+class GpuResourcePool;
 class CommandBufferManager {
 public:
 	CommandBufferManager();
@@ -25,31 +25,33 @@ public:
 		VkRenderPass renderPass, VkFramebuffer framebuffer,
 		VkExtent2D extent, VkPipeline graphicsPipeline,
 		VkPipelineLayout pipelineLayout, VkBuffer vertexBuffer,
-        VkBuffer indexBuffer, VkImage swapChainImage, VkImageLayout swapChainOldLayout, const std::vector<VkDescriptorSet>& descriptorSets,
+        VkBuffer indexBuffer, const std::vector<VkDescriptorSet>& descriptorSets,
 		uint32_t currentFrame, uint32_t indexCount, UIManager& uiManager);
 
+	// Begins the main render pass for secondary command buffer contents
 	void beginModelRenderPass(
 		VkCommandBuffer commandBuffer,
 		VkRenderPass renderPass,
 		VkFramebuffer framebuffer,
-		VkExtent2D extent,
-		VkPipeline graphicsPipeline,
-		VkPipelineLayout pipelineLayout,
-		SkyBox* skybox,
-		VkImage swapChainImage,
-		VkImageLayout swapChainOldLayout,
-		uint32_t currentFrame);
+		VkExtent2D extent);
+
+	void setViewportAndScissor(VkCommandBuffer commandBuffer, VkExtent2D extent);
 
+	// primitiveVisibility holds one byte per primitive (numbered as in Mesh::primitiveOffset);
+	// null draws every primitive. drawOpaque is false when the GPU-driven path draws the opaque meshes.
 	void recordModelDrawCommands(
 		VkCommandBuffer commandBuffer,
 		const Model& model,
+		const GpuResourcePool& resources,
 		VkPipelineLayout pipelineLayout,
 		VkPipeline graphicsPipeline,
 		VkPipeline transparentPipeline,
 		VkPipeline additivePipeline,
 		const glm::vec3& cameraPosition,
 		const std::vector<std::vector<VkDescriptorSet>>& materialDescriptorSets,
-		uint32_t currentFrame);
+		uint32_t currentFrame,
+		const uint8_t* primitiveVisibility = nullptr,
+		bool drawOpaque = true);
 
 	void endModelRenderPass(
 		VkCommandBuffer commandBuffer);
@@ -0,0 +1,226 @@
+#include "Benchmark.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+glm::vec3 readVec3(const nlohmann::json& value)
+{
+	if (!value.is_array() || value.size() != 3) {
+		throw std::runtime_error("benchmark script: expected a [x, y, z] array!");
+	}
+	return glm::vec3(value[0].get<float>(), value[1].get<float>(), value[2].get<float>());
+}
+
+glm::vec3 catmullRom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float t)
+{
+	float t2 = t * t;
+	float t3 = t2 * t;
+	return 0.5f * ((2.0f * p1) + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 +
+		(3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+}
+
+// Nearest-rank percentile of an ascending list
+float percentile(const std::vector<float>& sorted, float fraction)
+{
+	if (sorted.empty()) return 0.0f;
+	size_t rank = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+	return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+nlohmann::json summarize(std::vector<float> values)
+{
+	std::sort(values.begin(), values.end());
+	double sum = 0.0;
+	for (float value : values) sum += value;
+	return {
+		{ "p50", percentile(values, 0.50f) },
+		{ "p95", percentile(values, 0.95f) },
+		{ "p99", percentile(values, 0.99f) },
+		{ "max", values.empty() ? 0.0f : values.back() },
+		{ "mean", values.empty() ? 0.0 : sum / values.size() }
+	};
+}
+
+} // namespace
+
+void Benchmark::load(const std::string& path)
+{
+	std::ifstream file(path);
+	if (!file) {
+		throw std::runtime_error("failed to open benchmark script " + path + "!");
+	}
+
+	nlohmann::json script;
+	try {
+		file >> script;
+
+		scenePath = script.value("scene", std::string());
+		renderMode = script.value("renderMode", std::string());
+		outputPath = script.value("output", outputPath);
+		warmupFrames = script.value("warmupFrames", warmupFrames);
+		measuredFrames = script.value("frames", measuredFrames);
+		timestep = script.value("timestep", timestep);
+		hitchFactor = script.value("hitchFactor", hitchFactor);
+		hitchThresholdMs = script.value("hitchThresholdMs", hitchThresholdMs);
+
+		cameraKeys.clear();
+		for (const auto& entry : script.value("camera", nlohmann::json::array())) {
+			CameraKey key;
+			key.time = entry.at("time").get<double>();
+			key.position = readVec3(entry.at("position"));
+			key.target = readVec3(entry.at("target"));
+			cameraKeys.push_back(key);
+		}
+
+		vehicleKeys.clear();
+		for (const auto& entry : script.value("vehicle", nlohmann::json::array())) {
+			VehicleKey key;
+			key.time = entry.at("time").get<double>();
+			key.input.throttle = entry.value("throttle", 0.0f);
+			key.input.brake = entry.value("brake", 0.0f);
+			key.input.steering = entry.value("steering", 0.0f);
+			vehicleKeys.push_back(key);
+		}
+	}
+	catch (const nlohmann::json::exception& e) {
+		throw std::runtime_error("failed to parse benchmark script " + path + ": " + e.what());
+	}
+
+	if (measuredFrames == 0 || timestep <= 0.0f) {
+		throw std::runtime_error("benchmark script needs frames > 0 and timestep > 0!");
+	}
+
+	auto byTime = [](const auto& a, const auto& b) { return a.time < b.time; };
+	std::stable_sort(cameraKeys.begin(), cameraKeys.end(), byTime);
+	std::stable_sort(vehicleKeys.begin(), vehicleKeys.end(), byTime);
+
+	scriptPath = path;
+	samples.clear();
+	samples.reserve(measuredFrames);
+	peakCpuResidentBytes = 0;
+	peakGpuBytes = 0;
+	active = true;
+
+	std::cout << "Benchmark: " << path << ", " << warmupFrames << " warmup + " << measuredFrames
+		<< " frames at " << timestep * 1000.0f << " ms, " << cameraKeys.size() << " camera keys, "
+		<< vehicleKeys.size() << " vehicle keys" << std::endl;
+}
+
+double Benchmark::getFrameTime(uint32_t frame) const
+{
+	if (frame < warmupFrames) {
+		return 0.0;
+	}
+	return (frame - warmupFrames) * static_cast<double>(timestep);
+}
+
+void Benchmark::sampleCamera(double time, glm::vec3& position, glm::vec3& target) const
+{
+	if (cameraKeys.empty()) {
+		return;
+	}
+	if (time <= cameraKeys.front().time || cameraKeys.size() == 1) {
+		position = cameraKeys.front().position;
+		target = cameraKeys.front().target;
+		return;
+	}
+	if (time >= cameraKeys.back().time) {
+		position = cameraKeys.back().position;
+		target = cameraKeys.back().target;
+		return;
+	}
+
+	// Segment [i, i + 1] holding time; the end keys are repeated as the outer control points
+	size_t i = 0;
+	while (i + 2 < cameraKeys.size() && cameraKeys[i + 1].time <= time) {
+		i++;
+	}
+	const CameraKey& k0 = cameraKeys[i > 0 ? i - 1 : 0];
+	const CameraKey& k1 = cameraKeys[i];
+	const CameraKey& k2 = cameraKeys[i + 1];
+	const CameraKey& k3 = cameraKeys[std::min(i + 2, cameraKeys.size() - 1)];
+
+	double span = k2.time - k1.time;
+	float t = span > 0.0 ? static_cast<float>((time - k1.time) / span) : 1.0f;
+	position = catmullRom(k0.position, k1.position, k2.position, k3.position, t);
+	target = catmullRom(k0.target, k1.target, k2.target, k3.target, t);
+}
+
+SimInput Benchmark::sampleVehicle(double time) const
+{
+	SimInput input;
+	for (const auto& key : vehicleKeys) {
+		if (key.time > time) break;
+		input = key.input;
+	}
+	return input;
+}
+
+void Benchmark::recordFrame(const FrameSample& sample)
+{
+	samples.push_back(sample);
+}
+
+void Benchmark::recordMemory(size_t cpuResidentBytes, uint64_t gpuBytes)
+{
+	peakCpuResidentBytes = std::max(peakCpuResidentBytes, cpuResidentBytes);
+	peakGpuBytes = std::max(peakGpuBytes, gpuBytes);
+}
+
+bool Benchmark::writeReport(const std::string& deviceName) const
+{
+	std::ofstream file(outputPath);
+	if (!file) {
+		std::cout << "Benchmark: failed to open " << outputPath << std::endl;
+		return false;
+	}
+
+	std::vector<float> frameMs, cpuMs, gpuMs;
+	nlohmann::json frames = nlohmann::json::array();
+	for (const auto& sample : samples) {
+		frameMs.push_back(sample.frameMs);
+		cpuMs.push_back(sample.cpuMs);
+		gpuMs.push_back(sample.gpuMs);
+		frames.push_back({ sample.frameMs, sample.cpuMs, sample.gpuMs });
+	}
+
+	// Phases keep their startup order
+	nlohmann::json phases = nlohmann::json::array();
+	for (const auto& [name, ms] : startupPhases) {
+		phases.push_back({ { "name", name }, { "ms", ms } });
+	}
+
+	nlohmann::json frameStats = summarize(frameMs);
+	float threshold = hitchThresholdMs > 0.0f ? hitchThresholdMs : hitchFactor * frameStats["p50"].get<float>();
+	size_t hitches = std::count_if(frameMs.begin(), frameMs.end(), [threshold](float ms) { return ms > threshold; });
+
+	nlohmann::json report = {
+		{ "script", scriptPath },
+		{ "scene", scenePath },
+		{ "renderMode", renderMode },
+		{ "device", deviceName },
+		{ "warmupFrames", warmupFrames },
+		{ "frames", samples.size() },
+		{ "timestep", timestep },
+		{ "startup", { { "ms", startupMs }, { "firstFrameMs", firstFrameMs }, { "pipelineCache", warmCache ? "warm" : "cold" },
+			{ "phases", phases } } },
+		{ "frameMs", frameStats },
+		{ "cpuMs", summarize(cpuMs) },
+		{ "gpuMs", summarize(gpuMs) },
+		{ "hitches", { { "count", hitches }, { "thresholdMs", threshold } } },
+		{ "memory", { { "peakCpuResidentBytes", peakCpuResidentBytes }, { "peakGpuBytes", peakGpuBytes } } },
+		// [frameMs, cpuMs, gpuMs] per measured frame
+		{ "perFrame", frames }
+	};
+	file << report.dump(2);
+
+	std::cout << "Benchmark: " << samples.size() << " frames, p50 " << frameStats["p50"].get<float>()
+		<< " ms, p99 " << frameStats["p99"].get<float>() << " ms, " << hitches << " hitches, wrote "
+		<< outputPath << std::endl;
+	return true;
+}
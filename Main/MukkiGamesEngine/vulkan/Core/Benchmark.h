@@ -0,0 +1,99 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../Physics/SimulationThread.h"
+
+// Scripted benchmark run (--benchmark <script.json>). Every frame advances simulated time by
+// exactly one timestep and the camera and vehicle follow the script instead of the keyboard,
+// so two runs of the same build render the same frames; only the timings differ. Warmup
+// frames render the start of the path and are not measured.
+//
+// {
+//   "scene": "...",                optional, overrides --scene
+//   "renderMode": "graphics",      optional: graphics, compute or raytracing
+//   "warmupFrames": 60,
+//   "frames": 600,                 measured frames
+//   "timestep": 0.0166667,         simulated seconds per frame
+//   "hitchFactor": 2.0,            a hitch is a frame slower than hitchFactor x the median...
+//   "hitchThresholdMs": 0,         ...or than this, when set
+//   "output": "benchmark_results.json",
+//   "camera": [ { "time": 0, "position": [x, y, z], "target": [x, y, z] }, ... ],
+//   "vehicle": [ { "time": 0, "throttle": 500, "brake": 0, "steering": 0 }, ... ]
+// }
+class Benchmark {
+public:
+	struct CameraKey {
+		double time = 0.0;
+		glm::vec3 position = glm::vec3(0.0f);
+		glm::vec3 target = glm::vec3(0.0f, 0.0f, -1.0f);
+	};
+
+	struct VehicleKey {
+		double time = 0.0;
+		SimInput input;
+	};
+
+	struct FrameSample {
+		// Loop iteration wall time, waits included
+		float frameMs = 0.0f;
+		// frameMs without the frame-slot waits
+		float cpuMs = 0.0f;
+		// Latest completed frame on the GPU, so it trails by the frames in flight
+		float gpuMs = 0.0f;
+	};
+
+	// Throws on unreadable or malformed scripts
+	void load(const std::string& path);
+	bool isActive() const { return active; }
+
+	const std::string& getScenePath() const { return scenePath; }
+	const std::string& getRenderMode() const { return renderMode; }
+	uint32_t getTotalFrames() const { return warmupFrames + measuredFrames; }
+	float getTimestep() const { return timestep; }
+
+	// Warmup frames sit at t = 0; measured frames advance one timestep each
+	double getFrameTime(uint32_t frame) const;
+	bool isMeasured(uint32_t frame) const { return frame >= warmupFrames; }
+
+	bool hasCameraPath() const { return !cameraKeys.empty(); }
+	// Catmull-Rom through the keys; holds the end keys outside their range
+	void sampleCamera(double time, glm::vec3& position, glm::vec3& target) const;
+	bool hasVehicleTrack() const { return !vehicleKeys.empty(); }
+	// Each key holds until the next one, like the digital keyboard controls
+	SimInput sampleVehicle(double time) const;
+
+	void recordFrame(const FrameSample& sample);
+	void recordMemory(size_t cpuResidentBytes, uint64_t gpuBytes);
+	// Startup to the first frame, and whether the pipeline cache came from disk
+	void recordStartup(float ms, bool warmPipelineCache) { startupMs = ms; warmCache = warmPipelineCache; }
+	void recordFirstFrame(float ms) { firstFrameMs = ms; }
+	void recordStartupPhase(const std::string& name, float ms) { startupPhases.push_back({ name, ms }); }
+	bool writeReport(const std::string& deviceName) const;
+
+private:
+	bool active = false;
+	std::string scriptPath;
+	std::string scenePath;
+	std::string renderMode;
+	std::string outputPath = "benchmark_results.json";
+	uint32_t warmupFrames = 60;
+	uint32_t measuredFrames = 600;
+	float timestep = 1.0f / 60.0f;
+	float hitchFactor = 2.0f;
+	float hitchThresholdMs = 0.0f;
+
+	std::vector<CameraKey> cameraKeys;
+	std::vector<VehicleKey> vehicleKeys;
+
+	std::vector<FrameSample> samples;
+	size_t peakCpuResidentBytes = 0;
+	float startupMs = 0.0f;
+	float firstFrameMs = 0.0f;
+	bool warmCache = false;
+	std::vector<std::pair<std::string, float>> startupPhases;
+	uint64_t peakGpuBytes = 0;
+};
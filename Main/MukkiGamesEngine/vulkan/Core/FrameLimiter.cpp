@@ -0,0 +1,46 @@
+#include "FrameLimiter.h"
+#include <algorithm>
+#include <thread>
+
+void FrameLimiter::setTargetFps(float fps)
+{
+	if (fps == targetFps) {
+		return;
+	}
+	targetFps = std::max(fps, 0.0f);
+	interval = targetFps > 0.0f
+		? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / targetFps))
+		: Clock::duration::zero();
+	nextFrame = Clock::now() + interval;
+}
+
+void FrameLimiter::wait()
+{
+	waitMs = 0.0f;
+	if (targetFps <= 0.0f) {
+		return;
+	}
+
+	Clock::time_point start = Clock::now();
+	if (start >= nextFrame) {
+		// Missed the deadline: start a new interval instead of bursting frames to catch up
+		nextFrame = start + interval;
+		return;
+	}
+
+	Clock::time_point sleepUntil = nextFrame - spinMargin;
+	if (start < sleepUntil) {
+		std::this_thread::sleep_until(sleepUntil);
+		// Grow the margin straight to any larger overshoot, shrink it slowly otherwise
+		Clock::duration overshoot = Clock::now() - sleepUntil;
+		Clock::duration decayed = spinMargin - spinMargin / 16;
+		spinMargin = std::clamp<Clock::duration>(std::max(overshoot + overshoot / 4, decayed),
+			std::chrono::microseconds(500), std::chrono::milliseconds(20));
+	}
+	while (Clock::now() < nextFrame) {
+		std::this_thread::yield();
+	}
+
+	waitMs = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+	nextFrame += interval;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <chrono>
+
+// Caps the frame rate at a target FPS. OS sleeps overshoot by up to a scheduler tick, so the
+// limiter sleeps until shortly before the deadline and spins the remainder; the margin tracks
+// the overshoot actually observed on this machine.
+class FrameLimiter {
+public:
+	// 0 disables the limiter
+	void setTargetFps(float fps);
+	float getTargetFps() const { return targetFps; }
+
+	// Blocks until one frame interval has passed since the previous deadline
+	void wait();
+
+	// Time spent inside the last wait()
+	float getWaitMs() const { return waitMs; }
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	float targetFps = 0.0f;
+	Clock::duration interval{};
+	Clock::time_point nextFrame{};
+	Clock::duration spinMargin = std::chrono::milliseconds(2);
+	float waitMs = 0.0f;
+};
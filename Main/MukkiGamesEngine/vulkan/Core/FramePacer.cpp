@@ -0,0 +1,219 @@
+#include "FramePacer.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+// Graphics begin/end, then async compute begin/end
+static constexpr uint32_t QUERIES_PER_SLOT = 4;
+
+void FramePacer::init(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex, uint32_t framesInFlight,
+	uint32_t computeQueueFamilyIndex)
+{
+	this->device = device;
+	setFramesInFlight(framesInFlight);
+
+	VkSemaphoreTypeCreateInfo timelineInfo{};
+	timelineInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	timelineInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	timelineInfo.initialValue = 0;
+
+	VkSemaphoreCreateInfo semaphoreInfo{};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphoreInfo.pNext = &timelineInfo;
+
+	if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &timeline) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create frame timeline semaphore!");
+	}
+
+	// GPU timings are optional: skip them on queues that cannot write timestamps
+	uint32_t familyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> families(familyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+
+	VkPhysicalDeviceProperties properties{};
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+	if (queueFamilyIndex < familyCount && families[queueFamilyIndex].timestampValidBits > 0 &&
+		properties.limits.timestampPeriod > 0.0f) {
+		VkQueryPoolCreateInfo queryInfo{};
+		queryInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryInfo.queryCount = MAX_FRAMES_IN_FLIGHT * QUERIES_PER_SLOT;
+		if (vkCreateQueryPool(device, &queryInfo, nullptr, &timestampPool) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create frame timestamp query pool!");
+		}
+		timestampPeriod = properties.limits.timestampPeriod;
+		computeTimestamps = computeQueueFamilyIndex < familyCount &&
+			families[computeQueueFamilyIndex].timestampValidBits > 0;
+	}
+	else {
+		std::cout << "Frame pacer: graphics queue has no timestamp support, GPU busy time disabled" << std::endl;
+	}
+}
+
+void FramePacer::cleanup()
+{
+	if (timestampPool != VK_NULL_HANDLE) {
+		vkDestroyQueryPool(device, timestampPool, nullptr);
+		timestampPool = VK_NULL_HANDLE;
+	}
+	if (timeline != VK_NULL_HANDLE) {
+		vkDestroySemaphore(device, timeline, nullptr);
+		timeline = VK_NULL_HANDLE;
+	}
+	device = VK_NULL_HANDLE;
+}
+
+void FramePacer::setFramesInFlight(uint32_t count)
+{
+	framesInFlight = std::clamp<uint32_t>(count, 1, MAX_FRAMES_IN_FLIGHT);
+}
+
+uint32_t FramePacer::beginFrame()
+{
+	timings.cpuWaitMs = 0.0f;
+	currentSlot = static_cast<uint32_t>(lastSubmitted % framesInFlight);
+
+	// The slot's own last frame must be finished before its resources are reused, and no more
+	// than framesInFlight frames may be queued. After the count shrinks the second condition
+	// is the stricter one, so both are checked.
+	uint64_t waitValue = slotValues[currentSlot];
+	if (lastSubmitted >= framesInFlight) {
+		waitValue = std::max(waitValue, lastSubmitted + 1 - framesInFlight);
+	}
+	waitForValue(waitValue);
+
+	readGpuTimings(currentSlot);
+	updateInputLatency();
+	return currentSlot;
+}
+
+void FramePacer::writeBeginTimestamp(VkCommandBuffer commandBuffer)
+{
+	if (timestampPool == VK_NULL_HANDLE) {
+		return;
+	}
+	vkCmdResetQueryPool(commandBuffer, timestampPool, currentSlot * QUERIES_PER_SLOT, 2);
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampPool, currentSlot * QUERIES_PER_SLOT);
+}
+
+void FramePacer::writeEndTimestamp(VkCommandBuffer commandBuffer)
+{
+	if (timestampPool == VK_NULL_HANDLE) {
+		return;
+	}
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampPool, currentSlot * QUERIES_PER_SLOT + 1);
+	slotHasTimestamps[currentSlot] = true;
+}
+
+void FramePacer::writeComputeBeginTimestamp(VkCommandBuffer commandBuffer)
+{
+	if (!computeTimestamps) {
+		return;
+	}
+	vkCmdResetQueryPool(commandBuffer, timestampPool, currentSlot * QUERIES_PER_SLOT + 2, 2);
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampPool, currentSlot * QUERIES_PER_SLOT + 2);
+}
+
+void FramePacer::writeComputeEndTimestamp(VkCommandBuffer commandBuffer)
+{
+	if (!computeTimestamps) {
+		return;
+	}
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampPool, currentSlot * QUERIES_PER_SLOT + 3);
+	slotHasComputeTimestamps[currentSlot] = true;
+}
+
+void FramePacer::endFrame()
+{
+	slotValues[currentSlot] = ++lastSubmitted;
+}
+
+void FramePacer::markInputSampled(std::chrono::steady_clock::time_point sampledAt)
+{
+	slotInputTimes[currentSlot] = sampledAt;
+	slotHasInput[currentSlot] = true;
+}
+
+void FramePacer::updateInputLatency()
+{
+	uint64_t completed = getCompletedValue();
+	auto now = std::chrono::steady_clock::now();
+	for (uint32_t slot = 0; slot < MAX_FRAMES_IN_FLIGHT; slot++) {
+		if (!slotHasInput[slot] || slotValues[slot] == 0 || slotValues[slot] > completed) {
+			continue;
+		}
+		float latencyMs = std::chrono::duration<float, std::milli>(now - slotInputTimes[slot]).count();
+		timings.inputLatencyMs = timings.inputLatencyMs == 0.0f
+			? latencyMs
+			: timings.inputLatencyMs * 0.9f + latencyMs * 0.1f;
+		slotHasInput[slot] = false;
+	}
+}
+
+uint64_t FramePacer::getCompletedValue() const
+{
+	uint64_t value = 0;
+	vkGetSemaphoreCounterValue(device, timeline, &value);
+	return value;
+}
+
+void FramePacer::waitForValue(uint64_t value)
+{
+	if (value == 0 || isComplete(value)) {
+		return;
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	VkSemaphoreWaitInfo waitInfo{};
+	waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &timeline;
+	waitInfo.pValues = &value;
+	if (vkWaitSemaphores(device, &waitInfo, UINT64_MAX) != VK_SUCCESS) {
+		throw std::runtime_error("failed to wait for frame timeline semaphore!");
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	timings.cpuWaitMs += std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+void FramePacer::readGpuTimings(uint32_t slot)
+{
+	if (timestampPool == VK_NULL_HANDLE || !slotHasTimestamps[slot]) {
+		return;
+	}
+	// The slot's frame is complete at this point, so its results are available without waiting
+	uint64_t stamps[2] = {};
+	if (vkGetQueryPoolResults(device, timestampPool, slot * QUERIES_PER_SLOT, 2, sizeof(stamps), stamps,
+		sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS) {
+		timings.gpuBusyMs = static_cast<float>(stamps[1] - stamps[0]) * timestampPeriod / 1000000.0f;
+
+		// Both queues count on the device timestamp clock, so the previous frame's compute
+		// interval can be intersected with this frame's graphics interval directly
+		uint64_t overlapStart = std::max(stamps[0], lastComputeStart);
+		uint64_t overlapEnd = std::min(stamps[1], lastComputeEnd);
+		timings.asyncOverlapMs = overlapEnd > overlapStart
+			? static_cast<float>(overlapEnd - overlapStart) * timestampPeriod / 1000000.0f
+			: 0.0f;
+	}
+	slotHasTimestamps[slot] = false;
+
+	timings.computeBusyMs = 0.0f;
+	lastComputeStart = 0;
+	lastComputeEnd = 0;
+	if (slotHasComputeTimestamps[slot]) {
+		uint64_t computeStamps[2] = {};
+		if (vkGetQueryPoolResults(device, timestampPool, slot * QUERIES_PER_SLOT + 2, 2, sizeof(computeStamps),
+			computeStamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS) {
+			timings.computeBusyMs = static_cast<float>(computeStamps[1] - computeStamps[0]) * timestampPeriod / 1000000.0f;
+			lastComputeStart = computeStamps[0];
+			lastComputeEnd = computeStamps[1];
+		}
+		slotHasComputeTimestamps[slot] = false;
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <chrono>
+#include <cstdint>
+
+// Paces the CPU against the GPU with a single timeline semaphore (core in Vulkan 1.2).
+// The last submission of every frame signals the next value of one monotonically increasing counter;
+// frame slots, swapchain images, the retire queue and any upload or readback that needs to
+// know "has the GPU finished with this" compare against that counter instead of owning fences.
+class FramePacer {
+public:
+	// Capacity of per-frame resources (uniform buffers, command buffers, descriptor sets)
+	static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 3;
+
+	struct FrameTimings {
+		// Time the CPU spent blocked on the GPU before it could record this frame
+		float cpuWaitMs = 0.0f;
+		// First to last command of the most recently completed frame
+		float gpuBusyMs = 0.0f;
+		// Same for the frame's async compute submission (0 when it had none)
+		float computeBusyMs = 0.0f;
+		// How long the previous frame's async compute ran alongside this frame's graphics work
+		float asyncOverlapMs = 0.0f;
+		// Input sampled to frame complete on the GPU, smoothed. Measured when the CPU observes
+		// completion, so it can overestimate by up to a frame when the CPU is the bottleneck;
+		// scan-out adds up to one refresh interval on top.
+		float inputLatencyMs = 0.0f;
+	};
+
+	// computeQueueFamilyIndex enables timestamps on the async compute queue
+	void init(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex, uint32_t framesInFlight,
+		uint32_t computeQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED);
+	void cleanup();
+
+	// Clamped to [1, MAX_FRAMES_IN_FLIGHT]; takes effect at the next beginFrame
+	void setFramesInFlight(uint32_t count);
+	uint32_t getFramesInFlight() const { return framesInFlight; }
+
+	// Blocks until the next frame slot is free and returns its index
+	uint32_t beginFrame();
+	uint32_t getCurrentSlot() const { return currentSlot; }
+
+	// Bracket the frame's commands so the GPU busy time can be read back once it completes
+	void writeBeginTimestamp(VkCommandBuffer commandBuffer);
+	void writeEndTimestamp(VkCommandBuffer commandBuffer);
+	// The same for the frame's async compute command buffer
+	void writeComputeBeginTimestamp(VkCommandBuffer commandBuffer);
+	void writeComputeEndTimestamp(VkCommandBuffer commandBuffer);
+
+	// Timeline value the current frame's submission must signal on getTimelineSemaphore()
+	uint64_t getFrameSignalValue() const { return lastSubmitted + 1; }
+	// Call once the frame's submission succeeded
+	void endFrame();
+	// Records when the input the current frame renders with was sampled (after beginFrame)
+	void markInputSampled(std::chrono::steady_clock::time_point sampledAt);
+
+	VkSemaphore getTimelineSemaphore() const { return timeline; }
+	uint64_t getLastSubmittedValue() const { return lastSubmitted; }
+	uint64_t getCompletedValue() const;
+	bool isComplete(uint64_t value) const { return value <= getCompletedValue(); }
+	// Blocks until the GPU reaches value; the time spent counts as this frame's CPU wait
+	void waitForValue(uint64_t value);
+
+	const FrameTimings& getTimings() const { return timings; }
+
+private:
+	void readGpuTimings(uint32_t slot);
+	void updateInputLatency();
+
+	VkDevice device = VK_NULL_HANDLE;
+	VkSemaphore timeline = VK_NULL_HANDLE;
+	VkQueryPool timestampPool = VK_NULL_HANDLE;
+	float timestampPeriod = 0.0f;
+	bool computeTimestamps = false;
+	// Raw timestamps of the last completed async compute submission, for the overlap
+	uint64_t lastComputeStart = 0;
+	uint64_t lastComputeEnd = 0;
+
+	uint32_t framesInFlight = 2;
+	uint32_t currentSlot = 0;
+	uint64_t lastSubmitted = 0;
+	// Timeline value of the last submission made from each slot
+	uint64_t slotValues[MAX_FRAMES_IN_FLIGHT] = {};
+	bool slotHasTimestamps[MAX_FRAMES_IN_FLIGHT] = {};
+	bool slotHasComputeTimestamps[MAX_FRAMES_IN_FLIGHT] = {};
+	// When each slot's frame sampled its input; reported once the frame completes
+	std::chrono::steady_clock::time_point slotInputTimes[MAX_FRAMES_IN_FLIGHT] = {};
+	bool slotHasInput[MAX_FRAMES_IN_FLIGHT] = {};
+
+	FrameTimings timings;
+};
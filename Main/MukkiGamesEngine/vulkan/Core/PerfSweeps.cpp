@@ -0,0 +1,161 @@
+#include "PerfSweeps.h"
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+
+void PerfSweeps::startRecordSweep(uint32_t maxThreads, Settings& settings)
+{
+	recordResults.clear();
+	recordFrames = 0;
+	recordTotalMs = 0.0f;
+	recordMaxThreads = std::max(maxThreads, 1u);
+	recordSavedThreads = settings.recordThreads;
+	recordThreads = 1;
+	settings.recordThreads = 1;
+}
+
+void PerfSweeps::startScalingSweep(uint32_t sceneObjects, Settings& settings)
+{
+	scalingResults.clear();
+	scalingFrames = 0;
+	scalingTotalMs = 0.0f;
+	scalingTransformMs = 0.0f;
+	scalingDrawMs = 0.0f;
+	scalingSceneObjects = std::max(sceneObjects, 1u);
+	scalingSaved = settings;
+	scalingStep = 1;
+	applyScalingStep(settings);
+}
+
+void PerfSweeps::recordResize(float recreateMs)
+{
+	resizeCount++;
+	resizeMaxRecreateMs = std::max(resizeMaxRecreateMs, recreateMs);
+	lastResizeTime = std::chrono::steady_clock::now();
+}
+
+void PerfSweeps::endFrame(const FrameStats& stats, Settings& settings)
+{
+	updateRecordSweep(stats, settings);
+	updateScalingSweep(stats, settings);
+	updateResize(stats);
+}
+
+void PerfSweeps::updateRecordSweep(const FrameStats& stats, Settings& settings)
+{
+	if (recordThreads == 0) {
+		return;
+	}
+
+	// Skip the first frames after a thread count change so the workers have warmed up
+	const uint32_t warmupFrames = 10;
+	const uint32_t measuredFrames = 120;
+	if (++recordFrames > warmupFrames) {
+		recordTotalMs += stats.recordMs;
+	}
+	if (recordFrames < warmupFrames + measuredFrames) {
+		return;
+	}
+
+	recordResults.push_back(recordTotalMs / measuredFrames);
+	recordFrames = 0;
+	recordTotalMs = 0.0f;
+
+	if (recordThreads < recordMaxThreads) {
+		settings.recordThreads = static_cast<int>(++recordThreads);
+		return;
+	}
+
+	std::cout << "Draw recording sweep (" << stats.objectDraws << " object draws):" << std::endl;
+	for (size_t i = 0; i < recordResults.size(); i++) {
+		std::cout << "  " << (i + 1) << " threads: " << recordResults[i] << " ms ("
+			<< recordResults[0] / std::max(recordResults[i], 0.0001f) << "x)" << std::endl;
+	}
+	recordThreads = 0;
+	settings.recordThreads = recordSavedThreads;
+}
+
+void PerfSweeps::applyScalingStep(Settings& settings) const
+{
+	// Each object count runs on the CPU path, then the GPU-driven one
+	uint32_t config = scalingStep - 1;
+	uint32_t target = SCALING_OBJECTS[config / 2];
+	settings.drawCopies = static_cast<int>(std::max((target + scalingSceneObjects / 2) / scalingSceneObjects, 1u));
+	settings.gpuDriven = config % 2 == 1;
+}
+
+void PerfSweeps::updateScalingSweep(const FrameStats& stats, Settings& settings)
+{
+	if (scalingStep == 0) {
+		return;
+	}
+
+	// The warmup frames cover the GPU scene rebuild after a copy count change
+	const uint32_t warmupFrames = 10;
+	const uint32_t measuredFrames = 60;
+	if (++scalingFrames > warmupFrames) {
+		scalingTotalMs += stats.cullMs + stats.sceneUpdateMs + stats.drawListMs + stats.recordMs;
+		scalingTransformMs += stats.sceneUpdateMs;
+		scalingDrawMs += stats.recordMs;
+	}
+	if (scalingFrames < warmupFrames + measuredFrames) {
+		return;
+	}
+
+	bool gpuDrivenStep = (scalingStep - 1) % 2 == 1;
+	if (!gpuDrivenStep) {
+		ScalingResult result;
+		result.objects = stats.objectDraws;
+		result.cpuPathMs = scalingTotalMs / measuredFrames;
+		scalingResults.push_back(result);
+	}
+	else {
+		ScalingResult& result = scalingResults.back();
+		result.groups = stats.drawGroups;
+		result.gpuDrivenMs = scalingTotalMs / measuredFrames;
+		result.transformMs = scalingTransformMs / measuredFrames;
+		result.drawMs = scalingDrawMs / measuredFrames;
+	}
+	scalingFrames = 0;
+	scalingTotalMs = 0.0f;
+	scalingTransformMs = 0.0f;
+	scalingDrawMs = 0.0f;
+
+	if (scalingStep < std::size(SCALING_OBJECTS) * 2) {
+		++scalingStep;
+		applyScalingStep(settings);
+		return;
+	}
+
+	// The CPU path's copies reuse their object's uniform buffer and culling result, so its column
+	// only grows with recording; the GPU-driven copies are full objects with their own transforms
+	std::cout << "CPU vs GPU-driven scaling (cull + scene update + record ms per frame):" << std::endl;
+	for (const ScalingResult& result : scalingResults) {
+		std::cout << "  " << result.objects << " objects: CPU " << result.cpuPathMs << " ms, GPU-driven "
+			<< result.gpuDrivenMs << " ms (transforms " << result.transformMs << " ms, "
+			<< result.transformMs * 1000.0f / std::max(result.objects, 1u) << " us/object; "
+			<< result.groups << " indirect draws " << result.drawMs << " ms, "
+			<< result.drawMs * 1000.0f / std::max(result.groups, 1u) << " us/draw)" << std::endl;
+	}
+	scalingStep = 0;
+	settings.drawCopies = scalingSaved.drawCopies;
+	settings.gpuDriven = scalingSaved.gpuDriven;
+}
+
+void PerfSweeps::updateResize(const FrameStats& stats)
+{
+	// A resize drag is a burst of recreations; its worst frame is reported once it settles
+	if (resizeCount == 0) {
+		return;
+	}
+	resizeMaxFrameMs = std::max(resizeMaxFrameMs, stats.frameMs);
+	if (std::chrono::steady_clock::now() - lastResizeTime <= std::chrono::milliseconds(500)) {
+		return;
+	}
+	std::cout << "Resize to " << stats.extent.width << "x" << stats.extent.height << ": " << resizeCount
+		<< " swapchain recreations (max " << resizeMaxRecreateMs << " ms), max frame time "
+		<< resizeMaxFrameMs << " ms" << std::endl;
+	resizeCount = 0;
+	resizeMaxRecreateMs = 0.0f;
+	resizeMaxFrameMs = 0.0f;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Measurement runs started from the debug UI: draw recording time per thread count, CPU vs
+// GPU-driven cost per object count, and the worst frame of a resize drag. The app hands it the
+// timings of every finished frame; a running sweep steps the settings it measures and puts them
+// back when done. Results go to the log and the UI.
+class PerfSweeps {
+public:
+	// What the sweeps read from a finished frame
+	struct FrameStats {
+		// Loop iteration wall time
+		float frameMs = 0.0f;
+		// Main pass recording on the worker threads
+		float recordMs = 0.0f;
+		// CPU culling, frustum and occlusion
+		float cullMs = 0.0f;
+		// GPU-driven scene update: a model matrix and its inverse per object
+		float sceneUpdateMs = 0.0f;
+		float drawListMs = 0.0f;
+		// Loaded objects times synthetic copies
+		uint32_t objectDraws = 0;
+		// Indirect draws of the GPU-driven path, one per object and material
+		uint32_t drawGroups = 0;
+		VkExtent2D extent{};
+	};
+
+	// The settings the sweeps step through. The app passes its current values and renders the
+	// next frame with what it gets back.
+	struct Settings {
+		int recordThreads = 1;
+		int drawCopies = 1;
+		bool gpuDriven = true;
+	};
+
+	// One object count of the scaling sweep
+	struct ScalingResult {
+		uint32_t objects = 0;
+		uint32_t groups = 0;
+		// CPU milliseconds per frame spent culling, updating the GPU scene and recording, per path
+		float cpuPathMs = 0.0f;
+		float gpuDrivenMs = 0.0f;
+		// The GPU-driven path's share of that: transform upload (per object) and recording (per
+		// indirect draw)
+		float transformMs = 0.0f;
+		float drawMs = 0.0f;
+	};
+
+	// Object counts of the scaling sweep, reached with synthetic copies of the scene
+	static constexpr uint32_t SCALING_OBJECTS[] = { 10, 100, 1000, 10000 };
+
+	void startRecordSweep(uint32_t maxThreads, Settings& settings);
+	void startScalingSweep(uint32_t sceneObjects, Settings& settings);
+	bool isRecordSweepRunning() const { return recordThreads != 0; }
+	bool isScalingSweepRunning() const { return scalingStep != 0; }
+	const std::vector<float>& getRecordResults() const { return recordResults; }
+	const std::vector<ScalingResult>& getScalingResults() const { return scalingResults; }
+
+	// A swapchain recreation; the drag is reported once none came for half a second
+	void recordResize(float recreateMs);
+	// Advances the running sweeps and the resize report with a finished frame
+	void endFrame(const FrameStats& stats, Settings& settings);
+
+private:
+	void updateRecordSweep(const FrameStats& stats, Settings& settings);
+	void updateScalingSweep(const FrameStats& stats, Settings& settings);
+	void applyScalingStep(Settings& settings) const;
+	void updateResize(const FrameStats& stats);
+
+	// Record time per thread count (0 = not running)
+	uint32_t recordThreads = 0;
+	uint32_t recordMaxThreads = 1;
+	uint32_t recordFrames = 0;
+	float recordTotalMs = 0.0f;
+	int recordSavedThreads = 1;
+	std::vector<float> recordResults;
+
+	// Each step runs one path at one count from SCALING_OBJECTS, CPU path first (0 = not running)
+	uint32_t scalingStep = 0;
+	uint32_t scalingSceneObjects = 1;
+	uint32_t scalingFrames = 0;
+	float scalingTotalMs = 0.0f;
+	float scalingTransformMs = 0.0f;
+	float scalingDrawMs = 0.0f;
+	Settings scalingSaved;
+	std::vector<ScalingResult> scalingResults;
+
+	// Swapchain recreations since the current resize drag began
+	uint32_t resizeCount = 0;
+	float resizeMaxRecreateMs = 0.0f;
+	float resizeMaxFrameMs = 0.0f;
+	std::chrono::steady_clock::time_point lastResizeTime;
+};
@@ -0,0 +1,155 @@
+#include "PipelineCache.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+uint64_t PipelineCache::hashData(const char* data, size_t size)
+{
+	// FNV-1a; catches truncated and corrupted files, not tampering
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= static_cast<uint8_t>(data[i]);
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+PipelineCache::FileHeader PipelineCache::makeHeader() const
+{
+	FileHeader header;
+	header.magic = FILE_MAGIC;
+	header.version = FILE_VERSION;
+	header.vendorID = properties.vendorID;
+	header.deviceID = properties.deviceID;
+	header.driverVersion = properties.driverVersion;
+	std::memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+	return header;
+}
+
+bool PipelineCache::isValid(const FileHeader& header, const char* data, size_t size) const
+{
+	FileHeader expected = makeHeader();
+	if (header.magic != expected.magic || header.version != expected.version) {
+		std::cout << "Pipeline cache: unknown file format, starting cold" << std::endl;
+		return false;
+	}
+	if (header.vendorID != expected.vendorID || header.deviceID != expected.deviceID ||
+		header.driverVersion != expected.driverVersion ||
+		std::memcmp(header.pipelineCacheUUID, expected.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+		std::cout << "Pipeline cache: written by another GPU or driver, starting cold" << std::endl;
+		return false;
+	}
+	if (header.dataSize != size || header.dataHash != hashData(data, size)) {
+		std::cout << "Pipeline cache: file is corrupt, starting cold" << std::endl;
+		return false;
+	}
+
+	// The driver's own header has to agree as well
+	VkPipelineCacheHeaderVersionOne driverHeader{};
+	if (size < sizeof(driverHeader)) {
+		return false;
+	}
+	std::memcpy(&driverHeader, data, sizeof(driverHeader));
+	return driverHeader.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+		driverHeader.vendorID == expected.vendorID && driverHeader.deviceID == expected.deviceID &&
+		std::memcmp(driverHeader.pipelineCacheUUID, expected.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+void PipelineCache::init(VkDevice device, VkPhysicalDevice physicalDevice, const std::string& path)
+{
+	this->device = device;
+	this->path = path;
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+	std::vector<char> data;
+	if (!path.empty()) {
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (file) {
+			size_t fileSize = static_cast<size_t>(file.tellg());
+			file.seekg(0);
+			FileHeader header;
+			if (fileSize > sizeof(header) && file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+				data.resize(fileSize - sizeof(header));
+				file.read(data.data(), data.size());
+				if (!file || !isValid(header, data.data(), data.size())) {
+					data.clear();
+				}
+			}
+		}
+	}
+
+	VkPipelineCacheCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	createInfo.initialDataSize = data.size();
+	createInfo.pInitialData = data.empty() ? nullptr : data.data();
+	if (vkCreatePipelineCache(device, &createInfo, nullptr, &cache) != VK_SUCCESS) {
+		// A blob the driver still rejects is not worth failing startup over
+		createInfo.initialDataSize = 0;
+		createInfo.pInitialData = nullptr;
+		data.clear();
+		if (vkCreatePipelineCache(device, &createInfo, nullptr, &cache) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create pipeline cache!");
+		}
+	}
+
+	warm = !data.empty();
+	loadedBytes = data.size();
+	if (warm) {
+		std::cout << "Pipeline cache: loaded " << loadedBytes / 1024 << " KB from " << path << std::endl;
+	}
+}
+
+bool PipelineCache::save() const
+{
+	if (cache == VK_NULL_HANDLE || path.empty()) {
+		return false;
+	}
+
+	size_t size = 0;
+	if (vkGetPipelineCacheData(device, cache, &size, nullptr) != VK_SUCCESS || size == 0) {
+		return false;
+	}
+	std::vector<char> data(size);
+	if (vkGetPipelineCacheData(device, cache, &size, data.data()) != VK_SUCCESS) {
+		return false;
+	}
+	data.resize(size);
+
+	FileHeader header = makeHeader();
+	header.dataSize = data.size();
+	header.dataHash = hashData(data.data(), data.size());
+
+	std::string tempPath = path + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file) {
+			std::cout << "Pipeline cache: failed to open " << tempPath << std::endl;
+			return false;
+		}
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(data.data(), data.size());
+		if (!file) {
+			std::cout << "Pipeline cache: failed to write " << tempPath << std::endl;
+			return false;
+		}
+	}
+	// rename does not replace an existing file everywhere
+	std::remove(path.c_str());
+	if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+		std::cout << "Pipeline cache: failed to replace " << path << std::endl;
+		return false;
+	}
+	std::cout << "Pipeline cache: saved " << data.size() / 1024 << " KB to " << path << std::endl;
+	return true;
+}
+
+void PipelineCache::cleanup()
+{
+	if (cache != VK_NULL_HANDLE) {
+		vkDestroyPipelineCache(device, cache, nullptr);
+		cache = VK_NULL_HANDLE;
+	}
+}
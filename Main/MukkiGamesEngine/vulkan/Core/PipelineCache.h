@@ -0,0 +1,51 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// The VkPipelineCache every pipeline is created through, persisted between runs. The file is
+// only handed to the driver when its header matches the current GPU and driver (vendor,
+// device, driver version, cache UUID) and its payload is intact; anything else starts an
+// empty cache, since some drivers do not validate the blob themselves.
+class PipelineCache {
+public:
+	// path may be empty: the cache then only lives for this run
+	void init(VkDevice device, VkPhysicalDevice physicalDevice, const std::string& path);
+	// Writes the cache next to path and renames it over the old file, so a crash mid-write
+	// never leaves a truncated cache behind
+	bool save() const;
+	void cleanup();
+
+	VkPipelineCache get() const { return cache; }
+	// True when the run started from a valid file (warm start)
+	bool isWarm() const { return warm; }
+	size_t getLoadedBytes() const { return loadedBytes; }
+
+private:
+	// Prefixed to the driver's data; the driver's own header only carries vendor, device and UUID
+	struct FileHeader {
+		uint32_t magic = 0;
+		uint32_t version = 0;
+		uint32_t vendorID = 0;
+		uint32_t deviceID = 0;
+		uint32_t driverVersion = 0;
+		uint8_t pipelineCacheUUID[VK_UUID_SIZE] = {};
+		uint64_t dataSize = 0;
+		uint64_t dataHash = 0;
+	};
+
+	static constexpr uint32_t FILE_MAGIC = 0x43504B4D; // "MKPC"
+	static constexpr uint32_t FILE_VERSION = 1;
+
+	static uint64_t hashData(const char* data, size_t size);
+	FileHeader makeHeader() const;
+	bool isValid(const FileHeader& header, const char* data, size_t size) const;
+
+	VkDevice device = VK_NULL_HANDLE;
+	VkPhysicalDeviceProperties properties{};
+	VkPipelineCache cache = VK_NULL_HANDLE;
+	std::string path;
+	bool warm = false;
+	size_t loadedBytes = 0;
+};
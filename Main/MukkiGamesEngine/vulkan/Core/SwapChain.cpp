@@ -1,10 +1,11 @@
 #include "SwapChain.h"
+#include "../utils/GpuResourceRegistry.h"
 #include <algorithm>
 #include <stdexcept>
 #include <GLFW/glfw3.h>
 #include <array>
 
-void VulkanSwap::initSwap(Device& device, const VkSurfaceKHR& vkSurface, GLFWwindow* window)
+void VulkanSwap::initSwap(Device& device, const VkSurfaceKHR& vkSurface, GLFWwindow* window, VkSwapchainKHR oldSwapchain)
 {
 	this->window = window;
 	this->devicePtr = &device;  // Store pointer to device
@@ -17,7 +18,7 @@ void VulkanSwap::initSwap(Device& device, const VkSurfaceKHR& vkSurface, GLFWwin
 	SwapChainSupportDetails swapChainSupport = querySwapChainSupport(physicalDevice);
 
 	VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
-	VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+	presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
 	VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities, window);
 
 	uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
@@ -52,7 +53,7 @@ void VulkanSwap::initSwap(Device& device, const VkSurfaceKHR& vkSurface, GLFWwin
 	createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
 	createInfo.presentMode = presentMode;
 	createInfo.clipped = VK_TRUE;
-	createInfo.oldSwapchain = VK_NULL_HANDLE;
+	createInfo.oldSwapchain = oldSwapchain;
 
 	if (vkCreateSwapchainKHR(logicalDevice, &createInfo, nullptr, &swapChain) != VK_SUCCESS) {
 		throw std::runtime_error("failed to create swap chain!");
@@ -66,6 +67,76 @@ void VulkanSwap::initSwap(Device& device, const VkSurfaceKHR& vkSurface, GLFWwin
 	swapChainExtent = extent;
 }
 
+void VulkanSwap::recreate(FrameDeletionQueue& retireQueue)
+{
+	VkDevice logicalDevice = devicePtr->getDevice();
+	VkSwapchainKHR oldSwapchain = swapChain;
+	std::vector<VkImageView> oldViews = std::move(swapChainImageViews);
+	std::vector<VkFramebuffer> oldFramebuffers = std::move(swapChainFramebuffers);
+	swapChainImageViews.clear();
+	swapChainFramebuffers.clear();
+
+	initSwap(*devicePtr, surface, window, oldSwapchain);
+
+	// Frames in flight still render into and present the old images. Their GPU work being done
+	// is the closest signal core Vulkan gives that the presents no longer need them either.
+	retireQueue.retire([logicalDevice, oldSwapchain, oldViews = std::move(oldViews), oldFramebuffers = std::move(oldFramebuffers)]() {
+		for (auto framebuffer : oldFramebuffers) {
+			vkDestroyFramebuffer(logicalDevice, framebuffer, nullptr);
+		}
+		for (auto imageView : oldViews) {
+			GpuResourceRegistry::destroy(logicalDevice, imageView, nullptr);
+		}
+		vkDestroySwapchainKHR(logicalDevice, oldSwapchain, nullptr);
+	});
+}
+
+void VulkanSwap::initOffscreen(Device& device, VkExtent2D extent, uint32_t imageCount)
+{
+	this->window = nullptr;
+	this->devicePtr = &device;
+	this->surface = VK_NULL_HANDLE;
+	offscreen = true;
+
+	VkDevice logicalDevice = device.getDevice();
+	swapChainImageFormat = VK_FORMAT_B8G8R8A8_SRGB;
+	swapChainExtent = extent;
+	swapChainImages.resize(imageCount);
+	offscreenMemory.resize(imageCount);
+
+	for (uint32_t i = 0; i < imageCount; i++) {
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = swapChainImageFormat;
+		imageInfo.extent = { extent.width, extent.height, 1 };
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		if (vkCreateImage(logicalDevice, &imageInfo, nullptr, &swapChainImages[i]) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create offscreen image!");
+		}
+
+		VkMemoryRequirements memRequirements;
+		vkGetImageMemoryRequirements(logicalDevice, swapChainImages[i], &memRequirements);
+
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = memRequirements.size;
+		allocInfo.memoryTypeIndex = device.findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		if (vkAllocateMemory(logicalDevice, &allocInfo, nullptr, &offscreenMemory[i]) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate offscreen image memory!");
+		}
+		vkBindImageMemory(logicalDevice, swapChainImages[i], offscreenMemory[i], 0);
+		MK_TRACK_GPU_RESOURCE(swapChainImages[i], memRequirements.size, "offscreen.image");
+	}
+}
+
 void VulkanSwap::createImageViews()
 {
 	if (!devicePtr) {
@@ -95,6 +166,7 @@ void VulkanSwap::createImageViews()
 		if (vkCreateImageView(devicePtr->getDevice(), &createInfo, nullptr, &swapChainImageViews[i]) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create image views!");
 		}
+		MK_TRACK_GPU_RESOURCE(swapChainImageViews[i], 0, "swapchain.view");
 	}
 }
 
@@ -148,10 +220,20 @@ void VulkanSwap::cleanup()
 
 	// Destroy image views
 	for (auto imageView : swapChainImageViews) {
-		vkDestroyImageView(devicePtr->getDevice(), imageView, nullptr);
+		GpuResourceRegistry::destroy(devicePtr->getDevice(), imageView, nullptr);
 	}
 	swapChainImageViews.clear();
 
+	// Offscreen images are ours to free; swapchain images go with the swapchain
+	if (offscreen) {
+		for (size_t i = 0; i < swapChainImages.size(); i++) {
+			GpuResourceRegistry::destroy(devicePtr->getDevice(), swapChainImages[i], nullptr);
+			vkFreeMemory(devicePtr->getDevice(), offscreenMemory[i], nullptr);
+		}
+		swapChainImages.clear();
+		offscreenMemory.clear();
+	}
+
 	// Destroy swap chain
 	if (swapChain != VK_NULL_HANDLE) {
 		vkDestroySwapchainKHR(devicePtr->getDevice(), swapChain, nullptr);
@@ -205,7 +287,7 @@ VkSurfaceFormatKHR VulkanSwap::chooseSwapSurfaceFormat(const std::vector<VkSurfa
 
 VkPresentModeKHR VulkanSwap::chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes) {
 	for (const auto& availablePresentMode : availablePresentModes) {
-		if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
+		if (availablePresentMode == preferredPresentMode) {
 			return availablePresentMode;
 		}
 	}
@@ -213,6 +295,14 @@ VkPresentModeKHR VulkanSwap::chooseSwapPresentMode(const std::vector<VkPresentMo
 	return VK_PRESENT_MODE_FIFO_KHR;
 }
 
+bool VulkanSwap::isPresentModeSupported(VkPresentModeKHR mode) {
+	if (offscreen) {
+		return false;
+	}
+	SwapChainSupportDetails support = querySwapChainSupport(devicePtr->getPhysicalDevice());
+	return std::find(support.presentModes.begin(), support.presentModes.end(), mode) != support.presentModes.end();
+}
+
 VkExtent2D VulkanSwap::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, GLFWwindow* window) {
 	if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
 		return capabilities.currentExtent;
@@ -3,11 +3,12 @@
 #include <GLFW/glfw3.h>
 #include <vector>
 #include "VkDevice.h"
+#include "../Resources/DeletionQueue.h"
 
 class VulkanSwap {
 private:
-	VkSurfaceKHR surface;
-	VkSwapchainKHR swapChain;
+	VkSurfaceKHR surface = VK_NULL_HANDLE;
+	VkSwapchainKHR swapChain = VK_NULL_HANDLE;
 	Device* devicePtr;  // Store pointer to Device wrapper
 	std::vector<VkImage> swapChainImages;
 	std::vector<VkImageView> swapChainImageViews;  // ADD THIS
@@ -15,10 +16,24 @@ private:
 	VkFormat swapChainImageFormat;
 	VkExtent2D swapChainExtent;
 	GLFWwindow* window;
+	// Requested by the user; falls back to FIFO (always supported) when the surface lacks it
+	VkPresentModeKHR preferredPresentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+	VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
+	// Headless: the images are owned here instead of by a VkSwapchainKHR
+	bool offscreen = false;
+	std::vector<VkDeviceMemory> offscreenMemory;
 
 public:
 	~VulkanSwap() { cleanup(); }
-	void initSwap(Device& device, const VkSurfaceKHR& vkSurface, GLFWwindow* window);
+	// oldSwapchain lets the driver hand resources over from the swapchain being replaced
+	void initSwap(Device& device, const VkSurfaceKHR& vkSurface, GLFWwindow* window, VkSwapchainKHR oldSwapchain = VK_NULL_HANDLE);
+	// Replaces the swapchain at the window's current size without waiting for the GPU: the old
+	// swapchain, its views and framebuffers go to retireQueue. Image views and framebuffers of
+	// the new one still have to be created.
+	void recreate(FrameDeletionQueue& retireQueue);
+	// Headless stand-in for a swapchain: imageCount plain images with the usage and format a
+	// surface would provide; nothing is acquired or presented, the caller cycles through them
+	void initOffscreen(Device& device, VkExtent2D extent, uint32_t imageCount);
 	void createImageViews();
 	void createFramebuffers(VkRenderPass renderPass, VkImageView depthImageView = VK_NULL_HANDLE);
 	void cleanup();
@@ -37,4 +52,10 @@ public:
 	VkSwapchainKHR getSwapChain() const { return swapChain; }
 	VkExtent2D getSwapChainExtent() const { return swapChainExtent; }
 	size_t getImageCount() const { return swapChainImages.size(); }
+	bool isOffscreen() const { return offscreen; }
+
+	// Takes effect at the next initSwap (recreateSwapChain)
+	void setPreferredPresentMode(VkPresentModeKHR mode) { preferredPresentMode = mode; }
+	VkPresentModeKHR getPresentMode() const { return presentMode; }
+	bool isPresentModeSupported(VkPresentModeKHR mode);
 };
\ No newline at end of file
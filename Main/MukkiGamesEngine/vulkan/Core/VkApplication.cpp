@@ -3,11 +3,53 @@
 #include "../objects/vertex.h"
 #include <stdexcept>
 #include <array>
+#include <algorithm>
 #include "ShaderCompiler.h"
 #include <iostream>
 #include "../pipeline/computePipeline.h"
 #include "../Physics/VehiclePhysics.h"
+#include "../utils/MemoryStats.h"
+#include "../utils/GpuResourceRegistry.h"
+#include "../utils/CpuProfiler.h"
+#include <optional>
+#include <thread>
+#include <fstream>
+
+// Present modes selectable at runtime, in the order the UI lists them
+const VkPresentModeKHR PRESENT_MODE_OPTIONS[] = {
+	VK_PRESENT_MODE_FIFO_KHR,
+	VK_PRESENT_MODE_MAILBOX_KHR,
+	VK_PRESENT_MODE_IMMEDIATE_KHR,
+	VK_PRESENT_MODE_FIFO_RELAXED_KHR
+};
+
+static VkPresentModeKHR parsePresentMode(const std::string& name)
+{
+	if (name == "fifo") return VK_PRESENT_MODE_FIFO_KHR;
+	if (name == "immediate") return VK_PRESENT_MODE_IMMEDIATE_KHR;
+	if (name == "fifo_relaxed") return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+	if (name != "mailbox") {
+		std::cout << "Unknown present mode '" << name << "', using mailbox" << std::endl;
+	}
+	return VK_PRESENT_MODE_MAILBOX_KHR;
+}
 
+// Offscreen images cycled through in headless runs, standing in for the swapchain's
+static constexpr uint32_t HEADLESS_IMAGE_COUNT = 3;
+// Frames rendered by a headless run that does not ask for a count
+static constexpr uint32_t HEADLESS_DEFAULT_FRAMES = 100;
+// Frame step of headless runs outside a benchmark script, which brings its own
+static constexpr float HEADLESS_TIMESTEP = 1.0f / 60.0f;
+// Compute and ray tracing descriptor sets alive at once: the bound one plus those replaced by
+// resizes and scene rebuilds whose frames are still in flight
+static constexpr uint32_t DESCRIPTOR_SET_GENERATIONS = 2 * MAX_FRAMES_IN_FLIGHT;
+
+// Seconds since the first call; glfwGetTime needs GLFW, which headless runs never initialise
+static double secondsSinceStart()
+{
+	static const auto start = std::chrono::steady_clock::now();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
 
 // Example vertices (triangle)
 const std::vector<Vertex> vertices = {
@@ -47,7 +89,8 @@ void VulkanApplication::createRayTracingUniformBuffer()
 		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
 		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
 		rayTracingUniformBuffer,
-		rayTracingUniformBufferMemory);
+		rayTracingUniformBufferMemory,
+		"rayTracing.ubo");
 
 	vkMapMemory(device->getDevice(), rayTracingUniformBufferMemory, 0, bufferSize, 0, &rayTracingUniformBufferMapped);
 }
@@ -137,7 +180,8 @@ void VulkanApplication::createRayTracingGeometryBuffers()
 			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
 			rayTracingPrimitiveBuffer,
-			rayTracingPrimitiveBufferMemory);
+			rayTracingPrimitiveBufferMemory,
+			"rayTracing.primitives");
 
 		void* mapped = nullptr;
 		vkMapMemory(device->getDevice(), rayTracingPrimitiveBufferMemory, 0, primBufferSize, 0, &mapped);
@@ -152,7 +196,8 @@ void VulkanApplication::createRayTracingGeometryBuffers()
 			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
 			rayTracingMeshBuffer,
-			rayTracingMeshBufferMemory);
+			rayTracingMeshBufferMemory,
+			"rayTracing.meshes");
 
 		void* mapped = nullptr;
 		vkMapMemory(device->getDevice(), rayTracingMeshBufferMemory, 0, meshBufferSize, 0, &mapped);
@@ -170,9 +215,9 @@ void VulkanApplication::createRayTracingGeometryBuffers()
 
 		device->createBuffer(vbSize,
 			VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, rtCombinedVertexBuffer, rtCombinedVertexBufferMemory);
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, rtCombinedVertexBuffer, rtCombinedVertexBufferMemory, "rayTracing.vertices");
 		device->copyBuffer(staging, rtCombinedVertexBuffer, vbSize);
-		vkDestroyBuffer(device->getDevice(), staging, nullptr);
+		GpuResourceRegistry::destroy(device->getDevice(), staging, nullptr);
 		vkFreeMemory(device->getDevice(), stagingMem, nullptr);
 	}
 
@@ -186,47 +231,29 @@ void VulkanApplication::createRayTracingGeometryBuffers()
 
 		device->createBuffer(ibSize,
 			VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, rtCombinedIndexBuffer, rtCombinedIndexBufferMemory);
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, rtCombinedIndexBuffer, rtCombinedIndexBufferMemory, "rayTracing.indices");
 		device->copyBuffer(staging, rtCombinedIndexBuffer, ibSize);
-		vkDestroyBuffer(device->getDevice(), staging, nullptr);
+		GpuResourceRegistry::destroy(device->getDevice(), staging, nullptr);
 		vkFreeMemory(device->getDevice(), stagingMem, nullptr);
 	}
 }
 
 void VulkanApplication::cleanupRayTracingGeometryBuffers()
 {
-	if (rayTracingPrimitiveBuffer != VK_NULL_HANDLE) {
-		vkDestroyBuffer(device->getDevice(), rayTracingPrimitiveBuffer, nullptr);
-		rayTracingPrimitiveBuffer = VK_NULL_HANDLE;
-	}
-	if (rayTracingPrimitiveBufferMemory != VK_NULL_HANDLE) {
-		vkFreeMemory(device->getDevice(), rayTracingPrimitiveBufferMemory, nullptr);
-		rayTracingPrimitiveBufferMemory = VK_NULL_HANDLE;
-	}
-	if (rayTracingMeshBuffer != VK_NULL_HANDLE) {
-		vkDestroyBuffer(device->getDevice(), rayTracingMeshBuffer, nullptr);
-		rayTracingMeshBuffer = VK_NULL_HANDLE;
-	}
-	if (rayTracingMeshBufferMemory != VK_NULL_HANDLE) {
-		vkFreeMemory(device->getDevice(), rayTracingMeshBufferMemory, nullptr);
-		rayTracingMeshBufferMemory = VK_NULL_HANDLE;
-	}
-	if (rtCombinedVertexBuffer != VK_NULL_HANDLE) {
-		vkDestroyBuffer(device->getDevice(), rtCombinedVertexBuffer, nullptr);
-		rtCombinedVertexBuffer = VK_NULL_HANDLE;
-	}
-	if (rtCombinedVertexBufferMemory != VK_NULL_HANDLE) {
-		vkFreeMemory(device->getDevice(), rtCombinedVertexBufferMemory, nullptr);
-		rtCombinedVertexBufferMemory = VK_NULL_HANDLE;
-	}
-	if (rtCombinedIndexBuffer != VK_NULL_HANDLE) {
-		vkDestroyBuffer(device->getDevice(), rtCombinedIndexBuffer, nullptr);
-		rtCombinedIndexBuffer = VK_NULL_HANDLE;
-	}
-	if (rtCombinedIndexBufferMemory != VK_NULL_HANDLE) {
-		vkFreeMemory(device->getDevice(), rtCombinedIndexBufferMemory, nullptr);
-		rtCombinedIndexBufferMemory = VK_NULL_HANDLE;
-	}
+	// Frames still in flight may read these, so retire them instead of destroying them
+	VkDevice vkDev = device->getDevice();
+	m_retireQueue.retireBuffer(vkDev, rayTracingPrimitiveBuffer, rayTracingPrimitiveBufferMemory);
+	m_retireQueue.retireBuffer(vkDev, rayTracingMeshBuffer, rayTracingMeshBufferMemory);
+	m_retireQueue.retireBuffer(vkDev, rtCombinedVertexBuffer, rtCombinedVertexBufferMemory);
+	m_retireQueue.retireBuffer(vkDev, rtCombinedIndexBuffer, rtCombinedIndexBufferMemory);
+	rayTracingPrimitiveBuffer = VK_NULL_HANDLE;
+	rayTracingPrimitiveBufferMemory = VK_NULL_HANDLE;
+	rayTracingMeshBuffer = VK_NULL_HANDLE;
+	rayTracingMeshBufferMemory = VK_NULL_HANDLE;
+	rtCombinedVertexBuffer = VK_NULL_HANDLE;
+	rtCombinedVertexBufferMemory = VK_NULL_HANDLE;
+	rtCombinedIndexBuffer = VK_NULL_HANDLE;
+	rtCombinedIndexBufferMemory = VK_NULL_HANDLE;
 }
 
 VulkanApplication::~VulkanApplication()
@@ -301,6 +328,9 @@ void VulkanApplication::run()
 
 void VulkanApplication::initVulkan(const RenderConfig& config)
 {
+	initBegin = std::chrono::steady_clock::now();
+	phaseBegin = initBegin;
+	startupPhases.clear();
 	std::cout << "\n=== VERTEX LAYOUT DIAGNOSTICS ===" << std::endl;
 	Vertex::printLayout();
 	std::cout << "glm::vec3 size: " << sizeof(glm::vec3) << " bytes" << std::endl;
@@ -316,34 +346,122 @@ void VulkanApplication::initVulkan(const RenderConfig& config)
 	std::cout << "================================\n" << std::endl;
 	// 0. Ensure shaders are compiled to SPIR-V (will skip if up-to-date)
 	ShaderCompiler::compileShadersIfNeeded();
+	markStartupPhase("shaders");
+
+	// A benchmark script overrides the scene, the render mode and the frame count
+	std::string scenePath = config.scenePath;
+	std::string renderMode = config.renderMode;
+	if (!config.benchmarkPath.empty()) {
+		benchmark.load(config.benchmarkPath);
+		if (!benchmark.getScenePath().empty()) {
+			scenePath = benchmark.getScenePath();
+		}
+		if (!benchmark.getRenderMode().empty()) {
+			renderMode = benchmark.getRenderMode();
+		}
+	}
 
-	// 1. Create window
-	window = std::make_unique<EngineWindow>();
-	window->init(config.windowWidgth, config.windowHeight, config.windowTitle.c_str());
-	glfwSetWindowUserPointer(window->getGLFWwindow(), this);
+	// Decided up front: only the starting mode's ray tracing or compute resources are created here
+	if (renderMode == "compute") {
+		currentRenderMode = RenderMode::COMPUTE;
+	}
+	else if (renderMode == "raytracing") {
+		currentRenderMode = RenderMode::RAYTRACING;
+	}
+	else if (renderMode != "graphics") {
+		std::cout << "Unknown render mode '" << renderMode << "', using graphics" << std::endl;
+	}
+	prewarmModes = config.prewarmModes;
+	modeIdleReleaseSeconds = std::max(config.modeIdleReleaseSeconds, 0.0f);
+
+	// 1. Create window (headless runs never touch GLFW)
+	headless = config.headless;
+	maxFrames = static_cast<uint32_t>(std::max(config.maxFrames, 0));
+	if (benchmark.isActive()) {
+		maxFrames = benchmark.getTotalFrames();
+	}
+	fixedTimestep = headless || benchmark.isActive();
+	if (headless) {
+		if (maxFrames == 0) {
+			maxFrames = HEADLESS_DEFAULT_FRAMES;
+		}
+		readbackPath = config.readbackPath;
+		std::cout << "Headless: " << config.windowWidgth << "x" << config.windowHeight << ", " << maxFrames << " frames" << std::endl;
+	}
+	else {
+		window = std::make_unique<EngineWindow>();
+		window->init(config.windowWidgth, config.windowHeight, config.windowTitle.c_str());
+		glfwSetWindowUserPointer(window->getGLFWwindow(), this);
+	}
 	// 2. Create instance (Vulkan context)
+	instance.headless = headless;
 	instance.createInstance();
+	markStartupPhase("window + instance");
 
 	// 3. Create surface (connection between Vulkan and window)
-	VkSurfaceKHR surface = window->createSurface(instance.getInstance());
+	VkSurfaceKHR surface = headless ? VK_NULL_HANDLE : window->createSurface(instance.getInstance());
 
 	// 4. Create device (select GPU and create logical device)
 	device = std::make_unique<Device>(instance, surface);
+	device->getPipelineCache().init(device->getDevice(), device->getPhysicalDevice(), config.pipelineCachePath);
+	markStartupPhase("device");
+	if (currentRenderMode == RenderMode::RAYTRACING && !device->supportsRayTracing()) {
+		throw std::runtime_error("render mode 'raytracing' needs VK_KHR_ray_tracing_pipeline and VK_KHR_acceleration_structure, which this device lacks!");
+	}
 
-	// 5. Create swap chain (manages images for presentation)
+	// 5. Create swap chain (manages images for presentation), or the offscreen images
 	swapChain = std::make_unique<VulkanSwap>();
-	swapChain->initSwap(*device, surface, window->getGLFWwindow());
+	swapChain->setPreferredPresentMode(parsePresentMode(config.presentMode));
+	if (headless) {
+		VkExtent2D headlessExtent = { static_cast<uint32_t>(config.windowWidgth), static_cast<uint32_t>(config.windowHeight) };
+		swapChain->initOffscreen(*device, headlessExtent, HEADLESS_IMAGE_COUNT);
+	}
+	else {
+		swapChain->initSwap(*device, surface, window->getGLFWwindow());
+	}
 	swapChain->createImageViews();
+	for (size_t i = 0; i < std::size(PRESENT_MODE_OPTIONS); i++) {
+		presentModeSupported[i] = swapChain->isPresentModeSupported(PRESENT_MODE_OPTIONS[i]);
+	}
 	shadowMap = std::make_unique<ShadowMap>();
-	shadowMap->init(device.get(), 2048);
+	shadowMap->init(device.get(), 2048, true);
 
 	// 6. Create render pass (defines how rendering operations are performed)
 	renderPassObj = std::make_unique<VulkanRenderPass>(device.get(), swapChain->getSwapChainImageFormat());
 	renderPass = renderPassObj->getRenderPass();
+	markStartupPhase("swapchain + render pass");
+
+	// 6b. Descriptor set layouts and pipeline layouts up front, so that every pipeline can start
+	// compiling on a worker thread now and overlap the scene and texture loading below. The
+	// shared pipeline cache is internally synchronised; waitForPipelineJobs joins them.
+	createDescriptorSetLayout();
+	if (device->supportsRayTracing()) {
+		createRayTracingDescriptorSetLayout();
+	}
+	createPipelineLayout();
+	createGraphicsPipeline();
+	pipelineJobs.push_back(std::async(std::launch::async, [this]() { shadowMap->createPipeline(); }));
+	gpuDrivenRendering = gpuDrivenRendering && device->supportsGpuDrivenRendering();
+	if (device->supportsGpuDrivenRendering()) {
+		gpuScene.init(device.get(), descriptorSetLayout, MAX_FRAMES_IN_FLIGHT);
+		pipelineJobs.push_back(std::async(std::launch::async, [this]() { gpuScene.createPipelines(renderPass); }));
+	}
+	// Other modes are brought up on first use (ensureModeResources)
+	if (currentRenderMode == RenderMode::COMPUTE) {
+		initComputePipeline();
+	}
+	else if (currentRenderMode == RenderMode::RAYTRACING) {
+		initRayTracingPipeline();
+	}
+	markStartupPhase("layouts + pipeline jobs");
 
 	// 7. Create command buffers FIRST (required by BufferManager and TextureManager)
 	commandBufferManager = std::make_unique<CommandBufferManager>();
 	commandBufferManager->init(device.get(), MAX_FRAMES_IN_FLIGHT);
+	drawRecorder.init(device.get(), MAX_FRAMES_IN_FLIGHT,
+		std::min(std::max(std::thread::hardware_concurrency(), 1u), ParallelCommandRecorder::MAX_THREADS));
+	recordThreads = static_cast<int>(drawRecorder.getThreadCount());
+	occlusionCuller.init(std::max(std::thread::hardware_concurrency(), 1u));
 
 	// 8. Initialize BufferManager and TextureManager (they depend on CommandBufferManager)
 	bufferManager = std::make_unique<BufferManager>();
@@ -351,21 +469,35 @@ void VulkanApplication::initVulkan(const RenderConfig& config)
 
 	textureManager = std::make_unique<TextureManager>();
 	textureManager->init(*device, *commandBufferManager, *bufferManager);
+	frameGraph.init(device.get(), textureManager.get(), &m_retireQueue);
+	if (device->hasAsyncCompute()) {
+		QueueFamilyIndices families = device->findQueueFamilies(device->getPhysicalDevice());
+		frameGraph.setAsyncComputeQueue(families.graphicsFamily.value(), families.computeFamily.value());
+	}
+	asyncCompute = config.asyncCompute;
+	frameGraph.setAsyncComputeEnabled(asyncCompute);
+
+	resourcePool = std::make_unique<GpuResourcePool>();
+	resourcePool->init(device.get());
 
-	rayTracingAS = std::make_unique<RayTracingAS>();
-	rayTracingAS->init(device.get(), commandBufferManager.get());
+	if (device->supportsRayTracing()) {
+		rayTracingAS = std::make_unique<RayTracingAS>();
+		rayTracingAS->init(device.get(), commandBufferManager.get(), resourcePool.get());
+		rayTracingAS->setRetireQueue(&m_retireQueue);
+	}
 
 	objectLoader = std::make_unique<ObjectLoader>();
-	objectLoader->init(device.get(), textureManager.get(), bufferManager.get());
+	objectLoader->init(device.get(), textureManager.get(), bufferManager.get(), resourcePool.get());
 
 	sceneLoader = std::make_unique<SceneLoader>();
 	sceneLoader->init(device.get(), textureManager.get(), bufferManager.get(), objectLoader.get());
 
-	if (!config.scenePath.empty()) {
-		sceneLoader->loadScene(config.scenePath);
+	if (!scenePath.empty()) {
+		sceneLoader->loadScene(scenePath);
 	} else {
 		sceneLoader->loadScene(ASSETS_PATH + availableScenes[0]);
 	}
+	markStartupPhase("managers + scene file");
 
 	skybox = std::make_unique<SkyBox>();
 	std::string skyboxFileName = sceneLoader->getConfig().skyboxPath;
@@ -374,27 +506,23 @@ void VulkanApplication::initVulkan(const RenderConfig& config)
 
 	skybox->init(device.get(), textureManager.get(), bufferManager.get(),
 		renderPass, fullSkyboxPath,
-		CubemapLayout::VerticalCross, MAX_FRAMES_IN_FLIGHT);
+		CubemapLayout::VerticalCross, MAX_FRAMES_IN_FLIGHT, true);
+	pipelineJobs.push_back(std::async(std::launch::async, [this]() { skybox->createPipeline(renderPass); }));
+	markStartupPhase("skybox");
 
 	// 9. Create depth resources using TextureManager
 	VkExtent2D extent = swapChain->getSwapChainExtent();
 	textureManager->createdepthResources(depthImage, depthImageMemory, depthImageView,
 		extent.width, extent.height);
+	if (device->supportsGpuDrivenRendering()) {
+		gpuScene.resize(depthImageView, extent, m_retireQueue);
+	}
 
 	// 10. Create framebuffers (attachments for render pass)
 	swapChain->createFramebuffers(renderPass, depthImageView);
 
-	// 11. Create descriptor set layout and pipeline layout BEFORE creating the pipeline
-	createDescriptorSetLayout();
-    createRayTracingDescriptorSetLayout();
-	createPipelineLayout();
-
-	// 12. Create graphics pipeline (shaders and rendering configuration)
-	createGraphicsPipeline();
-
-	initComputePipeline();
-	createAccumulationImage();
-    initRayTracingPipeline();
+	// 11-12. Descriptor set layouts and pipelines were started after the render pass (6b)
+	createRenderTargets();
 	// 13. Create vertex and index buffers
 	createVertexBuffer();
 	createIndexBuffer();
@@ -402,6 +530,7 @@ void VulkanApplication::initVulkan(const RenderConfig& config)
 	createUniformBuffers();
 	createDefaultMaterialUniformBuffers();
 	createRayTracingUniformBuffer();
+	markStartupPhase("render targets + buffers");
 
 	lights = sceneLoader->getLights();
 	ambientStrength = sceneLoader->getConfig().ambientStrenght;
@@ -428,23 +557,60 @@ void VulkanApplication::initVulkan(const RenderConfig& config)
 		shadowMap ? shadowMap->getShadowSampler() : VK_NULL_HANDLE
 	);
 
-	createRayTracingDescriptorPool();
-	createRayTracingDescriptorSet();
+	// The ray tracing set itself is written once the scene's TLAS exists (buildRayTracingScene)
+	if (device->supportsRayTracing()) {
+		createRayTracingDescriptorPool();
+	}
+	markStartupPhase("descriptors");
 
 	loadSceneObjects();
+	markStartupPhase("scene objects");
 	initPhysics();
+	markStartupPhase("physics");
 
-	// 15. Create synchronization objects (semaphores and fences)
+	// 15. Create synchronization objects (semaphores and the frame timeline)
+	// Clamped here so the UI, the pacer and the per-frame resources all see the same count
+	framesInFlight = std::clamp(config.framesInFlight, 1, MAX_FRAMES_IN_FLIGHT);
 	createSyncObjects();
+	targetFps = config.targetFps;
+	frameLimiter.setTargetFps(targetFps);
+	justInTimeInput = config.justInTimeInput;
 
 	// Initialize camera
 	glm::vec3 camPos = sceneLoader->hasCameraSettings() ? sceneLoader->getInitialCameraPosition() : glm::vec3(0.0f, 0.0f, 3.0f);
 	camera = std::make_unique<Camera>(camPos);
 
 	// Setup mouse callback
-	glfwSetInputMode(window->getGLFWwindow(), GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-	glfwSetCursorPosCallback(window->getGLFWwindow(), mouseCallback);
+	if (!headless) {
+		glfwSetInputMode(window->getGLFWwindow(), GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+		glfwSetCursorPosCallback(window->getGLFWwindow(), mouseCallback);
+	}
 	SetupUIManager();
+	markStartupPhase("sync + camera + UI");
+	waitForPipelineJobs();
+	markStartupPhase("pipeline wait");
+
+	float startupMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - initBegin).count();
+	bool warmCache = device->getPipelineCache().isWarm();
+	std::cout << "Startup: " << startupMs << " ms (pipeline cache " << (warmCache ? "warm" : "cold") << ")" << std::endl;
+	benchmark.recordStartup(startupMs, warmCache);
+	printStartupPhases();
+}
+
+void VulkanApplication::markStartupPhase(const char* name)
+{
+	auto now = std::chrono::steady_clock::now();
+	startupPhases.push_back({ name, std::chrono::duration<float, std::milli>(now - phaseBegin).count() });
+	phaseBegin = now;
+}
+
+void VulkanApplication::printStartupPhases()
+{
+	std::cout << "Startup phases:" << std::endl;
+	for (const auto& [name, ms] : startupPhases) {
+		std::cout << "  " << name << ": " << ms << " ms" << std::endl;
+		benchmark.recordStartupPhase(name, ms);
+	}
 }
 
 void VulkanApplication::createSyncObjects()
@@ -452,32 +618,41 @@ void VulkanApplication::createSyncObjects()
 	// Get the number of swapchain images
 	size_t imageCount = swapChain->getSwapChainImages().size();
 
-	// Per-frame semaphores and fences
+	// Frame timeline semaphore; replaces the per-frame fences
+	QueueFamilyIndices families = device->findQueueFamilies(device->getPhysicalDevice());
+	framePacer.init(device->getDevice(), device->getPhysicalDevice(), families.graphicsFamily.value(),
+		static_cast<uint32_t>(framesInFlight), families.computeFamily.value_or(VK_QUEUE_FAMILY_IGNORED));
+	createAsyncComputeResources();
+	gpuProfiler.init(device->getDevice(), device->getPhysicalDevice(), families.graphicsFamily.value(),
+		families.computeFamily.value_or(VK_QUEUE_FAMILY_IGNORED), MAX_FRAMES_IN_FLIGHT);
+	frameGraph.setProfiler(&gpuProfiler);
+
+	// Anchor the GPU timestamps to the CPU profiler's clock for the merged trace
+	VkCommandBuffer calibrationCmd = commandBufferManager->beginSingleTimeCommands();
+	gpuProfiler.writeCalibration(calibrationCmd);
+	uint64_t calibrationStart = CpuProfiler::now();
+	commandBufferManager->endSingleTimeCommands(calibrationCmd);
+	gpuProfiler.finishCalibration(calibrationStart, CpuProfiler::now());
+
+	// Per-frame acquire semaphores (swapchain semaphores must stay binary)
 	imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-	inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
 
 	// Per-swapchain-image semaphores
 	renderFinishedSemaphores.resize(imageCount);
-	imagesInFlight.resize(imageCount, VK_NULL_HANDLE);
+	imageTimelineValues.assign(imageCount, 0);
 	swapChainImageLayouts.assign(imageCount, VK_IMAGE_LAYOUT_UNDEFINED);
 
 	VkSemaphoreCreateInfo semaphoreInfo{};
 	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-	VkFenceCreateInfo fenceInfo{};
-	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
 	VkDevice vkDevice = device->getDevice();
 
 	// Create per-frame synchronization objects
 	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-		if (vkCreateSemaphore(vkDevice, &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) != VK_SUCCESS ||
-			vkCreateFence(vkDevice, &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS) {
+		if (vkCreateSemaphore(vkDevice, &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create per-frame synchronization objects!");
 		}
 		m_deletionQueue.pushSemaphore(vkDevice, imageAvailableSemaphores[i]);
-		m_deletionQueue.pushFence(vkDevice, inFlightFences[i]);
 	}
 
 	// Create per-swapchain-image semaphores
@@ -489,6 +664,55 @@ void VulkanApplication::createSyncObjects()
 	}
 }
 
+void VulkanApplication::createAsyncComputeResources()
+{
+	if (!device->hasAsyncCompute()) {
+		return;
+	}
+	VkDevice vkDevice = device->getDevice();
+
+	VkCommandPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	poolInfo.queueFamilyIndex = device->findQueueFamilies(device->getPhysicalDevice()).computeFamily.value();
+	if (vkCreateCommandPool(vkDevice, &poolInfo, nullptr, &computeCommandPool) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create async compute command pool!");
+	}
+
+	VkCommandBufferAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.commandPool = computeCommandPool;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandBufferCount = MAX_FRAMES_IN_FLIGHT;
+	if (vkAllocateCommandBuffers(vkDevice, &allocInfo, computeCommandBuffers.data()) != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate async compute command buffers!");
+	}
+
+	VkSemaphoreCreateInfo semaphoreInfo{};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	for (auto& semaphore : graphicsDoneSemaphores) {
+		if (vkCreateSemaphore(vkDevice, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create async compute semaphores!");
+		}
+	}
+}
+
+void VulkanApplication::cleanupAsyncComputeResources()
+{
+	for (auto& semaphore : graphicsDoneSemaphores) {
+		if (semaphore != VK_NULL_HANDLE) {
+			vkDestroySemaphore(device->getDevice(), semaphore, nullptr);
+			semaphore = VK_NULL_HANDLE;
+		}
+	}
+	// Destroying the pool frees its command buffers
+	if (computeCommandPool != VK_NULL_HANDLE) {
+		vkDestroyCommandPool(device->getDevice(), computeCommandPool, nullptr);
+		computeCommandPool = VK_NULL_HANDLE;
+	}
+	computeCommandBuffers.fill(VK_NULL_HANDLE);
+}
+
 void VulkanApplication::createVertexBuffer()
 {
 	VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
@@ -538,7 +762,7 @@ void VulkanApplication::createVertexBuffer()
 	device->copyBuffer(stagingBuffer, vertexBuffer, bufferSize);
 
 	// Cleanup staging buffer
-	vkDestroyBuffer(device->getDevice(), stagingBuffer, nullptr);
+	GpuResourceRegistry::destroy(device->getDevice(), stagingBuffer, nullptr);
 	vkFreeMemory(device->getDevice(), stagingBufferMemory, nullptr);
 }
 
@@ -577,7 +801,7 @@ void VulkanApplication::createIndexBuffer()
 	device->copyBuffer(stagingBuffer, indexBuffer, bufferSize);
 
 	// Cleanup
-	vkDestroyBuffer(device->getDevice(), stagingBuffer, nullptr);
+	GpuResourceRegistry::destroy(device->getDevice(), stagingBuffer, nullptr);
 	vkFreeMemory(device->getDevice(), stagingBufferMemory, nullptr);
 }
 
@@ -593,7 +817,8 @@ void VulkanApplication::createUniformBuffers()
 			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
 			uniformBuffers[i],
-			uniformBuffersMemory[i]
+			uniformBuffersMemory[i],
+			"frame.ubo"
 		);
 		vkMapMemory(device->getDevice(), uniformBuffersMemory[i], 0, bufferSize, 0, &uniformBuffersMapped[i]);
 	}
@@ -622,7 +847,8 @@ void VulkanApplication::createDefaultMaterialUniformBuffers()
 			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
 			defaultMaterialUniformBuffers[i],
-			defaultMaterialUniformBuffersMemory[i]
+			defaultMaterialUniformBuffersMemory[i],
+			"material.default"
 		);
 		vkMapMemory(device->getDevice(), defaultMaterialUniformBuffersMemory[i], 0, bufferSize, 0, &defaultMaterialUniformBuffersMapped[i]);
 		memcpy(defaultMaterialUniformBuffersMapped[i], &defaultMaterial, sizeof(MaterialUBO));
@@ -714,19 +940,37 @@ void VulkanApplication::createTextureResources()
 
 void VulkanApplication::drawFrame()
 {
-	// 1. Wait for the current frame's fence
-	vkWaitForFences(device->getDevice(), 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
-
-	// 2. Acquire image from swap chain
-	uint32_t imageIndex;
-	VkResult result = vkAcquireNextImageKHR(
-		device->getDevice(),
-		swapChain->getSwapChain(),
-		UINT64_MAX,
-		imageAvailableSemaphores[currentFrame],
-		VK_NULL_HANDLE,
-		&imageIndex
-	);
+	MK_ZONE("drawFrame");
+	// 1. Wait until a frame slot is free (frames-in-flight limit on the timeline semaphore)
+	{
+		MK_ZONE("frameWait");
+		currentFrame = framePacer.beginFrame();
+	}
+	// The slot's previous frame is complete, so its pass timings can be read back
+	gpuProfiler.beginFrame(currentFrame, m_frameCount);
+
+	// Everything retired up to the completed timeline value is no longer referenced by the GPU
+	m_retireQueue.collect(framePacer.getCompletedValue());
+
+	// Set up ray tracing or compute on first use, and drop idle ray tracing scene data
+	ensureModeResources();
+	// Bring the current mode's render targets into residency (no-op unless the mode changed)
+	syncRenderTargets();
+
+	// 2. Acquire image from swap chain; headless runs cycle through the offscreen images, and
+	// the wait below on the image's last frame replaces the acquire
+	uint32_t imageIndex = static_cast<uint32_t>(m_frameCount % swapChain->getImageCount());
+	VkResult result = VK_SUCCESS;
+	if (!headless) {
+		result = vkAcquireNextImageKHR(
+			device->getDevice(),
+			swapChain->getSwapChain(),
+			UINT64_MAX,
+			imageAvailableSemaphores[currentFrame],
+			VK_NULL_HANDLE,
+			&imageIndex
+		);
+	}
 
 	if (result == VK_ERROR_OUT_OF_DATE_KHR) {
 		recreateSwapChain();
@@ -736,15 +980,18 @@ void VulkanApplication::drawFrame()
 	}
 
 	// 3. Check if a previous frame is using this image (wait for it)
-	if (imagesInFlight[imageIndex] != VK_NULL_HANDLE) {
-		vkWaitForFences(device->getDevice(), 1, &imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
-	}
+	framePacer.waitForValue(imageTimelineValues[imageIndex]);
 	// Mark the image as being in use by this frame
-	imagesInFlight[imageIndex] = inFlightFences[currentFrame];
+	imageTimelineValues[imageIndex] = framePacer.getFrameSignalValue();
 
-	// 4. Reset fence only after we're sure we'll submit work
-	vkResetFences(device->getDevice(), 1, &inFlightFences[currentFrame]);
+	// 4. With just-in-time input the camera and physics are sampled only now, after every
+	// wait of the frame, so the UBOs below carry the freshest input possible
+	if (justInTimeInput) {
+		sampleInput();
+	}
+	framePacer.markInputSampled(inputSampleTime);
 
+	bool clearAccumulation = false;
 	if (currentRenderMode == RenderMode::RAYTRACING) {
 		bool posChanged = glm::distance(camera->position, m_prevCameraPos) > 0.001f;
 		bool dirChanged = glm::distance(camera->front, m_prevCameraFront) > 0.001f;
@@ -753,18 +1000,7 @@ void VulkanApplication::drawFrame()
 			cameraMoved = false;
 			m_prevCameraPos = camera->position;
 			m_prevCameraFront = camera->front;
-			if (accumOutputImage != VK_NULL_HANDLE) {
-				VkCommandBuffer cmd = commandBufferManager->beginSingleTimeCommands();
-				VkClearColorValue clearValue = { 0.0f, 0.0f, 0.0f, 0.0f };
-				VkImageSubresourceRange range = {};
-				range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-				range.baseMipLevel = 0;
-				range.levelCount = 1;
-				range.baseArrayLayer = 0;
-				range.layerCount = 1;
-				vkCmdClearColorImage(cmd, accumOutputImage, VK_IMAGE_LAYOUT_GENERAL, &clearValue, 1, &range);
-				commandBufferManager->endSingleTimeCommands(cmd);
-			}
+			clearAccumulation = accumOutputImage != VK_NULL_HANDLE;
 		}
 		updateRayTracingUniformBuffer();
 		++accumulationFrameCount;
@@ -773,105 +1009,92 @@ void VulkanApplication::drawFrame()
 	auto loadedObjCount = loadedObjects.size();
 	bool hasLoadedModels = loadedObjCount > 0;
 
-	if (hasLoadedModels) {
-		for (auto& obj : loadedObjects) {
-			if (obj.loaded) {
-				updatePerObjectUBO(obj, currentFrame);
+	{
+		MK_ZONE("updateUniforms");
+		if (hasLoadedModels) {
+			for (auto& obj : loadedObjects) {
+				if (obj.loaded) {
+					updatePerObjectUBO(obj, currentFrame);
+				}
 			}
+		} else {
+			updateUniformBuffer(currentFrame);
 		}
-	} else {
-		updateUniformBuffer(currentFrame);
-	}
 
-	if (skybox) {
-		VkExtent2D extent = swapChain->getSwapChainExtent();
-		float aspect = extent.width / (float)extent.height;
-		glm::mat4 view = camera->getSkyboxVPMatrix(aspect, 0.1f, 100.f);
-		skybox->updateUniformBuffer(currentFrame, view);
+		if (skybox) {
+			VkExtent2D extent = swapChain->getSwapChainExtent();
+			float aspect = extent.width / (float)extent.height;
+			glm::mat4 view = camera->getSkyboxVPMatrix(aspect, 0.1f, 100.f);
+			skybox->updateUniformBuffer(currentFrame, view);
+		}
 	}
 
-	// Record shadow pass for directional light shadow mapping
-	recordShadowPass();
+	if (hasLoadedModels) {
+		syncSceneBVH();
+	}
+	// Decides gpuDrivenActive, which limits what the CPU cull has to cover
+	updateGpuScene(hasLoadedModels);
+	if (currentRenderMode == RenderMode::GRAPHICS && hasLoadedModels) {
+		cullScene();
+	}
 
-	// 5. Record command buffer
+	// 5. Record command buffer. Everything the frame needs goes into this one submission so
+	// the CPU can build the next frame while the GPU works through this one.
 	commandBufferManager->resetCommandBuffer(currentFrame);
+	drawRecorder.beginFrame(currentFrame);
 	VkCommandBuffer commandBuffer = commandBufferManager->getCommandBuffer(currentFrame);
-	if (currentRenderMode == RenderMode::COMPUTE) {
-		recordComputeCommandBuffer(commandBuffer, imageIndex);
-       swapChainImageLayouts[imageIndex] = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+		throw std::runtime_error("failed to begin recording command buffer!");
 	}
-	else if (currentRenderMode == RenderMode::RAYTRACING) {
-		recordRayTracingCommandBuffer(commandBuffer, imageIndex);
-		swapChainImageLayouts[imageIndex] = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	framePacer.writeBeginTimestamp(commandBuffer);
+	gpuProfiler.resetQueries(commandBuffer);
+	// Render targets made live by syncRenderTargets start here
+	renderTargets->recordAcquires(commandBuffer);
+
+	// The frame graph works out every barrier and layout transition between the passes
+	RenderGraph::ResourceId backbuffer = buildFrameGraph(imageIndex, clearAccumulation, hasLoadedModels);
+	if (headless && !readbackPath.empty() && m_frameCount + 1 == maxFrames) {
+		addReadbackPass(backbuffer, imageIndex);
+	}
+	frameGraph.compile();
+
+	// Async passes are recorded into the compute queue's command buffer, submitted after
+	// the graphics one
+	bool useAsyncCompute = frameGraph.usesAsyncQueue();
+	VkCommandBuffer computeCommandBuffer = VK_NULL_HANDLE;
+	if (useAsyncCompute) {
+		computeCommandBuffer = computeCommandBuffers[currentFrame];
+		vkResetCommandBuffer(computeCommandBuffer, 0);
+		if (vkBeginCommandBuffer(computeCommandBuffer, &beginInfo) != VK_SUCCESS) {
+			throw std::runtime_error("failed to begin recording async compute command buffer!");
+		}
+		framePacer.writeComputeBeginTimestamp(computeCommandBuffer);
 	}
-	else {
-		if (hasLoadedModels) {
-			VkCommandBufferBeginInfo beginInfo{};
-			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-			if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
-				throw std::runtime_error("failed to begin recording command buffer!");
-			}
-
-			VkPipeline mainPipeline = graphicsPipeline->getGraphicsPipeline();
-			VkPipeline transparentPipe = transparentPipeline ? transparentPipeline->getGraphicsPipeline() : VK_NULL_HANDLE;
-			VkPipeline addPipeline = additivePipeline ? additivePipeline->getGraphicsPipeline() : VK_NULL_HANDLE;
-
-			commandBufferManager->beginModelRenderPass(
-				commandBuffer,
-				renderPass,
-				swapChain->getSwapChainFramebuffers()[imageIndex],
-				swapChain->getSwapChainExtent(),
-				mainPipeline,
-				pipelineLayout,
-				skybox.get(),
-				swapChain->getSwapChainImages()[imageIndex],
-				swapChainImageLayouts[imageIndex],
-				currentFrame);
-
-			for (auto& obj : loadedObjects) {
-				if (obj.loaded) {
-					commandBufferManager->recordModelDrawCommands(
-						commandBuffer,
-						obj.model,
-						pipelineLayout,
-						mainPipeline,
-						transparentPipe,
-						addPipeline,
-						camera->position,
-						obj.descriptorSets,
-						currentFrame);
-				}
-			}
-
-			uiManager->render(commandBuffer);
-			commandBufferManager->endModelRenderPass(commandBuffer);
 
-			if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
-				throw std::runtime_error("failed to record command buffer!");
-			}
+	frameGraph.execute(commandBuffer, computeCommandBuffer);
+	swapChainImageLayouts[imageIndex] = frameGraph.getFinalState(backbuffer).layout;
+	if (computeOutputResource != RenderGraph::InvalidResource) {
+		computeOutputState = frameGraph.getFinalState(computeOutputResource);
+	}
+	if (hizResource != RenderGraph::InvalidResource) {
+		hizState = frameGraph.getFinalState(hizResource);
+	}
+	if (shadowMapResource != RenderGraph::InvalidResource) {
+		shadowMapState = frameGraph.getFinalState(shadowMapResource);
+	}
+	framePacer.writeEndTimestamp(commandBuffer);
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("failed to record command buffer!");
+	}
+	if (useAsyncCompute) {
+		framePacer.writeComputeEndTimestamp(computeCommandBuffer);
+		if (vkEndCommandBuffer(computeCommandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to record async compute command buffer!");
 		}
-		else {
-			// Fallback to default quad rendering
-			commandBufferManager->recordCommandBuffer(
-				commandBuffer,
-				imageIndex,
-				renderPass,
-				swapChain->getSwapChainFramebuffers()[imageIndex],
-				swapChain->getSwapChainExtent(),
-				graphicsPipeline->getGraphicsPipeline(),
-				pipelineLayout,
-				vertexBuffer,
-				indexBuffer,
-	            swapChain->getSwapChainImages()[imageIndex],
-				swapChainImageLayouts[imageIndex],
-				descriptorSets,
-				currentFrame,
-				indexCount,
-				*uiManager
-			);
-		}
-		// Track swap chain image layout for graphics mode
-		swapChainImageLayouts[imageIndex] = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 	}
 
 
@@ -879,23 +1102,97 @@ void VulkanApplication::drawFrame()
 	VkSubmitInfo submitInfo{};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-	VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]};
-	VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-	submitInfo.waitSemaphoreCount = 1;
-	submitInfo.pWaitSemaphores = waitSemaphores;
-	submitInfo.pWaitDstStageMask = waitStages;
+	// After a frame with async compute the graphics work waits for it on the timeline: where it
+	// acquires images the compute queue released, or entirely when it is the one signalling
+	// the timeline next (values must be signalled in increasing order)
+	VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame], framePacer.getTimelineSemaphore()};
+	VkPipelineStageFlags asyncWaitStages = frameGraph.getAsyncWaitStages();
+	VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+		asyncWaitStages != 0 ? asyncWaitStages : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT};
+	// Nothing was acquired headless, so the acquire semaphore is skipped
+	uint32_t firstWait = headless ? 1 : 0;
+	submitInfo.waitSemaphoreCount = (lastFrameUsedAsyncCompute ? 2 : 1) - firstWait;
+	submitInfo.pWaitSemaphores = waitSemaphores + firstWait;
+	submitInfo.pWaitDstStageMask = waitStages + firstWait;
 	submitInfo.commandBufferCount = 1;
 	submitInfo.pCommandBuffers = &commandBuffer;
 
-	// Use the per-image semaphore for signaling
-	VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[imageIndex]};
-	submitInfo.signalSemaphoreCount = 1;
-	submitInfo.pSignalSemaphores = signalSemaphores;
-
-	if (vkQueueSubmit(device->getGraphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS) {
+	// Use the per-image semaphore for presentation and advance the frame timeline; with async
+	// compute the compute submission completes the frame and signals the timeline instead
+	VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[imageIndex],
+		useAsyncCompute ? graphicsDoneSemaphores[currentFrame] : framePacer.getTimelineSemaphore()};
+	uint64_t signalValues[] = {0, useAsyncCompute ? 0 : framePacer.getFrameSignalValue()};
+	// Headless frames are never presented, so nothing would wait on the present semaphore
+	uint32_t firstSignal = headless ? 1 : 0;
+	submitInfo.signalSemaphoreCount = 2 - firstSignal;
+	submitInfo.pSignalSemaphores = signalSemaphores + firstSignal;
+
+	// The binary semaphores ignore their entries in the value arrays
+	uint64_t waitValues[] = {0, framePacer.getLastSubmittedValue()};
+	VkTimelineSemaphoreSubmitInfo timelineSubmitInfo{};
+	timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	timelineSubmitInfo.waitSemaphoreValueCount = submitInfo.waitSemaphoreCount;
+	timelineSubmitInfo.pWaitSemaphoreValues = waitValues + firstWait;
+	timelineSubmitInfo.signalSemaphoreValueCount = submitInfo.signalSemaphoreCount;
+	timelineSubmitInfo.pSignalSemaphoreValues = signalValues + firstSignal;
+	submitInfo.pNext = &timelineSubmitInfo;
+
+	std::optional<CpuZone> submitZone(std::in_place, "submit");
+	if (vkQueueSubmit(device->getGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
 		throw std::runtime_error("failed to submit draw command buffer!");
 	}
 
+	if (useAsyncCompute) {
+		VkSemaphore computeWait = graphicsDoneSemaphores[currentFrame];
+		VkPipelineStageFlags computeWaitStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		VkSemaphore computeSignal = framePacer.getTimelineSemaphore();
+		uint64_t computeWaitValue = 0;
+		uint64_t computeSignalValue = framePacer.getFrameSignalValue();
+
+		VkTimelineSemaphoreSubmitInfo computeTimelineInfo{};
+		computeTimelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		computeTimelineInfo.waitSemaphoreValueCount = 1;
+		computeTimelineInfo.pWaitSemaphoreValues = &computeWaitValue;
+		computeTimelineInfo.signalSemaphoreValueCount = 1;
+		computeTimelineInfo.pSignalSemaphoreValues = &computeSignalValue;
+
+		VkSubmitInfo computeSubmitInfo{};
+		computeSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		computeSubmitInfo.pNext = &computeTimelineInfo;
+		computeSubmitInfo.waitSemaphoreCount = 1;
+		computeSubmitInfo.pWaitSemaphores = &computeWait;
+		computeSubmitInfo.pWaitDstStageMask = &computeWaitStage;
+		computeSubmitInfo.commandBufferCount = 1;
+		computeSubmitInfo.pCommandBuffers = &computeCommandBuffer;
+		computeSubmitInfo.signalSemaphoreCount = 1;
+		computeSubmitInfo.pSignalSemaphores = &computeSignal;
+
+		if (vkQueueSubmit(device->getComputeQueue(), 1, &computeSubmitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+			throw std::runtime_error("failed to submit async compute command buffer!");
+		}
+	}
+	submitZone.reset();
+	lastFrameUsedAsyncCompute = useAsyncCompute;
+	m_retireQueue.markSubmitted(framePacer.getFrameSignalValue());
+	framePacer.endFrame();
+
+	// This frame acquired from the new swapchain and waits on that acquire, so the presents of
+	// the replaced images are behind it; their semaphores go once the frame completes
+	if (!replacedPresentSemaphores.empty()) {
+		VkDevice vkDev = device->getDevice();
+		m_retireQueue.retire([vkDev, semaphores = std::move(replacedPresentSemaphores)]() {
+			for (VkSemaphore semaphore : semaphores) {
+				vkDestroySemaphore(vkDev, semaphore, nullptr);
+			}
+		});
+		replacedPresentSemaphores.clear();
+	}
+
+	if (headless) {
+		m_frameCount++;
+		return;
+	}
+
 	// 7. Present result
 	VkPresentInfoKHR presentInfo{};
 	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -907,7 +1204,10 @@ void VulkanApplication::drawFrame()
 	presentInfo.pSwapchains = swapChains;
 	presentInfo.pImageIndices = &imageIndex;
 
-	result = vkQueuePresentKHR(device->getPresentQueue(), &presentInfo);
+	{
+		MK_ZONE("present");
+		result = vkQueuePresentKHR(device->getPresentQueue(), &presentInfo);
+	}
 
 	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
 		recreateSwapChain();
@@ -915,97 +1215,875 @@ void VulkanApplication::drawFrame()
 		throw std::runtime_error("failed to present swap chain image!");
 	}
 
-	currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
 	m_frameCount++;
 }
 
-void VulkanApplication::recreateSwapChain()
+RenderGraph::ResourceId VulkanApplication::buildFrameGraph(uint32_t imageIndex, bool clearAccumulation, bool hasLoadedModels)
+{
+	using Usage = RenderGraph::Usage;
+	using Queue = RenderGraph::Queue;
+	MK_ZONE("buildGraph");
+	frameGraph.reset();
+	computeOutputResource = RenderGraph::InvalidResource;
+	hizResource = RenderGraph::InvalidResource;
+	shadowMapResource = RenderGraph::InvalidResource;
+
+	// The acquire semaphore is waited on at COLOR_ATTACHMENT_OUTPUT, so the first use of the
+	// swapchain image chains off that stage
+	RenderGraph::ResourceId backbuffer = frameGraph.importImage("swapchain",
+		swapChain->getSwapChainImages()[imageIndex], VK_IMAGE_ASPECT_COLOR_BIT,
+		{ swapChainImageLayouts[imageIndex], VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0 });
+	frameGraph.markOutput(backbuffer);
+
+	// Cleared by every pass that uses it; the previous frame's depth tests or Hi-Z build are the
+	// last access
+	RenderGraph::ResourceId depth = frameGraph.importImage("depth", depthImage, VK_IMAGE_ASPECT_DEPTH_BIT,
+		{ VK_IMAGE_LAYOUT_UNDEFINED,
+		  VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT |
+		  VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		  VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT });
+
+	// The shadow map is shared by the frames in flight and keeps its contents between frames;
+	// frames without a shadow light sample whatever the last shadow pass left. Only the raster
+	// path reads it, so its passes are culled in the compute and ray tracing modes.
+	RenderGraph::ResourceId shadow = RenderGraph::InvalidResource;
+	if (shadowMap) {
+		shadow = frameGraph.importImage("shadowMap", shadowMap->getShadowImage(), VK_IMAGE_ASPECT_COLOR_BIT,
+			shadowMapState);
+		shadowMapResource = shadow;
+
+		if (findShadowLight()) {
+			RenderGraph::ResourceId shadowDepth = frameGraph.importImage("shadowDepth", shadowMap->getDepthImage(),
+				VK_IMAGE_ASPECT_DEPTH_BIT,
+				{ VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT });
+			frameGraph.addPass("shadow", Queue::Graphics,
+				[&](RenderGraph::PassBuilder& pass) {
+					pass.write(shadow, Usage::ColorAttachment, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+					pass.write(shadowDepth, Usage::DepthAttachment);
+				},
+				[this](VkCommandBuffer cmd) { recordShadowPass(cmd); });
+		}
+		else if (shadowMapState.layout == VK_IMAGE_LAYOUT_UNDEFINED) {
+			// No shadow pass has run yet; give the main pass a fully lit map instead of garbage
+			frameGraph.addPass("shadowClear", Queue::Graphics,
+				[&](RenderGraph::PassBuilder& pass) { pass.write(shadow, Usage::TransferDst); },
+				[this](VkCommandBuffer cmd) { recordShadowMapClear(cmd); });
+		}
+	}
+
+	if (currentRenderMode == RenderMode::GRAPHICS) {
+		// The cull reads the pyramid the previous frame built; the indirect commands and counts it
+		// writes are buffers, so their barriers are in GpuDrivenScene::recordCull
+		if (gpuDrivenActive) {
+			hizResource = frameGraph.importImage("hiz", gpuScene.getHiZImage(), VK_IMAGE_ASPECT_COLOR_BIT, hizState);
+			frameGraph.addPass("gpuCull", Queue::Graphics,
+				[&](RenderGraph::PassBuilder& pass) {
+					pass.read(hizResource, Usage::SampledCompute);
+					pass.setSideEffects();
+				},
+				[this](VkCommandBuffer cmd) { gpuScene.recordCull(cmd, currentFrame); });
+		}
+		frameGraph.addPass("main", Queue::Graphics,
+			[&](RenderGraph::PassBuilder& pass) {
+				if (shadow != RenderGraph::InvalidResource) {
+					pass.read(shadow, Usage::SampledFragment);
+				}
+				pass.write(backbuffer, Usage::ColorAttachment, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+				pass.write(depth, Usage::DepthAttachment);
+			},
+			[this, imageIndex, hasLoadedModels](VkCommandBuffer cmd) { recordMainPass(cmd, imageIndex, hasLoadedModels); });
+		if (gpuDrivenActive) {
+			frameGraph.addPass("hizBuild", Queue::Graphics,
+				[&](RenderGraph::PassBuilder& pass) {
+					pass.read(depth, Usage::SampledCompute);
+					pass.write(hizResource, Usage::StorageCompute);
+					pass.setSideEffects();
+				},
+				[this](VkCommandBuffer cmd) { gpuScene.recordHiZBuild(cmd); });
+		}
+		return backbuffer;
+	}
+
+	// Compute and ray tracing render into the output image, which is copied to the swapchain
+	// image and overlaid with the UI
+	RenderGraph::ResourceId output = frameGraph.importImage("computeOutput", computeOutputImage, VK_IMAGE_ASPECT_COLOR_BIT,
+		computeOutputState);
+	computeOutputResource = output;
+
+	bool asyncDispatch = currentRenderMode == RenderMode::COMPUTE && frameGraph.isAsyncComputeEnabled();
+	if (currentRenderMode == RenderMode::COMPUTE && !asyncDispatch) {
+		frameGraph.addPass("compute", Queue::Graphics,
+			[&](RenderGraph::PassBuilder& pass) { pass.write(output, Usage::StorageCompute); },
+			[this](VkCommandBuffer cmd) { recordComputeDispatch(cmd); });
+	}
+	else if (currentRenderMode == RenderMode::RAYTRACING) {
+		RenderGraph::ResourceId accumulation = frameGraph.importImage("accumulation", accumOutputImage, VK_IMAGE_ASPECT_COLOR_BIT,
+			{ VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_SHADER_WRITE_BIT });
+		if (clearAccumulation) {
+			frameGraph.addPass("accumulationClear", Queue::Graphics,
+				[&](RenderGraph::PassBuilder& pass) { pass.write(accumulation, Usage::TransferDst); },
+				[this](VkCommandBuffer cmd) { recordAccumulationClear(cmd); });
+		}
+		frameGraph.addPass("rayTrace", Queue::Graphics,
+			[&](RenderGraph::PassBuilder& pass) {
+				pass.readWrite(accumulation, Usage::StorageRayTracing);
+				pass.write(output, Usage::StorageRayTracing);
+			},
+			[this](VkCommandBuffer cmd) { recordRayTrace(cmd); });
+	}
+
+	frameGraph.addPass("outputCopy", Queue::Graphics,
+		[&](RenderGraph::PassBuilder& pass) {
+			pass.read(output, Usage::TransferSrc);
+			pass.write(backbuffer, Usage::TransferDst);
+		},
+		[this, imageIndex](VkCommandBuffer cmd) { recordOutputCopy(cmd, imageIndex); });
+
+	bool drawEmissive = currentRenderMode == RenderMode::RAYTRACING;
+	frameGraph.addPass("overlay", Queue::Graphics,
+		[&](RenderGraph::PassBuilder& pass) {
+			pass.readWrite(backbuffer, Usage::ColorAttachment, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+			pass.write(depth, Usage::DepthAttachment);
+		},
+		[this, imageIndex, drawEmissive](VkCommandBuffer cmd) { recordOverlayPass(cmd, imageIndex, drawEmissive); });
+
+	if (asyncDispatch) {
+		// Dispatched after the copy, on the compute queue; the next frame copies it out, so the
+		// dispatch runs alongside that frame's graphics work at the cost of a frame of latency
+		frameGraph.addPass("compute", Queue::AsyncCompute,
+			[&](RenderGraph::PassBuilder& pass) { pass.write(output, Usage::StorageCompute); },
+			[this](VkCommandBuffer cmd) { recordComputeDispatch(cmd); });
+		frameGraph.exportImage(output, Queue::Graphics);
+	}
+
+	return backbuffer;
+}
+
+void VulkanApplication::cullScene()
+{
+	MK_ZONE("frustumCull");
+	auto cullBegin = std::chrono::steady_clock::now();
+	objectCullOffsets.clear();
+	frustumCuller.clear();
+	cullVisibility = nullptr;
+	cullPrimitiveCount = 0;
+	cullObjectsCulled = 0;
+	occludersDrawn = 0;
+	occludedPrimitives = 0;
+	occludedObjects = 0;
+	if (!frustumCulling) {
+		for (const auto& obj : loadedObjects) {
+			cullPrimitiveCount += obj.loaded ? obj.model.primitiveCount : 0;
+		}
+		cullVisibleCount = cullPrimitiveCount;
+		cullMs = 0.0f;
+		return;
+	}
+
+	VkExtent2D extent = swapChain->getSwapChainExtent();
+	float aspect = static_cast<float>(extent.width) / static_cast<float>(extent.height);
+	glm::mat4 viewProj = camera->getProjectionMatrix(aspect) * camera->getViewMatrix();
+	Frustum frustum = Frustum::fromViewProjection(viewProj);
+
+	if (gpuDrivenActive) {
+		cullTransparent(frustum);
+	}
+	else if (bvhCulling) {
+		// The tree skips whole groups of boxes at once, so only the primitives near the frustum are tested
+		sceneBVH.queryFrustum(frustum, bvhQueryResults);
+		cullVisibleCount = markBVHResults(bvhQueryResults, bvhVisibility, objectCullOffsets);
+		cullVisibility = bvhVisibility.data();
+		for (size_t i = 0; i < loadedObjects.size(); i++) {
+			if (!loadedObjects[i].loaded) continue;
+			cullPrimitiveCount += loadedObjects[i].model.primitiveCount;
+			if (objectCullOffsets[i] == OBJECT_CULLED) {
+				cullObjectsCulled++;
+			}
+		}
+	}
+	else {
+		objectCullOffsets.resize(loadedObjects.size(), OBJECT_CULLED);
+		for (size_t i = 0; i < loadedObjects.size(); i++) {
+			const LoadedObject& obj = loadedObjects[i];
+			if (!obj.loaded) continue;
+			cullPrimitiveCount += obj.model.primitiveCount;
+
+			// Whole objects go first on their sphere, scaled by the largest axis of the transform
+			glm::mat4 model = obj.transform.getModelMatrix();
+			const Bounds& bounds = obj.model.bounds;
+			if (bounds.isValid()) {
+				float scale = std::max({ glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])),
+					glm::length(glm::vec3(model[2])) });
+				if (!frustum.intersectsSphere(glm::vec3(model * glm::vec4(bounds.center, 1.0f)), bounds.radius * scale)) {
+					cullObjectsCulled++;
+					continue;
+				}
+			}
+
+			// Queued mesh by mesh, so a primitive's box sits at the object's offset + Mesh::primitiveOffset
+			objectCullOffsets[i] = frustumCuller.getCount();
+			for (const auto& mesh : obj.model.meshes) {
+				for (const auto& primitive : mesh.primitives) {
+					frustumCuller.add(primitive.bounds, model);
+				}
+			}
+		}
+		frustumCuller.cull(frustum);
+		cullVisibility = frustumCuller.getVisibility(0);
+		cullVisibleCount = frustumCuller.getVisibleCount();
+	}
+	cullMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - cullBegin).count();
+
+	// The GPU cull pass has its own occlusion test against the depth pyramid, and the occluders
+	// are opaque, so there is nothing left for the CPU raster to do
+	if (occlusionCulling && !gpuDrivenActive) {
+		cullOccluded(viewProj);
+	}
+}
+
+void VulkanApplication::cullTransparent(const Frustum& frustum)
+{
+	objectCullOffsets.assign(loadedObjects.size(), OBJECT_CULLED);
+	transparentCullSlots.clear();
+	uint32_t total = 0;
+	for (size_t i = 0; i < loadedObjects.size(); i++) {
+		const LoadedObject& obj = loadedObjects[i];
+		if (!obj.loaded) continue;
+		cullPrimitiveCount += obj.model.primitiveCount;
+		if (obj.model.transparentMeshIndices.empty()) continue;
+
+		glm::mat4 model = obj.transform.getModelMatrix();
+		const Bounds& bounds = obj.model.bounds;
+		if (bounds.isValid()) {
+			float scale = std::max({ glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])),
+				glm::length(glm::vec3(model[2])) });
+			if (!frustum.intersectsSphere(glm::vec3(model * glm::vec4(bounds.center, 1.0f)), bounds.radius * scale)) {
+				cullObjectsCulled++;
+				continue;
+			}
+		}
+
+		objectCullOffsets[i] = total;
+		for (size_t meshIndex : obj.model.transparentMeshIndices) {
+			const Mesh& mesh = obj.model.meshes[meshIndex];
+			for (uint32_t p = 0; p < static_cast<uint32_t>(mesh.primitives.size()); p++) {
+				frustumCuller.add(mesh.primitives[p].bounds, model);
+				transparentCullSlots.push_back(total + mesh.primitiveOffset + p);
+			}
+		}
+		total += obj.model.primitiveCount;
+	}
+	frustumCuller.cull(frustum);
+
+	transparentVisibility.assign(total, 0);
+	const uint8_t* visibility = frustumCuller.getVisibility(0);
+	for (size_t k = 0; k < transparentCullSlots.size(); k++) {
+		transparentVisibility[transparentCullSlots[k]] = visibility[k];
+	}
+	cullVisibility = transparentVisibility.data();
+	cullVisibleCount = frustumCuller.getVisibleCount();
+}
+
+void VulkanApplication::selectOccluders()
+{
+	// Authored occluders first, then the largest primitives, until the triangle budget is spent
+	struct Scored {
+		OccluderCandidate candidate;
+		float radius;
+		uint32_t triangles;
+		bool authored;
+	};
+	std::vector<Scored> scored;
+	for (uint32_t i = 0; i < static_cast<uint32_t>(loadedObjects.size()); i++) {
+		const LoadedObject& obj = loadedObjects[i];
+		if (!obj.loaded || obj.occluder == OccluderMode::Never) continue;
+		bool authored = obj.occluder == OccluderMode::Always;
+		glm::mat4 model = obj.transform.getModelMatrix();
+		float scale = std::max({ glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])),
+			glm::length(glm::vec3(model[2])) });
+		for (size_t meshIndex : obj.model.opaqueMeshIndices) {
+			const Mesh& mesh = obj.model.meshes[meshIndex];
+			for (uint32_t p = 0; p < static_cast<uint32_t>(mesh.primitives.size()); p++) {
+				const Primitive& primitive = mesh.primitives[p];
+				float radius = primitive.bounds.radius * scale;
+				uint32_t triangles = primitive.indexCount / 3;
+				if (!authored && (radius < OCCLUDER_MIN_RADIUS || triangles > OCCLUDER_MAX_TRIANGLES)) continue;
+				scored.push_back({ { i, static_cast<uint32_t>(meshIndex), p }, radius, triangles, authored });
+			}
+		}
+	}
+	std::sort(scored.begin(), scored.end(), [](const Scored& a, const Scored& b) {
+		return a.authored != b.authored ? a.authored : a.radius > b.radius;
+	});
+
+	occluderCandidates.clear();
+	uint32_t triangleTotal = 0;
+	for (const auto& entry : scored) {
+		if (triangleTotal + entry.triangles > OCCLUDER_TRIANGLE_BUDGET) continue;
+		occluderCandidates.push_back(entry.candidate);
+		triangleTotal += entry.triangles;
+	}
+	std::cout << "Occluders: " << occluderCandidates.size() << " primitives, " << triangleTotal << " triangles" << std::endl;
+}
+
+void VulkanApplication::cullOccluded(const glm::mat4& viewProj)
+{
+	MK_ZONE("occlusionCull");
+	auto rasterBegin = std::chrono::steady_clock::now();
+	occlusionCuller.begin(viewProj);
+	// Only occluders that are themselves in view can hide anything
+	for (const auto& candidate : occluderCandidates) {
+		uint32_t offset = objectCullOffsets[candidate.objectIndex];
+		if (offset == OBJECT_CULLED) continue;
+		const LoadedObject& obj = loadedObjects[candidate.objectIndex];
+		const Mesh& mesh = obj.model.meshes[candidate.meshIndex];
+		if (!cullVisibility[offset + mesh.primitiveOffset + candidate.primitiveIndex]) continue;
+		occlusionCuller.addOccluder(obj.model, mesh.primitives[candidate.primitiveIndex], obj.transform.getModelMatrix());
+		occludersDrawn++;
+	}
+	occlusionCuller.rasterize();
+	auto testBegin = std::chrono::steady_clock::now();
+	occlusionRasterMs = std::chrono::duration<float, std::milli>(testBegin - rasterBegin).count();
+
+	// Primitives that survived the frustum are tested before their draws are recorded
+	for (size_t i = 0; i < loadedObjects.size(); i++) {
+		uint32_t offset = objectCullOffsets[i];
+		if (offset == OBJECT_CULLED) continue;
+		const LoadedObject& obj = loadedObjects[i];
+		glm::mat4 model = obj.transform.getModelMatrix();
+		bool anyVisible = false;
+		for (const auto& mesh : obj.model.meshes) {
+			for (size_t p = 0; p < mesh.primitives.size(); p++) {
+				uint8_t& visible = cullVisibility[offset + mesh.primitiveOffset + p];
+				if (!visible) continue;
+				if (occlusionCuller.isOccluded(Aabb::fromBounds(mesh.primitives[p].bounds, model))) {
+					visible = 0;
+					occludedPrimitives++;
+				}
+				else {
+					anyVisible = true;
+				}
+			}
+		}
+		if (!anyVisible) {
+			objectCullOffsets[i] = OBJECT_CULLED;
+			occludedObjects++;
+		}
+	}
+	cullVisibleCount -= occludedPrimitives;
+	occlusionTestMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - testBegin).count();
+}
+
+uint32_t VulkanApplication::markBVHResults(const std::vector<uint64_t>& results, std::vector<uint8_t>& visibility,
+	std::vector<uint32_t>& offsets) const
+{
+	// Objects get consecutive byte ranges in primitive order; objects with nothing marked are culled
+	offsets.assign(loadedObjects.size(), OBJECT_CULLED);
+	uint32_t total = 0;
+	for (size_t i = 0; i < loadedObjects.size(); i++) {
+		if (!loadedObjects[i].loaded) continue;
+		offsets[i] = total;
+		total += loadedObjects[i].model.primitiveCount;
+	}
+	visibility.assign(total, 0);
+	for (uint64_t userData : results) {
+		uint32_t objectIndex = static_cast<uint32_t>(userData >> 32);
+		visibility[offsets[objectIndex] + static_cast<uint32_t>(userData)] = 1;
+	}
+	for (size_t i = 0; i < loadedObjects.size(); i++) {
+		if (offsets[i] == OBJECT_CULLED) continue;
+		auto first = visibility.begin() + offsets[i];
+		if (std::find(first, first + loadedObjects[i].model.primitiveCount, 1) == first + loadedObjects[i].model.primitiveCount) {
+			offsets[i] = OBJECT_CULLED;
+		}
+	}
+	return static_cast<uint32_t>(results.size());
+}
+
+void VulkanApplication::rebuildSceneBVH()
+{
+	MK_ZONE("sceneBVHBuild");
+	std::vector<SceneBVH::Item> items;
+	for (size_t i = 0; i < loadedObjects.size(); i++) {
+		LoadedObject& obj = loadedObjects[i];
+		obj.bvhProxies.clear();
+		if (!obj.loaded) continue;
+		obj.bvhTransform = obj.transform.getModelMatrix();
+		for (const auto& mesh : obj.model.meshes) {
+			for (size_t p = 0; p < mesh.primitives.size(); p++) {
+				uint64_t userData = (static_cast<uint64_t>(i) << 32) | (mesh.primitiveOffset + p);
+				items.push_back({ Aabb::fromBounds(mesh.primitives[p].bounds, obj.bvhTransform), userData });
+			}
+		}
+	}
+
+	// Items went in object by object, so each object's proxies are one consecutive run
+	std::vector<uint32_t> proxies;
+	sceneBVH.build(items, proxies);
+	size_t next = 0;
+	for (auto& obj : loadedObjects) {
+		if (!obj.loaded) continue;
+		obj.bvhProxies.assign(proxies.begin() + next, proxies.begin() + next + obj.model.primitiveCount);
+		next += obj.model.primitiveCount;
+	}
+	std::cout << "Scene BVH: " << sceneBVH.getLeafCount() << " primitives, " << sceneBVH.getNodeCount()
+		<< " nodes, SAH cost " << sceneBVH.getSahCost() << std::endl;
+}
+
+void VulkanApplication::insertObjectIntoBVH(uint32_t objectIndex)
+{
+	LoadedObject& obj = loadedObjects[objectIndex];
+	obj.bvhTransform = obj.transform.getModelMatrix();
+	obj.bvhProxies.resize(obj.model.primitiveCount);
+	for (const auto& mesh : obj.model.meshes) {
+		for (size_t p = 0; p < mesh.primitives.size(); p++) {
+			uint64_t userData = (static_cast<uint64_t>(objectIndex) << 32) | (mesh.primitiveOffset + p);
+			obj.bvhProxies[mesh.primitiveOffset + p] =
+				sceneBVH.insert(Aabb::fromBounds(mesh.primitives[p].bounds, obj.bvhTransform), userData);
+		}
+	}
+}
+
+void VulkanApplication::removeObjectFromBVH(LoadedObject& obj)
+{
+	for (uint32_t proxy : obj.bvhProxies) {
+		sceneBVH.remove(proxy);
+	}
+	obj.bvhProxies.clear();
+}
+
+void VulkanApplication::syncSceneBVH()
+{
+	MK_ZONE("sceneBVHSync");
+	auto syncBegin = std::chrono::steady_clock::now();
+	bool moved = false;
+	for (uint32_t i = 0; i < static_cast<uint32_t>(loadedObjects.size()); i++) {
+		LoadedObject& obj = loadedObjects[i];
+		if (!obj.loaded) {
+			if (!obj.bvhProxies.empty()) {
+				removeObjectFromBVH(obj);
+			}
+			continue;
+		}
+		if (obj.bvhProxies.size() != obj.model.primitiveCount) {
+			insertObjectIntoBVH(i);
+			continue;
+		}
+
+		// Moved objects only mark their leaves; refit() then walks each changed branch once
+		glm::mat4 model = obj.transform.getModelMatrix();
+		if (model == obj.bvhTransform) continue;
+		obj.bvhTransform = model;
+		for (const auto& mesh : obj.model.meshes) {
+			for (size_t p = 0; p < mesh.primitives.size(); p++) {
+				sceneBVH.update(obj.bvhProxies[mesh.primitiveOffset + p], Aabb::fromBounds(mesh.primitives[p].bounds, model));
+			}
+		}
+		moved = true;
+	}
+
+	if (sceneBVH.needsRebuild()) {
+		rebuildSceneBVH();
+	}
+	else if (moved) {
+		sceneBVH.refit();
+	}
+	bvhSyncMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - syncBegin).count();
+}
+
+void VulkanApplication::pickObject(double cursorX, double cursorY)
 {
 	int width = 0, height = 0;
-	glfwGetFramebufferSize(window->getGLFWwindow(), &width, &height);
-	while (width == 0 || height == 0) {
-		glfwGetFramebufferSize(window->getGLFWwindow(), &width, &height);
-		glfwWaitEvents();
+	glfwGetWindowSize(window->getGLFWwindow(), &width, &height);
+	if (width <= 0 || height <= 0) return;
+
+	// Cursor to NDC; the projection already flips y, so window y maps straight onto it
+	VkExtent2D extent = swapChain->getSwapChainExtent();
+	float aspect = static_cast<float>(extent.width) / static_cast<float>(extent.height);
+	glm::mat4 invViewProj = glm::inverse(camera->getProjectionMatrix(aspect) * camera->getViewMatrix());
+	float ndcX = 2.0f * static_cast<float>(cursorX) / width - 1.0f;
+	float ndcY = 2.0f * static_cast<float>(cursorY) / height - 1.0f;
+	glm::vec4 nearPoint = invViewProj * glm::vec4(ndcX, ndcY, 0.0f, 1.0f);
+	glm::vec4 farPoint = invViewProj * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+	glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+	glm::vec3 rayEnd = glm::vec3(farPoint) / farPoint.w;
+	float maxDistance = glm::length(rayEnd - origin);
+	if (maxDistance <= 0.0f) return;
+	glm::vec3 direction = (rayEnd - origin) / maxDistance;
+
+	// Leaves are refined against the primitive's triangles, in model space so the CPU vertices
+	// need no transforming. The model-space direction is left unnormalised (its length changes
+	// under scale), so o + t * d maps back to origin + t * direction and t stays in world units
+	auto hitTest = [&](uint64_t userData, float maxT) -> float {
+		const LoadedObject& obj = loadedObjects[static_cast<uint32_t>(userData >> 32)];
+		uint32_t primitiveIndex = static_cast<uint32_t>(userData);
+		const Primitive* primitive = nullptr;
+		for (const auto& mesh : obj.model.meshes) {
+			if (primitiveIndex < mesh.primitiveOffset + mesh.primitives.size()) {
+				primitive = &mesh.primitives[primitiveIndex - mesh.primitiveOffset];
+				break;
+			}
+		}
+		if (!primitive || obj.model.vertices.empty()) return -1.0f;
+
+		glm::mat4 invModel = glm::inverse(obj.transform.getModelMatrix());
+		glm::vec3 o = glm::vec3(invModel * glm::vec4(origin, 1.0f));
+		glm::vec3 d = glm::vec3(invModel * glm::vec4(direction, 0.0f));
+		float best = -1.0f;
+		for (uint32_t i = 0; i + 2 < primitive->indexCount; i += 3) {
+			// Moller-Trumbore, both faces
+			const glm::vec3& v0 = obj.model.vertices[obj.model.indices[primitive->firstIndex + i]].pos;
+			const glm::vec3& v1 = obj.model.vertices[obj.model.indices[primitive->firstIndex + i + 1]].pos;
+			const glm::vec3& v2 = obj.model.vertices[obj.model.indices[primitive->firstIndex + i + 2]].pos;
+			glm::vec3 e1 = v1 - v0;
+			glm::vec3 e2 = v2 - v0;
+			glm::vec3 pvec = glm::cross(d, e2);
+			float det = glm::dot(e1, pvec);
+			if (std::abs(det) < 1e-12f) continue;
+			float invDet = 1.0f / det;
+			glm::vec3 tvec = o - v0;
+			float u = glm::dot(tvec, pvec) * invDet;
+			if (u < 0.0f || u > 1.0f) continue;
+			glm::vec3 qvec = glm::cross(tvec, e1);
+			float v = glm::dot(d, qvec) * invDet;
+			if (v < 0.0f || u + v > 1.0f) continue;
+			float t = glm::dot(e2, qvec) * invDet;
+			if (t >= 0.0f && t <= maxT && (best < 0.0f || t < best)) {
+				best = t;
+			}
+		}
+		return best;
+	};
+
+	uint64_t hitUserData = 0;
+	float hitDistance = 0.0f;
+	if (sceneBVH.raycast(origin, direction, maxDistance, hitTest, hitUserData, hitDistance)) {
+		selectedObjectIndex = static_cast<int>(hitUserData >> 32);
+		std::cout << "Picked object " << selectedObjectIndex << " (primitive " << static_cast<uint32_t>(hitUserData)
+			<< ") at " << hitDistance << " units" << std::endl;
 	}
+}
 
-	vkDeviceWaitIdle(device->getDevice());
+void VulkanApplication::buildDrawList(uint32_t drawCount, VkPipeline opaquePipe, VkPipeline transparentPipe, VkPipeline additivePipe)
+{
+	MK_ZONE("drawList");
+	auto buildBegin = std::chrono::steady_clock::now();
+	drawList.clear();
+
+	// Material ids number every object's material descriptor sets, object after object
+	uint32_t objectCount = static_cast<uint32_t>(loadedObjects.size());
+	std::vector<uint32_t> materialBases(objectCount);
+	std::vector<glm::mat4> modelMatrices(objectCount);
+	uint32_t materialCount = 0;
+	for (uint32_t i = 0; i < objectCount; i++) {
+		materialBases[i] = materialCount;
+		materialCount += static_cast<uint32_t>(loadedObjects[i].descriptorSets.size());
+		modelMatrices[i] = loadedObjects[i].transform.getModelMatrix();
+	}
 
-	// Cleanup old depth resources using TextureManager
-	if (depthImageView != VK_NULL_HANDLE) {
-		textureManager->destroyImageView(depthImageView);
-		depthImageView = VK_NULL_HANDLE;
+	// Objects are walked like the per-model path walks them, so the list can count that path's binds
+	for (uint32_t i = 0; i < drawCount; i++) {
+		uint32_t objectIndex = i % objectCount;
+		const LoadedObject& obj = loadedObjects[objectIndex];
+		if (!obj.loaded || obj.descriptorSets.empty()) continue;
+		if (gpuDrivenActive && obj.model.transparentMeshIndices.empty()) continue;
+		const uint8_t* visibility = nullptr;
+		if (!objectCullOffsets.empty()) {
+			if (objectCullOffsets[objectIndex] == OBJECT_CULLED) continue;
+			visibility = cullVisibility + objectCullOffsets[objectIndex];
+		}
+		VkBuffer vertexBuffer = resourcePool->getVkBuffer(obj.model.vertexBuffer);
+		VkBuffer indexBuffer = resourcePool->getVkBuffer(obj.model.indexBuffer);
+		if (vertexBuffer == VK_NULL_HANDLE || indexBuffer == VK_NULL_HANDLE) continue;
+
+		const Model& model = obj.model;
+		const glm::mat4& modelMatrix = modelMatrices[objectIndex];
+		auto isVisible = [visibility](const Mesh& mesh, size_t p) {
+			return !visibility || visibility[mesh.primitiveOffset + p] != 0;
+		};
+		auto materialOf = [](const Primitive& primitive) {
+			return static_cast<uint32_t>(primitive.materialIndex >= 0 ? primitive.materialIndex : 0);
+		};
+		// Materials without a descriptor set of their own use the object's first
+		auto add = [&](DrawList::Pass pass, VkPipeline pipeline, const Primitive& primitive) {
+			uint32_t setIndex = materialOf(primitive);
+			if (setIndex >= obj.descriptorSets.size()) {
+				setIndex = 0;
+			}
+			glm::vec3 center = glm::vec3(modelMatrix * glm::vec4(primitive.bounds.center, 1.0f));
+			drawList.add(pass, pipeline, materialBases[objectIndex] + setIndex, obj.descriptorSets[setIndex][currentFrame],
+				vertexBuffer, indexBuffer, primitive.firstIndex, primitive.indexCount, glm::distance(camera->position, center));
+		};
+
+		drawList.beginObject();
+		if (!gpuDrivenActive) {
+			for (size_t meshIndex : model.opaqueMeshIndices) {
+				const Mesh& mesh = model.meshes[meshIndex];
+				for (size_t p = 0; p < mesh.primitives.size(); p++) {
+					if (isVisible(mesh, p)) {
+						add(DrawList::Pass::Opaque, opaquePipe, mesh.primitives[p]);
+					}
+				}
+			}
+		}
+		// Transparent and emissive primitives without a material are skipped, as on the per-model path
+		for (int emissivePass = 0; emissivePass < 2; emissivePass++) {
+			VkPipeline pipeline = emissivePass ? additivePipe : transparentPipe;
+			if (pipeline == VK_NULL_HANDLE) continue;
+			DrawList::Pass pass = emissivePass ? DrawList::Pass::Additive : DrawList::Pass::Transparent;
+			for (size_t meshIndex : model.transparentMeshIndices) {
+				const Mesh& mesh = model.meshes[meshIndex];
+				for (size_t p = 0; p < mesh.primitives.size(); p++) {
+					uint32_t matIndex = materialOf(mesh.primitives[p]);
+					if (!isVisible(mesh, p) || matIndex >= model.materials.size() ||
+						model.materials[matIndex].isEmissive != (emissivePass != 0)) {
+						continue;
+					}
+					add(pass, pipeline, mesh.primitives[p]);
+				}
+			}
+		}
 	}
-	if (depthImage != VK_NULL_HANDLE) {
-		textureManager->destroyImage(depthImage, depthImageMemory);
-		depthImage = VK_NULL_HANDLE;
-		depthImageMemory = VK_NULL_HANDLE;
+
+	drawList.sort();
+	drawListBuildMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - buildBegin).count();
+}
+
+void VulkanApplication::recordMainPass(VkCommandBuffer commandBuffer, uint32_t imageIndex, bool hasLoadedModels)
+{
+	// Skybox, opaque, transparent and additive geometry and the UI share one render pass
+	if (hasLoadedModels) {
+		VkPipeline mainPipeline = graphicsPipeline->getGraphicsPipeline();
+		VkPipeline transparentPipe = transparentPipeline ? transparentPipeline->getGraphicsPipeline() : VK_NULL_HANDLE;
+		VkPipeline addPipeline = additivePipeline ? additivePipeline->getGraphicsPipeline() : VK_NULL_HANDLE;
+		VkFramebuffer framebuffer = swapChain->getSwapChainFramebuffers()[imageIndex];
+		VkExtent2D extent = swapChain->getSwapChainExtent();
+
+		VkCommandBufferInheritanceInfo inheritance{};
+		inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritance.renderPass = renderPass;
+		inheritance.subpass = 0;
+		inheritance.framebuffer = framebuffer;
+
+		commandBufferManager->beginModelRenderPass(commandBuffer, renderPass, framebuffer, extent);
+
+		// The primary may only execute secondaries inside this render pass, so the sub-pass
+		// timestamps are written from within the secondaries
+		if (skybox) {
+			uint32_t skyboxZone = gpuProfiler.reserveZone("skybox");
+			gpuProfiler.closeZone(skyboxZone);
+			drawRecorder.recordSecondary(inheritance, [&](VkCommandBuffer cmd) {
+				gpuProfiler.writeBegin(cmd, skyboxZone);
+				commandBufferManager->setViewportAndScissor(cmd, extent);
+				skybox->s_recordCommandBuffer(cmd, currentFrame);
+				gpuProfiler.writeEnd(cmd, skyboxZone);
+			});
+		}
+
+		// The GPU-driven opaque draws go before the CPU-recorded transparent ones
+		if (gpuDrivenActive) {
+			uint32_t gpuDrivenZone = gpuProfiler.reserveZone("gpuDriven");
+			gpuProfiler.closeZone(gpuDrivenZone);
+			drawRecorder.recordSecondary(inheritance, [&](VkCommandBuffer cmd) {
+				gpuProfiler.writeBegin(cmd, gpuDrivenZone);
+				commandBufferManager->setViewportAndScissor(cmd, extent);
+				gpuScene.recordDraws(cmd, currentFrame);
+				gpuProfiler.writeEnd(cmd, gpuDrivenZone);
+			});
+		}
+
+		// The draw list repeats the loaded objects syntheticDrawCopies times (stress testing);
+		// contiguous chunks keep each object's opaque/transparent/additive order intact. With draw
+		// sorting the chunks are ranges of the frame's sorted draws instead of objects.
+		uint32_t objectCount = static_cast<uint32_t>(loadedObjects.size());
+		uint32_t drawCount = objectCount * static_cast<uint32_t>(syntheticDrawCopies);
+		drawListBuildMs = 0.0f;
+		if (drawSorting) {
+			buildDrawList(drawCount, mainPipeline, transparentPipe, addPipeline);
+		}
+		uint32_t itemCount = drawSorting ? drawList.size() : drawCount;
+		if (itemCount > 0) {
+			// Opaque, transparent and additive draws interleave per object, so they share one zone
+			// from the start of the first chunk to the end of the last
+			uint32_t geometryZone = gpuProfiler.reserveZone("geometry");
+			gpuProfiler.closeZone(geometryZone);
+			drawRecorder.recordParallel(inheritance, itemCount, [&](VkCommandBuffer cmd, uint32_t first, uint32_t count) {
+				if (first == 0) {
+					gpuProfiler.writeBegin(cmd, geometryZone);
+				}
+				commandBufferManager->setViewportAndScissor(cmd, extent);
+				if (drawSorting) {
+					drawList.record(cmd, pipelineLayout, first, count);
+				}
+				else {
+					for (uint32_t i = first; i < first + count; i++) {
+						uint32_t objectIndex = i % objectCount;
+						const LoadedObject& obj = loadedObjects[objectIndex];
+						if (gpuDrivenActive && obj.model.transparentMeshIndices.empty()) continue;
+						const uint8_t* visibility = nullptr;
+						if (!objectCullOffsets.empty()) {
+							if (objectCullOffsets[objectIndex] == OBJECT_CULLED) continue;
+							visibility = cullVisibility + objectCullOffsets[objectIndex];
+						}
+						if (obj.loaded) {
+							commandBufferManager->recordModelDrawCommands(
+								cmd,
+								obj.model,
+								*resourcePool,
+								pipelineLayout,
+								mainPipeline,
+								transparentPipe,
+								addPipeline,
+								camera->position,
+								obj.descriptorSets,
+								currentFrame,
+								visibility,
+								!gpuDrivenActive);
+						}
+					}
+				}
+				if (first + count == itemCount) {
+					gpuProfiler.writeEnd(cmd, geometryZone);
+				}
+			});
+		}
+
+		uint32_t uiZone = gpuProfiler.reserveZone("ui");
+		gpuProfiler.closeZone(uiZone);
+		drawRecorder.recordSecondary(inheritance, [&](VkCommandBuffer cmd) {
+			gpuProfiler.writeBegin(cmd, uiZone);
+			uiManager->render(cmd);
+			gpuProfiler.writeEnd(cmd, uiZone);
+		});
+
+		drawRecorder.executeSecondaries(commandBuffer);
+		commandBufferManager->endModelRenderPass(commandBuffer);
+	}
+	else {
+		// Fallback to default quad rendering
+		commandBufferManager->recordCommandBuffer(
+			commandBuffer,
+			imageIndex,
+			renderPass,
+			swapChain->getSwapChainFramebuffers()[imageIndex],
+			swapChain->getSwapChainExtent(),
+			graphicsPipeline->getGraphicsPipeline(),
+			pipelineLayout,
+			vertexBuffer,
+			indexBuffer,
+			descriptorSets,
+			currentFrame,
+			indexCount,
+			*uiManager
+		);
 	}
+}
 
-	// Cleanup old compute output image
-	if (computeOutputImageView != VK_NULL_HANDLE) {
-		vkDestroyImageView(device->getDevice(), computeOutputImageView, nullptr);
-		computeOutputImageView = VK_NULL_HANDLE;
+void VulkanApplication::updateGpuScene(bool hasLoadedModels)
+{
+	gpuDrivenActive = false;
+	if (!device->supportsGpuDrivenRendering()) {
+		return;
 	}
-	if (computeOutputImage != VK_NULL_HANDLE) {
-		vkDestroyImage(device->getDevice(), computeOutputImage, nullptr);
-		computeOutputImage = VK_NULL_HANDLE;
+
+	MK_ZONE("gpuSceneUpdate");
+	auto updateBegin = std::chrono::steady_clock::now();
+	// Copies have their own instances, groups and transform slots, so a new count needs a rebuild
+	uint32_t copies = static_cast<uint32_t>(syntheticDrawCopies);
+	if (gpuDrivenRendering && (gpuSceneDirty || (gpuScene.getInstanceCount() > 0 && gpuScene.getCopies() != copies))) {
+		gpuScene.build(loadedObjects, *resourcePool, copies, m_retireQueue);
+		gpuSceneDirty = false;
 	}
-	if (computeOutputImageMemory != VK_NULL_HANDLE) {
-		vkFreeMemory(device->getDevice(), computeOutputImageMemory, nullptr);
-		computeOutputImageMemory = VK_NULL_HANDLE;
+
+	gpuDrivenActive = gpuDrivenRendering && hasLoadedModels && currentRenderMode == RenderMode::GRAPHICS && gpuScene.isReady();
+	if (gpuDrivenActive) {
+		VkExtent2D extent = swapChain->getSwapChainExtent();
+		float aspect = static_cast<float>(extent.width) / static_cast<float>(extent.height);
+		glm::mat4 viewProj = camera->getProjectionMatrix(aspect) * camera->getViewMatrix();
+		gpuScene.update(currentFrame, loadedObjects, viewProj, hizOcclusion);
 	}
+	gpuSceneUpdateMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - updateBegin).count();
+}
 
-	cleanupAccumulationResources();
+PerfSweeps::Settings VulkanApplication::getSweepSettings() const
+{
+	PerfSweeps::Settings settings;
+	settings.recordThreads = recordThreads;
+	settings.drawCopies = syntheticDrawCopies;
+	settings.gpuDriven = gpuDrivenRendering;
+	return settings;
+}
 
-	// Cleanup old per-image semaphores
-	for (size_t i = 0; i < renderFinishedSemaphores.size(); i++) {
-		vkDestroySemaphore(device->getDevice(), renderFinishedSemaphores[i], nullptr);
+void VulkanApplication::applySweepSettings(const PerfSweeps::Settings& settings)
+{
+	recordThreads = settings.recordThreads;
+	syntheticDrawCopies = settings.drawCopies;
+	gpuDrivenRendering = settings.gpuDriven;
+}
+
+void VulkanApplication::recreateSwapChain()
+{
+	// Offscreen images keep the size they were created with
+	if (headless) {
+		return;
 	}
 
-	// Cleanup old graphics pipeline
-	graphicsPipeline.reset();
-	transparentPipeline.reset();
-	additivePipeline.reset();
+	int width = 0, height = 0;
+	glfwGetFramebufferSize(window->getGLFWwindow(), &width, &height);
+	while (width == 0 || height == 0) {
+		glfwGetFramebufferSize(window->getGLFWwindow(), &width, &height);
+		glfwWaitEvents();
+	}
+
+	// No device idle: everything a frame in flight may still use is retired and destroyed once
+	// the frames submitted so far have completed. The pipelines survive as they are, since
+	// viewport and scissor are dynamic state and the render pass is kept.
+	auto resizeBegin = std::chrono::steady_clock::now();
+	VkDevice vkDev = device->getDevice();
 
-	// Cleanup old swap chain
-	swapChain->cleanup();
+	m_retireQueue.retireImage(vkDev, depthImage, depthImageMemory, depthImageView);
+	depthImage = VK_NULL_HANDLE;
+	depthImageMemory = VK_NULL_HANDLE;
+	depthImageView = VK_NULL_HANDLE;
 
-	// Recreate swap chain and dependent objects
-	swapChain->initSwap(*device, window->getSurface(), window->getGLFWwindow());
+	// Pending presents of the old images still wait on these, and the frame timeline says
+	// nothing about presents; drawFrame retires them after the next successful acquire
+	replacedPresentSemaphores.insert(replacedPresentSemaphores.end(),
+		renderFinishedSemaphores.begin(), renderFinishedSemaphores.end());
+	renderFinishedSemaphores.clear();
+
+	swapChain->recreate(m_retireQueue);
 	swapChain->createImageViews();
 
 	VkExtent2D swapExtent = swapChain->getSwapChainExtent();
 	textureManager->createdepthResources(depthImage, depthImageMemory, depthImageView, swapExtent.width, swapExtent.height);
 	swapChain->createFramebuffers(renderPass, depthImageView);
-
-	// Recreate graphics pipeline
-	createGraphicsPipeline();
-
-	// Recreate compute output image
-	createComputeOutputImage();
-	createAccumulationImage();
-	createRayTracingDescriptorSet();
-
-	// IMPORTANT: Update compute pipeline descriptor sets with new image view
-	if (computePipeline) {
-		computePipeline->resetDesciriptorPool(device.get());
-		computePipeline->createDescriptorSets(device.get(), computeOutputImageView);
+	if (device->supportsGpuDrivenRendering()) {
+		gpuScene.resize(depthImageView, swapExtent, m_retireQueue);
+		hizState = RenderGraph::ImageState{};
 	}
 
+	// The compute/ray tracing targets are released here and reallocated by the next frame's
+	// syncRenderTargets, only if the current mode uses them
+	renderTargets->setExtent(swapExtent);
+
 	// Recreate per-image semaphores for new swapchain
 	size_t imageCount = swapChain->getSwapChainImages().size();
 	renderFinishedSemaphores.resize(imageCount);
-	imagesInFlight.resize(imageCount, VK_NULL_HANDLE);
+	imageTimelineValues.assign(imageCount, 0);
 	swapChainImageLayouts.assign(imageCount, VK_IMAGE_LAYOUT_UNDEFINED);
 
 	VkSemaphoreCreateInfo semaphoreInfo{};
 	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
 	for (size_t i = 0; i < imageCount; i++) {
-		if (vkCreateSemaphore(device->getDevice(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS) {
+		if (vkCreateSemaphore(vkDev, &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS) {
 			throw std::runtime_error("failed to recreate per-image semaphores!");
 		}
 	}
+
+	// Reported once the drag settles
+	perfSweeps.recordResize(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - resizeBegin).count());
 }
 
 void VulkanApplication::SetupUIManager()
@@ -1022,32 +2100,47 @@ void VulkanApplication::SetupUIManager()
 	renderData.descriptorPool = descriptorBoss->getDescriptorPool();
 	renderData.imageCount = static_cast<uint32_t>(swapChain->getSwapChainImages().size());
 	renderData.minImageCount = 2; // Typical minimum
+	renderData.displayExtent = swapChain->getSwapChainExtent();
 	uiManager->init(renderData, window.get());
 }
 
 void VulkanApplication::mainLoop()
 {
-	while (!glfwWindowShouldClose(window->getGLFWwindow())) {
-		float currentFrame = static_cast<float>(glfwGetTime());
+	CpuProfiler::get().setThreadName("Main");
+	while (headless || !glfwWindowShouldClose(window->getGLFWwindow())) {
+		if (maxFrames != 0 && m_frameCount >= maxFrames) {
+			break;
+		}
+		CpuProfiler::get().markFrame(m_frameCount);
+		MK_ZONE("frame");
+		{
+			MK_ZONE("limiterWait");
+			frameLimiter.wait();
+		}
+		uint32_t frameIndex = m_frameCount;
+		auto frameStart = std::chrono::steady_clock::now();
+
+		float currentFrame = static_cast<float>(secondsSinceStart());
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
+		// Benchmark frames advance by the script's timestep whatever the wall clock says
+		if (benchmark.isActive()) {
+			deltaTime = benchmark.getTimestep();
+			simulatedTime = benchmark.getFrameTime(frameIndex);
+		}
+		else if (fixedTimestep) {
+			deltaTime = HEADLESS_TIMESTEP;
+			simulatedTime = frameIndex * static_cast<double>(HEADLESS_TIMESTEP);
+		}
 
-		glfwPollEvents();
-		processInput();
-
-		if (physicsEngine) {
-			static float accumulator = 0.0f;
-			const float fixedDt = 1.0f / 60.0f;
-			accumulator += deltaTime;
-			if (accumulator > 0.1f) accumulator = 0.1f;
-			while (accumulator >= fixedDt) {
-				physicsEngine->step(fixedDt);
-				accumulator -= fixedDt;
-			}
-			syncPhysicsTransforms();
-			// physicsEngine->drawDebug();
+		// In just-in-time mode drawFrame samples input after the frame-slot and image waits;
+		// the UI then sees last frame's events, which is fine for debug widgets
+		if (!justInTimeInput) {
+			sampleInput();
 		}
 
+		// Closed right before drawFrame
+		std::optional<CpuZone> uiZone(std::in_place, "buildUI");
 		uiManager->newFrame();
 		float fps = 1.0f / deltaTime;
 		uiManager->renderDebugWindow(fps, deltaTime);
@@ -1086,6 +2179,73 @@ void VulkanApplication::mainLoop()
 				accumulationFrameCount = 0;
 			}
 		}
+		uiManager->renderMemoryStats(
+			renderTargets->getResidentBytes(),
+			renderTargets->getUnaliasedBytes(),
+			resourcePool->getBufferCount(),
+			resourcePool->getTextureCount(),
+			MemoryStats::getPeakResidentBytes());
+		uiManager->renderGpuResources(GpuResourceRegistry::get());
+		uiManager->renderGpuProfiler(gpuProfiler);
+		uiManager->renderCpuProfiler(CpuProfiler::get(), gpuProfiler);
+		const FramePacer::FrameTimings& pacing = framePacer.getTimings();
+		uiManager->renderFramePacing(framesInFlight, MAX_FRAMES_IN_FLIGHT, pacing.cpuWaitMs, pacing.gpuBusyMs);
+		// A typed-in slider value can leave the range
+		framesInFlight = std::clamp(framesInFlight, 1, MAX_FRAMES_IN_FLIGHT);
+		framePacer.setFramesInFlight(static_cast<uint32_t>(framesInFlight));
+		uiManager->renderAsyncCompute(device->hasAsyncCompute(), asyncCompute,
+			pacing.gpuBusyMs, pacing.computeBusyMs, pacing.asyncOverlapMs);
+		frameGraph.setAsyncComputeEnabled(asyncCompute);
+		// Counts from the last compiled frame
+		const RenderGraph::Stats& graphStats = frameGraph.getStats();
+		uiManager->renderRenderGraphStats(graphStats.passCount, graphStats.culledPasses, graphStats.barrierCount,
+			graphStats.transientImages, graphStats.physicalImages);
+		uiManager->renderCullingStats(frustumCulling, bvhCulling, cullPrimitiveCount, cullVisibleCount, cullObjectsCulled,
+			static_cast<uint32_t>(loadedObjects.size()), cullMs, shadowCasterCount, shadowCastersDrawn, bvhSyncMs);
+		uiManager->renderOcclusionStats(occlusionCulling, static_cast<uint32_t>(occluderCandidates.size()), occludersDrawn,
+			occlusionCuller.getTriangleCount(), occludedPrimitives, occludedObjects, occlusionRasterMs, occlusionTestMs);
+		bool startRecordSweep = false;
+		uiManager->renderDrawRecording(recordThreads, static_cast<int>(drawRecorder.getMaxThreadCount()),
+			syntheticDrawCopies, static_cast<uint32_t>(loadedObjects.size()) * static_cast<uint32_t>(syntheticDrawCopies),
+			drawRecorder.getRecordMs(), perfSweeps.isRecordSweepRunning(), perfSweeps.getRecordResults(), startRecordSweep);
+		if (startRecordSweep) {
+			PerfSweeps::Settings settings = getSweepSettings();
+			perfSweeps.startRecordSweep(drawRecorder.getMaxThreadCount(), settings);
+			applySweepSettings(settings);
+		}
+		drawRecorder.setThreadCount(static_cast<uint32_t>(recordThreads));
+		{
+			DrawList::BindCounts modelBinds = drawList.getModelCounts();
+			DrawList::BindCounts sortedBinds = drawList.getSortedCounts();
+			uiManager->renderDrawSorting(drawSorting, sortedBinds.draws, drawListBuildMs,
+				modelBinds.pipelines, modelBinds.descriptorSets, modelBinds.vertexBuffers,
+				sortedBinds.pipelines, sortedBinds.descriptorSets, sortedBinds.vertexBuffers);
+		}
+		bool startScalingSweep = false;
+		uiManager->renderGpuDriven(device->supportsGpuDrivenRendering(), gpuDrivenRendering, hizOcclusion,
+			gpuScene.isHiZActive(), gpuScene.getInstanceCount(), gpuScene.getGroupCount(), gpuSceneUpdateMs,
+			perfSweeps.isScalingSweepRunning(), perfSweeps.getScalingResults(), startScalingSweep);
+		if (startScalingSweep) {
+			PerfSweeps::Settings settings = getSweepSettings();
+			perfSweeps.startScalingSweep(static_cast<uint32_t>(loadedObjects.size()), settings);
+			applySweepSettings(settings);
+		}
+		{
+			int presentModeIndex = 0;
+			for (size_t i = 0; i < std::size(PRESENT_MODE_OPTIONS); i++) {
+				if (PRESENT_MODE_OPTIONS[i] == swapChain->getPresentMode()) {
+					presentModeIndex = static_cast<int>(i);
+				}
+			}
+			int selectedPresentMode = presentModeIndex;
+			uiManager->renderPresentSettings(selectedPresentMode, presentModeSupported, targetFps, justInTimeInput,
+				pacing.inputLatencyMs, frameLimiter.getWaitMs());
+			frameLimiter.setTargetFps(targetFps);
+			if (selectedPresentMode != presentModeIndex) {
+				swapChain->setPreferredPresentMode(PRESENT_MODE_OPTIONS[selectedPresentMode]);
+				recreateSwapChain();
+			}
+		}
 		bool loadSceneFlag = false;
 		uiManager->renderSceneLoader(
 			loadSceneFlag,
@@ -1134,6 +2294,13 @@ void VulkanApplication::mainLoop()
 		std::vector<glm::vec3> physPositions;
 		std::vector<float> physSpeeds, physRPMs;
 		std::vector<int> physGears;
+		std::vector<const SimBodyState*> objectSimStates(loadedObjects.size(), nullptr);
+		if (simulation.isRunning()) {
+			const auto& simBodies = simulation.getBodies();
+			for (size_t i = 0; i < simBodies.size() && i < simStates.size(); i++) {
+				objectSimStates[simBodies[i].objectIndex] = &simStates[i];
+			}
+		}
 		for (auto& obj : loadedObjects) {
 			if (!obj.loaded) continue;
 			std::string name = "Unnamed";
@@ -1143,10 +2310,11 @@ void VulkanApplication::mainLoop()
 			}
 			physNames.push_back(name);
 			physPositions.push_back(obj.transform.position);
-			if (obj.vehicle) {
-				physSpeeds.push_back(obj.vehicle->getSpeed());
-				physRPMs.push_back(obj.vehicle->getRPM());
-				physGears.push_back(obj.vehicle->getCurrentGear());
+			const SimBodyState* simState = objectSimStates[&obj - loadedObjects.data()];
+			if (obj.vehicle && simState) {
+				physSpeeds.push_back(simState->speed);
+				physRPMs.push_back(simState->rpm);
+				physGears.push_back(simState->gear);
 			} else {
 				physSpeeds.push_back(0.0f);
 				physRPMs.push_back(0.0f);
@@ -1157,16 +2325,69 @@ void VulkanApplication::mainLoop()
 				physicsEngine ? 1 : 0,
 				physNames, physPositions, physSpeeds, physRPMs, physGears);
 		}
+		uiZone.reset();
 		drawFrame();
+
+		// The sweeps see the finished frame and may change the settings of the next one
+		{
+			PerfSweeps::FrameStats sweepStats;
+			sweepStats.frameMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+			sweepStats.recordMs = drawRecorder.getRecordMs();
+			sweepStats.cullMs = cullMs + occlusionRasterMs + occlusionTestMs;
+			sweepStats.sceneUpdateMs = gpuSceneUpdateMs;
+			sweepStats.drawListMs = drawListBuildMs;
+			sweepStats.objectDraws = static_cast<uint32_t>(loadedObjects.size()) * static_cast<uint32_t>(syntheticDrawCopies);
+			sweepStats.drawGroups = gpuScene.getGroupCount();
+			sweepStats.extent = swapChain->getSwapChainExtent();
+			PerfSweeps::Settings settings = getSweepSettings();
+			perfSweeps.endFrame(sweepStats, settings);
+			applySweepSettings(settings);
+		}
+
+		if (frameIndex == 0 && m_frameCount == 1) {
+			float firstFrameMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - initBegin).count();
+			std::cout << "Time to first frame: " << firstFrameMs << " ms" << std::endl;
+			benchmark.recordFirstFrame(firstFrameMs);
+			if (prewarmModes) {
+				prewarmModePipelines();
+			}
+		}
+
+		// Frames dropped for a swapchain recreation are retried and not counted
+		if (benchmark.isActive() && benchmark.isMeasured(frameIndex) && m_frameCount != frameIndex) {
+			const FramePacer::FrameTimings& timings = framePacer.getTimings();
+			Benchmark::FrameSample sample;
+			sample.frameMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+			sample.cpuMs = std::max(sample.frameMs - timings.cpuWaitMs, 0.0f);
+			sample.gpuMs = timings.gpuBusyMs;
+			benchmark.recordFrame(sample);
+			benchmark.recordMemory(MemoryStats::getPeakResidentBytes(), GpuResourceRegistry::get().getTotals().bytes);
+		}
 	}
 
 	vkDeviceWaitIdle(device->getDevice());
+	writeReadback();
+	if (benchmark.isActive()) {
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(device->getPhysicalDevice(), &properties);
+		benchmark.writeReport(properties.deviceName);
+	}
 }
 
 void VulkanApplication::cleanup()
 {
+	// A prewarm compile may still be running
+	for (auto& job : pipelineJobs) {
+		job.wait();
+	}
+	pipelineJobs.clear();
+	// Pipelines created during the run (mode switches, scene loads) are in it by now
+	device->getPipelineCache().save();
+
 	// Discard DeletionQueue entries (manual cleanup handles destruction in correct order)
 	m_deletionQueue.clear();
+	// The device is idle (see mainLoop); retired descriptor sets are freed before their pools go
+	m_retireQueue.flush();
 
 	// Cleanup in reverse order of creation
 	cleanupComputeResources();
@@ -1176,10 +2397,10 @@ void VulkanApplication::cleanup()
 		if (imageAvailableSemaphores[i] != VK_NULL_HANDLE) {
 			vkDestroySemaphore(device->getDevice(), imageAvailableSemaphores[i], nullptr);
 		}
-		if (inFlightFences[i] != VK_NULL_HANDLE) {
-			vkDestroyFence(device->getDevice(), inFlightFences[i], nullptr);
-		}
 	}
+	framePacer.cleanup();
+	gpuProfiler.cleanup();
+	cleanupAsyncComputeResources();
 
 	// Cleanup per-image synchronization objects
 	for (size_t i = 0; i < renderFinishedSemaphores.size(); i++) {
@@ -1187,26 +2408,43 @@ void VulkanApplication::cleanup()
 			vkDestroySemaphore(device->getDevice(), renderFinishedSemaphores[i], nullptr);
 		}
 	}
+	for (VkSemaphore semaphore : replacedPresentSemaphores) {
+		vkDestroySemaphore(device->getDevice(), semaphore, nullptr);
+	}
+	replacedPresentSemaphores.clear();
 
 	// Cleanup uniform buffers (manually managed vectors)
 	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
 		if (uniformBuffers[i] != VK_NULL_HANDLE) {
-			vkDestroyBuffer(device->getDevice(), uniformBuffers[i], nullptr);
+			GpuResourceRegistry::destroy(device->getDevice(), uniformBuffers[i], nullptr);
 		}
 		if (uniformBuffersMemory[i] != VK_NULL_HANDLE) {
 			vkFreeMemory(device->getDevice(), uniformBuffersMemory[i], nullptr);
 		}
 	}
+	if (readbackBuffer != VK_NULL_HANDLE) {
+		GpuResourceRegistry::destroy(device->getDevice(), readbackBuffer, nullptr);
+		vkFreeMemory(device->getDevice(), readbackMemory, nullptr);
+		readbackBuffer = VK_NULL_HANDLE;
+		readbackMemory = VK_NULL_HANDLE;
+	}
 
 	vkDeviceWaitIdle(device->getDevice());
 	destroyAllLoadedObjects();
+	gpuScene.cleanup(m_retireQueue);
+	frameGraph.cleanup();
+	drawRecorder.cleanup();
+	occlusionCuller.cleanup();
+	m_retireQueue.flush();
+	resourcePool->cleanup();
+	simulation.stop();
 	if (physicsEngine) {
 		physicsEngine->shutdown();
 		physicsEngine.reset();
 	}
 	for (size_t i = 0; i < defaultMaterialUniformBuffers.size(); i++) {
 		if (defaultMaterialUniformBuffers[i] != VK_NULL_HANDLE) {
-			vkDestroyBuffer(device->getDevice(), defaultMaterialUniformBuffers[i], nullptr);
+			GpuResourceRegistry::destroy(device->getDevice(), defaultMaterialUniformBuffers[i], nullptr);
 		}
 		if (i < defaultMaterialUniformBuffersMemory.size() &&
 			defaultMaterialUniformBuffersMemory[i] != VK_NULL_HANDLE) {
@@ -1235,13 +2473,13 @@ void VulkanApplication::cleanup()
 
 	// Cleanup vertex/index buffers (fallback quad)
 	if (indexBuffer != VK_NULL_HANDLE) {
-		vkDestroyBuffer(device->getDevice(), indexBuffer, nullptr);
+		GpuResourceRegistry::destroy(device->getDevice(), indexBuffer, nullptr);
 	}
 	if (indexBufferMemory != VK_NULL_HANDLE) {
 		vkFreeMemory(device->getDevice(), indexBufferMemory, nullptr);
 	}
 	if (vertexBuffer != VK_NULL_HANDLE) {
-		vkDestroyBuffer(device->getDevice(), vertexBuffer, nullptr);
+		GpuResourceRegistry::destroy(device->getDevice(), vertexBuffer, nullptr);
 	}
 	if (vertexBufferMemory != VK_NULL_HANDLE) {
 		vkFreeMemory(device->getDevice(), vertexBufferMemory, nullptr);
@@ -1255,17 +2493,17 @@ void VulkanApplication::cleanup()
 		vkDestroyDescriptorSetLayout(device->getDevice(), taaDescriptorSetLayout, nullptr);
 	}
 	if (taaDescriptorPool != VK_NULL_HANDLE) {
-		vkDestroyDescriptorPool(device->getDevice(), taaDescriptorPool, nullptr);
+		GpuResourceRegistry::destroy(device->getDevice(), taaDescriptorPool, nullptr);
 	}
 	if (taaPipeline != VK_NULL_HANDLE) {
-		vkDestroyPipeline(device->getDevice(), taaPipeline, nullptr);
+		GpuResourceRegistry::destroy(device->getDevice(), taaPipeline, nullptr);
 	}
 
 	// Destroy managers in correct dependency order
 	descriptorBoss.reset();
 
 	if (rayTracingUniformBuffer != VK_NULL_HANDLE) {
-		vkDestroyBuffer(device->getDevice(), rayTracingUniformBuffer, nullptr);
+		GpuResourceRegistry::destroy(device->getDevice(), rayTracingUniformBuffer, nullptr);
 		rayTracingUniformBuffer = VK_NULL_HANDLE;
 	}
 	if (rayTracingUniformBufferMemory != VK_NULL_HANDLE) {
@@ -1274,7 +2512,7 @@ void VulkanApplication::cleanup()
 	}
 	rayTracingUniformBufferMapped = nullptr;
 	if (rayTracingDescriptorPool != VK_NULL_HANDLE) {
-		vkDestroyDescriptorPool(device->getDevice(), rayTracingDescriptorPool, nullptr);
+		GpuResourceRegistry::destroy(device->getDevice(), rayTracingDescriptorPool, nullptr);
 		rayTracingDescriptorPool = VK_NULL_HANDLE;
 	}
 	if (rayTracingDescriptorSetLayout != VK_NULL_HANDLE) {
@@ -1337,66 +2575,13 @@ glm::mat4 VulkanApplication::computeDirectionalLightSpaceMatrix(const Light& lig
     return lightProj * lightView;
 }
 
-void VulkanApplication::recordShadowPass()
+void VulkanApplication::recordShadowPass(VkCommandBuffer cmd)
 {
-    if (!shadowMap) return;
-
-    // Find first enabled directional light
-    const Light* dirLight = nullptr;
-    for (const auto& light : lights) {
-        if (light.enabled && light.type == LightType::Directional) {
-            dirLight = &light;
-            break;
-        }
-    }
-    if (!dirLight) return;
+    const Light* dirLight = findShadowLight();
+    if (!shadowMap || !dirLight) return;
 
     glm::mat4 lightSpaceMatrix = computeDirectionalLightSpaceMatrix(*dirLight, *camera);
 
-    VkCommandBuffer cmd = commandBufferManager->beginSingleTimeCommands();
-
-    // Transition shadow images to proper rendering layouts
-    VkImageMemoryBarrier shadowColorBarrier{};
-    shadowColorBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    shadowColorBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    shadowColorBarrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-    shadowColorBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    shadowColorBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    shadowColorBarrier.image = shadowMap->getShadowImage();
-    shadowColorBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    shadowColorBarrier.subresourceRange.baseMipLevel = 0;
-    shadowColorBarrier.subresourceRange.levelCount = 1;
-    shadowColorBarrier.subresourceRange.baseArrayLayer = 0;
-    shadowColorBarrier.subresourceRange.layerCount = 1;
-    shadowColorBarrier.srcAccessMask = 0;
-    shadowColorBarrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-    VkImageMemoryBarrier shadowDepthBarrier{};
-    shadowDepthBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    shadowDepthBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    shadowDepthBarrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-    shadowDepthBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    shadowDepthBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    shadowDepthBarrier.image = shadowMap->getDepthImage();
-    shadowDepthBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-    shadowDepthBarrier.subresourceRange.baseMipLevel = 0;
-    shadowDepthBarrier.subresourceRange.levelCount = 1;
-    shadowDepthBarrier.subresourceRange.baseArrayLayer = 0;
-    shadowDepthBarrier.subresourceRange.layerCount = 1;
-    shadowDepthBarrier.srcAccessMask = 0;
-    shadowDepthBarrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-
-    VkImageMemoryBarrier barriers[] = { shadowColorBarrier, shadowDepthBarrier };
-    vkCmdPipelineBarrier(
-        cmd,
-        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
-        0,
-        0, nullptr,
-        0, nullptr,
-        2, barriers
-    );
-
     // Begin shadow render pass
     VkRenderPassBeginInfo rpInfo{};
     rpInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -1433,29 +2618,57 @@ void VulkanApplication::recordShadowPass()
     // Set depth bias (dynamic state) to match the pipeline's configured values
     vkCmdSetDepthBias(cmd, 1.25f, 0.0f, 1.75f);
 
-    // Push light-space matrix via push constant
-    vkCmdPushConstants(cmd, shadowMap->getPipelineLayout(),
-        VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &lightSpaceMatrix);
+    // Casters outside the light's frustum would be clipped anyway; the BVH drops them up front
+    bool cullCasters = bvhCulling && sceneBVH.getLeafCount() > 0;
+    if (cullCasters) {
+        sceneBVH.queryFrustum(Frustum::fromViewProjection(lightSpaceMatrix), shadowQueryResults);
+        markBVHResults(shadowQueryResults, shadowVisibility, shadowCullOffsets);
+    }
+    shadowCasterCount = 0;
+    shadowCastersDrawn = 0;
 
-    // Draw geometry into shadow map
+    // Draw geometry into shadow map; the push constant carries light space * model per object
     bool drewAnyModel = false;
-    for (const auto& obj : loadedObjects) {
-        if (obj.loaded && obj.model.vertexBuffer != VK_NULL_HANDLE) {
-            VkBuffer vertexBuffers[] = { obj.model.vertexBuffer };
+    for (size_t objectIndex = 0; objectIndex < loadedObjects.size(); objectIndex++) {
+        const LoadedObject& obj = loadedObjects[objectIndex];
+        VkBuffer modelVertexBuffer = obj.loaded ? resourcePool->getVkBuffer(obj.model.vertexBuffer) : VK_NULL_HANDLE;
+        if (modelVertexBuffer != VK_NULL_HANDLE) {
+            drewAnyModel = true;
+            const uint8_t* visibility = nullptr;
+            if (cullCasters) {
+                for (const auto& meshIndex : obj.model.opaqueMeshIndices) {
+                    shadowCasterCount += static_cast<uint32_t>(obj.model.meshes[meshIndex].primitives.size());
+                }
+                if (shadowCullOffsets[objectIndex] == OBJECT_CULLED) continue;
+                visibility = shadowVisibility.data() + shadowCullOffsets[objectIndex];
+            }
+
+            glm::mat4 lightModelMatrix = lightSpaceMatrix * obj.transform.getModelMatrix();
+            vkCmdPushConstants(cmd, shadowMap->getPipelineLayout(),
+                VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &lightModelMatrix);
+
+            VkBuffer vertexBuffers[] = { modelVertexBuffer };
             VkDeviceSize offsets[] = { 0 };
             vkCmdBindVertexBuffers(cmd, 0, 1, vertexBuffers, offsets);
-            vkCmdBindIndexBuffer(cmd, obj.model.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+            vkCmdBindIndexBuffer(cmd, resourcePool->getVkBuffer(obj.model.indexBuffer), 0, VK_INDEX_TYPE_UINT32);
 
             for (const auto& meshIndex : obj.model.opaqueMeshIndices) {
                 const auto& meshRef = obj.model.meshes[meshIndex];
-                for (const auto& primitive : meshRef.primitives) {
+                for (size_t p = 0; p < meshRef.primitives.size(); p++) {
+                    if (visibility && !visibility[meshRef.primitiveOffset + p]) continue;
+                    const auto& primitive = meshRef.primitives[p];
                     vkCmdDrawIndexed(cmd, primitive.indexCount, 1, primitive.firstIndex, 0, 0);
+                    shadowCastersDrawn++;
                 }
             }
-            drewAnyModel = true;
         }
     }
+    if (!cullCasters) {
+        shadowCasterCount = shadowCastersDrawn;
+    }
     if (!drewAnyModel) {
+        vkCmdPushConstants(cmd, shadowMap->getPipelineLayout(),
+            VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &lightSpaceMatrix);
         VkBuffer vertexBuffers[] = { vertexBuffer };
         VkDeviceSize offsets[] = { 0 };
         vkCmdBindVertexBuffers(cmd, 0, 1, vertexBuffers, offsets);
@@ -1464,13 +2677,92 @@ void VulkanApplication::recordShadowPass()
     }
 
     vkCmdEndRenderPass(cmd);
-    commandBufferManager->endSingleTimeCommands(cmd);
+}
+
+void VulkanApplication::recordAccumulationClear(VkCommandBuffer cmd)
+{
+	VkImageSubresourceRange range = {};
+	range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	range.baseMipLevel = 0;
+	range.levelCount = 1;
+	range.baseArrayLayer = 0;
+	range.layerCount = 1;
+
+	VkClearColorValue clearValue = { 0.0f, 0.0f, 0.0f, 0.0f };
+	vkCmdClearColorImage(cmd, accumOutputImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearValue, 1, &range);
+}
+
+void VulkanApplication::recordShadowMapClear(VkCommandBuffer cmd)
+{
+	VkImageSubresourceRange range = {};
+	range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	range.baseMipLevel = 0;
+	range.levelCount = 1;
+	range.baseArrayLayer = 0;
+	range.layerCount = 1;
+
+	// Same value the shadow pass clears to: the far plane, so nothing is in shadow
+	VkClearColorValue clearValue = { 1.0f, 0.0f, 0.0f, 0.0f };
+	vkCmdClearColorImage(cmd, shadowMap->getShadowImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearValue, 1, &range);
+}
+
+const Light* VulkanApplication::findShadowLight() const
+{
+	// The shadow map follows the first enabled directional light
+	for (const auto& light : lights) {
+		if (light.enabled && light.type == LightType::Directional) {
+			return &light;
+		}
+	}
+	return nullptr;
+}
+
+void VulkanApplication::sampleInput()
+{
+	MK_ZONE("sampleInput");
+	// No window, no input; the camera stays where the scene put it
+	if (!headless) {
+		MK_ZONE("pollEvents");
+		glfwPollEvents();
+	}
+	// Benchmark runs ignore the keyboard and follow the script
+	if (benchmark.isActive()) {
+		applyBenchmarkInput();
+	}
+	else if (!headless) {
+		processInput();
+	}
+	else {
+		simulation.advance(simulatedTime);
+	}
+
+	// Physics ticks on its own thread; this only interpolates its latest snapshot
+	if (simulation.isRunning()) {
+		syncPhysicsTransforms();
+	}
+	inputSampleTime = std::chrono::steady_clock::now();
+}
+
+void VulkanApplication::applyBenchmarkInput()
+{
+	if (benchmark.hasCameraPath()) {
+		glm::vec3 target;
+		benchmark.sampleCamera(simulatedTime, camera->position, target);
+		camera->lookAt(target);
+	}
+	if (benchmark.hasVehicleTrack() && simulation.isRunning()) {
+		simulation.pushInput(benchmark.sampleVehicle(simulatedTime));
+	}
+	// Lockstep physics catches up to this frame's simulated time before it is sampled
+	simulation.advance(simulatedTime);
 }
 
 void VulkanApplication::processInput() {
+	MK_ZONE("processInput");
 	GLFWwindow* win = window->getGLFWwindow();
 	static bool renderKeyPressed = false;
 	static bool cursorKeyPressed = false;
+	static bool pickButtonPressed = false;
 	if (glfwGetKey(win, GLFW_KEY_ESCAPE) == GLFW_PRESS)
 		glfwSetWindowShouldClose(win, true);
 	if (glfwGetKey(win, GLFW_KEY_TAB) == GLFW_PRESS) {
@@ -1483,6 +2775,19 @@ void VulkanApplication::processInput() {
 		cursorKeyPressed = false;
 	}
 
+	// With the cursor free, a left click outside the UI selects the object under it
+	if (glfwGetMouseButton(win, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
+		if (!pickButtonPressed && cursorEnabled && !ImGui::GetIO().WantCaptureMouse) {
+			double cursorX = 0.0, cursorY = 0.0;
+			glfwGetCursorPos(win, &cursorX, &cursorY);
+			pickObject(cursorX, cursorY);
+		}
+		pickButtonPressed = true;
+	}
+	else {
+		pickButtonPressed = false;
+	}
+
 	vehicleThrottle = 0.0f;
 	vehicleBrake = 0.0f;
 	vehicleSteering = 0.0f;
@@ -1528,11 +2833,9 @@ void VulkanApplication::processInput() {
 		}
 	}
 
-	// Apply vehicle input
-	for (auto& obj : loadedObjects) {
-		if (obj.vehicle) {
-			obj.vehicle->setInput(vehicleThrottle, vehicleBrake, vehicleSteering);
-		}
+	// Vehicle input is applied by the simulation thread at its next tick
+	if (simulation.isRunning()) {
+		simulation.pushInput({ vehicleThrottle, vehicleBrake, vehicleSteering });
 	}
 
 	if (glfwGetKey(win, GLFW_KEY_B) == GLFW_PRESS) {
@@ -1552,6 +2855,9 @@ void VulkanApplication::mouseCallback(GLFWwindow* window, double xpos, double yp
 	if(app->cursorEnabled) {
 		return; // Ignore mouse movement when cursor is enabled
 	}
+	if (app->benchmark.isActive()) {
+		return; // The script drives the camera
+	}
 	if (app->firstMouse) {
 		app->lastX = static_cast<float>(xpos);
 		app->lastY = static_cast<float>(ypos);
@@ -1599,14 +2905,13 @@ void VulkanApplication::setupDefaultLights()
 void VulkanApplication::initComputePipeline() {
 	computePipeline = std::make_unique<ComputePipeline>();
 
-	// Create the output storage image for compute shader
-	createComputeOutputImage();
-
-	// Initialize compute pipeline components
+	// Initialize compute pipeline components; the descriptor set is written once
+	// the output image becomes resident (see syncRenderTargets)
 	computePipeline->createDescriptorSetLayout(device.get());
-	computePipeline->createDescriptorPool(device.get(), MAX_FRAMES_IN_FLIGHT);
-	computePipeline->createDescriptorSets(device.get(), computeOutputImageView);
-	computePipeline->createComputePipeline(device.get(), "Shaders/compute.comp.spv");
+	computePipeline->createDescriptorPool(device.get(), DESCRIPTOR_SET_GENERATIONS);
+	pipelineJobs.push_back(std::async(std::launch::async, [this]() {
+		computePipeline->createComputePipeline(device.get(), "Shaders/compute.comp.spv");
+	}));
 
 }
 
@@ -1614,210 +2919,202 @@ void VulkanApplication::initRayTracingPipeline()
 {
 	rayTracingPipeline = std::make_unique<RayTracingPipeline>();
 	rayTracingPipeline->init(device.get());
-	rayTracingPipeline->createPipeline(rayTracingDescriptorSetLayout);
-	rayTracingPipeline->createShaderBindingTable();
+	// The shader binding table reads the handles of the pipeline, so both share one job
+	pipelineJobs.push_back(std::async(std::launch::async, [this]() {
+		rayTracingPipeline->createPipeline(rayTracingDescriptorSetLayout);
+		rayTracingPipeline->createShaderBindingTable();
+	}));
 }
-void VulkanApplication::createComputeOutputImage() {
-	VkExtent2D extent = swapChain->getSwapChainExtent();
-	computeOutputImageExtent = extent;
-	VkFormat storageFormat = VK_FORMAT_R8G8B8A8_UNORM;
-	// Create storage image
-	VkImageCreateInfo imageInfo{};
-	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-	imageInfo.imageType = VK_IMAGE_TYPE_2D;
-	imageInfo.extent.width = extent.width;
-	imageInfo.extent.height = extent.height;
-	imageInfo.extent.depth = 1;
-	imageInfo.mipLevels = 1;
-	imageInfo.arrayLayers = 1;
-	imageInfo.format = storageFormat;
-	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-	VkDevice vkDev = device->getDevice();
 
-	if (vkCreateImage(vkDev, &imageInfo, nullptr, &computeOutputImage) != VK_SUCCESS) {
-		throw std::runtime_error("failed to create compute output image!");
+void VulkanApplication::waitForPipelineJobs()
+{
+	MK_ZONE("waitForPipelines");
+	auto waitBegin = std::chrono::steady_clock::now();
+	size_t jobCount = pipelineJobs.size();
+	// Joins every job before rethrowing, so no worker outlives a failed startup
+	std::exception_ptr failure;
+	for (auto& job : pipelineJobs) {
+		try {
+			job.get();
+		}
+		catch (...) {
+			if (!failure) failure = std::current_exception();
+		}
 	}
-
-	VkMemoryRequirements memRequirements;
-	vkGetImageMemoryRequirements(vkDev, computeOutputImage, &memRequirements);
-
-	VkMemoryAllocateInfo allocInfo{};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize = memRequirements.size;
-	allocInfo.memoryTypeIndex = device->findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-	if (vkAllocateMemory(vkDev, &allocInfo, nullptr, &computeOutputImageMemory) != VK_SUCCESS) {
-		throw std::runtime_error("failed to allocate compute output image memory!");
+	pipelineJobs.clear();
+	if (failure) {
+		std::rethrow_exception(failure);
 	}
-
-	vkBindImageMemory(vkDev, computeOutputImage, computeOutputImageMemory, 0);
-
-	// Create image view
-	VkImageViewCreateInfo viewInfo{};
-	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-	viewInfo.image = computeOutputImage;
-	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-	viewInfo.format = storageFormat;
-	viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	viewInfo.subresourceRange.baseMipLevel = 0;
-	viewInfo.subresourceRange.levelCount = 1;
-	viewInfo.subresourceRange.baseArrayLayer = 0;
-	viewInfo.subresourceRange.layerCount = 1;
-
-	if (vkCreateImageView(vkDev, &viewInfo, nullptr, &computeOutputImageView) != VK_SUCCESS) {
-		throw std::runtime_error("failed to create compute output image view!");
+	if (jobCount > 0) {
+		std::cout << "Pipelines: " << jobCount << " jobs, main thread waited "
+			<< std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - waitBegin).count()
+			<< " ms" << std::endl;
 	}
-
-	m_deletionQueue.pushImage(vkDev, computeOutputImage, computeOutputImageMemory, computeOutputImageView);
-
-	// Transition image layout to GENERAL for compute shader access
-	VkCommandBuffer commandBuffer = commandBufferManager->beginSingleTimeCommands();
-
-	VkImageMemoryBarrier barrier{};
-	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
-	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.image = computeOutputImage;
-	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	barrier.subresourceRange.baseMipLevel = 0;
-	barrier.subresourceRange.levelCount = 1;
-	barrier.subresourceRange.baseArrayLayer = 0;
-	barrier.subresourceRange.layerCount = 1;
-	barrier.srcAccessMask = 0;
-	barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-
-	vkCmdPipelineBarrier(
-		commandBuffer,
-		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-		0,
-		0, nullptr,
-		0, nullptr,
-		1, &barrier
-	);
-
-	commandBufferManager->endSingleTimeCommands(commandBuffer);
 }
-
-void VulkanApplication::createAccumulationImage()
+void VulkanApplication::createRenderTargets()
 {
-	VkExtent2D extent = swapChain->getSwapChainExtent();
-	VkFormat accumFormat = VK_FORMAT_R32G32B32A32_SFLOAT;
-
-	VkImageCreateInfo imageInfo{};
-	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-	imageInfo.imageType = VK_IMAGE_TYPE_2D;
-	imageInfo.extent.width = extent.width;
-	imageInfo.extent.height = extent.height;
-	imageInfo.extent.depth = 1;
-	imageInfo.mipLevels = 1;
-	imageInfo.arrayLayers = 1;
-	imageInfo.format = accumFormat;
-	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-	VkDevice vkDev = device->getDevice();
+	renderTargets = std::make_unique<TransientRenderTargets>();
+	renderTargets->init(device.get(), &m_retireQueue);
+	renderTargets->setExtent(swapChain->getSwapChainExtent());
+
+	const RenderPhaseMask computePhase = 1u << static_cast<uint32_t>(RenderMode::COMPUTE);
+	const RenderPhaseMask rayTracingPhase = 1u << static_cast<uint32_t>(RenderMode::RAYTRACING);
+
+	// Written by the compute or raygen shader, then copied to the swapchain image. One per mode,
+	// so the compute output can take the ray tracing targets' memory and the other way round
+	TransientImageDesc outputDesc{};
+	outputDesc.name = "computeOutput";
+	outputDesc.format = VK_FORMAT_R8G8B8A8_UNORM;
+	outputDesc.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	outputDesc.lifetime = computePhase;
+	outputDesc.firstStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	outputDesc.firstAccess = VK_ACCESS_SHADER_WRITE_BIT;
+	computeOutputTarget = renderTargets->declare(outputDesc);
+
+	outputDesc.name = "rayTracingOutput";
+	outputDesc.lifetime = rayTracingPhase;
+	outputDesc.firstStage = VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR;
+	rayTracingOutputTarget = renderTargets->declare(outputDesc);
+
+	// Path tracing accumulation (rgba32f), starts from zero whenever it becomes live
+	TransientImageDesc accumDesc{};
+	accumDesc.name = "accumulation";
+	accumDesc.format = VK_FORMAT_R32G32B32A32_SFLOAT;
+	accumDesc.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	accumDesc.lifetime = rayTracingPhase;
+	accumDesc.firstStage = VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR;
+	accumDesc.firstAccess = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	accumDesc.clearOnAcquire = true;
+	accumulationTarget = renderTargets->declare(accumDesc);
+}
 
-	if (vkCreateImage(vkDev, &imageInfo, nullptr, &accumOutputImage) != VK_SUCCESS) {
-		throw std::runtime_error("failed to create accumulation image!");
+void VulkanApplication::syncRenderTargets()
+{
+	RenderPhaseMask phase = 1u << static_cast<uint32_t>(currentRenderMode);
+	double now = secondsSinceStart();
+	if (phase != renderTargetPhase) {
+		renderTargetPhase = phase;
+		renderTargetPhaseSince = now;
 	}
-
-	VkMemoryRequirements memRequirements;
-	vkGetImageMemoryRequirements(vkDev, accumOutputImage, &memRequirements);
-
-	VkMemoryAllocateInfo allocInfo{};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize = memRequirements.size;
-	allocInfo.memoryTypeIndex = device->findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-	if (vkAllocateMemory(vkDev, &allocInfo, nullptr, &accumOutputImageMemory) != VK_SUCCESS) {
-		throw std::runtime_error("failed to allocate accumulation image memory!");
+	// Coming from a larger mode the targets alias its allocation, which makes switching back
+	// cheap; once the mode has stuck for modeIdleReleaseSeconds the allocation shrinks to fit
+	if (modeIdleReleaseSeconds > 0.0f && now - renderTargetPhaseSince > modeIdleReleaseSeconds &&
+		renderTargets->canTrim()) {
+		renderTargets->trim();
 	}
-
-	vkBindImageMemory(vkDev, accumOutputImage, accumOutputImageMemory, 0);
-
-	VkImageViewCreateInfo viewInfo{};
-	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-	viewInfo.image = accumOutputImage;
-	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-	viewInfo.format = accumFormat;
-	viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	viewInfo.subresourceRange.baseMipLevel = 0;
-	viewInfo.subresourceRange.levelCount = 1;
-	viewInfo.subresourceRange.baseArrayLayer = 0;
-	viewInfo.subresourceRange.layerCount = 1;
-
-	if (vkCreateImageView(vkDev, &viewInfo, nullptr, &accumOutputImageView) != VK_SUCCESS) {
-		throw std::runtime_error("failed to create accumulation image view!");
+	if (!renderTargets->needsActivation(phase)) {
+		return;
 	}
 
-	m_deletionQueue.pushImage(vkDev, accumOutputImage, accumOutputImageMemory, accumOutputImageView);
+	// No queue wait: images that leave are retired behind the frames still using them, the
+	// acquire barriers go into this frame's command buffer (see drawFrame), and the active
+	// mode gets a new descriptor set while the old one is retired the same way
+	bool handlesChanged = renderTargets->activate(phase);
+	// Whatever the output held is stale now; discarding it needs no ownership transfer
+	computeOutputState = RenderGraph::ImageState{};
+
+	bool rayTracing = currentRenderMode == RenderMode::RAYTRACING;
+	TransientRenderTargets::TargetId output = rayTracing ? rayTracingOutputTarget : computeOutputTarget;
+	computeOutputImage = renderTargets->getImage(output);
+	computeOutputImageView = renderTargets->getImageView(output);
+	computeOutputImageExtent = renderTargets->getExtent();
+	accumOutputImage = renderTargets->getImage(accumulationTarget);
+	accumOutputImageView = renderTargets->getImageView(accumulationTarget);
+
+	if (renderTargets->isLive(accumulationTarget)) {
+		accumulationFrameCount = 0;
+	}
 
-	VkCommandBuffer cmdBuffer = commandBufferManager->beginSingleTimeCommands();
+	if (!handlesChanged || computeOutputImageView == VK_NULL_HANDLE) {
+		return;
+	}
+	if (currentRenderMode == RenderMode::COMPUTE && computePipeline) {
+		VkDescriptorSet previous = computePipeline->getDescriptorSet();
+		computePipeline->createDescriptorSets(device.get(), computeOutputImageView);
+		m_retireQueue.retireDescriptorSet(device->getDevice(), computePipeline->getDescriptorPool(), previous);
+	}
+	else if (rayTracing) {
+		createRayTracingDescriptorSet();
+	}
+}
 
-	VkImageMemoryBarrier barrier{};
-	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
-	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.image = accumOutputImage;
-	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	barrier.subresourceRange.baseMipLevel = 0;
-	barrier.subresourceRange.levelCount = 1;
-	barrier.subresourceRange.baseArrayLayer = 0;
-	barrier.subresourceRange.layerCount = 1;
-	barrier.srcAccessMask = 0;
-	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+void VulkanApplication::ensureModeResources()
+{
+	double now = secondsSinceStart();
+	if (currentRenderMode != RenderMode::RAYTRACING && rayTracingSceneResident && modeIdleReleaseSeconds > 0.0f &&
+		now - rayTracingLastUsed > modeIdleReleaseSeconds) {
+		releaseRayTracingScene();
+	}
+	if (currentRenderMode == RenderMode::GRAPHICS) {
+		return;
+	}
 
-	vkCmdPipelineBarrier(
-		cmdBuffer,
-		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-		VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
-		0,
-		0, nullptr,
-		0, nullptr,
-		1, &barrier
-	);
+	MK_ZONE("ensureModeResources");
+	if (currentRenderMode == RenderMode::COMPUTE && !computePipeline) {
+		std::cout << "Compute: first use, creating pipeline" << std::endl;
+		// The output only becomes live after this, so syncRenderTargets writes the set
+		initComputePipeline();
+	}
+	if (currentRenderMode == RenderMode::RAYTRACING) {
+		rayTracingLastUsed = now;
+		if (!rayTracingPipeline) {
+			std::cout << "Ray tracing: first use, creating pipeline" << std::endl;
+			initRayTracingPipeline();
+		}
+	}
+	// Pipelines started above, at startup or by the prewarm must be done before they are bound
+	if (!pipelineJobs.empty()) {
+		waitForPipelineJobs();
+	}
 
-	commandBufferManager->endSingleTimeCommands(cmdBuffer);
+	if (currentRenderMode == RenderMode::RAYTRACING && !rayTracingSceneResident) {
+		auto buildBegin = std::chrono::steady_clock::now();
+		buildRayTracingScene();
+		std::cout << "Ray tracing: scene built in "
+			<< std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - buildBegin).count()
+			<< " ms" << std::endl;
+	}
 }
 
-void VulkanApplication::cleanupAccumulationResources()
+void VulkanApplication::prewarmModePipelines()
 {
-	if (accumOutputImageView != VK_NULL_HANDLE) {
-		vkDestroyImageView(device->getDevice(), accumOutputImageView, nullptr);
-		accumOutputImageView = VK_NULL_HANDLE;
+	// Only the pipelines, which are small and usually come out of the pipeline cache; the
+	// scene data and render targets still wait for the mode to be used
+	if (!computePipeline) {
+		initComputePipeline();
 	}
-	if (accumOutputImage != VK_NULL_HANDLE) {
-		vkDestroyImage(device->getDevice(), accumOutputImage, nullptr);
-		accumOutputImage = VK_NULL_HANDLE;
-	}
-	if (accumOutputImageMemory != VK_NULL_HANDLE) {
-		vkFreeMemory(device->getDevice(), accumOutputImageMemory, nullptr);
-		accumOutputImageMemory = VK_NULL_HANDLE;
+	if (!rayTracingPipeline && device->supportsRayTracing()) {
+		initRayTracingPipeline();
 	}
 }
 
-void VulkanApplication::recordComputeCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+void VulkanApplication::buildRayTracingScene()
 {
-	VkCommandBufferBeginInfo beginInfo{};
-	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-
-	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
-		throw std::runtime_error("failed to begin recording compute command buffer!");
+	createRayTracingGeometryBuffers();
+	rayTracingAS->clearBLAS();
+	for (auto& obj : loadedObjects) {
+		if (obj.loaded) {
+			rayTracingAS->buildBLASWithoutClear(obj.model);
+		}
 	}
+	rayTracingAS->buildTLASAll(loadedObjects, 0);
+	rayTracingSceneResident = true;
+	// Skipped while the output targets are not resident; syncRenderTargets writes it then
+	createRayTracingDescriptorSet();
+}
+
+void VulkanApplication::releaseRayTracingScene()
+{
+	// Everything goes through the retire queue; the set keeps stale handles until the next
+	// build rewrites it, which is fine as nothing binds it before then
+	cleanupRayTracingGeometryBuffers();
+	rayTracingAS->release();
+	rayTracingSceneResident = false;
+	std::cout << "Ray tracing: unused for " << modeIdleReleaseSeconds << " s, released its scene data" << std::endl;
+}
 
+void VulkanApplication::recordComputeDispatch(VkCommandBuffer commandBuffer)
+{
 	// Bind compute pipeline
 	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline->getPipeline());
 
@@ -1837,7 +3134,7 @@ void VulkanApplication::recordComputeCommandBuffer(VkCommandBuffer commandBuffer
 	ComputePushConstants pushConstants{};
 	pushConstants.iResolution[0] = static_cast<float>(extent.width);
 	pushConstants.iResolution[1] = static_cast<float>(extent.height);
-	pushConstants.iTime = static_cast<float>(glfwGetTime());
+	pushConstants.iTime = static_cast<float>(fixedTimestep ? simulatedTime : secondsSinceStart());
 	vkCmdPushConstants(
 		commandBuffer,
 		computePipeline->getPipelineLayout(),
@@ -1849,60 +3146,11 @@ void VulkanApplication::recordComputeCommandBuffer(VkCommandBuffer commandBuffer
 	uint32_t groupCountX = (extent.width + 15) / 16;  // 16x16 work groups
 	uint32_t groupCountY = (extent.height + 15) / 16;
 	vkCmdDispatch(commandBuffer, groupCountX, groupCountY, 1);
+}
 
-	// Transition compute output for transfer
-	VkImageMemoryBarrier barrier{};
-	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
-	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.image = computeOutputImage;
-	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	barrier.subresourceRange.baseMipLevel = 0;
-	barrier.subresourceRange.levelCount = 1;
-	barrier.subresourceRange.baseArrayLayer = 0;
-	barrier.subresourceRange.layerCount = 1;
-	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-	barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-
-	vkCmdPipelineBarrier(
-		commandBuffer,
-		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-		VK_PIPELINE_STAGE_TRANSFER_BIT,
-		0,
-		0, nullptr,
-		0, nullptr,
-		1, &barrier
-	);
-
-	// Transition swapchain image for transfer destination
-	VkImageMemoryBarrier swapBarrier{};
-	swapBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    swapBarrier.oldLayout = swapChainImageLayouts[imageIndex];
-	swapBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-	swapBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	swapBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	swapBarrier.image = swapChain->getSwapChainImages()[imageIndex];
-	swapBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	swapBarrier.subresourceRange.baseMipLevel = 0;
-	swapBarrier.subresourceRange.levelCount = 1;
-	swapBarrier.subresourceRange.baseArrayLayer = 0;
-	swapBarrier.subresourceRange.layerCount = 1;
-	swapBarrier.srcAccessMask = 0;
-	swapBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-	vkCmdPipelineBarrier(
-		commandBuffer,
-		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-		VK_PIPELINE_STAGE_TRANSFER_BIT,
-		0,
-		0, nullptr,
-		0, nullptr,
-		1, &swapBarrier
-	);
-
-	// Copy compute output to swapchain image
+void VulkanApplication::recordOutputCopy(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+{
+	// Compute/ray tracing output to the swapchain image
 	VkImageCopy copyRegion{};
 	copyRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 	copyRegion.srcSubresource.layerCount = 1;
@@ -1918,68 +3166,105 @@ void VulkanApplication::recordComputeCommandBuffer(VkCommandBuffer commandBuffer
 		swapChain->getSwapChainImages()[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
 		1, &copyRegion
 	);
+}
 
-	// Transition swapchain image for color attachment rendering (UI)
-	swapBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-	swapBarrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-	swapBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-	swapBarrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+void VulkanApplication::addReadbackPass(RenderGraph::ResourceId backbuffer, uint32_t imageIndex)
+{
+	VkExtent2D extent = swapChain->getSwapChainExtent();
+	if (readbackBuffer == VK_NULL_HANDLE) {
+		device->createBuffer(static_cast<VkDeviceSize>(extent.width) * extent.height * 4, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			readbackBuffer, readbackMemory, "readback");
+	}
 
-	vkCmdPipelineBarrier(
-		commandBuffer,
-		VK_PIPELINE_STAGE_TRANSFER_BIT,
-		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-		0,
-		0, nullptr,
-		0, nullptr,
-		1, &swapBarrier
-	);
+	// Blitted into a graph-owned RGBA image first, so the PPM writer does not depend on the
+	// backbuffer's channel order. The image only lives between the two passes.
+	RenderGraph::ImageDesc rgbaDesc;
+	rgbaDesc.name = "readbackRgba";
+	rgbaDesc.format = VK_FORMAT_R8G8B8A8_SRGB;
+	rgbaDesc.extent = extent;
+	rgbaDesc.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	RenderGraph::ResourceId rgba = frameGraph.createImage(rgbaDesc);
+
+	frameGraph.addPass("readbackConvert", RenderGraph::Queue::Graphics,
+		[&](RenderGraph::PassBuilder& pass) {
+			pass.read(backbuffer, RenderGraph::Usage::TransferSrc);
+			pass.write(rgba, RenderGraph::Usage::TransferDst);
+		},
+		[this, imageIndex, extent, rgba](VkCommandBuffer cmd) {
+			VkImageBlit blit{};
+			blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			blit.srcSubresource.layerCount = 1;
+			blit.srcOffsets[1] = { static_cast<int32_t>(extent.width), static_cast<int32_t>(extent.height), 1 };
+			blit.dstSubresource = blit.srcSubresource;
+			blit.dstOffsets[1] = blit.srcOffsets[1];
+			vkCmdBlitImage(cmd, swapChain->getSwapChainImages()[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				frameGraph.getImage(rgba), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_NEAREST);
+		});
+
+	// Nothing downstream reads the copy, so the pass keeps itself alive
+	frameGraph.addPass("readback", RenderGraph::Queue::Graphics,
+		[&](RenderGraph::PassBuilder& pass) {
+			pass.read(rgba, RenderGraph::Usage::TransferSrc);
+			pass.setSideEffects();
+		},
+		[this, extent, rgba](VkCommandBuffer cmd) {
+			VkBufferImageCopy region{};
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.layerCount = 1;
+			region.imageExtent = { extent.width, extent.height, 1 };
+			vkCmdCopyImageToBuffer(cmd, frameGraph.getImage(rgba), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				readbackBuffer, 1, &region);
+
+			VkMemoryBarrier hostBarrier{};
+			hostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+			vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+				1, &hostBarrier, 0, nullptr, 0, nullptr);
+		});
+	readbackRecorded = true;
+}
 
-	// Transition compute output back to GENERAL
-	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-	barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
-	barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-	barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+void VulkanApplication::writeReadback()
+{
+	// The device is idle by now, so the copy recorded by the last frame has landed
+	if (!readbackRecorded) {
+		return;
+	}
+	readbackRecorded = false;
 
-	vkCmdPipelineBarrier(
-		commandBuffer,
-		VK_PIPELINE_STAGE_TRANSFER_BIT,
-		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-		0,
-		0, nullptr,
-		0, nullptr,
-		1, &barrier
-	);
+	std::ofstream file(readbackPath, std::ios::binary);
+	if (!file) {
+		std::cout << "Readback: failed to open " << readbackPath << std::endl;
+		return;
+	}
 
-	VkRenderPassBeginInfo renderPassInfo{};
-	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-	renderPassInfo.renderPass = renderPass;
-	renderPassInfo.framebuffer = swapChain->getSwapChainFramebuffers()[imageIndex];
-	renderPassInfo.renderArea.offset = { 0, 0 };
-	renderPassInfo.renderArea.extent = swapChain->getSwapChainExtent();
-	std::array<VkClearValue, 2> clearValues{};
-	clearValues[0].color = { {0.0f, 0.0f, 0.0f, 1.0f} };
-	clearValues[1].depthStencil = { 1.0f, 0 };
-	renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-	renderPassInfo.pClearValues = clearValues.data();
-	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-	uiManager->render(commandBuffer);
-	vkCmdEndRenderPass(commandBuffer);
+	VkExtent2D extent = swapChain->getSwapChainExtent();
+	void* data = nullptr;
+	if (vkMapMemory(device->getDevice(), readbackMemory, 0, VK_WHOLE_SIZE, 0, &data) != VK_SUCCESS) {
+		throw std::runtime_error("failed to map readback memory!");
+	}
 
-	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
-		throw std::runtime_error("failed to record compute command buffer!");
+	// Binary PPM; the copy is RGBA with sRGB-encoded values
+	file << "P6\n" << extent.width << " " << extent.height << "\n255\n";
+	const uint8_t* pixels = static_cast<const uint8_t*>(data);
+	std::vector<char> row(extent.width * 3);
+	for (uint32_t y = 0; y < extent.height; y++) {
+		for (uint32_t x = 0; x < extent.width; x++) {
+			const uint8_t* pixel = pixels + (static_cast<size_t>(y) * extent.width + x) * 4;
+			row[x * 3 + 0] = static_cast<char>(pixel[0]);
+			row[x * 3 + 1] = static_cast<char>(pixel[1]);
+			row[x * 3 + 2] = static_cast<char>(pixel[2]);
+		}
+		file.write(row.data(), static_cast<std::streamsize>(row.size()));
 	}
+	vkUnmapMemory(device->getDevice(), readbackMemory);
+	std::cout << "Readback: wrote " << extent.width << "x" << extent.height << " frame to " << readbackPath << std::endl;
 }
 
-void VulkanApplication::recordRayTracingCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+void VulkanApplication::recordRayTrace(VkCommandBuffer commandBuffer)
 {
-	VkCommandBufferBeginInfo beginInfo{};
-	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-
-	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
-		throw std::runtime_error("failed to begin recording ray tracing command buffer!");
-	}
-
 	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, rayTracingPipeline->getPipeline());
 	if (rayTracingDescriptorSet != VK_NULL_HANDLE) {
 		vkCmdBindDescriptorSets(
@@ -2026,103 +3311,11 @@ void VulkanApplication::recordRayTracingCommandBuffer(VkCommandBuffer commandBuf
 		extent.height,
 		1
 	);
+}
 
-	VkImageMemoryBarrier barrier{};
-	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
-	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.image = computeOutputImage;
-	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	barrier.subresourceRange.baseMipLevel = 0;
-	barrier.subresourceRange.levelCount = 1;
-	barrier.subresourceRange.baseArrayLayer = 0;
-	barrier.subresourceRange.layerCount = 1;
-	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-	barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-
-	vkCmdPipelineBarrier(
-		commandBuffer,
-		VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
-		VK_PIPELINE_STAGE_TRANSFER_BIT,
-		0,
-		0, nullptr,
-		0, nullptr,
-		1, &barrier
-	);
-
-	VkImageMemoryBarrier swapBarrier{};
-	swapBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	swapBarrier.oldLayout = swapChainImageLayouts[imageIndex];
-	swapBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-	swapBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	swapBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	swapBarrier.image = swapChain->getSwapChainImages()[imageIndex];
-	swapBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	swapBarrier.subresourceRange.baseMipLevel = 0;
-	swapBarrier.subresourceRange.levelCount = 1;
-	swapBarrier.subresourceRange.baseArrayLayer = 0;
-	swapBarrier.subresourceRange.layerCount = 1;
-	swapBarrier.srcAccessMask = 0;
-	swapBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-	vkCmdPipelineBarrier(
-		commandBuffer,
-		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-		VK_PIPELINE_STAGE_TRANSFER_BIT,
-		0,
-		0, nullptr,
-		0, nullptr,
-		1, &swapBarrier
-	);
-
-	VkImageCopy copyRegion{};
-	copyRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	copyRegion.srcSubresource.layerCount = 1;
-	copyRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	copyRegion.dstSubresource.layerCount = 1;
-	copyRegion.extent.width = computeOutputImageExtent.width;
-	copyRegion.extent.height = computeOutputImageExtent.height;
-	copyRegion.extent.depth = 1;
-
-	vkCmdCopyImage(
-		commandBuffer,
-		computeOutputImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-		swapChain->getSwapChainImages()[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-		1, &copyRegion
-	);
-
-    swapBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-	swapBarrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-	swapBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-	swapBarrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-	vkCmdPipelineBarrier(
-		commandBuffer,
-		VK_PIPELINE_STAGE_TRANSFER_BIT,
-		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-		0,
-		0, nullptr,
-		0, nullptr,
-		1, &swapBarrier
-	);
-
-	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-	barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
-	barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-	barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-
-	vkCmdPipelineBarrier(
-		commandBuffer,
-		VK_PIPELINE_STAGE_TRANSFER_BIT,
-		VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
-		0,
-		0, nullptr,
-		0, nullptr,
-		1, &barrier
-	);
-
+void VulkanApplication::recordOverlayPass(VkCommandBuffer commandBuffer, uint32_t imageIndex, bool drawEmissive)
+{
+	// Emissive surfaces (ray tracing only) and the UI on top of the copied output
 	VkRenderPassBeginInfo renderPassInfo{};
 	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
 	renderPassInfo.renderPass = renderPass;
@@ -2150,13 +3343,14 @@ void VulkanApplication::recordRayTracingCommandBuffer(VkCommandBuffer commandBuf
 	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
 	for (auto& rtObj : loadedObjects) {
-		if (!rtObj.loaded || rtObj.descriptorSets.empty() || !additivePipeline) continue;
+		if (!drawEmissive || !rtObj.loaded || rtObj.descriptorSets.empty() || !additivePipeline) continue;
 
 		Model& rtModel = rtObj.model;
-		VkBuffer vertexBuffers[] = { rtModel.vertexBuffer };
+		VkBuffer vertexBuffers[] = { resourcePool->getVkBuffer(rtModel.vertexBuffer) };
+		if (vertexBuffers[0] == VK_NULL_HANDLE) continue;
 		VkDeviceSize offsets[] = { 0 };
 		vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-		vkCmdBindIndexBuffer(commandBuffer, rtModel.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+		vkCmdBindIndexBuffer(commandBuffer, resourcePool->getVkBuffer(rtModel.indexBuffer), 0, VK_INDEX_TYPE_UINT32);
 		VkPipeline currentPipeline = VK_NULL_HANDLE;
 
 		for (const auto& mesh : rtModel.transparentMeshIndices) {
@@ -2193,16 +3387,18 @@ void VulkanApplication::recordRayTracingCommandBuffer(VkCommandBuffer commandBuf
 
 	uiManager->render(commandBuffer);
 	vkCmdEndRenderPass(commandBuffer);
-
-	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
-		throw std::runtime_error("failed to record ray tracing command buffer!");
-	}
 }
 
 void VulkanApplication::loadSceneObjects()
 {
 	const auto& sceneObjects = sceneLoader->getObjects();
 	destroyAllLoadedObjects();
+	// The previous scene's objects are older than the baseline and should drop out of the
+	// registry once their frames retire; any that stay listed leaked
+	GpuResourceRegistry::get().markBaseline();
+
+	uint64_t allocationsBefore = MemoryStats::getAllocationCount();
+	uint64_t allocatedBytesBefore = MemoryStats::getAllocatedBytes();
 
 	// Phase 1: Launch all model loads concurrently
 	struct AsyncLoad {
@@ -2218,6 +3414,7 @@ void VulkanApplication::loadSceneObjects()
 			AsyncLoad& al = asyncLoads.back();
 			al.obj.transform = sceneObj.modelTransform;
 			al.obj.physics = sceneObj.physics;
+			al.obj.occluder = sceneObj.occluder;
 			al.obj.sceneObjectId = sceneObj.id;
 			std::string fullPath = std::string(ASSETS_PATH) + sceneObj.modelPath;
 			al.future = objectLoader->loadGLTFAsync(fullPath, al.obj.model);
@@ -2235,17 +3432,25 @@ void VulkanApplication::loadSceneObjects()
 		}
 	}
 
-	createRayTracingGeometryBuffers();
-	if (rayTracingAS) {
-		rayTracingAS->clearBLAS();
-		for (auto& obj : loadedObjects) {
-			if (obj.loaded) {
-				rayTracingAS->buildBLASWithoutClear(obj.model);
-			}
-		}
-		rayTracingAS->buildTLASAll(loadedObjects, 0);
-		createRayTracingDescriptorSet();
+	std::cout << "Scene load memory: peak RSS " << MemoryStats::getPeakResidentBytes() / (1024 * 1024) << " MB";
+	if (MemoryStats::isAllocationTrackingEnabled()) {
+		std::cout << ", " << MemoryStats::getAllocationCount() - allocationsBefore << " allocations ("
+			<< (MemoryStats::getAllocatedBytes() - allocatedBytesBefore) / (1024 * 1024) << " MB)";
+	}
+	std::cout << std::endl;
+
+	rebuildSceneBVH();
+	selectOccluders();
+	gpuSceneDirty = true;
+
+	// Graphics-only sessions never build the ray tracing scene; ensureModeResources does on first use
+	if (rayTracingSceneResident) {
+		buildRayTracingScene();
 	}
+
+	GpuResourceRegistry::Totals gpuTotals = GpuResourceRegistry::get().getTotals();
+	std::cout << "Scene load GPU objects: " << gpuTotals.count << " live ("
+		<< gpuTotals.bytes / (1024 * 1024) << " MB)" << std::endl;
 }
 
 void VulkanApplication::createLoadedObjectBuffers(LoadedObject& obj)
@@ -2262,7 +3467,8 @@ void VulkanApplication::createLoadedObjectBuffers(LoadedObject& obj)
 			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
 			obj.uniformBuffers[i],
-			obj.uniformBuffersMemory[i]);
+			obj.uniformBuffersMemory[i],
+			"object.ubo");
 		vkMapMemory(device->getDevice(), obj.uniformBuffersMemory[i], 0, bufferSize, 0, &obj.uniformBuffersMapped[i]);
 	}
 
@@ -2293,7 +3499,8 @@ void VulkanApplication::createLoadedObjectBuffers(LoadedObject& obj)
 					VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
 					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
 					obj.materialUniformBuffers[matIndex][frame],
-					obj.materialUniformBuffersMemory[matIndex][frame]);
+					obj.materialUniformBuffersMemory[matIndex][frame],
+					"object.material");
 				vkMapMemory(device->getDevice(), obj.materialUniformBuffersMemory[matIndex][frame], 0, matBufferSize, 0, &obj.materialUniformBuffersMapped[matIndex][frame]);
 				memcpy(obj.materialUniformBuffersMapped[matIndex][frame], &materialData, sizeof(MaterialUBO));
 			}
@@ -2336,11 +3543,14 @@ void VulkanApplication::createLoadedObjectBuffers(LoadedObject& obj)
 
 			VkDescriptorImageInfo imageInfo{};
 			imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			std::optional<LoadedTexture> tex;
 			if (material.baseColorTextureIndex >= 0 &&
 				material.baseColorTextureIndex < static_cast<int32_t>(obj.model.textures.size())) {
-				const LoadedTexture& tex = obj.model.textures[material.baseColorTextureIndex];
-				imageInfo.imageView = tex.imageView;
-				imageInfo.sampler = tex.sampler;
+				tex = resourcePool->getTexture(obj.model.textures[material.baseColorTextureIndex]);
+			}
+			if (tex && tex->imageView != VK_NULL_HANDLE) {
+				imageInfo.imageView = tex->imageView;
+				imageInfo.sampler = tex->sampler;
 			} else {
 				imageInfo.imageView = textureImageView;
 				imageInfo.sampler = textureSampler;
@@ -2401,13 +3611,11 @@ void VulkanApplication::destroyLoadedObject(LoadedObject& obj)
 {
 	if (!obj.loaded) return;
 
+	// The object may still be referenced by in-flight frames; its resources are
+	// released by m_retireQueue once those frames' fences have signaled.
+	VkDevice vkDev = device->getDevice();
 	for (size_t i = 0; i < obj.uniformBuffers.size(); i++) {
-		if (obj.uniformBuffers[i] != VK_NULL_HANDLE) {
-			vkDestroyBuffer(device->getDevice(), obj.uniformBuffers[i], nullptr);
-		}
-		if (obj.uniformBuffersMemory[i] != VK_NULL_HANDLE) {
-			vkFreeMemory(device->getDevice(), obj.uniformBuffersMemory[i], nullptr);
-		}
+		m_retireQueue.retireBuffer(vkDev, obj.uniformBuffers[i], obj.uniformBuffersMemory[i]);
 	}
 	obj.uniformBuffers.clear();
 	obj.uniformBuffersMemory.clear();
@@ -2415,12 +3623,9 @@ void VulkanApplication::destroyLoadedObject(LoadedObject& obj)
 
 	for (size_t matIndex = 0; matIndex < obj.materialUniformBuffers.size(); matIndex++) {
 		for (size_t frame = 0; frame < obj.materialUniformBuffers[matIndex].size(); frame++) {
-			if (obj.materialUniformBuffers[matIndex][frame] != VK_NULL_HANDLE) {
-				vkDestroyBuffer(device->getDevice(), obj.materialUniformBuffers[matIndex][frame], nullptr);
-			}
-			if (obj.materialUniformBuffersMemory[matIndex][frame] != VK_NULL_HANDLE) {
-				vkFreeMemory(device->getDevice(), obj.materialUniformBuffersMemory[matIndex][frame], nullptr);
-			}
+			m_retireQueue.retireBuffer(vkDev,
+				obj.materialUniformBuffers[matIndex][frame],
+				obj.materialUniformBuffersMemory[matIndex][frame]);
 		}
 	}
 	obj.materialUniformBuffers.clear();
@@ -2429,8 +3634,8 @@ void VulkanApplication::destroyLoadedObject(LoadedObject& obj)
 
 	obj.descriptorSets.clear();
 
-	if (obj.model.vertexBuffer != VK_NULL_HANDLE) {
-		objectLoader->destroyModel(obj.model);
+	if (obj.model.vertexBuffer.isValid()) {
+		objectLoader->retireModel(obj.model, m_retireQueue);
 	}
 
 	obj.loaded = false;
@@ -2438,6 +3643,7 @@ void VulkanApplication::destroyLoadedObject(LoadedObject& obj)
 
 void VulkanApplication::destroyAllLoadedObjects()
 {
+	simulation.stop();
 	if (physicsEngine) {
 		for (auto& obj : loadedObjects) {
 			if (obj.vehicle) {
@@ -2454,10 +3660,14 @@ void VulkanApplication::destroyAllLoadedObjects()
 		destroyLoadedObject(obj);
 	}
 	loadedObjects.clear();
+	sceneBVH.clear();
+	occluderCandidates.clear();
+	gpuScene.clear(m_retireQueue);
 }
 
 void VulkanApplication::initPhysics()
 {
+	simulation.stop();
 	physicsEngine = std::make_unique<PhysicsEngine>();
 	physicsEngine->init();
 
@@ -2526,49 +3736,55 @@ void VulkanApplication::initPhysics()
 			}
 		}
 	}
+
+	std::vector<SimBody> simBodies;
+	for (size_t i = 0; i < loadedObjects.size(); i++) {
+		if (loadedObjects[i].physicsBodyID != 0xFFFFFFFF) {
+			simBodies.push_back({ static_cast<uint32_t>(i), loadedObjects[i].physicsBodyID, loadedObjects[i].vehicle.get() });
+		}
+	}
+	// Benchmark and headless runs step physics on the render thread at the frame's simulated
+	// time, so a replay produces the same world every run
+	simulation.start(physicsEngine.get(), simBodies, 60.0f, fixedTimestep);
 }
 
 void VulkanApplication::syncPhysicsTransforms()
 {
-	for (auto& obj : loadedObjects) {
-		if (!obj.loaded || obj.physicsBodyID == 0xFFFFFFFF) continue;
-		obj.transform.position = physicsEngine->getBodyPosition(obj.physicsBodyID);
-		glm::quat q = physicsEngine->getBodyRotation(obj.physicsBodyID);
-		glm::vec3 euler = glm::degrees(glm::eulerAngles(q));
-		obj.transform.rotation = euler;
-		if (obj.vehicle && obj.physicsBodyID != 0xFFFFFFFF) {
-			float speed = obj.vehicle->getSpeed();
-			float rpm = obj.vehicle->getRPM();
-			int gear = obj.vehicle->getCurrentGear();
+	MK_ZONE("syncPhysicsTransforms");
+	// Interpolated at this frame's timestamp between the two latest simulation ticks
+	double renderTime = simulation.isLockstep() ? simulatedTime : SimulationThread::clock();
+	if (!simulation.sample(renderTime, simStates)) {
+		return;
+	}
+
+	const auto& simBodies = simulation.getBodies();
+	for (size_t i = 0; i < simBodies.size(); i++) {
+		LoadedObject& obj = loadedObjects[simBodies[i].objectIndex];
+		const SimBodyState& state = simStates[i];
+		obj.transform.position = state.position;
+		obj.transform.rotation = glm::degrees(glm::eulerAngles(state.rotation));
+		if (simBodies[i].vehicle) {
 			static int frameCount = 0;
 			frameCount++;
 			if (frameCount % 60 == 0) {
-				std::cout << "Car speed: " << speed << " m/s  RPM: " << rpm
-					<< "  Gear: " << gear
+				std::cout << "Car speed: " << state.speed << " m/s  RPM: " << state.rpm
+					<< "  Gear: " << state.gear
 					<< "  pos: (" << obj.transform.position.x << ", "
 					<< obj.transform.position.y << ", "
 					<< obj.transform.position.z << ")"
 					<< "  input: T=" << vehicleThrottle << " B=" << vehicleBrake << " S=" << vehicleSteering
 					<< std::endl;
 			}
-			if (vehicleThrottle > 0.0f || vehicleBrake > 0.0f) {
-				JPH::BodyID id(obj.physicsBodyID);
-				JPH::Vec3 fwd = physicsEngine->getBodyInterface().GetRotation(id) * JPH::Vec3(0, 0, 1);
-				float forceMagnitude = vehicleThrottle > 0.0f ? 3000.0f : -1000.0f;
-				physicsEngine->getBodyInterface().AddForce(id, fwd * forceMagnitude);
-			}
-			if (vehicleSteering != 0.0f) {
-				JPH::BodyID id(obj.physicsBodyID);
-				physicsEngine->getBodyInterface().AddTorque(id, JPH::Vec3(0, vehicleSteering * 200.0f, 0));
-			}
-
 		}
 	}
 }
 
 void VulkanApplication::toggleRenderMode()
 {
-    if (currentRenderMode == RenderMode::GRAPHICS) {
+    if (currentRenderMode == RenderMode::GRAPHICS && !device->supportsRayTracing()) {
+		std::cout << "Raytracing rendering mode is not supported on this device" << std::endl;
+	}
+    else if (currentRenderMode == RenderMode::GRAPHICS) {
 		currentRenderMode = RenderMode::RAYTRACING;
 		accumulationFrameCount = 0;
 		std::cout << "Switched to Raytracing rendering mode" << std::endl;
@@ -2588,16 +3804,9 @@ void VulkanApplication::cleanupComputeResources()
     if (computePipeline) {
         computePipeline->cleanup(device.get());
     }
-    if (computeOutputImageView != VK_NULL_HANDLE) {
-        vkDestroyImageView(device->getDevice(), computeOutputImageView, nullptr);
-    }
-    if (computeOutputImage != VK_NULL_HANDLE) {
-        vkDestroyImage(device->getDevice(), computeOutputImage, nullptr);
-    }
-    if (computeOutputImageMemory != VK_NULL_HANDLE) {
-        vkFreeMemory(device->getDevice(), computeOutputImageMemory, nullptr);
-    }
-	cleanupAccumulationResources();
+	if (renderTargets) {
+		renderTargets->cleanup();
+	}
 	cleanupRayTracingGeometryBuffers();
    if (rayTracingPipeline) {
 		rayTracingPipeline->cleanup();
@@ -2684,26 +3893,29 @@ void VulkanApplication::createRayTracingDescriptorPool()
 {
     std::array<VkDescriptorPoolSize, 5> poolSizes{};
 	poolSizes[0].type = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
-	poolSizes[0].descriptorCount = 1;
+	poolSizes[0].descriptorCount = 1 * DESCRIPTOR_SET_GENERATIONS;
 	poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-	poolSizes[1].descriptorCount = 2;
+	poolSizes[1].descriptorCount = 2 * DESCRIPTOR_SET_GENERATIONS;
 	poolSizes[2].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	poolSizes[2].descriptorCount = 1;
+	poolSizes[2].descriptorCount = 1 * DESCRIPTOR_SET_GENERATIONS;
 	poolSizes[3].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-	poolSizes[3].descriptorCount = 4;
+	poolSizes[3].descriptorCount = 4 * DESCRIPTOR_SET_GENERATIONS;
 	poolSizes[4].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	poolSizes[4].descriptorCount = 33;
+	poolSizes[4].descriptorCount = 33 * DESCRIPTOR_SET_GENERATIONS;
 
 	VkDescriptorPoolCreateInfo poolInfo{};
 	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	// Every rewrite allocates a new set and frees the old one once its frames are done
+	poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
 	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
 	poolInfo.pPoolSizes = poolSizes.data();
-	poolInfo.maxSets = 1;
+	poolInfo.maxSets = DESCRIPTOR_SET_GENERATIONS;
 
 	VkDevice vkDev = device->getDevice();
 	if (vkCreateDescriptorPool(vkDev, &poolInfo, nullptr, &rayTracingDescriptorPool) != VK_SUCCESS) {
 		throw std::runtime_error("failed to create ray tracing descriptor pool!");
 	}
+	MK_TRACK_GPU_RESOURCE(rayTracingDescriptorPool, 0, "rayTracing.descriptorPool");
 	m_deletionQueue.pushDescriptorPool(vkDev, rayTracingDescriptorPool);
 }
 
@@ -2721,16 +3933,21 @@ void VulkanApplication::createRayTracingDescriptorSet()
 		return;
 	}
 
-    if (rayTracingDescriptorSet == VK_NULL_HANDLE) {
-		VkDescriptorSetAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-		allocInfo.descriptorPool = rayTracingDescriptorPool;
-		allocInfo.descriptorSetCount = 1;
-		allocInfo.pSetLayouts = &rayTracingDescriptorSetLayout;
+	// Output targets are only resident in compute/ray tracing mode; syncRenderTargets() writes the set then
+	if (computeOutputImageView == VK_NULL_HANDLE || accumOutputImageView == VK_NULL_HANDLE) {
+		return;
+	}
 
-		if (vkAllocateDescriptorSets(device->getDevice(), &allocInfo, &rayTracingDescriptorSet) != VK_SUCCESS) {
-			throw std::runtime_error("failed to allocate ray tracing descriptor set!");
-		}
+	// Frames in flight may still bind the current set, so it is replaced rather than rewritten
+	m_retireQueue.retireDescriptorSet(device->getDevice(), rayTracingDescriptorPool, rayTracingDescriptorSet);
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = rayTracingDescriptorPool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &rayTracingDescriptorSetLayout;
+
+	if (vkAllocateDescriptorSets(device->getDevice(), &allocInfo, &rayTracingDescriptorSet) != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate ray tracing descriptor set!");
 	}
 
 	VkWriteDescriptorSetAccelerationStructureKHR asInfo{};
@@ -2855,9 +4072,10 @@ void VulkanApplication::createRayTracingDescriptorSet()
 	for (auto& obj : loadedObjects) {
 		if (!obj.loaded) continue;
 		for (size_t i = 0; i < obj.model.textures.size() && texSlot < 32; i++) {
-			if (obj.model.textures[i].imageView != VK_NULL_HANDLE) {
-				texImageInfos[texSlot].imageView = obj.model.textures[i].imageView;
-				texImageInfos[texSlot].sampler = obj.model.textures[i].sampler;
+			std::optional<LoadedTexture> tex = resourcePool->getTexture(obj.model.textures[i]);
+			if (tex && tex->imageView != VK_NULL_HANDLE) {
+				texImageInfos[texSlot].imageView = tex->imageView;
+				texImageInfos[texSlot].sampler = tex->sampler;
 			}
 			texSlot++;
 		}
@@ -2954,42 +4172,50 @@ void VulkanApplication::createPipelineLayout()
 
 void VulkanApplication::createGraphicsPipeline()
 {
-	PipelineConfigInfo pipelineConfig{};
-	VulkanPipeline::defaultPipelineConfigInfo(pipelineConfig);
-	pipelineConfig.renderPass = renderPass;
-	pipelineConfig.pipelineLayout = pipelineLayout;
-	VulkanPipeline::enableAlphaBlending(pipelineConfig);
-	graphicsPipeline = std::make_unique<VulkanPipeline>(
-		device.get(),
-		"Shaders/shader.vert.spv",
-		"Shaders/brdf.frag.spv",
-		pipelineConfig
-	);
-
-	PipelineConfigInfo transparentConfig{};
-	VulkanPipeline::defaultPipelineConfigInfo(transparentConfig);
-	transparentConfig.renderPass = renderPass;
-	transparentConfig.pipelineLayout = pipelineLayout;
-	VulkanPipeline::enableAlphaBlending(transparentConfig);
-	transparentConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
-	transparentPipeline = std::make_unique<VulkanPipeline>(
-		device.get(),
-		"Shaders/shader.vert.spv",
-		"Shaders/brdf.frag.spv",
-		transparentConfig
-	);
-
-	PipelineConfigInfo additiveConfig{};
-	VulkanPipeline::defaultPipelineConfigInfo(additiveConfig);
-	additiveConfig.renderPass = renderPass;
-	additiveConfig.pipelineLayout = pipelineLayout;
-	VulkanPipeline::enableAdditiveBlending(additiveConfig);
-	additivePipeline = std::make_unique<VulkanPipeline>(
-		device.get(),
-		"Shaders/shader.vert.spv",
-		"Shaders/brdf.frag.spv",
-		additiveConfig
-	);
+	// The three variants compile in parallel; each job owns its config, whose create infos
+	// point into itself
+	pipelineJobs.push_back(std::async(std::launch::async, [this]() {
+		PipelineConfigInfo pipelineConfig{};
+		VulkanPipeline::defaultPipelineConfigInfo(pipelineConfig);
+		pipelineConfig.renderPass = renderPass;
+		pipelineConfig.pipelineLayout = pipelineLayout;
+		VulkanPipeline::enableAlphaBlending(pipelineConfig);
+		graphicsPipeline = std::make_unique<VulkanPipeline>(
+			device.get(),
+			"Shaders/shader.vert.spv",
+			"Shaders/brdf.frag.spv",
+			pipelineConfig
+		);
+	}));
+
+	pipelineJobs.push_back(std::async(std::launch::async, [this]() {
+		PipelineConfigInfo transparentConfig{};
+		VulkanPipeline::defaultPipelineConfigInfo(transparentConfig);
+		transparentConfig.renderPass = renderPass;
+		transparentConfig.pipelineLayout = pipelineLayout;
+		VulkanPipeline::enableAlphaBlending(transparentConfig);
+		transparentConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
+		transparentPipeline = std::make_unique<VulkanPipeline>(
+			device.get(),
+			"Shaders/shader.vert.spv",
+			"Shaders/brdf.frag.spv",
+			transparentConfig
+		);
+	}));
+
+	pipelineJobs.push_back(std::async(std::launch::async, [this]() {
+		PipelineConfigInfo additiveConfig{};
+		VulkanPipeline::defaultPipelineConfigInfo(additiveConfig);
+		additiveConfig.renderPass = renderPass;
+		additiveConfig.pipelineLayout = pipelineLayout;
+		VulkanPipeline::enableAdditiveBlending(additiveConfig);
+		additivePipeline = std::make_unique<VulkanPipeline>(
+			device.get(),
+			"Shaders/shader.vert.spv",
+			"Shaders/brdf.frag.spv",
+			additiveConfig
+		);
+	}));
 }
 
 void* VulkanApplication::getNativeWindow() const
@@ -3060,6 +4286,8 @@ void VulkanApplication::setRenderMode(int mode)
 {
 	if (mode == 0) {
 		currentRenderMode = RenderMode::GRAPHICS;
+	} else if (mode == 1 && !device->supportsRayTracing()) {
+		std::cout << "Raytracing rendering mode is not supported on this device" << std::endl;
 	} else if (mode == 1) {
 		currentRenderMode = RenderMode::RAYTRACING;
 		accumulationFrameCount = 0;
@@ -5,9 +5,17 @@
 #include "VkDevice.h"
 #include "EngineWindow.h"
 #include "SwapChain.h"
+#include "FramePacer.h"
+#include "FrameLimiter.h"
+#include "Benchmark.h"
+#include "PerfSweeps.h"
+#include "../utils/GpuProfiler.h"
 #include "../pipeline.h"
 #include "../RenderPass.h"
 #include "../CommandBufferManager.h"
+#include "../RenderGraph.h"
+#include "../ParallelCommandRecorder.h"
+#include "../DrawList.h"
 #include "../Descriptors/VkDescriptor.h"
 #include "../Resources/TextureManager.h"
 #include "../Resources/BufferManager.h"
@@ -17,19 +25,31 @@
 #include "../Resources/Sceneloader.h"
 #include "../Resources/DeletionQueue.h"
 #include "../Resources/ShadowMap.h"
+#include "../Resources/TransientRenderTargets.h"
+#include "../Resources/FrustumCuller.h"
+#include "../Resources/SceneBVH.h"
+#include "../Resources/OcclusionCuller.h"
+#include "../Resources/GpuDrivenScene.h"
 #include "../uiManager/uiManager.h"
 #include "../pipeline/computePipeline.h"
 #include "../objects/lights.h"
+#include <array>
+#include <chrono>
+#include <future>
 #include <memory>
 #include <vector>
 #include <string>
+#include <utility>
 #include "ShaderCompiler.h"
 #include "../raytracing/RayTracingAS.h"
 #include "../raytracing/RayTracingPipeline.h"
 #include "../Physics/PhysicsEngine.h"
+#include "../Physics/SimulationThread.h"
 #include "../../Renderer/Renderer.h"
 
-const int MAX_FRAMES_IN_FLIGHT = 2;
+// Per-frame resources are sized for the pacer's maximum; how many frames are actually
+// queued is FramePacer's runtime setting
+const int MAX_FRAMES_IN_FLIGHT = FramePacer::MAX_FRAMES_IN_FLIGHT;
 
 class VulkanApplication {
 public:
@@ -83,15 +103,185 @@ private:
 
 	// Command buffers
 	std::unique_ptr<CommandBufferManager> commandBufferManager;
+	// Rebuilt every frame; owns the barriers between passes
+	RenderGraph frameGraph;
+	// Records the main pass draws into secondary command buffers on worker threads
+	ParallelCommandRecorder drawRecorder;
+	int recordThreads = 1;
+	// Each loaded object is drawn this many times, to measure recording with large draw lists
+	int syntheticDrawCopies = 1;
+	// With drawSorting every visible primitive of the frame goes into one DrawList, sorted by
+	// pass, pipeline, material and depth, and the chunks recorded in parallel are ranges of it
+	// instead of whole objects
+	DrawList drawList;
+	bool drawSorting = true;
+	float drawListBuildMs = 0.0f;
+	void buildDrawList(uint32_t drawCount, VkPipeline opaquePipe, VkPipeline transparentPipe, VkPipeline additivePipe);
+	// Every primitive's box is tested against the camera frustum before the draws are recorded;
+	// objectCullOffsets holds each loaded object's first byte in cullVisibility, or OBJECT_CULLED
+	// when the whole object is already outside. Empty when culling is off.
+	static constexpr uint32_t OBJECT_CULLED = UINT32_MAX;
+	FrustumCuller frustumCuller;
+	bool frustumCulling = true;
+	std::vector<uint32_t> objectCullOffsets;
+	uint32_t cullPrimitiveCount = 0;
+	uint32_t cullVisibleCount = 0;
+	uint32_t cullObjectsCulled = 0;
+	float cullMs = 0.0f;
+	// Visibility bytes objectCullOffsets index into: the FrustumCuller's, bvhVisibility or
+	// transparentVisibility
+	uint8_t* cullVisibility = nullptr;
+	void cullScene();
+	// While the GPU cull pass draws the opaque meshes only the transparent primitives are tested
+	// here; their results are scattered into the usual per-object layout, opaque bytes stay 0
+	std::vector<uint32_t> transparentCullSlots;
+	std::vector<uint8_t> transparentVisibility;
+	void cullTransparent(const Frustum& frustum);
+	// After the frustum, the selected occluders are rasterized on the CPU and every remaining
+	// primitive's box is tested against them. Occluders are picked once per scene load: objects
+	// marked "occluder" in the scene file, then opaque primitives at least OCCLUDER_MIN_RADIUS
+	// across, largest first, within the triangle budget.
+	struct OccluderCandidate {
+		uint32_t objectIndex;
+		uint32_t meshIndex;
+		uint32_t primitiveIndex;
+	};
+	static constexpr float OCCLUDER_MIN_RADIUS = 2.0f;
+	static constexpr uint32_t OCCLUDER_MAX_TRIANGLES = 8192;
+	static constexpr uint32_t OCCLUDER_TRIANGLE_BUDGET = 65536;
+	OcclusionCuller occlusionCuller;
+	bool occlusionCulling = true;
+	std::vector<OccluderCandidate> occluderCandidates;
+	uint32_t occludersDrawn = 0;
+	uint32_t occludedPrimitives = 0;
+	uint32_t occludedObjects = 0;
+	float occlusionRasterMs = 0.0f;
+	float occlusionTestMs = 0.0f;
+	void selectOccluders();
+	void cullOccluded(const glm::mat4& viewProj);
+	// Every loaded primitive's world box, for camera and shadow culling, mouse picking and radius
+	// queries. Leaf user data is (object index << 32) | primitive index within the object.
+	// syncSceneBVH keeps it in step with the objects each frame, refitting moved ones.
+	SceneBVH sceneBVH;
+	bool bvhCulling = true;
+	std::vector<uint64_t> bvhQueryResults;
+	std::vector<uint8_t> bvhVisibility;
+	// Shadow casters are culled against the light's frustum the same way
+	std::vector<uint64_t> shadowQueryResults;
+	std::vector<uint8_t> shadowVisibility;
+	std::vector<uint32_t> shadowCullOffsets;
+	uint32_t shadowCasterCount = 0;
+	uint32_t shadowCastersDrawn = 0;
+	float bvhSyncMs = 0.0f;
+	void rebuildSceneBVH();
+	void syncSceneBVH();
+	// Marks the query results in a byte per loaded primitive; offsets gets each object's first
+	// byte, or OBJECT_CULLED when none of its primitives were found. Returns the marked count.
+	uint32_t markBVHResults(const std::vector<uint64_t>& results, std::vector<uint8_t>& visibility,
+		std::vector<uint32_t>& offsets) const;
+	void insertObjectIntoBVH(uint32_t objectIndex);
+	void removeObjectFromBVH(LoadedObject& obj);
+	// Selects the object under the cursor
+	void pickObject(double cursorX, double cursorY);
+	// Opaque geometry can instead be culled and drawn on the GPU: a compute pass before the main
+	// pass culls every opaque primitive against the frustum and the previous frame's Hi-Z pyramid,
+	// and the main pass draws the survivors with indirect count draws. Transparent and additive
+	// geometry stays on the CPU path. The pyramid is built from the depth after the main pass.
+	GpuDrivenScene gpuScene;
+	bool gpuDrivenRendering = true;
+	bool hizOcclusion = true;
+	// Set when the objects change; the instances are rebuilt before the next frame records
+	bool gpuSceneDirty = false;
+	// This frame draws through gpuScene
+	bool gpuDrivenActive = false;
+	// Layout the previous frame left the pyramid in, and this frame's graph resource for it
+	RenderGraph::ImageState hizState;
+	RenderGraph::ResourceId hizResource = RenderGraph::InvalidResource;
+	float gpuSceneUpdateMs = 0.0f;
+	void updateGpuScene(bool hasLoadedModels);
+	// With a dedicated compute queue the compute-mode dispatch runs there. The next frame copies
+	// its output to the swapchain, so the dispatch overlaps that frame's graphics work.
+	bool asyncCompute = true;
+	VkCommandPool computeCommandPool = VK_NULL_HANDLE;
+	std::array<VkCommandBuffer, MAX_FRAMES_IN_FLIGHT> computeCommandBuffers{};
+	// Signalled by a frame's graphics submission, waited on by its async compute submission
+	std::array<VkSemaphore, MAX_FRAMES_IN_FLIGHT> graphicsDoneSemaphores{};
+	bool lastFrameUsedAsyncCompute = false;
+	// Layout and owning queue the previous frame left the compute output image in
+	RenderGraph::ImageState computeOutputState;
+	// This frame's graph resource for the compute output (InvalidResource in graphics mode)
+	RenderGraph::ResourceId computeOutputResource = RenderGraph::InvalidResource;
 
 	// Synchronization objects
 	std::vector<VkSemaphore> imageAvailableSemaphores;
 	std::vector<VkSemaphore> renderFinishedSemaphores;
-	std::vector<VkFence> inFlightFences;
-	std::vector<VkFence> imagesInFlight;
+	// Render-finished semaphores of replaced swapchains. Presents of the old images may still
+	// wait on them, so they are retired only after a frame that acquired from the new swapchain
+	std::vector<VkSemaphore> replacedPresentSemaphores;
+	// Timeline value of the last frame that rendered to each swapchain image
+	std::vector<uint64_t> imageTimelineValues;
   std::vector<VkImageLayout> swapChainImageLayouts;
+	FramePacer framePacer;
+	int framesInFlight = 2;
+	GpuProfiler gpuProfiler;
+	FrameLimiter frameLimiter;
+	float targetFps = 0.0f;
+	// Poll events, move the camera and sample physics right before the UBO updates instead of
+	// at the top of the loop, so the frame renders input sampled after the frame-slot wait
+	bool justInTimeInput = false;
+	std::chrono::steady_clock::time_point inputSampleTime;
+	// Indexed like PRESENT_MODE_OPTIONS in VkApplication.cpp
+	bool presentModeSupported[4] = {};
 	uint32_t currentFrame = 0;
 
+	// Headless runs have no window or swapchain: frames go to offscreen images that are never
+	// presented, and the last one can be read back to readbackPath
+	bool headless = false;
+	// Frames to render before exiting; 0 runs until the window closes
+	uint32_t maxFrames = 0;
+	std::string readbackPath;
+	VkBuffer readbackBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory readbackMemory = VK_NULL_HANDLE;
+	bool readbackRecorded = false;
+
+	// Scripted benchmark run: fixed timestep, camera path and vehicle input from the script,
+	// physics stepped in lockstep with the frames
+	Benchmark benchmark;
+	// Benchmark and headless runs advance time by the frame index instead of the wall clock, and
+	// step physics in lockstep with the frames, so a rerun renders the same images (--golden)
+	bool fixedTimestep = false;
+	// Simulated seconds of the current frame when fixedTimestep is set
+	double simulatedTime = 0.0;
+	// Start of initVulkan, for the startup and time-to-first-frame reports
+	std::chrono::steady_clock::time_point initBegin;
+
+	// Record, scaling and resize measurements; fed each finished frame by mainLoop
+	PerfSweeps perfSweeps;
+	PerfSweeps::Settings getSweepSettings() const;
+	void applySweepSettings(const PerfSweeps::Settings& settings);
+
+	// Pipeline compiles started during initVulkan, joined before the first frame
+	std::vector<std::future<void>> pipelineJobs;
+	void waitForPipelineJobs();
+
+	// Time spent in each initVulkan phase, reported once startup is done
+	std::vector<std::pair<std::string, float>> startupPhases;
+	std::chrono::steady_clock::time_point phaseBegin;
+	void markStartupPhase(const char* name);
+	void printStartupPhases();
+
+	// Ray tracing and compute are only set up once their mode is first drawn (or their pipelines
+	// prewarmed after the first frame); the ray tracing scene data is dropped again after
+	// modeIdleReleaseSeconds without ray tracing
+	bool prewarmModes = true;
+	float modeIdleReleaseSeconds = 30.0f;
+	bool rayTracingSceneResident = false;
+	double rayTracingLastUsed = 0.0;
+	void ensureModeResources();
+	void prewarmModePipelines();
+	void buildRayTracingScene();
+	void releaseRayTracingScene();
+
 	// Vertex/Index buffers
 	VkBuffer vertexBuffer = VK_NULL_HANDLE;
 	VkDeviceMemory vertexBufferMemory = VK_NULL_HANDLE;
@@ -177,6 +367,8 @@ private:
 	void cleanup();
 	void toggleCursor();
 	void createSyncObjects();
+	void createAsyncComputeResources();
+	void cleanupAsyncComputeResources();
 	void createVertexBuffer();
 	void createIndexBuffer();
 	void createUniformBuffers();
@@ -191,11 +383,19 @@ private:
 	void SetupUIManager();
 	void initComputePipeline();
     void initRayTracingPipeline();
-	void createComputeOutputImage();
+	void createRenderTargets();
+	void syncRenderTargets();
 	void createRayTracingGeometryBuffers();
 	void cleanupRayTracingGeometryBuffers();
-	void recordComputeCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex);
-    void recordRayTracingCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+	// Frame graph construction and the pass bodies it records
+	RenderGraph::ResourceId buildFrameGraph(uint32_t imageIndex, bool clearAccumulation, bool hasLoadedModels);
+	void recordMainPass(VkCommandBuffer commandBuffer, uint32_t imageIndex, bool hasLoadedModels);
+	void recordComputeDispatch(VkCommandBuffer commandBuffer);
+	void recordRayTrace(VkCommandBuffer commandBuffer);
+	void recordOutputCopy(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+	void recordOverlayPass(VkCommandBuffer commandBuffer, uint32_t imageIndex, bool drawEmissive);
+	void addReadbackPass(RenderGraph::ResourceId backbuffer, uint32_t imageIndex);
+	void writeReadback();
 	void loadSceneObjects();
 	void createLoadedObjectBuffers(LoadedObject& obj);
 	void destroyLoadedObject(LoadedObject& obj);
@@ -209,7 +409,10 @@ private:
 	void cleanupTAAImages();
 	void cleanupTAAPipeline();
 	void updateTAADescriptorSets();
-	void recordShadowPass();
+	void recordShadowPass(VkCommandBuffer cmd);
+	void recordAccumulationClear(VkCommandBuffer cmd);
+	void recordShadowMapClear(VkCommandBuffer cmd);
+	const Light* findShadowLight() const;
 
 	// New methods for pipeline setup
 	void createDescriptorSetLayout();
@@ -220,17 +423,25 @@ private:
 	void createGraphicsPipeline();
 
 	// Input handling methods
-    void createAccumulationImage();
-    void cleanupAccumulationResources();
 	void processInput();
+	void sampleInput();
+	void applyBenchmarkInput();
 	static void mouseCallback(GLFWwindow* window, double xpos, double ypos);
 
 	//UI Manager
 	std::unique_ptr<UIManager> uiManager;
 	// Compute Pipeline
 	std::unique_ptr<ComputePipeline> computePipeline;
+	// Swapchain-sized targets of the compute and ray tracing modes, only resident while one of them is active.
+	// The image/view members below mirror the pool and are null in graphics mode; computeOutputImage is
+	// the active mode's output, the compute or the ray tracing one.
+	std::unique_ptr<TransientRenderTargets> renderTargets;
+	TransientRenderTargets::TargetId computeOutputTarget = 0;
+	TransientRenderTargets::TargetId rayTracingOutputTarget = 0;
+	TransientRenderTargets::TargetId accumulationTarget = 0;
+	RenderPhaseMask renderTargetPhase = 0;
+	double renderTargetPhaseSince = 0.0;
 	VkImage computeOutputImage = VK_NULL_HANDLE;
-	VkDeviceMemory computeOutputImageMemory = VK_NULL_HANDLE;
 	VkImageView computeOutputImageView = VK_NULL_HANDLE;
 	VkExtent2D computeOutputImageExtent{};
 
@@ -255,7 +466,6 @@ private:
 
 	// Accumulation
 	VkImage accumOutputImage = VK_NULL_HANDLE;
-	VkDeviceMemory accumOutputImageMemory = VK_NULL_HANDLE;
 	VkImageView accumOutputImageView = VK_NULL_HANDLE;
 	uint32_t accumulationFrameCount = 0;
 	bool cameraMoved = false;
@@ -264,6 +474,8 @@ private:
 
 	//Object-Loader
 	std::unique_ptr<ObjectLoader> objectLoader;
+	// Model geometry buffers and textures, addressed by generational handles
+	std::unique_ptr<GpuResourcePool> resourcePool;
 	std::vector<LoadedObject> loadedObjects;
 	int selectedObjectIndex = 0;
 
@@ -279,12 +491,20 @@ private:
 
 	//ShadowMap
 	std::unique_ptr<ShadowMap> shadowMap;
+	// Layout the previous frame left the shadow map in (UNDEFINED until something wrote it), and
+	// this frame's graph resource for it
+	RenderGraph::ImageState shadowMapState;
+	RenderGraph::ResourceId shadowMapResource = RenderGraph::InvalidResource;
 	//TODO: find a way to automatically update scenes like hot shader reloading
 	std::vector<std::string> availableScenes{ "sceneTrack.json", "scene.json","WaterExample.json", "showRoom.json"};
 	int currentSceneIndex = 0;
 
 	// Physics
 	std::unique_ptr<PhysicsEngine> physicsEngine;
+	// Owns physicsEngine and the vehicles while running; the render thread only sees snapshots
+	SimulationThread simulation;
+	// Interpolated body states of the current frame, indexed like simulation.getBodies()
+	std::vector<SimBodyState> simStates;
 	void initLineRenderer();
 	void drawDebugLines(VkCommandBuffer commandBuffer, uint32_t currentImage);
 	VkPipeline linePipeline = VK_NULL_HANDLE;
@@ -300,5 +520,7 @@ private:
 
 	// Deletion queue for deferred resource cleanup
 	DeletionQueue m_deletionQueue;
+	// Resources destroyed at runtime, released once the frames that used them complete
+	FrameDeletionQueue m_retireQueue;
 
 };
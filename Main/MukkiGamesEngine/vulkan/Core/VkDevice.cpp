@@ -16,6 +16,8 @@ Device::~Device() {
 }
 void Device::cleanup() {
 	if (device != VK_NULL_HANDLE) {
+		pipelineCache.cleanup();
+		GpuResourceRegistry::get().reportLeaks();
 		vkDestroyDevice(device, nullptr);
 		device = VK_NULL_HANDLE;
 	}
@@ -60,8 +62,9 @@ bool Device::isDeviceSuitable(VkPhysicalDevice device)
 
 	bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-	bool swapChainAdequate = false;
-	if (extensionsSupported) {
+	// Headless devices only need VK_KHR_swapchain for the PRESENT_SRC layout the render passes use
+	bool swapChainAdequate = isHeadless();
+	if (extensionsSupported && !isHeadless()) {
 		SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
 		swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
 	}
@@ -93,20 +96,30 @@ QueueFamilyIndices Device::findQueueFamilies(VkPhysicalDevice device)
 
     int i = 0;
     for (const auto& queueFamily : queueFamilies) {
-        // Check for graphics support
-        if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
-            indices.graphicsFamily = i;
+        if (!indices.isComplete()) {
+            // Check for graphics support
+            if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+                indices.graphicsFamily = i;
+            }
+
+            // Check for present support
+            VkBool32 presentSupport = false;
+            if (surface != VK_NULL_HANDLE) {
+                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+            }
+            else if (indices.graphicsFamily.has_value()) {
+                indices.presentFamily = indices.graphicsFamily;
+            }
+            if (presentSupport) {
+                indices.presentFamily = i;
+            }
         }
 
-        // Check for present support
-        VkBool32 presentSupport = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
-        if (presentSupport) {
-            indices.presentFamily = i;
-        }
-
-        if (indices.isComplete()) {
-            break;
+        // A compute family without graphics runs on its own hardware queue, so its work can
+        // overlap the graphics queue instead of being interleaved with it
+        if (!indices.computeFamily.has_value() &&
+            (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) && !(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+            indices.computeFamily = i;
         }
 
         i++;
@@ -163,9 +176,33 @@ SwapChainSupportDetails Device::querySwapChainSupport(VkPhysicalDevice device)
     	std::vector<VkExtensionProperties> availableExtensions(extensionCount);
     	vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
 
+    	std::set<std::string> missingRayTracing(rayTracingExtensions.begin(), rayTracingExtensions.end());
+    	for (const auto& ext : availableExtensions) {
+    		missingRayTracing.erase(ext.extensionName);
+    	}
+    	// The feature structs may only be chained once the extensions are known to exist
+    	if (missingRayTracing.empty()) {
+    		VkPhysicalDeviceAccelerationStructureFeaturesKHR supportedAS{};
+    		supportedAS.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_FEATURES_KHR;
+    		VkPhysicalDeviceRayTracingPipelineFeaturesKHR supportedRT{};
+    		supportedRT.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_PIPELINE_FEATURES_KHR;
+    		supportedRT.pNext = &supportedAS;
+    		VkPhysicalDeviceFeatures2 supportedFeatures{};
+    		supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    		supportedFeatures.pNext = &supportedRT;
+    		vkGetPhysicalDeviceFeatures2(physicalDevice, &supportedFeatures);
+    		rayTracingSupported = supportedAS.accelerationStructure && supportedRT.rayTracingPipeline;
+    	}
+    	if (rayTracingSupported) {
+    		optionalDeviceExtensions.insert(optionalDeviceExtensions.end(), rayTracingExtensions.begin(), rayTracingExtensions.end());
+    	}
+    	else {
+    		std::cout << "Ray tracing not supported; the raytracing render mode is unavailable" << std::endl;
+    	}
+
     	// VK_NV_ray_tracing_validation — extra ray tracing validation from NVIDIA drivers
     	for (const auto& ext : availableExtensions) {
-    		if (strcmp(ext.extensionName, VK_NV_RAY_TRACING_VALIDATION_EXTENSION_NAME) == 0) {
+    		if (rayTracingSupported && strcmp(ext.extensionName, VK_NV_RAY_TRACING_VALIDATION_EXTENSION_NAME) == 0) {
     			optionalDeviceExtensions.push_back(VK_NV_RAY_TRACING_VALIDATION_EXTENSION_NAME);
     			std::cout << "Enabled optional extension: VK_NV_ray_tracing_validation" << std::endl;
     			break;
@@ -179,6 +216,9 @@ SwapChainSupportDetails Device::querySwapChainSupport(VkPhysicalDevice device)
 
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
     std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value() };
+    if (indices.computeFamily.has_value()) {
+        uniqueQueueFamilies.insert(indices.computeFamily.value());
+    }
 
     float queuePriority = 1.0f;
     for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -190,8 +230,23 @@ SwapChainSupportDetails Device::querySwapChainSupport(VkPhysicalDevice device)
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
+    // The GPU-driven path (compute culling into indirect count draws) is optional
+    VkPhysicalDeviceVulkan12Features supported12{};
+    supported12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    VkPhysicalDeviceFeatures2 supportedFeatures{};
+    supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supportedFeatures.pNext = &supported12;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &supportedFeatures);
+    gpuDrivenSupported = supported12.drawIndirectCount
+        && supportedFeatures.features.multiDrawIndirect
+        && supportedFeatures.features.drawIndirectFirstInstance;
+
     VkPhysicalDeviceFeatures deviceFeatures{};
     deviceFeatures.samplerAnisotropy = VK_TRUE;
+    if (gpuDrivenSupported) {
+        deviceFeatures.multiDrawIndirect = VK_TRUE;
+        deviceFeatures.drawIndirectFirstInstance = VK_TRUE;
+    }
 
     VkPhysicalDeviceAccelerationStructureFeaturesKHR accelerationStructureFeatures{};
     accelerationStructureFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_FEATURES_KHR;
@@ -207,7 +262,9 @@ SwapChainSupportDetails Device::querySwapChainSupport(VkPhysicalDevice device)
     vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
     vulkan12Features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
     vulkan12Features.bufferDeviceAddress = VK_TRUE;
-    vulkan12Features.pNext = &rayTracingFeatures;
+    vulkan12Features.timelineSemaphore = VK_TRUE;
+    vulkan12Features.drawIndirectCount = gpuDrivenSupported ? VK_TRUE : VK_FALSE;
+    vulkan12Features.pNext = rayTracingSupported ? &rayTracingFeatures : nullptr;
 
     VkDeviceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -239,6 +296,12 @@ SwapChainSupportDetails Device::querySwapChainSupport(VkPhysicalDevice device)
 
     vkGetDeviceQueue(device, indices.graphicsFamily.value(), 0, &graphicsQueue);
     vkGetDeviceQueue(device, indices.presentFamily.value(), 0, &presentQueue);
+    if (indices.computeFamily.has_value()) {
+        vkGetDeviceQueue(device, indices.computeFamily.value(), 0, &computeQueue);
+        std::cout << "Async compute queue family: " << indices.computeFamily.value() << std::endl;
+    }
+
+    GpuResourceRegistry::get().init(instance->getInstance(), device, instance->enableValidationLayers);
 }
 
 void Device::createBuffer(
@@ -246,7 +309,10 @@ void Device::createBuffer(
     VkBufferUsageFlags usage,
     VkMemoryPropertyFlags properties,
     VkBuffer& buffer,
-    VkDeviceMemory& bufferMemory)
+    VkDeviceMemory& bufferMemory,
+    const char* debugName,
+    const char* file,
+    int line)
 {
     VkBufferCreateInfo bufferInfo{};
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -280,6 +346,7 @@ void Device::createBuffer(
     }
 
     vkBindBufferMemory(device, buffer, bufferMemory, 0);
+    GpuResourceRegistry::get().track(buffer, memRequirements.size, debugName, file, line);
 }
 
 void Device::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
@@ -4,9 +4,13 @@
 #include <optional>
 #include <set>
 #include "VkInstance.h"
+#include "PipelineCache.h"
+#include "../utils/GpuResourceRegistry.h"
 struct QueueFamilyIndices {
 	std::optional<uint32_t> graphicsFamily;
 	std::optional<uint32_t> presentFamily;
+	// Compute-capable family without graphics support, when the GPU exposes one (async compute)
+	std::optional<uint32_t> computeFamily;
 	bool isComplete() {
 		return graphicsFamily.has_value() && presentFamily.has_value();
 	}
@@ -19,6 +23,8 @@ struct SwapChainSupportDetails {
 class Device{
 	public:
 
+	// surface may be VK_NULL_HANDLE for headless rendering: presentation is then never used and
+	// the graphics family stands in for the present family
 	Device(Instance& instance, VkSurfaceKHR surface);
 	~Device();
 	void cleanup();
@@ -31,13 +37,32 @@ class Device{
 	uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
 	VkQueue getGraphicsQueue() const { return graphicsQueue; }
 	VkQueue getPresentQueue() const { return presentQueue; }
+	// VK_NULL_HANDLE when the GPU has no dedicated compute family
+	VkQueue getComputeQueue() const { return computeQueue; }
+	bool hasAsyncCompute() const { return computeQueue != VK_NULL_HANDLE; }
+	bool isHeadless() const { return surface == VK_NULL_HANDLE; }
+	// drawIndirectCount, multiDrawIndirect and drawIndirectFirstInstance are all enabled
+	bool supportsGpuDrivenRendering() const { return gpuDrivenSupported; }
+	// The acceleration structure and ray tracing pipeline extensions and features are enabled;
+	// without them (lavapipe, most CI devices) only the graphics and compute modes can run
+	bool supportsRayTracing() const { return rayTracingSupported; }
+	// VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR, or 0 without ray tracing
+	VkBufferUsageFlags getAccelerationStructureInputUsage() const {
+		return rayTracingSupported ? VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR : 0;
+	}
+	// Passed to every pipeline creation; the application loads it at startup and saves it at shutdown
+	PipelineCache& getPipelineCache() { return pipelineCache; }
+	VkPipelineCache getPipelineCacheHandle() const { return pipelineCache.get(); }
 
 	void createBuffer(
 		VkDeviceSize size,
 		VkBufferUsageFlags usage,
 		VkMemoryPropertyFlags properties,
 		VkBuffer& buffer,
-		VkDeviceMemory& bufferMemory);
+		VkDeviceMemory& bufferMemory,
+		const char* debugName = nullptr,
+		const char* file = MK_CALLER_FILE,
+		int line = MK_CALLER_LINE);
 	
 	void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
 
@@ -47,16 +72,23 @@ private:
 	VkSurfaceKHR surface;
 	VkQueue graphicsQueue;
 	VkQueue presentQueue;
+	VkQueue computeQueue = VK_NULL_HANDLE;
+	bool gpuDrivenSupported = false;
+	bool rayTracingSupported = false;
 	Instance* instance = nullptr;
+	PipelineCache pipelineCache;
 	const std::vector<const char*> deviceExtensions = {
 		VK_KHR_SWAPCHAIN_EXTENSION_NAME,
-		VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME,
-		VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME,
-		VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME,
 		VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME,
 		VK_KHR_SPIRV_1_4_EXTENSION_NAME,
 		VK_KHR_SHADER_FLOAT_CONTROLS_EXTENSION_NAME
 	};
+	// Enabled together, and only when every one of them is available
+	const std::vector<const char*> rayTracingExtensions = {
+		VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME,
+		VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME,
+		VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME
+	};
 
 	// Optional: only enabled when the driver supports it
 	std::vector<const char*> optionalDeviceExtensions;
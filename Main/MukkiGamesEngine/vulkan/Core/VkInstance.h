@@ -20,6 +20,8 @@ public:
 	const std::vector<std::string>& getEnabledExtensions() { return enabledExtensions; }
 	static Instance* getInstancePtr() { return instancePtr; }
 	bool enableValidationLayers = true;
+	// No window system: skips GLFW's surface extensions (GLFW is never initialised)
+	bool headless = false;
 	bool checkValidationLayersSupport();
 	void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
 	const std::vector<const char*> getValidationLayers();
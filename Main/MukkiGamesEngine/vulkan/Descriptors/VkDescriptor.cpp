@@ -1,4 +1,5 @@
 #include "VkDescriptor.h"
+#include "../utils/GpuResourceRegistry.h"
 #include "../objects/UBO.h"
 #include <stdexcept>
 #include <array>
@@ -29,6 +30,7 @@ void VkDescriptorBoss::createDescriptorPool(uint32_t maxSets)
 	if (vkCreateDescriptorPool(device->getDevice(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
 		throw std::runtime_error("failed to create descriptor pool!");
 	}
+	MK_TRACK_GPU_RESOURCE(descriptorPool, 0, "descriptorBoss.pool");
 }
 
 void VkDescriptorBoss::createDescriptorSets(VkDescriptorSetLayout descriptorSetLayout, uint32_t count, std::vector<VkDescriptorSet>& descriptorSets)
@@ -132,7 +134,7 @@ void VkDescriptorBoss::updateDescriptorSets(
 void VkDescriptorBoss::destroyDescriptorPool()
 {
 	if (descriptorPool != VK_NULL_HANDLE) {
-		vkDestroyDescriptorPool(device->getDevice(), descriptorPool, nullptr);
+		GpuResourceRegistry::destroy(device->getDevice(), descriptorPool, nullptr);
 		descriptorPool = VK_NULL_HANDLE;
 	}
 }
@@ -0,0 +1,161 @@
+#include "DrawList.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace {
+
+constexpr uint32_t PASS_SHIFT = 62;
+constexpr uint32_t DEPTH_BITS = 28;
+constexpr uint32_t MATERIAL_BITS = 24;
+
+// Non-negative floats order like their bit patterns; the top 28 of the 31 value bits are kept
+uint64_t depthBits(float depth)
+{
+	depth = std::max(depth, 0.0f);
+	uint32_t bits;
+	std::memcpy(&bits, &depth, sizeof(bits));
+	return bits >> (31 - DEPTH_BITS);
+}
+
+}
+
+void DrawList::clear()
+{
+	draws.clear();
+	sorted.clear();
+	pipelines.clear();
+	modelCounts = BindCounts{};
+	modelPipeline = VK_NULL_HANDLE;
+	sortedPipelines = 0;
+	sortedDescriptorSets = 0;
+	sortedVertexBuffers = 0;
+	sortedDraws = 0;
+}
+
+void DrawList::beginObject()
+{
+	modelCounts.vertexBuffers++;
+	modelPipeline = VK_NULL_HANDLE;
+}
+
+uint32_t DrawList::getPipelineId(VkPipeline pipeline)
+{
+	for (uint32_t i = 0; i < pipelines.size(); i++) {
+		if (pipelines[i] == pipeline) {
+			return i;
+		}
+	}
+	pipelines.push_back(pipeline);
+	return std::min(static_cast<uint32_t>(pipelines.size() - 1), MAX_PIPELINES - 1);
+}
+
+void DrawList::add(Pass pass, VkPipeline pipeline, uint32_t materialId, VkDescriptorSet descriptorSet,
+	VkBuffer vertexBuffer, VkBuffer indexBuffer, uint32_t firstIndex, uint32_t indexCount, float depth)
+{
+	// The per-model path binds the material set before every draw
+	if (pipeline != modelPipeline) {
+		modelCounts.pipelines++;
+		modelPipeline = pipeline;
+	}
+	modelCounts.descriptorSets++;
+	modelCounts.draws++;
+
+	uint64_t pipelineId = getPipelineId(pipeline);
+	uint64_t material = std::min(materialId, MAX_MATERIALS - 1);
+	uint64_t key = static_cast<uint64_t>(pass) << PASS_SHIFT;
+	if (pass == Pass::Transparent) {
+		uint64_t farFirst = ((1ull << DEPTH_BITS) - 1) - depthBits(depth);
+		key |= farFirst << (PASS_SHIFT - DEPTH_BITS);
+		key |= pipelineId << MATERIAL_BITS;
+		key |= material;
+	}
+	else {
+		key |= pipelineId << (DEPTH_BITS + MATERIAL_BITS);
+		key |= material << DEPTH_BITS;
+		key |= depthBits(depth);
+	}
+
+	sorted.push_back({ key, static_cast<uint32_t>(draws.size()) });
+	draws.push_back({ pipeline, descriptorSet, vertexBuffer, indexBuffer, firstIndex, indexCount });
+}
+
+void DrawList::sort()
+{
+	// Least significant byte first; each pass is stable, so equal keys keep the order they were
+	// added in
+	size_t count = sorted.size();
+	scratch.resize(count);
+	for (uint32_t shift = 0; shift < 64 && count > 1; shift += 8) {
+		std::array<uint32_t, 256> histogram{};
+		for (const auto& entry : sorted) {
+			histogram[(entry.key >> shift) & 0xFF]++;
+		}
+		// Every key has the same byte here, so the pass would not move anything
+		if (histogram[(sorted[0].key >> shift) & 0xFF] == count) {
+			continue;
+		}
+
+		uint32_t offset = 0;
+		for (auto& bucket : histogram) {
+			uint32_t bucketCount = bucket;
+			bucket = offset;
+			offset += bucketCount;
+		}
+		for (const auto& entry : sorted) {
+			scratch[histogram[(entry.key >> shift) & 0xFF]++] = entry;
+		}
+		sorted.swap(scratch);
+	}
+}
+
+void DrawList::record(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout, uint32_t first, uint32_t count)
+{
+	// A secondary starts with nothing bound
+	BindCounts counts;
+	VkPipeline boundPipeline = VK_NULL_HANDLE;
+	VkDescriptorSet boundSet = VK_NULL_HANDLE;
+	VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
+	VkBuffer boundIndexBuffer = VK_NULL_HANDLE;
+	for (uint32_t i = first; i < first + count; i++) {
+		const Draw& draw = draws[sorted[i].index];
+		if (draw.pipeline != boundPipeline) {
+			vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, draw.pipeline);
+			boundPipeline = draw.pipeline;
+			counts.pipelines++;
+		}
+		if (draw.vertexBuffer != boundVertexBuffer) {
+			VkDeviceSize offset = 0;
+			vkCmdBindVertexBuffers(cmd, 0, 1, &draw.vertexBuffer, &offset);
+			boundVertexBuffer = draw.vertexBuffer;
+			counts.vertexBuffers++;
+		}
+		if (draw.indexBuffer != boundIndexBuffer) {
+			vkCmdBindIndexBuffer(cmd, draw.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+			boundIndexBuffer = draw.indexBuffer;
+		}
+		// Every main pass pipeline uses pipelineLayout, so set 0 survives pipeline changes
+		if (draw.descriptorSet != boundSet) {
+			vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &draw.descriptorSet, 0, nullptr);
+			boundSet = draw.descriptorSet;
+			counts.descriptorSets++;
+		}
+		vkCmdDrawIndexed(cmd, draw.indexCount, 1, draw.firstIndex, 0, 0);
+		counts.draws++;
+	}
+
+	sortedPipelines += counts.pipelines;
+	sortedDescriptorSets += counts.descriptorSets;
+	sortedVertexBuffers += counts.vertexBuffers;
+	sortedDraws += counts.draws;
+}
+
+DrawList::BindCounts DrawList::getSortedCounts() const
+{
+	BindCounts counts;
+	counts.pipelines = sortedPipelines;
+	counts.descriptorSets = sortedDescriptorSets;
+	counts.vertexBuffers = sortedVertexBuffers;
+	counts.draws = sortedDraws;
+	return counts;
+}
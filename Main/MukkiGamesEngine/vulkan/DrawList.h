@@ -0,0 +1,82 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// The main pass's draws for a whole frame, across every object. Each visible primitive is added
+// with a 64-bit sort key, the list is radix sorted once, and the sorted draws are recorded with
+// pipeline, descriptor set and vertex/index buffer binds skipped whenever the previous draw in
+// the same command buffer already bound them.
+//
+// Key layout, most significant first:
+//   Opaque, Additive: pass (2) | pipeline (10) | material (24) | depth (28), front to back
+//   Transparent:      pass (2) | depth (28), back to front | pipeline (10) | material (24)
+// Material ids are assigned by the caller; each object's material descriptor sets get their own
+// id, which also keeps an object's draws (and so its vertex buffer) together.
+class DrawList {
+public:
+	enum class Pass : uint32_t {
+		Opaque = 0,
+		Transparent = 1,
+		Additive = 2
+	};
+
+	static constexpr uint32_t MAX_PIPELINES = 1u << 10;
+	static constexpr uint32_t MAX_MATERIALS = 1u << 24;
+
+	struct BindCounts {
+		uint32_t pipelines = 0;
+		uint32_t descriptorSets = 0;
+		uint32_t vertexBuffers = 0;
+		uint32_t draws = 0;
+	};
+
+	void clear();
+	// Marks the start of an object's draws, where the per-model path rebinds its buffers and
+	// starts tracking the bound pipeline again; only feeds getModelCounts()
+	void beginObject();
+	// depth is the distance from the camera
+	void add(Pass pass, VkPipeline pipeline, uint32_t materialId, VkDescriptorSet descriptorSet,
+		VkBuffer vertexBuffer, VkBuffer indexBuffer, uint32_t firstIndex, uint32_t indexCount, float depth);
+	void sort();
+
+	// Records sorted draws [first, first + count); safe to call from several threads at once
+	void record(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout, uint32_t first, uint32_t count);
+
+	uint32_t size() const { return static_cast<uint32_t>(draws.size()); }
+	// Binds the per-model path would have issued for the same draws
+	const BindCounts& getModelCounts() const { return modelCounts; }
+	// Binds issued by record() since clear()
+	BindCounts getSortedCounts() const;
+
+private:
+	struct Draw {
+		VkPipeline pipeline;
+		VkDescriptorSet descriptorSet;
+		VkBuffer vertexBuffer;
+		VkBuffer indexBuffer;
+		uint32_t firstIndex;
+		uint32_t indexCount;
+	};
+	struct SortEntry {
+		uint64_t key;
+		uint32_t index;
+	};
+
+	uint32_t getPipelineId(VkPipeline pipeline);
+
+	std::vector<Draw> draws;
+	std::vector<SortEntry> sorted;
+	std::vector<SortEntry> scratch;
+	// Pipelines seen this frame, in order of first use; a handful at most
+	std::vector<VkPipeline> pipelines;
+
+	BindCounts modelCounts;
+	VkPipeline modelPipeline = VK_NULL_HANDLE;
+
+	std::atomic<uint32_t> sortedPipelines{ 0 };
+	std::atomic<uint32_t> sortedDescriptorSets{ 0 };
+	std::atomic<uint32_t> sortedVertexBuffers{ 0 };
+	std::atomic<uint32_t> sortedDraws{ 0 };
+};
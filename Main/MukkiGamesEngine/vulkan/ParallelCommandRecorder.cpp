@@ -0,0 +1,221 @@
+#include "ParallelCommandRecorder.h"
+#include "Core/VkDevice.h"
+#include "utils/CpuProfiler.h"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+void ParallelCommandRecorder::init(Device* device, uint32_t framesInFlight, uint32_t threadCount)
+{
+	this->device = device;
+	threadCount = std::clamp(threadCount, 1u, MAX_THREADS);
+
+	QueueFamilyIndices queueFamilyIndices = device->findQueueFamilies(device->getPhysicalDevice());
+	VkCommandPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	// Buffers are recycled by resetting the whole pool once per frame
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
+
+	threadPools.resize(framesInFlight);
+	for (auto& framePools : threadPools) {
+		framePools.resize(threadCount);
+		for (auto& threadPool : framePools) {
+			if (vkCreateCommandPool(device->getDevice(), &poolInfo, nullptr, &threadPool.pool) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create secondary command pool!");
+			}
+		}
+	}
+
+	activeThreads = threadCount;
+	stopping = false;
+	for (uint32_t thread = 1; thread < threadCount; thread++) {
+		workers.emplace_back(&ParallelCommandRecorder::workerLoop, this, thread);
+	}
+}
+
+void ParallelCommandRecorder::cleanup()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	workReady.notify_all();
+	for (auto& worker : workers) {
+		worker.join();
+	}
+	workers.clear();
+
+	for (auto& framePools : threadPools) {
+		for (auto& threadPool : framePools) {
+			// Destroying the pool frees its command buffers
+			vkDestroyCommandPool(device->getDevice(), threadPool.pool, nullptr);
+		}
+	}
+	threadPools.clear();
+	pendingSecondaries.clear();
+}
+
+void ParallelCommandRecorder::setThreadCount(uint32_t count)
+{
+	activeThreads = std::clamp(count, 1u, std::max(getMaxThreadCount(), 1u));
+}
+
+void ParallelCommandRecorder::beginFrame(uint32_t frameIndex)
+{
+	currentFrame = frameIndex;
+	for (auto& threadPool : threadPools[frameIndex]) {
+		vkResetCommandPool(device->getDevice(), threadPool.pool, 0);
+		threadPool.used = 0;
+	}
+	pendingSecondaries.clear();
+	recordMs = 0.0f;
+}
+
+VkCommandBuffer ParallelCommandRecorder::acquireSecondary(uint32_t thread, const VkCommandBufferInheritanceInfo& inheritance)
+{
+	ThreadPool& threadPool = threadPools[currentFrame][thread];
+	if (threadPool.used == threadPool.buffers.size()) {
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = threadPool.pool;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+		allocInfo.commandBufferCount = 1;
+
+		VkCommandBuffer buffer = VK_NULL_HANDLE;
+		if (vkAllocateCommandBuffers(device->getDevice(), &allocInfo, &buffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate secondary command buffer!");
+		}
+		threadPool.buffers.push_back(buffer);
+	}
+	VkCommandBuffer cmd = threadPool.buffers[threadPool.used++];
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+	beginInfo.pInheritanceInfo = &inheritance;
+	if (vkBeginCommandBuffer(cmd, &beginInfo) != VK_SUCCESS) {
+		throw std::runtime_error("failed to begin recording secondary command buffer!");
+	}
+	return cmd;
+}
+
+void ParallelCommandRecorder::recordSecondary(const VkCommandBufferInheritanceInfo& inheritance, const std::function<void(VkCommandBuffer)>& record)
+{
+	VkCommandBuffer cmd = acquireSecondary(0, inheritance);
+	record(cmd);
+	if (vkEndCommandBuffer(cmd) != VK_SUCCESS) {
+		throw std::runtime_error("failed to record secondary command buffer!");
+	}
+	pendingSecondaries.push_back(cmd);
+}
+
+void ParallelCommandRecorder::recordChunk(uint32_t thread, const Job& job)
+{
+	MK_ZONE("recordChunk");
+	uint32_t first = static_cast<uint32_t>(static_cast<uint64_t>(job.itemCount) * thread / job.chunkCount);
+	uint32_t last = static_cast<uint32_t>(static_cast<uint64_t>(job.itemCount) * (thread + 1) / job.chunkCount);
+
+	VkCommandBuffer cmd = acquireSecondary(thread, *job.inheritance);
+	(*job.record)(cmd, first, last - first);
+	if (vkEndCommandBuffer(cmd) != VK_SUCCESS) {
+		throw std::runtime_error("failed to record secondary command buffer!");
+	}
+	job.outputs[thread] = cmd;
+}
+
+void ParallelCommandRecorder::recordParallel(const VkCommandBufferInheritanceInfo& inheritance, uint32_t itemCount, const RecordFunc& record)
+{
+	if (itemCount == 0) {
+		return;
+	}
+	auto start = std::chrono::steady_clock::now();
+
+	uint32_t chunkCount = std::min(activeThreads, itemCount);
+	std::vector<VkCommandBuffer> outputs(chunkCount, VK_NULL_HANDLE);
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		job.inheritance = &inheritance;
+		job.record = &record;
+		job.itemCount = itemCount;
+		job.chunkCount = chunkCount;
+		job.outputs = outputs.data();
+		jobsRemaining = chunkCount - 1;
+		workerError = nullptr;
+		jobGeneration++;
+	}
+	if (chunkCount > 1) {
+		workReady.notify_all();
+	}
+
+	// The main thread takes the first chunk instead of idling
+	std::exception_ptr mainError;
+	try {
+		recordChunk(0, job);
+	}
+	catch (...) {
+		mainError = std::current_exception();
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		workDone.wait(lock, [this]() { return jobsRemaining == 0; });
+	}
+	if (mainError) {
+		std::rethrow_exception(mainError);
+	}
+	if (workerError) {
+		std::rethrow_exception(workerError);
+	}
+
+	pendingSecondaries.insert(pendingSecondaries.end(), outputs.begin(), outputs.end());
+	recordMs += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void ParallelCommandRecorder::executeSecondaries(VkCommandBuffer primary)
+{
+	if (pendingSecondaries.empty()) {
+		return;
+	}
+	vkCmdExecuteCommands(primary, static_cast<uint32_t>(pendingSecondaries.size()), pendingSecondaries.data());
+	pendingSecondaries.clear();
+}
+
+void ParallelCommandRecorder::workerLoop(uint32_t thread)
+{
+	CpuProfiler::get().setThreadName(("Record worker " + std::to_string(thread)).c_str());
+	uint64_t seenGeneration = 0;
+	while (true) {
+		Job current;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			workReady.wait(lock, [&]() { return stopping || jobGeneration != seenGeneration; });
+			if (stopping) {
+				return;
+			}
+			seenGeneration = jobGeneration;
+			current = job;
+		}
+		if (thread >= current.chunkCount) {
+			continue;
+		}
+
+		std::exception_ptr error;
+		try {
+			recordChunk(thread, current);
+		}
+		catch (...) {
+			error = std::current_exception();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (error && !workerError) {
+				workerError = error;
+			}
+			jobsRemaining--;
+		}
+		workDone.notify_one();
+	}
+}
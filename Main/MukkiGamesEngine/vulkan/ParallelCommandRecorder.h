@@ -0,0 +1,85 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class Device;
+
+// Records the contents of a render pass into secondary command buffers on several threads.
+// Every recording thread owns one command pool per frame slot, so no pool is ever touched by
+// two threads and a slot's pools can be reset wholesale once the GPU is done with that slot.
+// The main thread records chunk 0 itself and any single secondaries (skybox, UI); the
+// collected secondaries are executed in the order they were requested.
+class ParallelCommandRecorder {
+public:
+	static constexpr uint32_t MAX_THREADS = 16;
+
+	// Records items [first, first + count) into cmd
+	using RecordFunc = std::function<void(VkCommandBuffer cmd, uint32_t first, uint32_t count)>;
+
+	void init(Device* device, uint32_t framesInFlight, uint32_t threadCount);
+	// Stops the workers and destroys the pools; the device must be idle
+	void cleanup();
+
+	// Clamped to [1, the number of threads started at init]
+	void setThreadCount(uint32_t count);
+	uint32_t getThreadCount() const { return activeThreads; }
+	uint32_t getMaxThreadCount() const { return static_cast<uint32_t>(threadPools.empty() ? 0 : threadPools[0].size()); }
+
+	// Recycles the slot's command buffers; the slot's previous submission must have completed
+	void beginFrame(uint32_t frameIndex);
+
+	// Records one secondary on the calling thread
+	void recordSecondary(const VkCommandBufferInheritanceInfo& inheritance, const std::function<void(VkCommandBuffer)>& record);
+	// Splits itemCount into one contiguous chunk per active thread and records them in parallel
+	void recordParallel(const VkCommandBufferInheritanceInfo& inheritance, uint32_t itemCount, const RecordFunc& record);
+	// Executes everything recorded since the last call; the render pass must have been begun
+	// with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+	void executeSecondaries(VkCommandBuffer primary);
+
+	// Wall time of the recordParallel calls of the current frame
+	float getRecordMs() const { return recordMs; }
+
+private:
+	struct ThreadPool {
+		VkCommandPool pool = VK_NULL_HANDLE;
+		std::vector<VkCommandBuffer> buffers;
+		uint32_t used = 0;
+	};
+
+	struct Job {
+		const VkCommandBufferInheritanceInfo* inheritance = nullptr;
+		const RecordFunc* record = nullptr;
+		uint32_t itemCount = 0;
+		uint32_t chunkCount = 0;
+		// One secondary per chunk, filled in by the thread recording it
+		VkCommandBuffer* outputs = nullptr;
+	};
+
+	VkCommandBuffer acquireSecondary(uint32_t thread, const VkCommandBufferInheritanceInfo& inheritance);
+	void recordChunk(uint32_t thread, const Job& job);
+	void workerLoop(uint32_t thread);
+
+	Device* device = nullptr;
+	// [frame slot][thread], thread 0 is the main thread
+	std::vector<std::vector<ThreadPool>> threadPools;
+	uint32_t currentFrame = 0;
+	uint32_t activeThreads = 1;
+	std::vector<VkCommandBuffer> pendingSecondaries;
+	float recordMs = 0.0f;
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable workReady;
+	std::condition_variable workDone;
+	Job job;
+	uint64_t jobGeneration = 0;
+	uint32_t jobsRemaining = 0;
+	std::exception_ptr workerError;
+	bool stopping = false;
+};
@@ -0,0 +1,183 @@
+#include "SimulationThread.h"
+#include "PhysicsEngine.h"
+#include "VehiclePhysics.h"
+#include "../utils/CpuProfiler.h"
+#include <algorithm>
+#include <chrono>
+
+double SimulationThread::clock()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SimulationThread::start(PhysicsEngine* engine, const std::vector<SimBody>& bodies, float tickRate, bool lockstep)
+{
+	stop();
+
+	this->engine = engine;
+	this->bodies = bodies;
+	this->lockstep = lockstep;
+	tickDelta = 1.0f / tickRate;
+	input = SimInput{};
+	tickCount = 0;
+	captureBodies(lastBodies);
+	active = true;
+
+	if (!lockstep) {
+		running = true;
+		thread = std::thread(&SimulationThread::run, this);
+	}
+}
+
+void SimulationThread::stop()
+{
+	if (!active) {
+		return;
+	}
+	if (thread.joinable()) {
+		running = false;
+		thread.join();
+	}
+	active = false;
+	lockstep = false;
+
+	// A restarted simulation must not serve the old world's snapshots
+	for (auto& snapshot : snapshots) {
+		snapshot.tick = 0;
+	}
+	sharedSlot = 2;
+	writeSlot = 0;
+	readSlot = 1;
+	readTick = 0;
+	bodies.clear();
+	engine = nullptr;
+}
+
+void SimulationThread::run()
+{
+	using Clock = std::chrono::steady_clock;
+	const auto tickDuration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(tickDelta));
+
+	CpuProfiler::get().setThreadName("Simulation");
+
+	Clock::time_point tickStart = Clock::now();
+	while (running) {
+		// The tick advances the world from tickStart to tickStart + dt ahead of real time, so
+		// the render thread can interpolate up to its own "now"
+		Clock::time_point tickEnd = tickStart + tickDuration;
+		tick(std::chrono::duration<double>(tickStart.time_since_epoch()).count(),
+			std::chrono::duration<double>(tickEnd.time_since_epoch()).count());
+
+		tickStart = tickEnd;
+		Clock::time_point now = Clock::now();
+		if (now - tickStart > std::chrono::milliseconds(250)) {
+			// Fell far behind (breakpoint, long stall); resynchronise instead of spiralling
+			tickStart = now;
+		}
+		else {
+			std::this_thread::sleep_until(tickStart);
+		}
+	}
+}
+
+void SimulationThread::advance(double time)
+{
+	if (!active || !lockstep) {
+		return;
+	}
+	// Tick times are derived from the tick count rather than accumulated, so a replay lands on
+	// exactly the same ticks
+	while (tickCount * static_cast<double>(tickDelta) < time) {
+		tick(tickCount * static_cast<double>(tickDelta), (tickCount + 1) * static_cast<double>(tickDelta));
+	}
+}
+
+void SimulationThread::tick(double startTime, double endTime)
+{
+	MK_ZONE("physicsTick");
+	// Only the latest input matters; it stays applied until a newer one arrives
+	SimInput pending;
+	while (inputQueue.pop(pending)) {
+		input = pending;
+	}
+	applyInput(input);
+	{
+		MK_ZONE("physicsStep");
+		engine->step(tickDelta);
+	}
+
+	Snapshot& snapshot = snapshots[writeSlot];
+	snapshot.tick = ++tickCount;
+	snapshot.previousTime = startTime;
+	snapshot.time = endTime;
+	snapshot.previous = lastBodies;
+	captureBodies(snapshot.current);
+	lastBodies = snapshot.current;
+	publish();
+}
+
+void SimulationThread::applyInput(const SimInput& input)
+{
+	for (const auto& body : bodies) {
+		if (!body.vehicle) continue;
+
+		body.vehicle->setInput(input.throttle, input.brake, input.steering);
+
+		JPH::BodyID id(body.bodyID);
+		if (input.throttle > 0.0f || input.brake > 0.0f) {
+			JPH::Vec3 fwd = engine->getBodyInterface().GetRotation(id) * JPH::Vec3(0, 0, 1);
+			float forceMagnitude = input.throttle > 0.0f ? 3000.0f : -1000.0f;
+			engine->getBodyInterface().AddForce(id, fwd * forceMagnitude);
+		}
+		if (input.steering != 0.0f) {
+			engine->getBodyInterface().AddTorque(id, JPH::Vec3(0, input.steering * 200.0f, 0));
+		}
+	}
+}
+
+void SimulationThread::captureBodies(std::vector<SimBodyState>& out) const
+{
+	out.resize(bodies.size());
+	for (size_t i = 0; i < bodies.size(); i++) {
+		SimBodyState& state = out[i];
+		state.position = engine->getBodyPosition(bodies[i].bodyID);
+		state.rotation = engine->getBodyRotation(bodies[i].bodyID);
+		if (bodies[i].vehicle) {
+			state.speed = bodies[i].vehicle->getSpeed();
+			state.rpm = bodies[i].vehicle->getRPM();
+			state.gear = bodies[i].vehicle->getCurrentGear();
+		}
+	}
+}
+
+void SimulationThread::publish()
+{
+	writeSlot = sharedSlot.exchange(writeSlot | FRESH_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+}
+
+bool SimulationThread::sample(double renderTime, std::vector<SimBodyState>& out)
+{
+	if (sharedSlot.load(std::memory_order_acquire) & FRESH_BIT) {
+		readSlot = sharedSlot.exchange(readSlot, std::memory_order_acq_rel) & INDEX_MASK;
+	}
+
+	const Snapshot& snapshot = snapshots[readSlot];
+	if (snapshot.tick == 0) {
+		return false;
+	}
+	readTick = snapshot.tick;
+
+	double span = snapshot.time - snapshot.previousTime;
+	float alpha = span > 0.0 ? static_cast<float>((renderTime - snapshot.previousTime) / span) : 1.0f;
+	alpha = std::clamp(alpha, 0.0f, 1.0f);
+
+	out.resize(snapshot.current.size());
+	for (size_t i = 0; i < snapshot.current.size(); i++) {
+		const SimBodyState& from = snapshot.previous[i];
+		const SimBodyState& to = snapshot.current[i];
+		out[i] = to;
+		out[i].position = glm::mix(from.position, to.position, alpha);
+		out[i].rotation = glm::slerp(from.rotation, to.rotation, alpha);
+	}
+	return true;
+}
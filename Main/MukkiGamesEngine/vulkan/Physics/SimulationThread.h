@@ -0,0 +1,116 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "../utils/SpscQueue.h"
+
+class PhysicsEngine;
+class VehiclePhysics;
+
+// Player input, produced once per render frame by processInput
+struct SimInput {
+	float throttle = 0.0f;
+	float brake = 0.0f;
+	float steering = 0.0f;
+};
+
+// A physics body mirrored into a LoadedObject
+struct SimBody {
+	uint32_t objectIndex = 0;
+	uint32_t bodyID = 0xFFFFFFFF;
+	// Owned by the LoadedObject, only touched by the simulation thread while it runs
+	VehiclePhysics* vehicle = nullptr;
+};
+
+struct SimBodyState {
+	glm::vec3 position = glm::vec3(0.0f);
+	glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+	float speed = 0.0f;
+	float rpm = 0.0f;
+	int gear = 0;
+};
+
+// Steps the physics world on its own thread at a fixed rate. After every tick it publishes a
+// snapshot of all bodies through a triple buffer, so neither side ever waits on the other: a
+// render hitch no longer delays physics and a slow physics tick no longer delays a frame.
+// Each snapshot carries the two latest ticks, which is all the render thread needs to
+// interpolate at its own timestamp.
+//
+// While the thread runs the physics engine and the vehicles belong to it; stop() before
+// adding, removing or reading bodies from anywhere else.
+//
+// In lockstep mode no thread is started: the owner calls advance() with its own timestamps,
+// which runs the same ticks on the calling thread, so replays are independent of scheduling.
+class SimulationThread {
+public:
+	~SimulationThread() { stop(); }
+
+	void start(PhysicsEngine* engine, const std::vector<SimBody>& bodies, float tickRate = 60.0f, bool lockstep = false);
+	void stop();
+	bool isRunning() const { return active; }
+	bool isLockstep() const { return lockstep; }
+
+	// Lockstep only: ticks until the world has reached time (seconds since start()), so that
+	// sample(time) interpolates between the two latest ticks
+	void advance(double time);
+
+	// Render thread side; dropped when the simulation falls behind by a full queue of frames
+	void pushInput(const SimInput& input) { inputQueue.push(input); }
+
+	// Interpolates the latest snapshot at renderTime (seconds on clock()); out is indexed like
+	// getBodies(). Returns false until the first tick has been published.
+	bool sample(double renderTime, std::vector<SimBodyState>& out);
+
+	const std::vector<SimBody>& getBodies() const { return bodies; }
+	float getTickDelta() const { return tickDelta; }
+	uint64_t getTickCount() const { return readTick; }
+
+	// Shared timebase of snapshot timestamps and render timestamps
+	static double clock();
+
+private:
+	struct Snapshot {
+		uint64_t tick = 0;
+		double previousTime = 0.0;
+		double time = 0.0;
+		std::vector<SimBodyState> previous;
+		std::vector<SimBodyState> current;
+	};
+
+	void run();
+	// One fixed step from startTime to endTime, published as a snapshot
+	void tick(double startTime, double endTime);
+	void applyInput(const SimInput& input);
+	void captureBodies(std::vector<SimBodyState>& out) const;
+	void publish();
+
+	static constexpr uint32_t FRESH_BIT = 4;
+	static constexpr uint32_t INDEX_MASK = 3;
+
+	PhysicsEngine* engine = nullptr;
+	std::vector<SimBody> bodies;
+	float tickDelta = 1.0f / 60.0f;
+
+	std::thread thread;
+	std::atomic<bool> running{ false };
+	bool active = false;
+	bool lockstep = false;
+	SpscQueue<SimInput, 64> inputQueue;
+
+	// Owned by whichever thread steps the world
+	SimInput input;
+	std::vector<SimBodyState> lastBodies;
+	uint64_t tickCount = 0;
+
+	// Triple buffer: the writer fills snapshots[writeSlot], swaps it with the shared slot and
+	// marks it fresh; the reader swaps readSlot with the shared slot only when it is fresh
+	std::array<Snapshot, 3> snapshots;
+	std::atomic<uint32_t> sharedSlot{ 2 };
+	uint32_t writeSlot = 0;
+	uint32_t readSlot = 1;
+	uint64_t readTick = 0;
+};
@@ -0,0 +1,558 @@
+#include "RenderGraph.h"
+#include "Core/VkDevice.h"
+#include "Resources/TextureManager.h"
+#include "Resources/DeletionQueue.h"
+#include "utils/GpuProfiler.h"
+#include "utils/CpuProfiler.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+struct UsageInfo {
+	VkImageLayout layout;
+	VkPipelineStageFlags stage;
+	VkAccessFlags readAccess;
+	VkAccessFlags writeAccess;
+};
+
+UsageInfo getUsageInfo(RenderGraph::Usage usage)
+{
+	switch (usage) {
+	case RenderGraph::Usage::ColorAttachment:
+		return { VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			VK_ACCESS_COLOR_ATTACHMENT_READ_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT };
+	case RenderGraph::Usage::DepthAttachment:
+		return { VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT };
+	case RenderGraph::Usage::SampledFragment:
+		return { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			VK_ACCESS_SHADER_READ_BIT, 0 };
+	case RenderGraph::Usage::SampledCompute:
+		return { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_ACCESS_SHADER_READ_BIT, 0 };
+	case RenderGraph::Usage::StorageCompute:
+		return { VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_SHADER_WRITE_BIT };
+	case RenderGraph::Usage::StorageRayTracing:
+		return { VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
+			VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_SHADER_WRITE_BIT };
+	case RenderGraph::Usage::TransferSrc:
+		return { VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_ACCESS_TRANSFER_READ_BIT, 0 };
+	case RenderGraph::Usage::TransferDst:
+		return { VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, VK_ACCESS_TRANSFER_WRITE_BIT };
+	}
+	return { VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+		VK_ACCESS_MEMORY_READ_BIT, VK_ACCESS_MEMORY_WRITE_BIT };
+}
+
+const VkAccessFlags WRITE_ACCESS_MASK =
+	VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+	VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT |
+	VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+bool sameDesc(const RenderGraph::ImageDesc& a, const RenderGraph::ImageDesc& b)
+{
+	return a.format == b.format && a.extent.width == b.extent.width && a.extent.height == b.extent.height &&
+		a.usage == b.usage && a.aspect == b.aspect;
+}
+
+}
+
+void RenderGraph::PassBuilder::read(ResourceId id, Usage usage)
+{
+	graph.passes[pass].accesses.push_back({ id, usage, true, false, VK_IMAGE_LAYOUT_UNDEFINED });
+}
+
+void RenderGraph::PassBuilder::write(ResourceId id, Usage usage, VkImageLayout layoutAfter)
+{
+	graph.passes[pass].accesses.push_back({ id, usage, false, true, layoutAfter });
+}
+
+void RenderGraph::PassBuilder::readWrite(ResourceId id, Usage usage, VkImageLayout layoutAfter)
+{
+	graph.passes[pass].accesses.push_back({ id, usage, true, true, layoutAfter });
+}
+
+void RenderGraph::PassBuilder::setSideEffects()
+{
+	graph.passes[pass].sideEffects = true;
+}
+
+void RenderGraph::init(Device* device, TextureManager* textureManager, FrameDeletionQueue* retireQueue)
+{
+	this->device = device;
+	this->textureManager = textureManager;
+	this->retireQueue = retireQueue;
+}
+
+void RenderGraph::cleanup()
+{
+	for (auto& physical : physicalImages) {
+		destroyPhysicalImage(physical, false);
+	}
+	physicalImages.clear();
+	reset();
+}
+
+void RenderGraph::setAsyncComputeQueue(uint32_t graphicsFamily, uint32_t computeFamily)
+{
+	this->graphicsFamily = graphicsFamily;
+	this->computeFamily = computeFamily;
+}
+
+void RenderGraph::reset()
+{
+	passes.clear();
+	resources.clear();
+	exports.clear();
+	graphicsExportReleases.clear();
+	asyncExportReleases.clear();
+	asyncWaitStages = 0;
+	stats = Stats{};
+}
+
+RenderGraph::ResourceId RenderGraph::importImage(const char* name, VkImage image, VkImageAspectFlags aspect, const ImageState& current)
+{
+	Resource resource;
+	resource.name = name;
+	resource.image = image;
+	resource.aspect = aspect;
+	resource.state = current;
+	resources.push_back(std::move(resource));
+	return static_cast<ResourceId>(resources.size() - 1);
+}
+
+RenderGraph::ResourceId RenderGraph::createImage(const ImageDesc& desc)
+{
+	Resource resource;
+	resource.name = desc.name;
+	resource.aspect = desc.aspect;
+	resource.transient = true;
+	resource.desc = desc;
+	resources.push_back(std::move(resource));
+	return static_cast<ResourceId>(resources.size() - 1);
+}
+
+void RenderGraph::addPass(const char* name, Queue queue, const SetupFunc& setup, ExecuteFunc execute)
+{
+	Pass pass;
+	pass.name = name;
+	pass.queue = queue;
+	pass.execute = std::move(execute);
+	passes.push_back(std::move(pass));
+
+	PassBuilder builder(*this, static_cast<uint32_t>(passes.size() - 1));
+	setup(builder);
+}
+
+void RenderGraph::markOutput(ResourceId id)
+{
+	resources[id].output = true;
+}
+
+void RenderGraph::exportImage(ResourceId id, Queue nextQueue)
+{
+	markOutput(id);
+	exports.push_back({ id, nextQueue });
+}
+
+bool RenderGraph::usesAsyncQueue() const
+{
+	if (!asyncExportReleases.empty()) {
+		return true;
+	}
+	if (!asyncEnabled()) {
+		return false;
+	}
+	for (const auto& pass : passes) {
+		if (!pass.culled && pass.queue == Queue::AsyncCompute) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void RenderGraph::compile()
+{
+	MK_ZONE("compileGraph");
+	cullPasses();
+	validateQueues();
+	assignPhysicalImages();
+	buildBarriers();
+	buildExportReleases();
+
+	stats.barrierCount = static_cast<uint32_t>(graphicsExportReleases.size() + asyncExportReleases.size());
+	for (const auto& pass : passes) {
+		if (pass.culled) {
+			stats.culledPasses++;
+		}
+		else {
+			stats.passCount++;
+			stats.barrierCount += static_cast<uint32_t>(pass.barriers.size() + pass.releases.size());
+		}
+	}
+}
+
+void RenderGraph::cullPasses()
+{
+	// Walk backwards keeping only passes that contribute to an output. A pure write ends the
+	// resource's dependency chain; earlier writers are only needed if something read in between.
+	std::vector<bool> needed(resources.size(), false);
+	for (size_t i = 0; i < resources.size(); i++) {
+		needed[i] = resources[i].output;
+	}
+
+	for (size_t p = passes.size(); p-- > 0;) {
+		Pass& pass = passes[p];
+		bool alive = pass.sideEffects;
+		for (const auto& access : pass.accesses) {
+			if (access.writes && needed[access.resource]) {
+				alive = true;
+			}
+		}
+		pass.culled = !alive;
+		if (!alive) {
+			continue;
+		}
+
+		for (const auto& access : pass.accesses) {
+			if (access.writes && !access.reads) {
+				needed[access.resource] = false;
+			}
+		}
+		for (const auto& access : pass.accesses) {
+			if (access.reads) {
+				needed[access.resource] = true;
+			}
+		}
+	}
+}
+
+void RenderGraph::validateQueues() const
+{
+	if (!asyncEnabled()) {
+		return;
+	}
+
+	// The async command buffer is submitted after the graphics one, so a graphics pass can not
+	// consume anything an async pass touches in the same frame
+	for (size_t p = 0; p < passes.size(); p++) {
+		if (passes[p].culled || passes[p].queue != Queue::AsyncCompute) {
+			continue;
+		}
+		for (const auto& access : passes[p].accesses) {
+			for (size_t later = p + 1; later < passes.size(); later++) {
+				if (passes[later].culled || passes[later].queue != Queue::Graphics) {
+					continue;
+				}
+				for (const auto& laterAccess : passes[later].accesses) {
+					if (laterAccess.resource == access.resource) {
+						throw std::runtime_error("render graph: graphics pass '" + passes[later].name +
+							"' uses '" + resources[access.resource].name + "' after async pass '" + passes[p].name + "'!");
+					}
+				}
+			}
+		}
+	}
+}
+
+void RenderGraph::assignPhysicalImages()
+{
+	for (size_t p = 0; p < passes.size(); p++) {
+		if (passes[p].culled) {
+			continue;
+		}
+		for (const auto& access : passes[p].accesses) {
+			Resource& resource = resources[access.resource];
+			resource.firstPass = std::min(resource.firstPass, static_cast<uint32_t>(p));
+			resource.lastPass = std::max(resource.lastPass, static_cast<uint32_t>(p));
+		}
+	}
+
+	std::vector<ResourceId> transients;
+	for (size_t i = 0; i < resources.size(); i++) {
+		if (resources[i].transient && resources[i].firstPass != UINT32_MAX) {
+			transients.push_back(static_cast<ResourceId>(i));
+		}
+	}
+	std::sort(transients.begin(), transients.end(), [this](ResourceId a, ResourceId b) {
+		return resources[a].firstPass < resources[b].firstPass;
+	});
+
+	for (auto& physical : physicalImages) {
+		physical.assigned = false;
+		physical.busyUntil = 0;
+	}
+
+	// Greedy interval placement: reuse any compatible image whose current occupant is done
+	for (ResourceId id : transients) {
+		Resource& resource = resources[id];
+		uint32_t chosen = UINT32_MAX;
+		for (size_t i = 0; i < physicalImages.size(); i++) {
+			PhysicalImage& physical = physicalImages[i];
+			if (sameDesc(physical.desc, resource.desc) &&
+				(!physical.assigned || physical.busyUntil < resource.firstPass)) {
+				chosen = static_cast<uint32_t>(i);
+				break;
+			}
+		}
+
+		if (chosen == UINT32_MAX) {
+			PhysicalImage physical;
+			physical.desc = resource.desc;
+			textureManager->createImage(resource.desc.extent.width, resource.desc.extent.height,
+				resource.desc.format, VK_IMAGE_TILING_OPTIMAL, resource.desc.usage,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, physical.image, physical.memory, false, resource.desc.name);
+			physical.view = textureManager->createImageView(physical.image, resource.desc.format,
+				resource.desc.aspect, false, resource.desc.name);
+			physicalImages.push_back(physical);
+			chosen = static_cast<uint32_t>(physicalImages.size() - 1);
+		}
+
+		PhysicalImage& physical = physicalImages[chosen];
+		if (!physical.assigned) {
+			// Earlier submissions on the queue may still use the image
+			physical.state = { VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_WRITE_BIT };
+		}
+		physical.assigned = true;
+		physical.busyUntil = resource.lastPass;
+		resource.physical = chosen;
+	}
+
+	// Images no pass needed this frame go back to the allocator once the GPU is done with them
+	std::vector<uint32_t> remap(physicalImages.size(), UINT32_MAX);
+	size_t kept = 0;
+	for (size_t i = 0; i < physicalImages.size(); i++) {
+		if (physicalImages[i].assigned) {
+			remap[i] = static_cast<uint32_t>(kept);
+			physicalImages[kept++] = physicalImages[i];
+		}
+		else {
+			destroyPhysicalImage(physicalImages[i], true);
+		}
+	}
+	physicalImages.resize(kept);
+
+	for (ResourceId id : transients) {
+		Resource& resource = resources[id];
+		resource.physical = remap[resource.physical];
+		resource.image = physicalImages[resource.physical].image;
+		resource.view = physicalImages[resource.physical].view;
+	}
+
+	stats.transientImages = static_cast<uint32_t>(transients.size());
+	stats.physicalImages = static_cast<uint32_t>(physicalImages.size());
+}
+
+void RenderGraph::buildBarriers()
+{
+	for (auto& pass : passes) {
+		if (pass.culled) {
+			continue;
+		}
+		Queue passQueue = asyncEnabled() ? pass.queue : Queue::Graphics;
+
+		for (const auto& access : pass.accesses) {
+			Resource& resource = resources[access.resource];
+			if (resource.transient && resource.firstPass != UINT32_MAX &&
+				&pass == &passes[resource.firstPass]) {
+				// Contents start undefined; wait for whatever used the physical image before
+				resource.state = physicalImages[resource.physical].state;
+				resource.state.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+			}
+
+			UsageInfo info = getUsageInfo(access.usage);
+			VkAccessFlags accessMask = (access.reads ? info.readAccess : 0) | (access.writes ? info.writeAccess : 0);
+			ImageState& state = resource.state;
+
+			bool layoutChange = state.layout != info.layout;
+			bool pendingWrite = (state.access & WRITE_ACCESS_MASK) != 0;
+			bool queueChange = state.queue != passQueue;
+			// The previous frame already released an imported image to this queue
+			bool acquireOnly = !resource.transient && !resource.touched;
+			resource.touched = true;
+
+			if (layoutChange || pendingWrite || access.writes || queueChange) {
+				Barrier barrier{};
+				barrier.barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+				barrier.barrier.oldLayout = state.layout;
+				barrier.barrier.newLayout = info.layout;
+				barrier.barrier.srcAccessMask = state.access & WRITE_ACCESS_MASK;
+				barrier.barrier.dstAccessMask = accessMask;
+				barrier.barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.barrier.image = resource.image;
+				barrier.barrier.subresourceRange.aspectMask = resource.aspect;
+				barrier.barrier.subresourceRange.baseMipLevel = 0;
+				barrier.barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+				barrier.barrier.subresourceRange.baseArrayLayer = 0;
+				barrier.barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+				barrier.srcStage = state.stage;
+				barrier.dstStage = info.stage;
+
+				// Discarded contents need no ownership transfer
+				if (queueChange && state.layout != VK_IMAGE_LAYOUT_UNDEFINED) {
+					barrier.barrier.srcQueueFamilyIndex = getFamily(state.queue);
+					barrier.barrier.dstQueueFamilyIndex = getFamily(passQueue);
+
+					if (acquireOnly) {
+						if (passQueue == Queue::Graphics) {
+							asyncWaitStages |= info.stage;
+						}
+					}
+					else {
+						Barrier release = barrier;
+						release.barrier.dstAccessMask = 0;
+						release.dstStage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+						pass.releases.push_back(release);
+					}
+
+					barrier.barrier.srcAccessMask = 0;
+					barrier.srcStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+				}
+				pass.barriers.push_back(barrier);
+
+				state = { info.layout, info.stage, accessMask, passQueue };
+			}
+			else {
+				// Read after read in the same layout: later writers have to wait for both readers
+				state.stage |= info.stage;
+				state.access |= accessMask;
+			}
+
+			if (access.layoutAfter != VK_IMAGE_LAYOUT_UNDEFINED) {
+				state.layout = access.layoutAfter;
+			}
+			state.queue = passQueue;
+			if (resource.transient) {
+				physicalImages[resource.physical].state = state;
+			}
+		}
+	}
+}
+
+void RenderGraph::buildExportReleases()
+{
+	for (const auto& exported : exports) {
+		Resource& resource = resources[exported.resource];
+		ImageState& state = resource.state;
+		if (!resource.touched || state.queue == exported.nextQueue || state.layout == VK_IMAGE_LAYOUT_UNDEFINED) {
+			continue;
+		}
+
+		// Layout stays put; the acquire next frame repeats it with the same layouts
+		Barrier release{};
+		release.barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		release.barrier.oldLayout = state.layout;
+		release.barrier.newLayout = state.layout;
+		release.barrier.srcAccessMask = state.access & WRITE_ACCESS_MASK;
+		release.barrier.dstAccessMask = 0;
+		release.barrier.srcQueueFamilyIndex = getFamily(state.queue);
+		release.barrier.dstQueueFamilyIndex = getFamily(exported.nextQueue);
+		release.barrier.image = resource.image;
+		release.barrier.subresourceRange.aspectMask = resource.aspect;
+		release.barrier.subresourceRange.baseMipLevel = 0;
+		release.barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+		release.barrier.subresourceRange.baseArrayLayer = 0;
+		release.barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+		release.srcStage = state.stage;
+		release.dstStage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+		if (state.queue == Queue::Graphics) {
+			graphicsExportReleases.push_back(release);
+		}
+		else {
+			asyncExportReleases.push_back(release);
+		}
+	}
+}
+
+void RenderGraph::execute(VkCommandBuffer graphicsCmd, VkCommandBuffer asyncComputeCmd)
+{
+	MK_ZONE("executeGraph");
+	for (auto& pass : passes) {
+		if (pass.culled) {
+			continue;
+		}
+
+		VkCommandBuffer cmd = graphicsCmd;
+		VkCommandBuffer otherCmd = asyncComputeCmd;
+		bool onAsyncQueue = asyncEnabled() && pass.queue == Queue::AsyncCompute;
+		if (onAsyncQueue) {
+			if (asyncComputeCmd == VK_NULL_HANDLE) {
+				throw std::runtime_error("render graph: async compute pass recorded without a compute command buffer!");
+			}
+			std::swap(cmd, otherCmd);
+		}
+
+		if (!pass.releases.empty()) {
+			recordBarriers(otherCmd, pass.releases);
+		}
+		// Barriers count towards the pass, so time spent waiting on its inputs shows up there
+		uint32_t zone = profiler ? profiler->beginZone(cmd, pass.name.c_str(), onAsyncQueue) : GpuProfiler::INVALID_ZONE;
+		recordBarriers(cmd, pass.barriers);
+		if (pass.execute) {
+			pass.execute(cmd);
+		}
+		if (profiler) {
+			profiler->endZone(cmd, zone);
+		}
+	}
+
+	recordBarriers(graphicsCmd, graphicsExportReleases);
+	if (!asyncExportReleases.empty()) {
+		if (asyncComputeCmd == VK_NULL_HANDLE) {
+			throw std::runtime_error("render graph: async compute release recorded without a compute command buffer!");
+		}
+		recordBarriers(asyncComputeCmd, asyncExportReleases);
+	}
+}
+
+void RenderGraph::recordBarriers(VkCommandBuffer cmd, const std::vector<Barrier>& barriers)
+{
+	if (barriers.empty()) {
+		return;
+	}
+
+	std::vector<VkImageMemoryBarrier> imageBarriers;
+	imageBarriers.reserve(barriers.size());
+	VkPipelineStageFlags srcStage = 0;
+	VkPipelineStageFlags dstStage = 0;
+	for (const auto& barrier : barriers) {
+		imageBarriers.push_back(barrier.barrier);
+		srcStage |= barrier.srcStage;
+		dstStage |= barrier.dstStage;
+	}
+
+	vkCmdPipelineBarrier(
+		cmd,
+		srcStage ? srcStage : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+		dstStage ? dstStage : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+		0,
+		0, nullptr,
+		0, nullptr,
+		static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data()
+	);
+}
+
+void RenderGraph::destroyPhysicalImage(PhysicalImage& physical, bool retire)
+{
+	if (retire && retireQueue) {
+		retireQueue->retireImage(device->getDevice(), physical.image, physical.memory, physical.view);
+	}
+	else {
+		if (physical.view != VK_NULL_HANDLE) {
+			textureManager->destroyImageView(physical.view);
+		}
+		if (physical.image != VK_NULL_HANDLE) {
+			textureManager->destroyImage(physical.image, physical.memory);
+		}
+	}
+	physical.image = VK_NULL_HANDLE;
+	physical.memory = VK_NULL_HANDLE;
+	physical.view = VK_NULL_HANDLE;
+}
@@ -0,0 +1,216 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+class Device;
+class TextureManager;
+class FrameDeletionQueue;
+class GpuProfiler;
+
+// Per-frame render graph. Passes declare the images they read and write; compile() drops
+// passes whose results nobody consumes, places transient images with disjoint lifetimes on
+// the same physical image, and works out every layout transition and barrier, so the
+// recording callbacks only contain draws, dispatches and copies.
+//
+// The graph is rebuilt every frame (reset, import/create, addPass, compile, execute); the
+// physical images behind transient resources are cached across frames.
+class RenderGraph {
+public:
+	using ResourceId = uint32_t;
+	static constexpr ResourceId InvalidResource = UINT32_MAX;
+
+	enum class Usage {
+		ColorAttachment,
+		DepthAttachment,
+		SampledFragment,
+		SampledCompute,
+		StorageCompute,
+		StorageRayTracing,
+		TransferSrc,
+		TransferDst
+	};
+
+	enum class Queue {
+		Graphics,
+		// Recorded into the async compute command buffer when one is configured, otherwise inline
+		AsyncCompute
+	};
+
+	// Layout and last access of an image; for imported images this is the state the previous
+	// user left it in (a layout of UNDEFINED discards the contents). An imported image owned by
+	// the other queue must have been released to its first user here by exportImage.
+	struct ImageState {
+		VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VkPipelineStageFlags stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		VkAccessFlags access = 0;
+		Queue queue = Queue::Graphics;
+	};
+
+	struct ImageDesc {
+		const char* name = "";
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		VkExtent2D extent{};
+		VkImageUsageFlags usage = 0;
+		VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+	};
+
+	struct Stats {
+		uint32_t passCount = 0;
+		uint32_t culledPasses = 0;
+		uint32_t barrierCount = 0;
+		uint32_t transientImages = 0;
+		uint32_t physicalImages = 0;
+	};
+
+	class PassBuilder {
+	public:
+		void read(ResourceId id, Usage usage);
+		// layoutAfter is the layout a VkRenderPass leaves the attachment in (its finalLayout)
+		void write(ResourceId id, Usage usage, VkImageLayout layoutAfter = VK_IMAGE_LAYOUT_UNDEFINED);
+		void readWrite(ResourceId id, Usage usage, VkImageLayout layoutAfter = VK_IMAGE_LAYOUT_UNDEFINED);
+		// Keeps the pass even when nothing reads what it writes
+		void setSideEffects();
+
+	private:
+		friend class RenderGraph;
+		PassBuilder(RenderGraph& graph, uint32_t pass) : graph(graph), pass(pass) {}
+		RenderGraph& graph;
+		uint32_t pass;
+	};
+
+	using SetupFunc = std::function<void(PassBuilder&)>;
+	using ExecuteFunc = std::function<void(VkCommandBuffer)>;
+
+	void init(Device* device, TextureManager* textureManager, FrameDeletionQueue* retireQueue);
+	// Destroys the cached transient images immediately; the device must be idle
+	void cleanup();
+	// Enables recording AsyncCompute passes into a separate command buffer on computeFamily
+	void setAsyncComputeQueue(uint32_t graphicsFamily, uint32_t computeFamily);
+	// Runtime switch; images the async queue still owns are handed back through acquires
+	void setAsyncComputeEnabled(bool enabled) { asyncRequested = enabled; }
+	// Brackets every executed pass with a profiler zone named after it
+	void setProfiler(GpuProfiler* profiler) { this->profiler = profiler; }
+	bool isAsyncComputeEnabled() const { return asyncEnabled(); }
+
+	void reset();
+	ResourceId importImage(const char* name, VkImage image, VkImageAspectFlags aspect, const ImageState& current);
+	ResourceId createImage(const ImageDesc& desc);
+	void addPass(const char* name, Queue queue, const SetupFunc& setup, ExecuteFunc execute);
+	// Resources that must be valid when the frame ends (the swapchain image)
+	void markOutput(ResourceId id);
+	// An output whose first user next frame runs on nextQueue; when the frame leaves it on the
+	// other queue, the ownership release is recorded at the end of that queue's command buffer
+	void exportImage(ResourceId id, Queue nextQueue);
+
+	void compile();
+	// asyncComputeCmd is submitted by the caller after graphicsCmd, waiting on it
+	void execute(VkCommandBuffer graphicsCmd, VkCommandBuffer asyncComputeCmd = VK_NULL_HANDLE);
+
+	// Valid after compile; the final state is what the frame leaves the image in
+	VkImage getImage(ResourceId id) const { return resources[id].image; }
+	VkImageView getImageView(ResourceId id) const { return resources[id].view; }
+	ImageState getFinalState(ResourceId id) const { return resources[id].state; }
+
+	const Stats& getStats() const { return stats; }
+	// Valid after compile: whether execute needs the async compute command buffer
+	bool usesAsyncQueue() const;
+	// Valid after compile: stages of the graphics work that acquire images released by the
+	// previous frame's async submission; the graphics submission has to wait on it there
+	VkPipelineStageFlags getAsyncWaitStages() const { return asyncWaitStages; }
+
+private:
+	struct Access {
+		ResourceId resource;
+		Usage usage;
+		bool reads;
+		bool writes;
+		VkImageLayout layoutAfter;
+	};
+
+	struct Barrier {
+		VkImageMemoryBarrier barrier;
+		VkPipelineStageFlags srcStage;
+		VkPipelineStageFlags dstStage;
+	};
+
+	struct Pass {
+		std::string name;
+		Queue queue = Queue::Graphics;
+		std::vector<Access> accesses;
+		ExecuteFunc execute;
+		bool sideEffects = false;
+		bool culled = false;
+		// Recorded before the pass on its own queue
+		std::vector<Barrier> barriers;
+		// Queue family ownership releases recorded on the other queue before the pass
+		std::vector<Barrier> releases;
+	};
+
+	struct Export {
+		ResourceId resource;
+		Queue nextQueue;
+	};
+
+	struct Resource {
+		std::string name;
+		VkImage image = VK_NULL_HANDLE;
+		VkImageView view = VK_NULL_HANDLE;
+		VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+		ImageState state;
+		bool transient = false;
+		bool output = false;
+		// Set once buildBarriers reaches the first access this frame
+		bool touched = false;
+		ImageDesc desc;
+		// Index into physicalImages for transients
+		uint32_t physical = UINT32_MAX;
+		// First and last surviving pass touching the resource
+		uint32_t firstPass = UINT32_MAX;
+		uint32_t lastPass = 0;
+	};
+
+	struct PhysicalImage {
+		ImageDesc desc;
+		VkImage image = VK_NULL_HANDLE;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkImageView view = VK_NULL_HANDLE;
+		// Last pass of the resource currently placed on it, during compile
+		uint32_t busyUntil = 0;
+		bool assigned = false;
+		// State left by the previous resource placed on it this frame
+		ImageState state;
+	};
+
+	void cullPasses();
+	void validateQueues() const;
+	void assignPhysicalImages();
+	void buildBarriers();
+	void buildExportReleases();
+	uint32_t getFamily(Queue queue) const { return queue == Queue::Graphics ? graphicsFamily : computeFamily; }
+	bool asyncEnabled() const {
+		return asyncRequested && computeFamily != VK_QUEUE_FAMILY_IGNORED && computeFamily != graphicsFamily;
+	}
+	void recordBarriers(VkCommandBuffer cmd, const std::vector<Barrier>& barriers);
+	void destroyPhysicalImage(PhysicalImage& physical, bool retire);
+
+	Device* device = nullptr;
+	TextureManager* textureManager = nullptr;
+	FrameDeletionQueue* retireQueue = nullptr;
+	GpuProfiler* profiler = nullptr;
+	uint32_t graphicsFamily = VK_QUEUE_FAMILY_IGNORED;
+	uint32_t computeFamily = VK_QUEUE_FAMILY_IGNORED;
+	bool asyncRequested = true;
+
+	std::vector<Pass> passes;
+	std::vector<Resource> resources;
+	std::vector<Export> exports;
+	// End-of-frame releases for exported images, per queue
+	std::vector<Barrier> graphicsExportReleases;
+	std::vector<Barrier> asyncExportReleases;
+	VkPipelineStageFlags asyncWaitStages = 0;
+	std::vector<PhysicalImage> physicalImages;
+	Stats stats;
+};
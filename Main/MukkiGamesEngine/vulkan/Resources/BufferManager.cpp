@@ -1,4 +1,5 @@
 #include "BufferManager.h"
+#include "../utils/GpuResourceRegistry.h"
 #include "../CommandBufferManager.h"
 #include <stdexcept>
 #include <cstring>
@@ -16,7 +17,7 @@ void BufferManager::init( Device& device,CommandBufferManager& commandBufferMana
 	this->commandBufferManager = &commandBufferManager;
 }
 void BufferManager::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
-	VkBuffer& buffer, VkDeviceMemory& bufferMemory) {
+	VkBuffer& buffer, VkDeviceMemory& bufferMemory, const char* debugName, const char* file, int line) {
 	// Implementation of buffer creation
 	VkBufferCreateInfo  createInfo{};
 	createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -37,6 +38,7 @@ void BufferManager::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, Vk
 		throw std::runtime_error("failed to allocate buffer memory!");
 	}
 	vkBindBufferMemory(device->getDevice(), buffer, bufferMemory, 0);
+	GpuResourceRegistry::get().track(buffer, memoryRq.size, debugName, file, line);
 }
 void BufferManager::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
 	// Implementation of buffer copy
@@ -63,7 +65,7 @@ void BufferManager::createVertexBuffer(const std::vector<Vertex>& vertices, VkBu
 	createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
 		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBuffer, vertexBufferMemory);
 	copyBuffer(stagingBuffer, vertexBuffer, bufferSize);
-	vkDestroyBuffer(device->getDevice(), stagingBuffer, nullptr);
+	GpuResourceRegistry::destroy(device->getDevice(), stagingBuffer, nullptr);
 	vkFreeMemory(device->getDevice(), stagingBufferMemory, nullptr);
 }
 void BufferManager::indexBuffer(const std::vector<uint32_t>& indices, VkBuffer& indexBuffer, VkDeviceMemory& indexBufferMemory) {
@@ -80,7 +82,7 @@ void BufferManager::indexBuffer(const std::vector<uint32_t>& indices, VkBuffer&
 	createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
 		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBuffer, indexBufferMemory);
 	copyBuffer(stagingBuffer, indexBuffer, bufferSize);
-	vkDestroyBuffer(device->getDevice(), stagingBuffer, nullptr);
+	GpuResourceRegistry::destroy(device->getDevice(), stagingBuffer, nullptr);
 	vkFreeMemory(device->getDevice(), stagingBufferMemory, nullptr);
 
 }
@@ -90,6 +92,6 @@ void BufferManager::createUniformBuffer(VkDeviceSize size, VkBuffer& uniformBuff
 	VkDeviceSize bufferSize = size;
 }
 void BufferManager::destroyBuffer(VkBuffer buffer, VkDeviceMemory bufferMemory) {
-	vkDestroyBuffer(device->getDevice(), buffer, nullptr);
+	GpuResourceRegistry::destroy(device->getDevice(), buffer, nullptr);
 	vkFreeMemory(device->getDevice(), bufferMemory, nullptr);
 }
@@ -13,7 +13,8 @@ public:
 	void init( Device& device, CommandBufferManager& commandBufferManager);
 	void cleanup();
 	void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
-		VkBuffer& buffer, VkDeviceMemory& bufferMemory);
+		VkBuffer& buffer, VkDeviceMemory& bufferMemory,
+		const char* debugName = nullptr, const char* file = MK_CALLER_FILE, int line = MK_CALLER_LINE);
 	void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
 	void createVertexBuffer(const std::vector<Vertex>& vertices, VkBuffer& vertexBuffer, VkDeviceMemory& vertexBufferMemory);
 	void indexBuffer(const std::vector<uint32_t>& indices, VkBuffer& indexBuffer, VkDeviceMemory& indexBufferMemory);
@@ -95,6 +95,23 @@ void Camera::processMouseScroll(float yoffset)
 		zoom = 45.0f;
 }
 
+void Camera::lookAt(const glm::vec3& target)
+{
+	glm::vec3 direction = target - position;
+	if (glm::dot(direction, direction) < 1e-8f)
+		return;
+	direction = glm::normalize(direction);
+
+	yaw = glm::degrees(atan2(direction.z, direction.x));
+	pitch = glm::degrees(asin(glm::clamp(direction.y, -1.0f, 1.0f)));
+	if (pitch > 89.0f)
+		pitch = 89.0f;
+	if (pitch < -89.0f)
+		pitch = -89.0f;
+
+	updateCameraVectors();
+}
+
 void Camera::updateCameraVectors()
 {
 	// Calculate new front vector
@@ -43,6 +43,8 @@ public:
 	void processKeyboardInput(CameraMovement direction, float deltaTime);
 	void processMouseMovement(float xoffset, float yoffset, bool constrainPitch = true);
 	void processMouseScroll(float yoffset);
+	// Turns towards target, keeping the yaw/pitch controls in sync
+	void lookAt(const glm::vec3& target);
 
 private:
 	void updateCameraVectors();
@@ -1,4 +1,5 @@
 #include "DeletionQueue.h"
+#include "../utils/GpuResourceRegistry.h"
 
 DeletionQueue::~DeletionQueue()
 {
@@ -7,7 +8,7 @@ DeletionQueue::~DeletionQueue()
 	flush();
 }
 
-void DeletionQueue::push(std::function<void()>&& deleter)
+void DeletionQueue::push(DeletionFunc&& deleter)
 {
 	m_deleters.push_back(std::move(deleter));
 }
@@ -18,7 +19,7 @@ void DeletionQueue::pushBuffer(VkDevice device, VkBuffer buffer, VkDeviceMemory
 	{
 		push([device, buffer, memory]() {
 			if (buffer != VK_NULL_HANDLE)
-				vkDestroyBuffer(device, buffer, nullptr);
+				GpuResourceRegistry::destroy(device, buffer, nullptr);
 			if (memory != VK_NULL_HANDLE)
 				vkFreeMemory(device, memory, nullptr);
 		});
@@ -31,9 +32,9 @@ void DeletionQueue::pushImage(VkDevice device, VkImage image, VkDeviceMemory mem
 	{
 		push([device, image, memory, view]() {
 			if (view != VK_NULL_HANDLE)
-				vkDestroyImageView(device, view, nullptr);
+				GpuResourceRegistry::destroy(device, view, nullptr);
 			if (image != VK_NULL_HANDLE)
-				vkDestroyImage(device, image, nullptr);
+				GpuResourceRegistry::destroy(device, image, nullptr);
 			if (memory != VK_NULL_HANDLE)
 				vkFreeMemory(device, memory, nullptr);
 		});
@@ -45,7 +46,7 @@ void DeletionQueue::pushImageView(VkDevice device, VkImageView view)
 	if (view != VK_NULL_HANDLE)
 	{
 		push([device, view]() {
-			vkDestroyImageView(device, view, nullptr);
+			GpuResourceRegistry::destroy(device, view, nullptr);
 		});
 	}
 }
@@ -55,7 +56,7 @@ void DeletionQueue::pushSampler(VkDevice device, VkSampler sampler)
 	if (sampler != VK_NULL_HANDLE)
 	{
 		push([device, sampler]() {
-			vkDestroySampler(device, sampler, nullptr);
+			GpuResourceRegistry::destroy(device, sampler, nullptr);
 		});
 	}
 }
@@ -85,7 +86,7 @@ void DeletionQueue::pushDescriptorPool(VkDevice device, VkDescriptorPool pool)
 	if (pool != VK_NULL_HANDLE)
 	{
 		push([device, pool]() {
-			vkDestroyDescriptorPool(device, pool, nullptr);
+			GpuResourceRegistry::destroy(device, pool, nullptr);
 		});
 	}
 }
@@ -115,7 +116,7 @@ void DeletionQueue::pushPipeline(VkDevice device, VkPipeline pipeline)
 	if (pipeline != VK_NULL_HANDLE)
 	{
 		push([device, pipeline]() {
-			vkDestroyPipeline(device, pipeline, nullptr);
+			GpuResourceRegistry::destroy(device, pipeline, nullptr);
 		});
 	}
 }
@@ -137,3 +138,100 @@ void DeletionQueue::clear()
 {
 	m_deleters.clear();
 }
+
+
+FrameDeletionQueue::~FrameDeletionQueue()
+{
+	flush();
+}
+
+void FrameDeletionQueue::retire(DeletionFunc&& deleter)
+{
+	m_entries.push_back({ m_lastSubmitted, std::move(deleter) });
+}
+
+void FrameDeletionQueue::retireBuffer(VkDevice device, VkBuffer buffer, VkDeviceMemory memory)
+{
+	if (buffer != VK_NULL_HANDLE || memory != VK_NULL_HANDLE)
+	{
+		retire([device, buffer, memory]() {
+			if (buffer != VK_NULL_HANDLE)
+				GpuResourceRegistry::destroy(device, buffer, nullptr);
+			if (memory != VK_NULL_HANDLE)
+				vkFreeMemory(device, memory, nullptr);
+		});
+	}
+}
+
+void FrameDeletionQueue::retireImage(VkDevice device, VkImage image, VkDeviceMemory memory, VkImageView view)
+{
+	if (image != VK_NULL_HANDLE || memory != VK_NULL_HANDLE || view != VK_NULL_HANDLE)
+	{
+		retire([device, image, memory, view]() {
+			if (view != VK_NULL_HANDLE)
+				GpuResourceRegistry::destroy(device, view, nullptr);
+			if (image != VK_NULL_HANDLE)
+				GpuResourceRegistry::destroy(device, image, nullptr);
+			if (memory != VK_NULL_HANDLE)
+				vkFreeMemory(device, memory, nullptr);
+		});
+	}
+}
+
+void FrameDeletionQueue::retireSampler(VkDevice device, VkSampler sampler)
+{
+	if (sampler != VK_NULL_HANDLE)
+	{
+		retire([device, sampler]() {
+			GpuResourceRegistry::destroy(device, sampler, nullptr);
+		});
+	}
+}
+
+void FrameDeletionQueue::retirePipeline(VkDevice device, VkPipeline pipeline)
+{
+	if (pipeline != VK_NULL_HANDLE)
+	{
+		retire([device, pipeline]() {
+			GpuResourceRegistry::destroy(device, pipeline, nullptr);
+		});
+	}
+}
+
+void FrameDeletionQueue::retireDescriptorPool(VkDevice device, VkDescriptorPool pool)
+{
+	if (pool != VK_NULL_HANDLE)
+	{
+		retire([device, pool]() {
+			GpuResourceRegistry::destroy(device, pool, nullptr);
+		});
+	}
+}
+
+void FrameDeletionQueue::retireDescriptorSet(VkDevice device, VkDescriptorPool pool, VkDescriptorSet set)
+{
+	if (pool != VK_NULL_HANDLE && set != VK_NULL_HANDLE)
+	{
+		retire([device, pool, set]() {
+			vkFreeDescriptorSets(device, pool, 1, &set);
+		});
+	}
+}
+
+void FrameDeletionQueue::collect(uint64_t completedValue)
+{
+	// Entries are appended with non-decreasing frame values, so the
+	// completed ones are always at the front.
+	while (!m_entries.empty() && m_entries.front().frameValue <= completedValue)
+	{
+		auto& entry = m_entries.front();
+		if (entry.deleter)
+			entry.deleter();
+		m_entries.pop_front();
+	}
+}
+
+void FrameDeletionQueue::flush()
+{
+	collect(UINT64_MAX);
+}
@@ -1,8 +1,112 @@
 #pragma once
 
 #include <vulkan/vulkan.h>
-#include <functional>
 #include <deque>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/// <summary>
+/// Move-only, type-erased void() callable with inline storage.
+/// Deleters typically capture a VkDevice and a handful of handles, which fit in the
+/// inline buffer, so pushing them does not heap allocate the way std::function can.
+/// Larger callables fall back to a single heap allocation.
+/// </summary>
+class DeletionFunc
+{
+public:
+	static constexpr size_t InlineSize = 48;
+
+	DeletionFunc() = default;
+
+	template<typename F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, DeletionFunc>::value>>
+	DeletionFunc(F&& fn)
+	{
+		using Fn = std::decay_t<F>;
+		if constexpr (sizeof(Fn) <= InlineSize && alignof(Fn) <= alignof(std::max_align_t) &&
+			std::is_nothrow_move_constructible<Fn>::value)
+		{
+			new (m_storage) Fn(std::forward<F>(fn));
+			m_ops = &InlineOps<Fn>::table;
+		}
+		else
+		{
+			*reinterpret_cast<Fn**>(m_storage) = new Fn(std::forward<F>(fn));
+			m_ops = &HeapOps<Fn>::table;
+		}
+	}
+
+	DeletionFunc(DeletionFunc&& other) noexcept { moveFrom(other); }
+
+	DeletionFunc& operator=(DeletionFunc&& other) noexcept
+	{
+		if (this != &other)
+		{
+			reset();
+			moveFrom(other);
+		}
+		return *this;
+	}
+
+	DeletionFunc(const DeletionFunc&) = delete;
+	DeletionFunc& operator=(const DeletionFunc&) = delete;
+
+	~DeletionFunc() { reset(); }
+
+	explicit operator bool() const { return m_ops != nullptr; }
+
+	void operator()() { m_ops->invoke(m_storage); }
+
+	void reset()
+	{
+		if (m_ops)
+		{
+			m_ops->destroy(m_storage);
+			m_ops = nullptr;
+		}
+	}
+
+private:
+	struct Ops
+	{
+		void (*invoke)(void* storage);
+		void (*move)(void* dst, void* src);
+		void (*destroy)(void* storage);
+	};
+
+	template<typename Fn>
+	struct InlineOps
+	{
+		static void invoke(void* s) { (*static_cast<Fn*>(s))(); }
+		static void move(void* dst, void* src) { new (dst) Fn(std::move(*static_cast<Fn*>(src))); static_cast<Fn*>(src)->~Fn(); }
+		static void destroy(void* s) { static_cast<Fn*>(s)->~Fn(); }
+		static constexpr Ops table{ &invoke, &move, &destroy };
+	};
+
+	template<typename Fn>
+	struct HeapOps
+	{
+		static void invoke(void* s) { (**static_cast<Fn**>(s))(); }
+		static void move(void* dst, void* src) { *static_cast<Fn**>(dst) = *static_cast<Fn**>(src); }
+		static void destroy(void* s) { delete *static_cast<Fn**>(s); }
+		static constexpr Ops table{ &invoke, &move, &destroy };
+	};
+
+	void moveFrom(DeletionFunc& other) noexcept
+	{
+		if (other.m_ops)
+		{
+			other.m_ops->move(m_storage, other.m_storage);
+			m_ops = other.m_ops;
+			other.m_ops = nullptr;
+		}
+	}
+
+	alignas(std::max_align_t) unsigned char m_storage[InlineSize];
+	const Ops* m_ops = nullptr;
+};
 
 /// <summary>
 /// A LIFO deletion queue that stores cleanup functions for Vulkan resources.
@@ -22,7 +126,7 @@ public:
 	DeletionQueue& operator=(DeletionQueue&&) = delete;
 
 	/// Push a generic cleanup function
-	void push(std::function<void()>&& deleter);
+	void push(DeletionFunc&& deleter);
 
 	// --- Convenience helpers for common Vulkan resource types ---
 
@@ -68,5 +172,56 @@ public:
 	void clear();
 
 private:
-	std::deque<std::function<void()>> m_deleters;
+	std::deque<DeletionFunc> m_deleters;
+};
+
+/// <summary>
+/// Frame-indexed retirement queue for resources destroyed while the GPU may still use them.
+/// Every deleter is tagged with the frame timeline value of the last submission; it runs once
+/// collect() is told the timeline semaphore has reached that value.
+/// This replaces vkDeviceWaitIdle() before runtime destruction (scene switches, RT rebuilds).
+/// </summary>
+class FrameDeletionQueue
+{
+public:
+	FrameDeletionQueue() = default;
+	~FrameDeletionQueue();
+
+	FrameDeletionQueue(const FrameDeletionQueue&) = delete;
+	FrameDeletionQueue& operator=(const FrameDeletionQueue&) = delete;
+
+	/// Retire a generic deleter; it runs after every frame submitted so far has completed.
+	void retire(DeletionFunc&& deleter);
+
+	// --- Convenience helpers, each null-checks its handles ---
+
+	void retireBuffer(VkDevice device, VkBuffer buffer, VkDeviceMemory memory = VK_NULL_HANDLE);
+	void retireImage(VkDevice device, VkImage image, VkDeviceMemory memory, VkImageView view = VK_NULL_HANDLE);
+	void retireSampler(VkDevice device, VkSampler sampler);
+	void retirePipeline(VkDevice device, VkPipeline pipeline);
+	void retireDescriptorPool(VkDevice device, VkDescriptorPool pool);
+	/// The pool must have been created with VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT.
+	void retireDescriptorSet(VkDevice device, VkDescriptorPool pool, VkDescriptorSet set);
+
+	/// Call once per queue submission with the timeline value that submission signals.
+	void markSubmitted(uint64_t timelineValue) { m_lastSubmitted = timelineValue; }
+	uint64_t getLastSubmitted() const { return m_lastSubmitted; }
+
+	/// Run every deleter whose frame value is <= completedValue (FIFO).
+	void collect(uint64_t completedValue);
+
+	/// Run every pending deleter. Only call once the device is idle.
+	void flush();
+
+	size_t pendingCount() const { return m_entries.size(); }
+
+private:
+	struct Entry
+	{
+		uint64_t frameValue;
+		DeletionFunc deleter;
+	};
+
+	std::deque<Entry> m_entries;
+	uint64_t m_lastSubmitted = 0;
 };
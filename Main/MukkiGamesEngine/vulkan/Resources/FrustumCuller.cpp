@@ -0,0 +1,165 @@
+#include "FrustumCuller.h"
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define MK_CULL_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MK_CULL_SSE 1
+#endif
+
+Frustum Frustum::fromViewProjection(const glm::mat4& viewProj)
+{
+	// glm is column-major: row i of the matrix is (m[0][i], m[1][i], m[2][i], m[3][i])
+	auto row = [&viewProj](int i) {
+		return glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]);
+	};
+	glm::vec4 r0 = row(0), r1 = row(1), r2 = row(2), r3 = row(3);
+
+	Frustum frustum;
+	frustum.planes[0] = r3 + r0; // left
+	frustum.planes[1] = r3 - r0; // right
+	frustum.planes[2] = r3 + r1; // bottom
+	frustum.planes[3] = r3 - r1; // top
+	frustum.planes[4] = r2;      // near, z >= 0 in Vulkan clip space
+	frustum.planes[5] = r3 - r2; // far
+	for (auto& plane : frustum.planes) {
+		float length = glm::length(glm::vec3(plane));
+		if (length > 0.0f) {
+			plane /= length;
+		}
+	}
+	return frustum;
+}
+
+bool Frustum::intersectsSphere(const glm::vec3& center, float radius) const
+{
+	for (const auto& plane : planes) {
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void FrustumCuller::clear()
+{
+	count = 0;
+	visibleCount = 0;
+}
+
+uint32_t FrustumCuller::add(const Bounds& bounds, const glm::mat4& model)
+{
+	// Storage is padded to whole batches so cull() never needs a tail loop
+	if (count == centerX.size()) {
+		size_t size = centerX.size() + BATCH;
+		for (auto* lane : { &centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ }) {
+			lane->resize(size, 0.0f);
+		}
+		visibility.resize(size, 0);
+	}
+
+	// Without bounds there is nothing to test, so the box covers everything and is never culled.
+	// Large rather than infinite so the plane tests can't produce 0 * inf
+	glm::vec3 worldCenter(0.0f);
+	glm::vec3 worldExtent(1e30f);
+	if (bounds.isValid()) {
+		glm::vec3 center = (bounds.min + bounds.max) * 0.5f;
+		glm::vec3 extent = (bounds.max - bounds.min) * 0.5f;
+
+		// Box around the transformed box: the half extent goes through the absolute matrix
+		worldCenter = glm::vec3(model * glm::vec4(center, 1.0f));
+		worldExtent = glm::abs(glm::vec3(model[0])) * extent.x +
+			glm::abs(glm::vec3(model[1])) * extent.y +
+			glm::abs(glm::vec3(model[2])) * extent.z;
+	}
+
+	uint32_t index = count++;
+	centerX[index] = worldCenter.x;
+	centerY[index] = worldCenter.y;
+	centerZ[index] = worldCenter.z;
+	extentX[index] = worldExtent.x;
+	extentY[index] = worldExtent.y;
+	extentZ[index] = worldExtent.z;
+	return index;
+}
+
+void FrustumCuller::cullScalar(const Frustum& frustum, uint32_t begin, uint32_t end)
+{
+	for (uint32_t i = begin; i < end; i++) {
+		bool inside = true;
+		for (const auto& plane : frustum.planes) {
+			float distance = plane.x * centerX[i] + plane.y * centerY[i] + plane.z * centerZ[i] + plane.w;
+			float radius = std::abs(plane.x) * extentX[i] + std::abs(plane.y) * extentY[i] + std::abs(plane.z) * extentZ[i];
+			if (distance + radius < 0.0f) {
+				inside = false;
+				break;
+			}
+		}
+		visibility[i] = inside ? 1 : 0;
+	}
+}
+
+void FrustumCuller::cull(const Frustum& frustum)
+{
+	// A box is outside when it lies entirely behind one plane: dot(n, c) + w + dot(|n|, e) < 0
+#if defined(MK_CULL_AVX)
+	for (uint32_t i = 0; i < count; i += BATCH) {
+		__m256 cx = _mm256_loadu_ps(&centerX[i]);
+		__m256 cy = _mm256_loadu_ps(&centerY[i]);
+		__m256 cz = _mm256_loadu_ps(&centerZ[i]);
+		__m256 ex = _mm256_loadu_ps(&extentX[i]);
+		__m256 ey = _mm256_loadu_ps(&extentY[i]);
+		__m256 ez = _mm256_loadu_ps(&extentZ[i]);
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (const auto& plane : frustum.planes) {
+			__m256 distance = _mm256_add_ps(
+				_mm256_add_ps(_mm256_mul_ps(cx, _mm256_set1_ps(plane.x)), _mm256_mul_ps(cy, _mm256_set1_ps(plane.y))),
+				_mm256_add_ps(_mm256_mul_ps(cz, _mm256_set1_ps(plane.z)), _mm256_set1_ps(plane.w)));
+			__m256 radius = _mm256_add_ps(
+				_mm256_add_ps(_mm256_mul_ps(ex, _mm256_set1_ps(std::abs(plane.x))), _mm256_mul_ps(ey, _mm256_set1_ps(std::abs(plane.y)))),
+				_mm256_mul_ps(ez, _mm256_set1_ps(std::abs(plane.z))));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_GE_OQ));
+		}
+		int mask = _mm256_movemask_ps(inside);
+		for (uint32_t lane = 0; lane < BATCH; lane++) {
+			visibility[i + lane] = static_cast<uint8_t>((mask >> lane) & 1);
+		}
+	}
+#elif defined(MK_CULL_SSE)
+	for (uint32_t i = 0; i < count; i += BATCH) {
+		// Two four-wide halves share the broadcast plane constants
+		__m128 cx[2] = { _mm_loadu_ps(&centerX[i]), _mm_loadu_ps(&centerX[i + 4]) };
+		__m128 cy[2] = { _mm_loadu_ps(&centerY[i]), _mm_loadu_ps(&centerY[i + 4]) };
+		__m128 cz[2] = { _mm_loadu_ps(&centerZ[i]), _mm_loadu_ps(&centerZ[i + 4]) };
+		__m128 ex[2] = { _mm_loadu_ps(&extentX[i]), _mm_loadu_ps(&extentX[i + 4]) };
+		__m128 ey[2] = { _mm_loadu_ps(&extentY[i]), _mm_loadu_ps(&extentY[i + 4]) };
+		__m128 ez[2] = { _mm_loadu_ps(&extentZ[i]), _mm_loadu_ps(&extentZ[i + 4]) };
+		__m128 allOnes = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		__m128 inside[2] = { allOnes, allOnes };
+		for (const auto& plane : frustum.planes) {
+			__m128 nx = _mm_set1_ps(plane.x), ny = _mm_set1_ps(plane.y), nz = _mm_set1_ps(plane.z), nw = _mm_set1_ps(plane.w);
+			__m128 ax = _mm_set1_ps(std::abs(plane.x)), ay = _mm_set1_ps(std::abs(plane.y)), az = _mm_set1_ps(std::abs(plane.z));
+			for (int half = 0; half < 2; half++) {
+				__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx[half], nx), _mm_mul_ps(cy[half], ny)),
+					_mm_add_ps(_mm_mul_ps(cz[half], nz), nw));
+				__m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex[half], ax), _mm_mul_ps(ey[half], ay)),
+					_mm_mul_ps(ez[half], az));
+				inside[half] = _mm_and_ps(inside[half], _mm_cmpge_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+			}
+		}
+		int mask = _mm_movemask_ps(inside[0]) | (_mm_movemask_ps(inside[1]) << 4);
+		for (uint32_t lane = 0; lane < BATCH; lane++) {
+			visibility[i + lane] = static_cast<uint8_t>((mask >> lane) & 1);
+		}
+	}
+#else
+	cullScalar(frustum, 0, count);
+#endif
+
+	visibleCount = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		visibleCount += visibility[i];
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "ObjectLoader.h"
+
+// Six inward-facing planes (xyz = normal, w = distance), extracted from a Vulkan view-projection
+// matrix (clip z in [0, w])
+struct Frustum {
+	glm::vec4 planes[6];
+
+	static Frustum fromViewProjection(const glm::mat4& viewProj);
+	// Scalar test, for whole objects before their primitives are queued
+	bool intersectsSphere(const glm::vec3& center, float radius) const;
+};
+
+// Per-frame frustum culling of world-space boxes. Boxes are queued with add(), which moves
+// them into world space, and cull() tests all of them at once: the boxes are kept as
+// structure-of-arrays (center and half extent per axis) so that eight are tested per
+// iteration, with AVX when the build enables it and two SSE halves otherwise.
+class FrustumCuller {
+public:
+	static constexpr uint32_t BATCH = 8;
+
+	void clear();
+	// Returns the box's index in the visibility results
+	uint32_t add(const Bounds& bounds, const glm::mat4& model);
+	void cull(const Frustum& frustum);
+
+	uint32_t getCount() const { return count; }
+	uint32_t getVisibleCount() const { return visibleCount; }
+	// One byte per box from first on, non-zero when the box touches the frustum
+	const uint8_t* getVisibility(uint32_t first) const { return visibility.data() + first; }
+	// Writable, for later passes (occlusion) that hide more boxes
+	uint8_t* getVisibility(uint32_t first) { return visibility.data() + first; }
+
+private:
+	void cullScalar(const Frustum& frustum, uint32_t begin, uint32_t end);
+
+	std::vector<float> centerX, centerY, centerZ;
+	std::vector<float> extentX, extentY, extentZ;
+	std::vector<uint8_t> visibility;
+	uint32_t count = 0;
+	uint32_t visibleCount = 0;
+};
@@ -0,0 +1,720 @@
+#include "GpuDrivenScene.h"
+#include "FrustumCuller.h"
+#include "../utils/utils.h"
+#include "../utils/GpuResourceRegistry.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+static_assert(sizeof(GpuDrivenScene::GpuInstance) == 64, "GpuInstance must match the std430 Instance struct");
+static_assert(sizeof(GpuDrivenScene::CullParams) == 176, "CullParams must match the std140 uniform block");
+
+namespace {
+
+uint32_t floorPowerOfTwo(uint32_t value)
+{
+	uint32_t result = 1;
+	while (result * 2 <= value) {
+		result *= 2;
+	}
+	return result;
+}
+
+VkDescriptorSetLayoutBinding layoutBinding(uint32_t binding, VkDescriptorType type, VkShaderStageFlags stages)
+{
+	VkDescriptorSetLayoutBinding layoutBinding{};
+	layoutBinding.binding = binding;
+	layoutBinding.descriptorType = type;
+	layoutBinding.descriptorCount = 1;
+	layoutBinding.stageFlags = stages;
+	return layoutBinding;
+}
+
+}
+
+void GpuDrivenScene::init(Device* device, VkDescriptorSetLayout materialSetLayout, uint32_t framesInFlight)
+{
+	this->device = device;
+	this->materialSetLayout = materialSetLayout;
+	this->framesInFlight = framesInFlight;
+
+	createSetLayouts();
+	createParamBuffers();
+
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_NEAREST;
+	samplerInfo.minFilter = VK_FILTER_NEAREST;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.minLod = 0.0f;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+	if (vkCreateSampler(device->getDevice(), &samplerInfo, nullptr, &hizSampler) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create Hi-Z sampler!");
+	}
+	MK_TRACK_GPU_RESOURCE(hizSampler, 0, "gpuScene.hizSampler");
+}
+
+void GpuDrivenScene::createSetLayouts()
+{
+	VkDevice vkDev = device->getDevice();
+
+	// Set 1 of the draw pipeline, next to the material set
+	std::array<VkDescriptorSetLayoutBinding, 2> sceneBindings = {
+		layoutBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT),
+		layoutBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+	};
+	std::array<VkDescriptorSetLayoutBinding, 6> cullBindings = {
+		layoutBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT),
+		layoutBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT),
+		layoutBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT),
+		layoutBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT),
+		layoutBinding(4, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT),
+		layoutBinding(5, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
+	};
+	std::array<VkDescriptorSetLayoutBinding, 3> hizBindings = {
+		layoutBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT),
+		layoutBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT),
+		layoutBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)
+	};
+
+	auto createSetLayout = [vkDev](const VkDescriptorSetLayoutBinding* bindings, uint32_t count, VkDescriptorSetLayout& layout) {
+		VkDescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.bindingCount = count;
+		layoutInfo.pBindings = bindings;
+		if (vkCreateDescriptorSetLayout(vkDev, &layoutInfo, nullptr, &layout) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create GPU scene descriptor set layout!");
+		}
+	};
+	createSetLayout(sceneBindings.data(), static_cast<uint32_t>(sceneBindings.size()), sceneSetLayout);
+	createSetLayout(cullBindings.data(), static_cast<uint32_t>(cullBindings.size()), cullSetLayout);
+	createSetLayout(hizBindings.data(), static_cast<uint32_t>(hizBindings.size()), hizSetLayout);
+
+	std::array<VkDescriptorSetLayout, 2> drawSetLayouts = { materialSetLayout, sceneSetLayout };
+	VkPipelineLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layoutInfo.setLayoutCount = static_cast<uint32_t>(drawSetLayouts.size());
+	layoutInfo.pSetLayouts = drawSetLayouts.data();
+	if (vkCreatePipelineLayout(vkDev, &layoutInfo, nullptr, &drawPipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create GPU-driven draw pipeline layout!");
+	}
+
+	layoutInfo.setLayoutCount = 1;
+	layoutInfo.pSetLayouts = &cullSetLayout;
+	if (vkCreatePipelineLayout(vkDev, &layoutInfo, nullptr, &cullPipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create GPU cull pipeline layout!");
+	}
+
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(HiZPushConstants);
+	layoutInfo.pSetLayouts = &hizSetLayout;
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &pushConstantRange;
+	if (vkCreatePipelineLayout(vkDev, &layoutInfo, nullptr, &hizPipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create Hi-Z pipeline layout!");
+	}
+}
+
+void GpuDrivenScene::createParamBuffers()
+{
+	paramBuffers.resize(framesInFlight);
+	paramMemory.resize(framesInFlight);
+	paramMapped.resize(framesInFlight);
+	for (uint32_t i = 0; i < framesInFlight; i++) {
+		device->createBuffer(
+			sizeof(CullParams),
+			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			paramBuffers[i],
+			paramMemory[i],
+			"gpuScene.cullParams");
+		vkMapMemory(device->getDevice(), paramMemory[i], 0, sizeof(CullParams), 0, &paramMapped[i]);
+	}
+}
+
+void GpuDrivenScene::createPipelines(VkRenderPass renderPass)
+{
+	// Same state as the main opaque pipeline
+	PipelineConfigInfo pipelineConfig{};
+	VulkanPipeline::defaultPipelineConfigInfo(pipelineConfig);
+	pipelineConfig.renderPass = renderPass;
+	pipelineConfig.pipelineLayout = drawPipelineLayout;
+	VulkanPipeline::enableAlphaBlending(pipelineConfig);
+	drawPipeline = std::make_unique<VulkanPipeline>(
+		device,
+		"Shaders/gpudriven.vert.spv",
+		"Shaders/brdf.frag.spv",
+		pipelineConfig
+	);
+
+	cullPipeline = createComputePipeline("Shaders/gpucull.comp.spv", cullPipelineLayout);
+	hizPipeline = createComputePipeline("Shaders/hiz.comp.spv", hizPipelineLayout);
+}
+
+VkPipeline GpuDrivenScene::createComputePipeline(const std::string& path, VkPipelineLayout layout)
+{
+	auto code = EngineUtils::readFile(path);
+	VkShaderModuleCreateInfo moduleInfo{};
+	moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	moduleInfo.codeSize = code.size();
+	moduleInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+	VkShaderModule shaderModule;
+	if (vkCreateShaderModule(device->getDevice(), &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create shader module: " + path);
+	}
+
+	VkComputePipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = shaderModule;
+	pipelineInfo.stage.pName = "main";
+	pipelineInfo.layout = layout;
+	pipelineInfo.basePipelineIndex = -1;
+
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	VkResult result = vkCreateComputePipelines(device->getDevice(), device->getPipelineCacheHandle(), 1, &pipelineInfo, nullptr, &pipeline);
+	vkDestroyShaderModule(device->getDevice(), shaderModule, nullptr);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to create compute pipeline: " + path);
+	}
+	MK_TRACK_GPU_RESOURCE(pipeline, 0, "gpuScene.pipeline");
+	return pipeline;
+}
+
+void GpuDrivenScene::cleanup(FrameDeletionQueue& retireQueue)
+{
+	if (device == nullptr) return;
+	VkDevice vkDev = device->getDevice();
+
+	retireSceneBuffers(retireQueue);
+	retireHiZ(retireQueue);
+	retireQueue.retireDescriptorPool(vkDev, descriptorPool);
+	descriptorPool = VK_NULL_HANDLE;
+	for (uint32_t i = 0; i < paramBuffers.size(); i++) {
+		retireQueue.retireBuffer(vkDev, paramBuffers[i], paramMemory[i]);
+	}
+	paramBuffers.clear();
+	paramMemory.clear();
+	paramMapped.clear();
+
+	// Only called with the device idle
+	drawPipeline.reset();
+	retireQueue.retirePipeline(vkDev, cullPipeline);
+	retireQueue.retirePipeline(vkDev, hizPipeline);
+	retireQueue.retireSampler(vkDev, hizSampler);
+	cullPipeline = VK_NULL_HANDLE;
+	hizPipeline = VK_NULL_HANDLE;
+	hizSampler = VK_NULL_HANDLE;
+	retireQueue.retire([vkDev, layouts = std::array<VkPipelineLayout, 3>{ drawPipelineLayout, cullPipelineLayout, hizPipelineLayout },
+		setLayouts = std::array<VkDescriptorSetLayout, 3>{ sceneSetLayout, cullSetLayout, hizSetLayout }]() {
+		for (VkPipelineLayout layout : layouts) {
+			vkDestroyPipelineLayout(vkDev, layout, nullptr);
+		}
+		for (VkDescriptorSetLayout layout : setLayouts) {
+			vkDestroyDescriptorSetLayout(vkDev, layout, nullptr);
+		}
+	});
+	drawPipelineLayout = cullPipelineLayout = hizPipelineLayout = VK_NULL_HANDLE;
+	sceneSetLayout = cullSetLayout = hizSetLayout = VK_NULL_HANDLE;
+	device = nullptr;
+}
+
+void GpuDrivenScene::retireSceneBuffers(FrameDeletionQueue& retireQueue)
+{
+	VkDevice vkDev = device->getDevice();
+	retireQueue.retireBuffer(vkDev, instanceBuffer, instanceMemory);
+	retireQueue.retireBuffer(vkDev, commandBuffer, commandMemory);
+	retireQueue.retireBuffer(vkDev, countBuffer, countMemory);
+	instanceBuffer = commandBuffer = countBuffer = VK_NULL_HANDLE;
+	instanceMemory = commandMemory = countMemory = VK_NULL_HANDLE;
+	for (size_t i = 0; i < transformBuffers.size(); i++) {
+		retireQueue.retireBuffer(vkDev, transformBuffers[i], transformMemory[i]);
+	}
+	transformBuffers.clear();
+	transformMemory.clear();
+	transformMapped.clear();
+	transformCount = 0;
+	instanceCount = 0;
+	commandCount = 0;
+	copies = 0;
+	objectCount = 0;
+	copyOffsets.clear();
+	groups.clear();
+}
+
+void GpuDrivenScene::retireHiZ(FrameDeletionQueue& retireQueue)
+{
+	VkDevice vkDev = device->getDevice();
+	if (!hizLevelViews.empty()) {
+		retireQueue.retire([vkDev, views = std::move(hizLevelViews)]() {
+			for (VkImageView view : views) {
+				GpuResourceRegistry::destroy(vkDev, view, nullptr);
+			}
+		});
+	}
+	hizLevelViews.clear();
+	retireQueue.retireImage(vkDev, hizImage, hizMemory, hizView);
+	hizImage = VK_NULL_HANDLE;
+	hizMemory = VK_NULL_HANDLE;
+	hizView = VK_NULL_HANDLE;
+	hizLevels = 0;
+	hizSerial = 0;
+}
+
+void GpuDrivenScene::clear(FrameDeletionQueue& retireQueue)
+{
+	if (device == nullptr) return;
+	retireSceneBuffers(retireQueue);
+	retireQueue.retireDescriptorPool(device->getDevice(), descriptorPool);
+	descriptorPool = VK_NULL_HANDLE;
+	cullSets.clear();
+	drawSets.clear();
+	hizSets.clear();
+	// Hi-Z sets are rebuilt with the next scene's
+	hizSerial = 0;
+}
+
+void GpuDrivenScene::build(const std::vector<LoadedObject>& objects, const GpuResourcePool& resources, uint32_t copies,
+	FrameDeletionQueue& retireQueue)
+{
+	clear(retireQueue);
+	copies = std::max(copies, 1u);
+
+	// Groups in object order, one per material an object's opaque primitives use
+	struct GroupPrimitive {
+		const Primitive* primitive;
+		uint32_t objectIndex;
+		uint32_t groupIndex;
+	};
+	std::vector<GroupPrimitive> primitives;
+	for (uint32_t objectIndex = 0; objectIndex < objects.size(); objectIndex++) {
+		const LoadedObject& obj = objects[objectIndex];
+		if (!obj.loaded || obj.descriptorSets.empty()) continue;
+		VkBuffer vertexBuffer = resources.getVkBuffer(obj.model.vertexBuffer);
+		VkBuffer indexBuffer = resources.getVkBuffer(obj.model.indexBuffer);
+		if (vertexBuffer == VK_NULL_HANDLE || indexBuffer == VK_NULL_HANDLE) continue;
+
+		std::vector<uint32_t> materialGroups(obj.descriptorSets.size(), UINT32_MAX);
+		for (size_t meshIndex : obj.model.opaqueMeshIndices) {
+			for (const auto& primitive : obj.model.meshes[meshIndex].primitives) {
+				size_t matIndex = primitive.materialIndex >= 0 ? static_cast<size_t>(primitive.materialIndex) : 0;
+				if (matIndex >= materialGroups.size()) {
+					matIndex = 0;
+				}
+				if (materialGroups[matIndex] == UINT32_MAX) {
+					materialGroups[matIndex] = static_cast<uint32_t>(groups.size());
+					groups.push_back({ vertexBuffer, indexBuffer, obj.descriptorSets[matIndex], 0, 0 });
+				}
+				primitives.push_back({ &primitive, objectIndex, materialGroups[matIndex] });
+				groups[materialGroups[matIndex]].capacity++;
+			}
+		}
+	}
+	if (primitives.empty()) {
+		return;
+	}
+
+	// Every copy gets its own groups, like a distinct object with the same materials would
+	uint32_t sceneGroupCount = static_cast<uint32_t>(groups.size());
+	for (uint32_t copy = 1; copy < copies; copy++) {
+		for (uint32_t g = 0; g < sceneGroupCount; g++) {
+			groups.push_back(groups[g]);
+		}
+	}
+	for (auto& group : groups) {
+		group.commandBase = commandCount;
+		commandCount += group.capacity;
+	}
+
+	objectCount = static_cast<uint32_t>(objects.size());
+	placeCopies(objects, copies);
+
+	std::vector<GpuInstance> instances;
+	instances.reserve(primitives.size() * copies);
+	for (uint32_t copy = 0; copy < copies; copy++) {
+		for (const auto& entry : primitives) {
+			const Bounds& bounds = entry.primitive->bounds;
+			GpuInstance instance{};
+			if (bounds.isValid()) {
+				instance.center = glm::vec4((bounds.min + bounds.max) * 0.5f, 0.0f);
+				instance.extent = glm::vec4((bounds.max - bounds.min) * 0.5f, 0.0f);
+			}
+			else {
+				// Never culled
+				instance.extent = glm::vec4(glm::vec3(1e30f), 0.0f);
+			}
+			uint32_t groupIndex = copy * sceneGroupCount + entry.groupIndex;
+			instance.transformIndex = copy * objectCount + entry.objectIndex;
+			instance.groupIndex = groupIndex;
+			instance.commandBase = groups[groupIndex].commandBase;
+			instance.firstIndex = entry.primitive->firstIndex;
+			instance.indexCount = entry.primitive->indexCount;
+			instances.push_back(instance);
+		}
+	}
+	instanceCount = static_cast<uint32_t>(instances.size());
+	this->copies = copies;
+
+	VkDevice vkDev = device->getDevice();
+	VkDeviceSize instanceBytes = sizeof(GpuInstance) * instances.size();
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingMemory;
+	device->createBuffer(instanceBytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		stagingBuffer, stagingMemory, "gpuScene.staging");
+	void* data;
+	vkMapMemory(vkDev, stagingMemory, 0, instanceBytes, 0, &data);
+	memcpy(data, instances.data(), static_cast<size_t>(instanceBytes));
+	vkUnmapMemory(vkDev, stagingMemory);
+
+	device->createBuffer(instanceBytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, instanceBuffer, instanceMemory, "gpuScene.instances");
+	device->copyBuffer(stagingBuffer, instanceBuffer, instanceBytes);
+	GpuResourceRegistry::destroy(vkDev, stagingBuffer, nullptr);
+	vkFreeMemory(vkDev, stagingMemory, nullptr);
+
+	device->createBuffer(sizeof(VkDrawIndexedIndirectCommand) * commandCount,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, commandBuffer, commandMemory, "gpuScene.commands");
+	device->createBuffer(sizeof(uint32_t) * groups.size(),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, countBuffer, countMemory, "gpuScene.counts");
+
+	// One transform slot per object and copy
+	transformCount = objectCount * copies;
+	VkDeviceSize transformBytes = sizeof(GpuTransform) * transformCount;
+	transformBuffers.resize(framesInFlight);
+	transformMemory.resize(framesInFlight);
+	transformMapped.resize(framesInFlight);
+	for (uint32_t i = 0; i < framesInFlight; i++) {
+		device->createBuffer(transformBytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			transformBuffers[i], transformMemory[i], "gpuScene.transforms");
+		vkMapMemory(vkDev, transformMemory[i], 0, transformBytes, 0, &transformMapped[i]);
+	}
+
+	std::cout << "GPU-driven scene: " << instanceCount << " instances in " << groups.size() << " draw groups" << std::endl;
+	writeDescriptors(retireQueue);
+}
+
+void GpuDrivenScene::placeCopies(const std::vector<LoadedObject>& objects, uint32_t copies)
+{
+	// Copies go on a square grid in the XZ plane, one scene width apart, so none overlap
+	glm::vec3 sceneMin(std::numeric_limits<float>::max());
+	glm::vec3 sceneMax(std::numeric_limits<float>::lowest());
+	for (const auto& obj : objects) {
+		const Bounds& bounds = obj.model.bounds;
+		if (!obj.loaded || !bounds.isValid()) continue;
+		glm::mat4 model = obj.transform.getModelMatrix();
+		float scale = std::max({ glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])),
+			glm::length(glm::vec3(model[2])) });
+		glm::vec3 center = glm::vec3(model * glm::vec4(bounds.center, 1.0f));
+		sceneMin = glm::min(sceneMin, center - glm::vec3(bounds.radius * scale));
+		sceneMax = glm::max(sceneMax, center + glm::vec3(bounds.radius * scale));
+	}
+	float spacing = sceneMin.x <= sceneMax.x ? std::max(sceneMax.x - sceneMin.x, sceneMax.z - sceneMin.z) : 1.0f;
+
+	uint32_t columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(copies))));
+	copyOffsets.resize(copies);
+	for (uint32_t copy = 0; copy < copies; copy++) {
+		copyOffsets[copy] = glm::vec3(static_cast<float>(copy % columns), 0.0f, static_cast<float>(copy / columns)) * spacing;
+	}
+}
+
+void GpuDrivenScene::resize(VkImageView depthView, VkExtent2D depthExtent, FrameDeletionQueue& retireQueue)
+{
+	retireHiZ(retireQueue);
+	this->depthView = depthView;
+	this->depthExtent = depthExtent;
+	hizExtent = { floorPowerOfTwo(depthExtent.width), floorPowerOfTwo(depthExtent.height) };
+	hizLevels = 1;
+	while ((std::max(hizExtent.width, hizExtent.height) >> hizLevels) > 0) {
+		hizLevels++;
+	}
+
+	VkDevice vkDev = device->getDevice();
+	VkImageCreateInfo imageInfo{};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.extent = { hizExtent.width, hizExtent.height, 1 };
+	imageInfo.mipLevels = hizLevels;
+	imageInfo.arrayLayers = 1;
+	imageInfo.format = VK_FORMAT_R32_SFLOAT;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	if (vkCreateImage(vkDev, &imageInfo, nullptr, &hizImage) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create Hi-Z image!");
+	}
+
+	VkMemoryRequirements memRequirements;
+	vkGetImageMemoryRequirements(vkDev, hizImage, &memRequirements);
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = memRequirements.size;
+	allocInfo.memoryTypeIndex = device->findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	if (vkAllocateMemory(vkDev, &allocInfo, nullptr, &hizMemory) != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate Hi-Z image memory!");
+	}
+	vkBindImageMemory(vkDev, hizImage, hizMemory, 0);
+	MK_TRACK_GPU_RESOURCE(hizImage, memRequirements.size, "gpuScene.hiz");
+
+	// The whole pyramid for the cull shader, and a view per level for the build
+	VkImageViewCreateInfo viewInfo{};
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.image = hizImage;
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format = VK_FORMAT_R32_SFLOAT;
+	viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	viewInfo.subresourceRange.baseMipLevel = 0;
+	viewInfo.subresourceRange.levelCount = hizLevels;
+	viewInfo.subresourceRange.baseArrayLayer = 0;
+	viewInfo.subresourceRange.layerCount = 1;
+	if (vkCreateImageView(vkDev, &viewInfo, nullptr, &hizView) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create Hi-Z image view!");
+	}
+	MK_TRACK_GPU_RESOURCE(hizView, 0, "gpuScene.hiz");
+
+	hizLevelViews.resize(hizLevels);
+	viewInfo.subresourceRange.levelCount = 1;
+	for (uint32_t level = 0; level < hizLevels; level++) {
+		viewInfo.subresourceRange.baseMipLevel = level;
+		if (vkCreateImageView(vkDev, &viewInfo, nullptr, &hizLevelViews[level]) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create Hi-Z level view!");
+		}
+		MK_TRACK_GPU_RESOURCE(hizLevelViews[level], 0, "gpuScene.hizLevel");
+	}
+
+	writeDescriptors(retireQueue);
+}
+
+void GpuDrivenScene::writeDescriptors(FrameDeletionQueue& retireQueue)
+{
+	VkDevice vkDev = device->getDevice();
+	retireQueue.retireDescriptorPool(vkDev, descriptorPool);
+	descriptorPool = VK_NULL_HANDLE;
+	cullSets.clear();
+	drawSets.clear();
+	hizSets.clear();
+	if (instanceBuffer == VK_NULL_HANDLE || hizImage == VK_NULL_HANDLE) {
+		return;
+	}
+
+	std::array<VkDescriptorPoolSize, 4> poolSizes{};
+	poolSizes[0] = { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 6 * framesInFlight };
+	poolSizes[1] = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, framesInFlight };
+	poolSizes[2] = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, framesInFlight + hizLevels };
+	poolSizes[3] = { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 2 * hizLevels };
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	poolInfo.pPoolSizes = poolSizes.data();
+	poolInfo.maxSets = 2 * framesInFlight + hizLevels;
+	if (vkCreateDescriptorPool(vkDev, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create GPU scene descriptor pool!");
+	}
+	MK_TRACK_GPU_RESOURCE(descriptorPool, 0, "gpuScene.descriptorPool");
+
+	auto allocate = [&](VkDescriptorSetLayout layout, uint32_t count, std::vector<VkDescriptorSet>& sets) {
+		std::vector<VkDescriptorSetLayout> layouts(count, layout);
+		VkDescriptorSetAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = descriptorPool;
+		allocInfo.descriptorSetCount = count;
+		allocInfo.pSetLayouts = layouts.data();
+		sets.resize(count);
+		if (vkAllocateDescriptorSets(vkDev, &allocInfo, sets.data()) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate GPU scene descriptor sets!");
+		}
+	};
+	allocate(cullSetLayout, framesInFlight, cullSets);
+	allocate(sceneSetLayout, framesInFlight, drawSets);
+	allocate(hizSetLayout, hizLevels, hizSets);
+
+	auto bufferWrite = [](VkDescriptorSet set, uint32_t binding, VkDescriptorType type, const VkDescriptorBufferInfo* info) {
+		VkWriteDescriptorSet write{};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = set;
+		write.dstBinding = binding;
+		write.descriptorType = type;
+		write.descriptorCount = 1;
+		write.pBufferInfo = info;
+		return write;
+	};
+	auto imageWrite = [](VkDescriptorSet set, uint32_t binding, VkDescriptorType type, const VkDescriptorImageInfo* info) {
+		VkWriteDescriptorSet write{};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = set;
+		write.dstBinding = binding;
+		write.descriptorType = type;
+		write.descriptorCount = 1;
+		write.pImageInfo = info;
+		return write;
+	};
+
+	VkDescriptorBufferInfo instanceInfo{ instanceBuffer, 0, VK_WHOLE_SIZE };
+	VkDescriptorBufferInfo commandInfo{ commandBuffer, 0, VK_WHOLE_SIZE };
+	VkDescriptorBufferInfo countInfo{ countBuffer, 0, VK_WHOLE_SIZE };
+	VkDescriptorImageInfo hizInfo{ hizSampler, hizView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+	for (uint32_t frame = 0; frame < framesInFlight; frame++) {
+		VkDescriptorBufferInfo transformInfo{ transformBuffers[frame], 0, VK_WHOLE_SIZE };
+		VkDescriptorBufferInfo paramInfo{ paramBuffers[frame], 0, sizeof(CullParams) };
+		std::array<VkWriteDescriptorSet, 8> writes = {
+			bufferWrite(cullSets[frame], 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &instanceInfo),
+			bufferWrite(cullSets[frame], 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &transformInfo),
+			bufferWrite(cullSets[frame], 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &commandInfo),
+			bufferWrite(cullSets[frame], 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &countInfo),
+			bufferWrite(cullSets[frame], 4, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, &paramInfo),
+			imageWrite(cullSets[frame], 5, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &hizInfo),
+			bufferWrite(drawSets[frame], 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &instanceInfo),
+			bufferWrite(drawSets[frame], 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &transformInfo)
+		};
+		vkUpdateDescriptorSets(vkDev, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+	}
+
+	// Level 0 reads the depth buffer; its source level binding is unused but must be valid
+	VkDescriptorImageInfo depthInfo{ hizSampler, depthView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+	for (uint32_t level = 0; level < hizLevels; level++) {
+		VkDescriptorImageInfo srcInfo{ VK_NULL_HANDLE, hizLevelViews[level > 0 ? level - 1 : 0], VK_IMAGE_LAYOUT_GENERAL };
+		VkDescriptorImageInfo dstInfo{ VK_NULL_HANDLE, hizLevelViews[level], VK_IMAGE_LAYOUT_GENERAL };
+		std::array<VkWriteDescriptorSet, 3> writes = {
+			imageWrite(hizSets[level], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &depthInfo),
+			imageWrite(hizSets[level], 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, &srcInfo),
+			imageWrite(hizSets[level], 2, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, &dstInfo)
+		};
+		vkUpdateDescriptorSets(vkDev, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+	}
+}
+
+bool GpuDrivenScene::isReady() const
+{
+	return drawPipeline && cullPipeline != VK_NULL_HANDLE && hizPipeline != VK_NULL_HANDLE && !cullSets.empty();
+}
+
+void GpuDrivenScene::update(uint32_t frame, const std::vector<LoadedObject>& objects, const glm::mat4& viewProj, bool hizOcclusion)
+{
+	if (!isReady()) return;
+
+	// The per-object CPU cost: copies are treated as the distinct objects they stand in for, so
+	// each slot gets its own matrix and inverse
+	auto* transforms = static_cast<GpuTransform*>(transformMapped[frame]);
+	uint32_t count = std::min(objectCount, static_cast<uint32_t>(objects.size()));
+	for (uint32_t copy = 0; copy < copies; copy++) {
+		for (uint32_t i = 0; i < count; i++) {
+			glm::mat4 model = objects[i].transform.getModelMatrix();
+			model[3] += glm::vec4(copyOffsets[copy], 0.0f);
+			GpuTransform& transform = transforms[copy * objectCount + i];
+			transform.model = model;
+			transform.normalMatrix = glm::transpose(glm::inverse(model));
+		}
+	}
+
+	// The pyramid lags a frame behind, so boxes are placed on it with the view it was rendered from
+	updateSerial++;
+	hizActive = hizOcclusion && hizSerial != 0 && hizSerial + 1 == updateSerial;
+	currentViewProj = viewProj;
+
+	CullParams params{};
+	Frustum frustum = Frustum::fromViewProjection(viewProj);
+	for (int i = 0; i < 6; i++) {
+		params.planes[i] = frustum.planes[i];
+	}
+	params.prevViewProj = hizViewProj;
+	params.hizSize = glm::vec2(static_cast<float>(hizExtent.width), static_cast<float>(hizExtent.height));
+	params.instanceCount = instanceCount;
+	params.hizEnabled = hizActive ? 1u : 0u;
+	memcpy(paramMapped[frame], &params, sizeof(CullParams));
+}
+
+void GpuDrivenScene::recordCull(VkCommandBuffer cmd, uint32_t frame) const
+{
+	// The previous frame's indirect draws are done with the commands and counts before the
+	// counts restart at zero
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0, 0, nullptr, 0, nullptr, 0, nullptr);
+	vkCmdFillBuffer(cmd, countBuffer, 0, VK_WHOLE_SIZE, 0);
+
+	VkMemoryBarrier clearBarrier{};
+	clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0, 1, &clearBarrier, 0, nullptr, 0, nullptr);
+
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline);
+	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipelineLayout, 0, 1, &cullSets[frame], 0, nullptr);
+	vkCmdDispatch(cmd, (instanceCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+	VkMemoryBarrier drawBarrier{};
+	drawBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	drawBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	drawBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+		0, 1, &drawBarrier, 0, nullptr, 0, nullptr);
+}
+
+void GpuDrivenScene::recordDraws(VkCommandBuffer cmd, uint32_t frame) const
+{
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, drawPipeline->getGraphicsPipeline());
+	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, drawPipelineLayout, 1, 1, &drawSets[frame], 0, nullptr);
+
+	const VkDeviceSize commandStride = sizeof(VkDrawIndexedIndirectCommand);
+	VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
+	for (uint32_t g = 0; g < groups.size(); g++) {
+		const DrawGroup& group = groups[g];
+		if (group.vertexBuffer != boundVertexBuffer) {
+			VkDeviceSize offset = 0;
+			vkCmdBindVertexBuffers(cmd, 0, 1, &group.vertexBuffer, &offset);
+			vkCmdBindIndexBuffer(cmd, group.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+			boundVertexBuffer = group.vertexBuffer;
+		}
+		vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, drawPipelineLayout, 0, 1, &group.materialSets[frame], 0, nullptr);
+		vkCmdDrawIndexedIndirectCount(cmd, commandBuffer, group.commandBase * commandStride,
+			countBuffer, g * sizeof(uint32_t), group.capacity, static_cast<uint32_t>(commandStride));
+	}
+}
+
+void GpuDrivenScene::recordHiZBuild(VkCommandBuffer cmd)
+{
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, hizPipeline);
+
+	VkMemoryBarrier levelBarrier{};
+	levelBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	levelBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	levelBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	VkExtent2D src = depthExtent;
+	for (uint32_t level = 0; level < hizLevels; level++) {
+		VkExtent2D dst = { std::max(hizExtent.width >> level, 1u), std::max(hizExtent.height >> level, 1u) };
+		if (level > 0) {
+			vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				0, 1, &levelBarrier, 0, nullptr, 0, nullptr);
+		}
+
+		HiZPushConstants push{};
+		push.srcSize[0] = static_cast<int32_t>(src.width);
+		push.srcSize[1] = static_cast<int32_t>(src.height);
+		push.dstSize[0] = static_cast<int32_t>(dst.width);
+		push.dstSize[1] = static_cast<int32_t>(dst.height);
+		push.fromDepth = level == 0 ? 1u : 0u;
+		vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, hizPipelineLayout, 0, 1, &hizSets[level], 0, nullptr);
+		vkCmdPushConstants(cmd, hizPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(HiZPushConstants), &push);
+		vkCmdDispatch(cmd, (dst.width + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, (dst.height + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, 1);
+		src = dst;
+	}
+
+	hizSerial = updateSerial;
+	hizViewProj = currentViewProj;
+}
@@ -0,0 +1,170 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../Core/VkDevice.h"
+#include "../pipeline.h"
+#include "DeletionQueue.h"
+#include "GpuResourcePool.h"
+#include "SceneObject.h"
+
+// GPU-driven opaque geometry. Every opaque primitive of the loaded objects is an instance in a
+// device buffer (model-space box, transform slot, draw group, index range). Each frame a compute
+// pass culls the instances against the camera frustum and the previous frame's Hi-Z pyramid and
+// appends an indexed indirect draw per survivor to its group's range, counting them; the main
+// pass then issues one vkCmdDrawIndexedIndirectCount per group.
+//
+// Materials are not bindless, so a group is one object's material descriptor set (and vertex
+// buffer). What stays on the CPU is per object and per group: every object's model matrix and
+// its inverse are written each frame, and every group is one indirect draw. Synthetic copies
+// stand in for distinct objects, so they pay both: each copy has its own transform slots and
+// groups and sits beside the scene at its own offset.
+class GpuDrivenScene {
+public:
+	static constexpr uint32_t CULL_GROUP_SIZE = 64;
+	static constexpr uint32_t HIZ_GROUP_SIZE = 8;
+
+	// Shared with gpucull.comp and gpudriven.vert (std430)
+	struct GpuInstance {
+		glm::vec4 center;
+		glm::vec4 extent;
+		uint32_t transformIndex;
+		uint32_t groupIndex;
+		uint32_t commandBase;
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		int32_t vertexOffset;
+		uint32_t pad0;
+		uint32_t pad1;
+	};
+	struct GpuTransform {
+		glm::mat4 model;
+		glm::mat4 normalMatrix;
+	};
+	// std140, like CullParams in gpucull.comp
+	struct CullParams {
+		glm::vec4 planes[6];
+		glm::mat4 prevViewProj;
+		glm::vec2 hizSize;
+		uint32_t instanceCount;
+		uint32_t hizEnabled;
+	};
+
+	// Device features the path needs: drawIndirectCount, multiDrawIndirect, drawIndirectFirstInstance
+	void init(Device* device, VkDescriptorSetLayout materialSetLayout, uint32_t framesInFlight);
+	// Compiles the draw and compute pipelines; may run on another thread
+	void createPipelines(VkRenderPass renderPass);
+	void cleanup(FrameDeletionQueue& retireQueue);
+
+	// Rebuilds the instances and groups for the objects, each repeated copies times on a grid;
+	// the previous buffers are retired. Uploads through a blocking copy.
+	void build(const std::vector<LoadedObject>& objects, const GpuResourcePool& resources, uint32_t copies,
+		FrameDeletionQueue& retireQueue);
+	// Drops the instances and groups, which point at the objects' descriptor sets
+	void clear(FrameDeletionQueue& retireQueue);
+	// Recreates the Hi-Z pyramid for a new depth buffer; the previous one is retired
+	void resize(VkImageView depthView, VkExtent2D depthExtent, FrameDeletionQueue& retireQueue);
+
+	// Writes the frame's transforms and cull parameters. The Hi-Z test only runs when the
+	// pyramid was built by the frame right before this one.
+	void update(uint32_t frame, const std::vector<LoadedObject>& objects, const glm::mat4& viewProj, bool hizOcclusion);
+
+	// Pass bodies: the cull dispatch (before the main pass), the indirect draws (inside it) and
+	// the pyramid build from the main pass's depth (after it)
+	void recordCull(VkCommandBuffer cmd, uint32_t frame) const;
+	void recordDraws(VkCommandBuffer cmd, uint32_t frame) const;
+	void recordHiZBuild(VkCommandBuffer cmd);
+
+	bool isReady() const;
+	uint32_t getCopies() const { return copies; }
+	uint32_t getInstanceCount() const { return instanceCount; }
+	uint32_t getGroupCount() const { return static_cast<uint32_t>(groups.size()); }
+	VkImage getHiZImage() const { return hizImage; }
+	bool isHiZActive() const { return hizActive; }
+
+private:
+	// One object's primitives sharing a material descriptor set
+	struct DrawGroup {
+		VkBuffer vertexBuffer;
+		VkBuffer indexBuffer;
+		std::vector<VkDescriptorSet> materialSets; // [frame]
+		uint32_t commandBase;
+		uint32_t capacity;
+	};
+	struct HiZPushConstants {
+		int32_t srcSize[2];
+		int32_t dstSize[2];
+		uint32_t fromDepth;
+	};
+
+	void createSetLayouts();
+	void createParamBuffers();
+	VkPipeline createComputePipeline(const std::string& path, VkPipelineLayout layout);
+	void retireSceneBuffers(FrameDeletionQueue& retireQueue);
+	// Grid offsets of the copies, spaced by the scene's extent
+	void placeCopies(const std::vector<LoadedObject>& objects, uint32_t copies);
+	void retireHiZ(FrameDeletionQueue& retireQueue);
+	// Reallocates every descriptor set once both the scene buffers and the pyramid exist
+	void writeDescriptors(FrameDeletionQueue& retireQueue);
+
+	Device* device = nullptr;
+	uint32_t framesInFlight = 0;
+	VkDescriptorSetLayout materialSetLayout = VK_NULL_HANDLE;
+
+	VkDescriptorSetLayout sceneSetLayout = VK_NULL_HANDLE;
+	VkDescriptorSetLayout cullSetLayout = VK_NULL_HANDLE;
+	VkDescriptorSetLayout hizSetLayout = VK_NULL_HANDLE;
+	VkPipelineLayout drawPipelineLayout = VK_NULL_HANDLE;
+	VkPipelineLayout cullPipelineLayout = VK_NULL_HANDLE;
+	VkPipelineLayout hizPipelineLayout = VK_NULL_HANDLE;
+	std::unique_ptr<VulkanPipeline> drawPipeline;
+	VkPipeline cullPipeline = VK_NULL_HANDLE;
+	VkPipeline hizPipeline = VK_NULL_HANDLE;
+	VkSampler hizSampler = VK_NULL_HANDLE;
+
+	// Static per build; copy 0 is the scene itself
+	uint32_t copies = 0;
+	uint32_t objectCount = 0;
+	std::vector<glm::vec3> copyOffsets;
+	uint32_t instanceCount = 0;
+	uint32_t commandCount = 0;
+	std::vector<DrawGroup> groups;
+	VkBuffer instanceBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory instanceMemory = VK_NULL_HANDLE;
+	VkBuffer commandBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory commandMemory = VK_NULL_HANDLE;
+	VkBuffer countBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory countMemory = VK_NULL_HANDLE;
+	// Host written every frame, one per frame in flight; slot copy * objectCount + object
+	uint32_t transformCount = 0;
+	std::vector<VkBuffer> transformBuffers;
+	std::vector<VkDeviceMemory> transformMemory;
+	std::vector<void*> transformMapped;
+	std::vector<VkBuffer> paramBuffers;
+	std::vector<VkDeviceMemory> paramMemory;
+	std::vector<void*> paramMapped;
+
+	// Farthest depth per texel; mip 0 is the depth buffer rounded down to powers of two
+	VkImageView depthView = VK_NULL_HANDLE;
+	VkExtent2D depthExtent{};
+	VkExtent2D hizExtent{};
+	uint32_t hizLevels = 0;
+	VkImage hizImage = VK_NULL_HANDLE;
+	VkDeviceMemory hizMemory = VK_NULL_HANDLE;
+	VkImageView hizView = VK_NULL_HANDLE;
+	std::vector<VkImageView> hizLevelViews;
+	// update() counts frames; the pyramid records the frame it was built in and its view-projection
+	uint64_t updateSerial = 0;
+	uint64_t hizSerial = 0;
+	glm::mat4 currentViewProj = glm::mat4(1.0f);
+	glm::mat4 hizViewProj = glm::mat4(1.0f);
+	bool hizActive = false;
+
+	VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+	std::vector<VkDescriptorSet> cullSets;  // [frame]
+	std::vector<VkDescriptorSet> drawSets;  // [frame]
+	std::vector<VkDescriptorSet> hizSets;   // [level]
+};
@@ -0,0 +1,131 @@
+#include "GpuResourcePool.h"
+#include "../Core/VkDevice.h"
+#include "../utils/GpuResourceRegistry.h"
+
+GpuResourcePool::~GpuResourcePool()
+{
+	cleanup();
+}
+
+void GpuResourcePool::init(Device* device)
+{
+	this->device = device;
+}
+
+void GpuResourcePool::cleanup()
+{
+	if (device == nullptr) return;
+	std::unique_lock<std::shared_mutex> lock(mutex);
+
+	for (const auto& buffer : buffers) {
+		destroyBufferNow(buffer);
+	}
+	for (const auto& texture : textures) {
+		destroyTextureNow(texture);
+	}
+	buffers = ResourcePool<GpuBuffer>();
+	textures = ResourcePool<LoadedTexture>();
+	device = nullptr;
+}
+
+BufferHandle GpuResourcePool::addBuffer(VkBuffer buffer, VkDeviceMemory memory, VkDeviceSize size)
+{
+	GpuBuffer entry{};
+	entry.buffer = buffer;
+	entry.memory = memory;
+	entry.size = size;
+	return buffers.create(std::move(entry));
+}
+
+TextureHandle GpuResourcePool::addTexture(const LoadedTexture& texture)
+{
+	std::unique_lock<std::shared_mutex> lock(mutex);
+	LoadedTexture entry = texture;
+	return textures.create(std::move(entry));
+}
+
+std::optional<GpuBuffer> GpuResourcePool::getBuffer(BufferHandle handle) const
+{
+	const GpuBuffer* buffer = buffers.get(handle);
+	return buffer ? std::optional<GpuBuffer>(*buffer) : std::nullopt;
+}
+
+std::optional<LoadedTexture> GpuResourcePool::getTexture(TextureHandle handle) const
+{
+	std::shared_lock<std::shared_mutex> lock(mutex);
+	const LoadedTexture* texture = textures.get(handle);
+	return texture ? std::optional<LoadedTexture>(*texture) : std::nullopt;
+}
+
+VkBuffer GpuResourcePool::getVkBuffer(BufferHandle handle) const
+{
+	const GpuBuffer* buffer = buffers.get(handle);
+	return buffer ? buffer->buffer : VK_NULL_HANDLE;
+}
+
+size_t GpuResourcePool::getBufferCount() const
+{
+	return buffers.size();
+}
+
+size_t GpuResourcePool::getTextureCount() const
+{
+	std::shared_lock<std::shared_mutex> lock(mutex);
+	return textures.size();
+}
+
+void GpuResourcePool::destroyBuffer(BufferHandle handle)
+{
+	if (!buffers.isAlive(handle)) return;
+	destroyBufferNow(buffers.release(handle));
+}
+
+void GpuResourcePool::destroyTexture(TextureHandle handle)
+{
+	std::unique_lock<std::shared_mutex> lock(mutex);
+	if (!textures.isAlive(handle)) return;
+	destroyTextureNow(textures.release(handle));
+}
+
+void GpuResourcePool::retireBuffer(BufferHandle handle, FrameDeletionQueue& retireQueue)
+{
+	if (!buffers.isAlive(handle)) return;
+	GpuBuffer buffer = buffers.release(handle);
+	retireQueue.retireBuffer(device->getDevice(), buffer.buffer, buffer.memory);
+}
+
+void GpuResourcePool::retireTexture(TextureHandle handle, FrameDeletionQueue& retireQueue)
+{
+	std::unique_lock<std::shared_mutex> lock(mutex);
+	if (!textures.isAlive(handle)) return;
+	LoadedTexture texture = textures.release(handle);
+	retireQueue.retireSampler(device->getDevice(), texture.sampler);
+	retireQueue.retireImage(device->getDevice(), texture.image, texture.memory, texture.imageView);
+}
+
+void GpuResourcePool::destroyBufferNow(const GpuBuffer& buffer)
+{
+	if (buffer.buffer != VK_NULL_HANDLE) {
+		GpuResourceRegistry::destroy(device->getDevice(), buffer.buffer, nullptr);
+	}
+	if (buffer.memory != VK_NULL_HANDLE) {
+		vkFreeMemory(device->getDevice(), buffer.memory, nullptr);
+	}
+}
+
+void GpuResourcePool::destroyTextureNow(const LoadedTexture& texture)
+{
+	VkDevice vkDev = device->getDevice();
+	if (texture.sampler != VK_NULL_HANDLE) {
+		GpuResourceRegistry::destroy(vkDev, texture.sampler, nullptr);
+	}
+	if (texture.imageView != VK_NULL_HANDLE) {
+		GpuResourceRegistry::destroy(vkDev, texture.imageView, nullptr);
+	}
+	if (texture.image != VK_NULL_HANDLE) {
+		GpuResourceRegistry::destroy(vkDev, texture.image, nullptr);
+	}
+	if (texture.memory != VK_NULL_HANDLE) {
+		vkFreeMemory(vkDev, texture.memory, nullptr);
+	}
+}
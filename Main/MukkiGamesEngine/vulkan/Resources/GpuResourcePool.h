@@ -0,0 +1,78 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include "ResourcePool.h"
+#include "DeletionQueue.h"
+
+class Device;
+
+// Buffer owned by the resource pool
+struct GpuBuffer {
+	VkBuffer buffer = VK_NULL_HANDLE;
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	VkDeviceSize size = 0;
+};
+
+// Texture loaded from glTF
+struct LoadedTexture {
+	VkImage image = VK_NULL_HANDLE;
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	VkImageView imageView = VK_NULL_HANDLE;
+	VkSampler sampler = VK_NULL_HANDLE;
+	uint32_t width = 0;
+	uint32_t height = 0;
+};
+
+using BufferHandle = ResourceHandle<GpuBuffer>;
+using TextureHandle = ResourceHandle<LoadedTexture>;
+
+// Owns model geometry buffers and textures; the loader, renderer and RT code refer to
+// them through generational handles.
+//
+// Buffers are only added, destroyed and retired on the main thread between frames, never
+// while draws are being recorded, so buffer lookups take no lock: the draw recording threads
+// call getVkBuffer per object and must not contend on a shared cache line.
+// Textures are registered from the async glTF loaders while other threads look them up, and
+// an add can reallocate the dense array, so texture access takes the lock: shared for
+// lookups, exclusive for changes. Lookups return copies, never pointers into the arrays.
+class GpuResourcePool {
+public:
+	GpuResourcePool() = default;
+	~GpuResourcePool();
+
+	GpuResourcePool(const GpuResourcePool&) = delete;
+	GpuResourcePool& operator=(const GpuResourcePool&) = delete;
+
+	void init(Device* device);
+	// Destroys every resource still in the pool; the device must be idle
+	void cleanup();
+
+	BufferHandle addBuffer(VkBuffer buffer, VkDeviceMemory memory, VkDeviceSize size);
+	TextureHandle addTexture(const LoadedTexture& texture);
+
+	// Empty for invalid or stale handles
+	std::optional<GpuBuffer> getBuffer(BufferHandle handle) const;
+	std::optional<LoadedTexture> getTexture(TextureHandle handle) const;
+	// VK_NULL_HANDLE for invalid or stale handles; lock-free, see above
+	VkBuffer getVkBuffer(BufferHandle handle) const;
+
+	void destroyBuffer(BufferHandle handle);
+	void destroyTexture(TextureHandle handle);
+	void retireBuffer(BufferHandle handle, FrameDeletionQueue& retireQueue);
+	void retireTexture(TextureHandle handle, FrameDeletionQueue& retireQueue);
+
+	size_t getBufferCount() const;
+	size_t getTextureCount() const;
+
+private:
+	Device* device = nullptr;
+	// Guards textures only
+	mutable std::shared_mutex mutex;
+	ResourcePool<GpuBuffer> buffers;
+	ResourcePool<LoadedTexture> textures;
+
+	void destroyBufferNow(const GpuBuffer& buffer);
+	void destroyTextureNow(const LoadedTexture& texture);
+};
@@ -1,6 +1,9 @@
 #include "ObjectLoader.h"
 #include "BufferManager.h"
 #include "TextureManager.h"
+#include "../utils/GpuResourceRegistry.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <stdexcept>
 #include <filesystem>
@@ -11,20 +14,110 @@
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <tiny_gltf.h>
 
+namespace {
+
+uint32_t getPrimitiveVertexCount(const tinygltf::Model& gltfModel, const tinygltf::Primitive& primitive)
+{
+	auto it = primitive.attributes.find("POSITION");
+	if (it == primitive.attributes.end()) {
+		return 0;
+	}
+	return static_cast<uint32_t>(gltfModel.accessors[it->second].count);
+}
+
+uint32_t getPrimitiveIndexCount(const tinygltf::Model& gltfModel, const tinygltf::Primitive& primitive)
+{
+	if (primitive.indices < 0) {
+		return 0;
+	}
+	const tinygltf::Accessor& accessor = gltfModel.accessors[primitive.indices];
+	switch (accessor.componentType) {
+	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+		return static_cast<uint32_t>(accessor.count);
+	default:
+		return 0;
+	}
+}
+
+// Mirrors the loadNode traversal so the model arrays can be sized before any vertex is decoded
+void countNodeGeometry(const tinygltf::Model& gltfModel, int nodeIndex, size_t& vertexCount, size_t& indexCount)
+{
+	const tinygltf::Node& gltfNode = gltfModel.nodes[nodeIndex];
+	if (gltfNode.mesh > -1) {
+		for (const auto& primitive : gltfModel.meshes[gltfNode.mesh].primitives) {
+			vertexCount += getPrimitiveVertexCount(gltfModel, primitive);
+			indexCount += getPrimitiveIndexCount(gltfModel, primitive);
+		}
+	}
+	for (int childIndex : gltfNode.children) {
+		countNodeGeometry(gltfModel, childIndex, vertexCount, indexCount);
+	}
+}
+
+// Box around the parts' boxes and a sphere around their spheres, both centered on the box
+template<typename T, typename GetBounds>
+Bounds mergeBounds(const std::vector<T>& parts, GetBounds getBounds)
+{
+	Bounds merged;
+	for (const auto& part : parts) {
+		const Bounds& bounds = getBounds(part);
+		if (bounds.isValid()) {
+			merged.min = glm::min(merged.min, bounds.min);
+			merged.max = glm::max(merged.max, bounds.max);
+		}
+	}
+	if (!merged.isValid()) {
+		return merged;
+	}
+	merged.center = (merged.min + merged.max) * 0.5f;
+	for (const auto& part : parts) {
+		const Bounds& bounds = getBounds(part);
+		if (bounds.isValid()) {
+			merged.radius = std::max(merged.radius, glm::distance(merged.center, bounds.center) + bounds.radius);
+		}
+	}
+	return merged;
+}
+
+}
+
 ObjectLoader::~ObjectLoader()
 {
 	cleanup();
 }
 
-void ObjectLoader::init(Device* device, TextureManager* textureManager, BufferManager* bufferManager)
+void ObjectLoader::init(Device* device, TextureManager* textureManager, BufferManager* bufferManager, GpuResourcePool* resourcePool)
 {
 	this->device = device;
 	this->textureManager = textureManager;
 	this->bufferManager = bufferManager;
+	this->resourcePool = resourcePool;
 }
 
 void ObjectLoader::cleanup()
 {
+	std::lock_guard<std::mutex> lock(scratchMutex);
+	freeScratchArenas.clear();
+}
+
+std::unique_ptr<ScratchArena> ObjectLoader::acquireScratchArena()
+{
+	std::lock_guard<std::mutex> lock(scratchMutex);
+	if (freeScratchArenas.empty()) {
+		return std::make_unique<ScratchArena>();
+	}
+	std::unique_ptr<ScratchArena> arena = std::move(freeScratchArenas.back());
+	freeScratchArenas.pop_back();
+	return arena;
+}
+
+void ObjectLoader::releaseScratchArena(std::unique_ptr<ScratchArena> arena)
+{
+	arena->reset();
+	std::lock_guard<std::mutex> lock(scratchMutex);
+	freeScratchArenas.push_back(std::move(arena));
 }
 
 std::future<bool> ObjectLoader::loadGLTFAsync(const std::string& filepath, Model& outModel)
@@ -69,21 +162,50 @@ bool ObjectLoader::loadGLTF(const std::string& filepath, Model& outModel)
 	std::cout << "  Images: " << gltfModel.images.size() << std::endl;
 	std::cout << "  Nodes: " << gltfModel.nodes.size() << std::endl;
 
-	loadTextures(gltfModel, outModel);
+	std::unique_ptr<ScratchArena> scratch = acquireScratchArena();
+	uint64_t scratchChunksBefore = scratch->getChunkAllocationCount();
+	scratch->resetPeak();
+
+	loadTextures(gltfModel, outModel, *scratch);
 	loadMaterials(gltfModel, outModel);
 
 	outModel.nodes.resize(gltfModel.nodes.size());
 
 	const tinygltf::Scene& scene = gltfModel.scenes[gltfModel.defaultScene > -1 ? gltfModel.defaultScene : 0];
 
+	// Size the geometry arrays once so primitives decode in place instead of being merged
+	size_t totalVertices = 0;
+	size_t totalIndices = 0;
+	for (int nodeIndex : scene.nodes) {
+		countNodeGeometry(gltfModel, nodeIndex, totalVertices, totalIndices);
+	}
+	GeometryCursor cursor;
+	cursor.vertexOffset = static_cast<uint32_t>(outModel.vertices.size());
+	cursor.indexOffset = static_cast<uint32_t>(outModel.indices.size());
+	outModel.vertices.resize(cursor.vertexOffset + totalVertices);
+	outModel.rtVertices.resize(cursor.vertexOffset + totalVertices);
+	outModel.indices.resize(cursor.indexOffset + totalIndices);
+
+	outModel.rootNodes.reserve(scene.nodes.size());
 	for (int nodeIndex : scene.nodes) {
 		outModel.rootNodes.push_back(nodeIndex);
-		loadNode(gltfModel, gltfModel.nodes[nodeIndex], nodeIndex, outModel, glm::mat4(1.0f));
+		loadNode(gltfModel, gltfModel.nodes[nodeIndex], nodeIndex, outModel, glm::mat4(1.0f), cursor);
 	}
 
 	std::cout << "  Loaded vertices: " << outModel.vertices.size() << std::endl;
 	std::cout << "  Loaded indices: " << outModel.indices.size() << std::endl;
 	std::cout << "  Loaded textures: " << outModel.textures.size() << std::endl;
+	std::cout << "  Scratch peak: " << scratch->getPeakBytesUsed() / 1024 << " KB ("
+		<< scratch->getChunkAllocationCount() - scratchChunksBefore << " new chunks)" << std::endl;
+	releaseScratchArena(std::move(scratch));
+
+	outModel.primitiveCount = 0;
+	for (auto& mesh : outModel.meshes) {
+		mesh.primitiveOffset = outModel.primitiveCount;
+		outModel.primitiveCount += static_cast<uint32_t>(mesh.primitives.size());
+	}
+	outModel.bounds = mergeBounds(outModel.meshes, [](const Mesh& mesh) -> const Bounds& { return mesh.bounds; });
+
 	for (size_t i = 0; i < outModel.meshes.size(); i++) {
 		bool hasTransparent = false;
 		for (const auto& prim : outModel.meshes[i].primitives) {
@@ -105,15 +227,16 @@ bool ObjectLoader::loadGLTF(const std::string& filepath, Model& outModel)
 	return true;
 }
 
-void ObjectLoader::loadTextures(const tinygltf::Model& gltfModel, Model& model)
+void ObjectLoader::loadTextures(const tinygltf::Model& gltfModel, Model& model, ScratchArena& scratch)
 {
 	size_t textureCount = gltfModel.textures.size();
 	model.textures.resize(textureCount);
 
+	// Expanded RGBA copies live in the scratch arena until the uploads below are done
+	ScratchArena::Scope scratchScope(scratch);
+
 	// Phase 1: Convert pixel data in parallel
-	std::vector<std::vector<unsigned char>> convertedBuffers(textureCount);
-	std::vector<int> widths(textureCount);
-	std::vector<int> heights(textureCount);
+	std::vector<unsigned char*> convertedBuffers(textureCount, nullptr);
 	std::vector<std::future<void>> conversions;
 
 	for (size_t i = 0; i < textureCount; i++) {
@@ -124,28 +247,31 @@ void ObjectLoader::loadTextures(const tinygltf::Model& gltfModel, Model& model)
 			continue;
 		}
 
-		widths[i] = gltfImage.width;
-		heights[i] = gltfImage.height;
+		int channels = gltfImage.component;
+		if (channels != 3 && channels != 1) {
+			continue;
+		}
 
-		conversions.push_back(std::async(std::launch::async, [&gltfImage, &convertedBuffers, i]() {
-			int channels = gltfImage.component;
-			int pixelCount = gltfImage.width * gltfImage.height;
+		// Allocate on this thread; the arena is not shared with the conversion tasks
+		size_t pixelCount = static_cast<size_t>(gltfImage.width) * gltfImage.height;
+		unsigned char* dst = scratch.allocateArray<unsigned char>(pixelCount * 4);
+		convertedBuffers[i] = dst;
 
+		conversions.push_back(std::async(std::launch::async, [&gltfImage, dst, channels, pixelCount]() {
+			const unsigned char* src = gltfImage.image.data();
 			if (channels == 3) {
-				convertedBuffers[i].resize(pixelCount * 4);
-				for (int j = 0; j < pixelCount; j++) {
-					convertedBuffers[i][j * 4 + 0] = gltfImage.image[j * 3 + 0];
-					convertedBuffers[i][j * 4 + 1] = gltfImage.image[j * 3 + 1];
-					convertedBuffers[i][j * 4 + 2] = gltfImage.image[j * 3 + 2];
-					convertedBuffers[i][j * 4 + 3] = 255;
+				for (size_t j = 0; j < pixelCount; j++) {
+					dst[j * 4 + 0] = src[j * 3 + 0];
+					dst[j * 4 + 1] = src[j * 3 + 1];
+					dst[j * 4 + 2] = src[j * 3 + 2];
+					dst[j * 4 + 3] = 255;
 				}
-			} else if (channels == 1) {
-				convertedBuffers[i].resize(pixelCount * 4);
-				for (int j = 0; j < pixelCount; j++) {
-					convertedBuffers[i][j * 4 + 0] = gltfImage.image[j];
-					convertedBuffers[i][j * 4 + 1] = gltfImage.image[j];
-					convertedBuffers[i][j * 4 + 2] = gltfImage.image[j];
-					convertedBuffers[i][j * 4 + 3] = 255;
+			} else {
+				for (size_t j = 0; j < pixelCount; j++) {
+					dst[j * 4 + 0] = src[j];
+					dst[j * 4 + 1] = src[j];
+					dst[j * 4 + 2] = src[j];
+					dst[j * 4 + 3] = 255;
 				}
 			}
 		}));
@@ -166,15 +292,22 @@ void ObjectLoader::loadTextures(const tinygltf::Model& gltfModel, Model& model)
 		}
 
 		int channels = gltfImage.component;
-		LoadedTexture& outTexture = model.textures[i];
-		outTexture.width = static_cast<uint32_t>(widths[i]);
-		outTexture.height = static_cast<uint32_t>(heights[i]);
-
 		const unsigned char* pixelData = channels == 4
 			? gltfImage.image.data()
-			: convertedBuffers[i].data();
+			: convertedBuffers[i];
+		if (!pixelData) {
+			std::cerr << "Unsupported channel count " << channels << " for texture " << i << std::endl;
+			continue;
+		}
+
+		LoadedTexture outTexture{};
+		outTexture.width = static_cast<uint32_t>(gltfImage.width);
+		outTexture.height = static_cast<uint32_t>(gltfImage.height);
 
-		uploadTextureToGPU(pixelData, widths[i], heights[i], outTexture);
+		std::string textureName = !gltfImage.name.empty() ? gltfImage.name
+			: !gltfImage.uri.empty() ? gltfImage.uri
+			: "gltf.texture" + std::to_string(i);
+		uploadTextureToGPU(pixelData, gltfImage.width, gltfImage.height, outTexture, textureName.c_str());
 
 		VkSamplerCreateInfo samplerInfo{};
 		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
@@ -211,11 +344,14 @@ void ObjectLoader::loadTextures(const tinygltf::Model& gltfModel, Model& model)
 		if (vkCreateSampler(device->getDevice(), &samplerInfo, nullptr, &outTexture.sampler) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create texture sampler!");
 		}
+		MK_TRACK_GPU_RESOURCE(outTexture.sampler, 0, textureName.c_str());
+
+		model.textures[i] = resourcePool->addTexture(outTexture);
 	}
 }
 
 void ObjectLoader::uploadTextureToGPU(const unsigned char* pixelData, int width, int height,
-                                      LoadedTexture& outTexture)
+                                      LoadedTexture& outTexture, const char* debugName)
 {
 	VkDeviceSize imageSize = static_cast<VkDeviceSize>(width) * height * 4;
 
@@ -227,7 +363,8 @@ void ObjectLoader::uploadTextureToGPU(const unsigned char* pixelData, int width,
 		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
 		stagingBuffer,
-		stagingBufferMemory
+		stagingBufferMemory,
+		"texture.staging"
 	);
 
 	void* data;
@@ -243,7 +380,9 @@ void ObjectLoader::uploadTextureToGPU(const unsigned char* pixelData, int width,
 		VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
 		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 		outTexture.image,
-		outTexture.memory
+		outTexture.memory,
+		false,
+		debugName
 	);
 
 	textureManager->transitionImageLayout(
@@ -270,7 +409,9 @@ void ObjectLoader::uploadTextureToGPU(const unsigned char* pixelData, int width,
 	outTexture.imageView = textureManager->createImageView(
 		outTexture.image,
 		VK_FORMAT_R8G8B8A8_SRGB,
-		VK_IMAGE_ASPECT_COLOR_BIT
+		VK_IMAGE_ASPECT_COLOR_BIT,
+		false,
+		debugName
 	);
 
 	bufferManager->destroyBuffer(stagingBuffer, stagingBufferMemory);
@@ -363,7 +504,7 @@ void ObjectLoader::loadMaterials(const tinygltf::Model& gltfModel, Model& model)
 }
 
 void ObjectLoader::loadNode(const tinygltf::Model& gltfModel, const tinygltf::Node& gltfNode,
-                            int nodeIndex, Model& model, const glm::mat4& parentTransform)
+                            int nodeIndex, Model& model, const glm::mat4& parentTransform, GeometryCursor& cursor)
 {
 	Node& node = model.nodes[nodeIndex];
 	node.name = gltfNode.name;
@@ -373,23 +514,28 @@ void ObjectLoader::loadNode(const tinygltf::Model& gltfModel, const tinygltf::No
 	// Load mesh if present - pass the world transform to apply to vertices
 	if (gltfNode.mesh > -1) {
 		node.meshIndex = static_cast<int32_t>(model.meshes.size());
-		loadMesh(gltfModel, gltfModel.meshes[gltfNode.mesh], model, node.worldTransform);
+		loadMesh(gltfModel, gltfModel.meshes[gltfNode.mesh], model, node.worldTransform, cursor);
 	}
 
 	// Process children
 	for (int childIndex : gltfNode.children) {
 		node.children.push_back(childIndex);
 		model.nodes[childIndex].parent = nodeIndex;
-		loadNode(gltfModel, gltfModel.nodes[childIndex], childIndex, model, node.worldTransform);
+		loadNode(gltfModel, gltfModel.nodes[childIndex], childIndex, model, node.worldTransform, cursor);
 	}
 }
 
-ObjectLoader::PrimitiveData ObjectLoader::loadPrimitiveData(const tinygltf::Model& gltfModel,
-                                                            const tinygltf::Primitive& primitive,
-                                                            const glm::mat4& worldTransform,
-                                                            const glm::mat3& normalMatrix)
+void ObjectLoader::writePrimitiveData(const tinygltf::Model& gltfModel,
+                                      const tinygltf::Primitive& primitive,
+                                      const glm::mat4& worldTransform,
+                                      const glm::mat3& normalMatrix,
+                                      Vertex* outVertices,
+                                      RayTracingVertex* outRtVertices,
+                                      uint32_t* outIndices,
+                                      uint32_t vertexOffset,
+                                      Bounds* outBounds)
 {
-	PrimitiveData result;
+	uint32_t vertexCount = 0;
 
 	const float* positionBuffer = nullptr;
 	const float* normalBuffer = nullptr;
@@ -401,7 +547,7 @@ ObjectLoader::PrimitiveData ObjectLoader::loadPrimitiveData(const tinygltf::Mode
 		const tinygltf::Accessor& accessor = gltfModel.accessors[primitive.attributes.find("POSITION")->second];
 		const tinygltf::BufferView& bufferView = gltfModel.bufferViews[accessor.bufferView];
 		positionBuffer = reinterpret_cast<const float*>(&gltfModel.buffers[bufferView.buffer].data[accessor.byteOffset + bufferView.byteOffset]);
-		result.vertexCount = static_cast<uint32_t>(accessor.count);
+		vertexCount = static_cast<uint32_t>(accessor.count);
 	}
 
 	if (primitive.attributes.find("NORMAL") != primitive.attributes.end()) {
@@ -423,12 +569,9 @@ ObjectLoader::PrimitiveData ObjectLoader::loadPrimitiveData(const tinygltf::Mode
 		colorComponentCount = (accessor.type == TINYGLTF_TYPE_VEC4) ? 4 : 3;
 	}
 
-	result.vertices.reserve(result.vertexCount);
-	result.rtVertices.reserve(result.vertexCount);
-
-	for (uint32_t v = 0; v < result.vertexCount; v++) {
-		Vertex vertex{};
-		RayTracingVertex rtVertex{};
+	for (uint32_t v = 0; v < vertexCount; v++) {
+		Vertex& vertex = outVertices[v];
+		RayTracingVertex& rtVertex = outRtVertices[v];
 
 		glm::vec3 localPos = glm::vec3(
 			positionBuffer[v * 3 + 0],
@@ -437,6 +580,8 @@ ObjectLoader::PrimitiveData ObjectLoader::loadPrimitiveData(const tinygltf::Mode
 		);
 		glm::vec4 worldPos = worldTransform * glm::vec4(localPos, 1.0f);
 		vertex.pos = glm::vec3(worldPos);
+		outBounds->min = glm::min(outBounds->min, vertex.pos);
+		outBounds->max = glm::max(outBounds->max, vertex.pos);
 		rtVertex.position = glm::vec4(localPos, 1.0f);
 
 		if (colorBuffer) {
@@ -470,9 +615,17 @@ ObjectLoader::PrimitiveData ObjectLoader::loadPrimitiveData(const tinygltf::Mode
 
 		vertex.normal = normalMatrix * localNormal;
 		rtVertex.normal = glm::vec4(glm::normalize(localNormal), 0.0f);
+	}
 
-		result.vertices.push_back(vertex);
-		result.rtVertices.push_back(rtVertex);
+	// Sphere around the box center; tighter than the half diagonal for most meshes
+	if (outBounds->isValid()) {
+		outBounds->center = (outBounds->min + outBounds->max) * 0.5f;
+		float radiusSq = 0.0f;
+		for (uint32_t v = 0; v < vertexCount; v++) {
+			glm::vec3 d = outVertices[v].pos - outBounds->center;
+			radiusSq = std::max(radiusSq, glm::dot(d, d));
+		}
+		outBounds->radius = std::sqrt(radiusSq);
 	}
 
 	if (primitive.indices > -1) {
@@ -480,28 +633,26 @@ ObjectLoader::PrimitiveData ObjectLoader::loadPrimitiveData(const tinygltf::Mode
 		const tinygltf::BufferView& bufferView = gltfModel.bufferViews[accessor.bufferView];
 		const void* dataPtr = &gltfModel.buffers[bufferView.buffer].data[accessor.byteOffset + bufferView.byteOffset];
 
-		result.indexCount = static_cast<uint32_t>(accessor.count);
-		result.indices.reserve(result.indexCount);
-
+		// Rebase onto the primitive's first vertex while copying
 		switch (accessor.componentType) {
 		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT: {
 			const uint32_t* buf = static_cast<const uint32_t*>(dataPtr);
 			for (size_t i = 0; i < accessor.count; i++) {
-				result.indices.push_back(buf[i]);
+				outIndices[i] = buf[i] + vertexOffset;
 			}
 			break;
 		}
 		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
 			const uint16_t* buf = static_cast<const uint16_t*>(dataPtr);
 			for (size_t i = 0; i < accessor.count; i++) {
-				result.indices.push_back(buf[i]);
+				outIndices[i] = buf[i] + vertexOffset;
 			}
 			break;
 		}
 		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: {
 			const uint8_t* buf = static_cast<const uint8_t*>(dataPtr);
 			for (size_t i = 0; i < accessor.count; i++) {
-				result.indices.push_back(buf[i]);
+				outIndices[i] = buf[i] + vertexOffset;
 			}
 			break;
 		}
@@ -510,57 +661,51 @@ ObjectLoader::PrimitiveData ObjectLoader::loadPrimitiveData(const tinygltf::Mode
 			break;
 		}
 	}
-
-	return result;
 }
 
 void ObjectLoader::loadMesh(const tinygltf::Model& gltfModel, const tinygltf::Mesh& gltfMesh,
-	Model& model, const glm::mat4& worldTransform)
+	Model& model, const glm::mat4& worldTransform, GeometryCursor& cursor)
 {
 	Mesh mesh;
 	mesh.name = gltfMesh.name;
 
 	glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(worldTransform)));
 
-	// Process primitives in parallel
+	// Process primitives in parallel, each writing its own slice of the model arrays
 	size_t primCount = gltfMesh.primitives.size();
-	std::vector<std::future<PrimitiveData>> futures;
+	std::vector<std::future<void>> futures;
 	futures.reserve(primCount);
+	mesh.primitives.reserve(primCount);
 
 	for (const auto& primitive : gltfMesh.primitives) {
-		futures.push_back(std::async(std::launch::async, &ObjectLoader::loadPrimitiveData, this,
-		                             std::ref(gltfModel), std::ref(primitive),
-		                             std::ref(worldTransform), std::ref(normalMatrix)));
-	}
-
-	uint32_t vertexOffset = static_cast<uint32_t>(model.vertices.size());
-	uint32_t indexOffset = static_cast<uint32_t>(model.indices.size());
-
-	for (size_t pi = 0; pi < primCount; pi++) {
-		PrimitiveData data = futures[pi].get();
-
 		Primitive prim;
-		prim.firstVertex = vertexOffset;
-		prim.firstIndex = indexOffset;
-		prim.materialIndex = gltfMesh.primitives[pi].material;
-		prim.vertexCount = data.vertexCount;
-		prim.indexCount = data.indexCount;
-
-		// Merge collected data into model
-		model.vertices.insert(model.vertices.end(), data.vertices.begin(), data.vertices.end());
-		model.rtVertices.insert(model.rtVertices.end(), data.rtVertices.begin(), data.rtVertices.end());
-
-		for (uint32_t idx : data.indices) {
-			model.indices.push_back(idx + vertexOffset);
-		}
+		prim.firstVertex = cursor.vertexOffset;
+		prim.firstIndex = cursor.indexOffset;
+		prim.materialIndex = primitive.material;
+		prim.vertexCount = getPrimitiveVertexCount(gltfModel, primitive);
+		prim.indexCount = getPrimitiveIndexCount(gltfModel, primitive);
+		// Reserved above, so the bounds pointer handed to the task stays valid
+		mesh.primitives.push_back(prim);
 
-		vertexOffset += data.vertexCount;
-		indexOffset += data.indexCount;
+		Vertex* outVertices = model.vertices.data() + prim.firstVertex;
+		RayTracingVertex* outRtVertices = model.rtVertices.data() + prim.firstVertex;
+		uint32_t* outIndices = model.indices.data() + prim.firstIndex;
+		futures.push_back(std::async(std::launch::async, &ObjectLoader::writePrimitiveData, this,
+		                             std::ref(gltfModel), std::ref(primitive),
+		                             std::ref(worldTransform), std::ref(normalMatrix),
+		                             outVertices, outRtVertices, outIndices, prim.firstVertex,
+		                             &mesh.primitives.back().bounds));
 
-		mesh.primitives.push_back(prim);
+		cursor.vertexOffset += prim.vertexCount;
+		cursor.indexOffset += prim.indexCount;
 	}
 
-	model.meshes.push_back(mesh);
+	for (auto& f : futures) {
+		f.get();
+	}
+	mesh.bounds = mergeBounds(mesh.primitives, [](const Primitive& prim) -> const Bounds& { return prim.bounds; });
+
+	model.meshes.push_back(std::move(mesh));
 }
 
 glm::mat4 ObjectLoader::getNodeTransform(const tinygltf::Node& node)
@@ -610,25 +755,30 @@ void ObjectLoader::createModelBuffers(Model& model)
 
 	device->createBuffer(vertexBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		stagingBuffer, stagingBufferMemory);
+		stagingBuffer, stagingBufferMemory, "model.staging");
 
 	void* data;
 	vkMapMemory(device->getDevice(), stagingBufferMemory, 0, vertexBufferSize, 0, &data);
 	memcpy(data, model.vertices.data(), vertexBufferSize);
 	vkUnmapMemory(device->getDevice(), stagingBufferMemory);
 
+	VkBuffer vertexBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory vertexBufferMemory = VK_NULL_HANDLE;
 	device->createBuffer(vertexBufferSize,
-       VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, model.vertexBuffer, model.vertexBufferMemory);
+       VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | device->getAccelerationStructureInputUsage(),
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBuffer, vertexBufferMemory, "model.vertices");
+	model.vertexBuffer = resourcePool->addBuffer(vertexBuffer, vertexBufferMemory, vertexBufferSize);
 
-	// Ray tracing vertex buffer (local positions/normals)
+	// Ray tracing vertex buffer (local positions/normals); nothing else reads it
 	VkDeviceSize rtVertexBufferSize = sizeof(RayTracingVertex) * model.rtVertices.size();
-	if (rtVertexBufferSize > 0) {
+	if (rtVertexBufferSize > 0 && device->supportsRayTracing()) {
 		VkBuffer rtStagingBuffer = VK_NULL_HANDLE;
 		VkDeviceMemory rtStagingMemory = VK_NULL_HANDLE;
+		VkBuffer rtVertexBuffer = VK_NULL_HANDLE;
+		VkDeviceMemory rtVertexBufferMemory = VK_NULL_HANDLE;
 		device->createBuffer(rtVertexBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			rtStagingBuffer, rtStagingMemory);
+			rtStagingBuffer, rtStagingMemory, "model.staging");
 
 		vkMapMemory(device->getDevice(), rtStagingMemory, 0, rtVertexBufferSize, 0, &data);
 		memcpy(data, model.rtVertices.data(), rtVertexBufferSize);
@@ -638,16 +788,17 @@ void ObjectLoader::createModelBuffers(Model& model)
 			VK_BUFFER_USAGE_TRANSFER_DST_BIT |
 			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
 			VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
-			VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, model.rtVertexBuffer, model.rtVertexBufferMemory);
+			device->getAccelerationStructureInputUsage(),
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, rtVertexBuffer, rtVertexBufferMemory, "model.rtVertices");
+		model.rtVertexBuffer = resourcePool->addBuffer(rtVertexBuffer, rtVertexBufferMemory, rtVertexBufferSize);
 
-		device->copyBuffer(rtStagingBuffer, model.rtVertexBuffer, rtVertexBufferSize);
-		vkDestroyBuffer(device->getDevice(), rtStagingBuffer, nullptr);
+		device->copyBuffer(rtStagingBuffer, rtVertexBuffer, rtVertexBufferSize);
+		GpuResourceRegistry::destroy(device->getDevice(), rtStagingBuffer, nullptr);
 		vkFreeMemory(device->getDevice(), rtStagingMemory, nullptr);
 	}
 
-	device->copyBuffer(stagingBuffer, model.vertexBuffer, vertexBufferSize);
-	vkDestroyBuffer(device->getDevice(), stagingBuffer, nullptr);
+	device->copyBuffer(stagingBuffer, vertexBuffer, vertexBufferSize);
+	GpuResourceRegistry::destroy(device->getDevice(), stagingBuffer, nullptr);
 	vkFreeMemory(device->getDevice(), stagingBufferMemory, nullptr);
 
 	// Index buffer
@@ -655,18 +806,21 @@ void ObjectLoader::createModelBuffers(Model& model)
 
 	device->createBuffer(indexBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		stagingBuffer, stagingBufferMemory);
+		stagingBuffer, stagingBufferMemory, "model.staging");
 
 	vkMapMemory(device->getDevice(), stagingBufferMemory, 0, indexBufferSize, 0, &data);
 	memcpy(data, model.indices.data(), indexBufferSize);
 	vkUnmapMemory(device->getDevice(), stagingBufferMemory);
 
+	VkBuffer indexBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory indexBufferMemory = VK_NULL_HANDLE;
 	device->createBuffer(indexBufferSize,
-        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, model.indexBuffer, model.indexBufferMemory);
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | device->getAccelerationStructureInputUsage(),
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBuffer, indexBufferMemory, "model.indices");
+	model.indexBuffer = resourcePool->addBuffer(indexBuffer, indexBufferMemory, indexBufferSize);
 
-	device->copyBuffer(stagingBuffer, model.indexBuffer, indexBufferSize);
-	vkDestroyBuffer(device->getDevice(), stagingBuffer, nullptr);
+	device->copyBuffer(stagingBuffer, indexBuffer, indexBufferSize);
+	GpuResourceRegistry::destroy(device->getDevice(), stagingBuffer, nullptr);
 	vkFreeMemory(device->getDevice(), stagingBufferMemory, nullptr);
 
 	std::cout << "Created GPU buffers - Vertices: " << vertexBufferSize
@@ -675,44 +829,37 @@ void ObjectLoader::createModelBuffers(Model& model)
 
 void ObjectLoader::destroyModel(Model& model)
 {
-	// Destroy buffers
-	if (model.vertexBuffer != VK_NULL_HANDLE) {
-		vkDestroyBuffer(device->getDevice(), model.vertexBuffer, nullptr);
-	}
-	if (model.vertexBufferMemory != VK_NULL_HANDLE) {
-		vkFreeMemory(device->getDevice(), model.vertexBufferMemory, nullptr);
-	}
-	if (model.indexBuffer != VK_NULL_HANDLE) {
-		vkDestroyBuffer(device->getDevice(), model.indexBuffer, nullptr);
-	}
-	if (model.indexBufferMemory != VK_NULL_HANDLE) {
-		vkFreeMemory(device->getDevice(), model.indexBufferMemory, nullptr);
-	}
+	resourcePool->destroyBuffer(model.vertexBuffer);
+	resourcePool->destroyBuffer(model.indexBuffer);
+	resourcePool->destroyBuffer(model.rtVertexBuffer);
+	model.vertexBuffer = BufferHandle();
+	model.indexBuffer = BufferHandle();
+	model.rtVertexBuffer = BufferHandle();
 
-	// Destroy ray tracing vertex buffer
-	if (model.rtVertexBuffer != VK_NULL_HANDLE) {
-		vkDestroyBuffer(device->getDevice(), model.rtVertexBuffer, nullptr);
-		model.rtVertexBuffer = VK_NULL_HANDLE;
-	}
-	if (model.rtVertexBufferMemory != VK_NULL_HANDLE) {
-		vkFreeMemory(device->getDevice(), model.rtVertexBufferMemory, nullptr);
-		model.rtVertexBufferMemory = VK_NULL_HANDLE;
+	for (TextureHandle texture : model.textures) {
+		resourcePool->destroyTexture(texture);
 	}
 
-	// Destroy textures
-	for (auto& texture : model.textures) {
-		if (texture.sampler != VK_NULL_HANDLE) {
-			vkDestroySampler(device->getDevice(), texture.sampler, nullptr);
-		}
-		if (texture.imageView != VK_NULL_HANDLE) {
-			vkDestroyImageView(device->getDevice(), texture.imageView, nullptr);
-		}
-		if (texture.image != VK_NULL_HANDLE) {
-			vkDestroyImage(device->getDevice(), texture.image, nullptr);
-		}
-		if (texture.memory != VK_NULL_HANDLE) {
-			vkFreeMemory(device->getDevice(), texture.memory, nullptr);
-		}
+	model.vertices.clear();
+	model.rtVertices.clear();
+	model.indices.clear();
+	model.meshes.clear();
+	model.nodes.clear();
+	model.materials.clear();
+	model.textures.clear();
+}
+
+void ObjectLoader::retireModel(Model& model, FrameDeletionQueue& retireQueue)
+{
+	resourcePool->retireBuffer(model.vertexBuffer, retireQueue);
+	resourcePool->retireBuffer(model.indexBuffer, retireQueue);
+	resourcePool->retireBuffer(model.rtVertexBuffer, retireQueue);
+	model.vertexBuffer = BufferHandle();
+	model.indexBuffer = BufferHandle();
+	model.rtVertexBuffer = BufferHandle();
+
+	for (TextureHandle texture : model.textures) {
+		resourcePool->retireTexture(texture, retireQueue);
 	}
 
 	model.vertices.clear();
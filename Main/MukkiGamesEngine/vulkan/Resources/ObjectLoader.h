@@ -6,6 +6,7 @@
 #include <tiny_gltf.h>
 #include <string>
 #include <vector>
+#include <limits>
 #include <memory>
 #include <unordered_map>
 #include <future>
@@ -13,6 +14,9 @@
 
 #include "../Core/VkDevice.h"
 #include "../objects/vertex.h"
+#include "DeletionQueue.h"
+#include "GpuResourcePool.h"
+#include "ScratchArena.h"
 
 class TextureManager;
 class BufferManager;
@@ -40,6 +44,17 @@ struct Material {
 	float alphaCutoff = 0.5f;
 };
 
+// Box and enclosing sphere of some vertices, in the model space the loader bakes them into
+// (node transforms applied, the object's Transform not)
+struct Bounds {
+	glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+	glm::vec3 max = glm::vec3(std::numeric_limits<float>::lowest());
+	glm::vec3 center = glm::vec3(0.0f);
+	float radius = 0.0f;
+
+	bool isValid() const { return min.x <= max.x; }
+};
+
 // A single mesh primitive (submesh)
 struct Primitive {
 	uint32_t firstIndex;
@@ -47,12 +62,16 @@ struct Primitive {
 	uint32_t firstVertex;
 	uint32_t vertexCount;
 	int32_t materialIndex = -1;
+	Bounds bounds;
 };
 
 // A mesh can contain multiple primitives
 struct Mesh {
 	std::string name;
 	std::vector<Primitive> primitives;
+	Bounds bounds;
+	// Index of the first primitive when all of the model's primitives are numbered mesh by mesh
+	uint32_t primitiveOffset = 0;
 };
 
 // A node in the scene hierarchy
@@ -65,16 +84,6 @@ struct Node {
 	int32_t parent = -1;
 };
 
-// Texture loaded from glTF
-struct LoadedTexture {
-	VkImage image = VK_NULL_HANDLE;
-	VkDeviceMemory memory = VK_NULL_HANDLE;
-	VkImageView imageView = VK_NULL_HANDLE;
-	VkSampler sampler = VK_NULL_HANDLE;
-	uint32_t width = 0;
-	uint32_t height = 0;
-};
-
 // Complete loaded model
 struct Model {
 	std::vector<Vertex> vertices;
@@ -83,18 +92,17 @@ struct Model {
 	std::vector<Mesh> meshes;
 	std::vector<Node> nodes;
 	std::vector<Material> materials;
-	std::vector<LoadedTexture> textures;
+	std::vector<TextureHandle> textures;
 	std::vector<int32_t> rootNodes;
 	//rendering order 
 	std::vector<size_t> opaqueMeshIndices;
 	std::vector<size_t> transparentMeshIndices;
-	// GPU buffers
-	VkBuffer vertexBuffer = VK_NULL_HANDLE;
-	VkDeviceMemory vertexBufferMemory = VK_NULL_HANDLE;
-	VkBuffer indexBuffer = VK_NULL_HANDLE;
-	VkDeviceMemory indexBufferMemory = VK_NULL_HANDLE;
-	VkBuffer rtVertexBuffer = VK_NULL_HANDLE;
-	VkDeviceMemory rtVertexBufferMemory = VK_NULL_HANDLE;
+	Bounds bounds;
+	uint32_t primitiveCount = 0;
+	// GPU buffers, owned by the GpuResourcePool
+	BufferHandle vertexBuffer;
+	BufferHandle indexBuffer;
+	BufferHandle rtVertexBuffer;
 };
 
 class ObjectLoader {
@@ -102,45 +110,59 @@ public:
 	ObjectLoader() = default;
 	~ObjectLoader();
 	
-	void init(Device* device, TextureManager* textureManager, BufferManager* bufferManager);
+	void init(Device* device, TextureManager* textureManager, BufferManager* bufferManager, GpuResourcePool* resourcePool);
 	void cleanup();
 	
 	bool loadGLTF(const std::string& filepath, Model& outModel);
 	std::future<bool> loadGLTFAsync(const std::string& filepath, Model& outModel);
 	void createModelBuffers(Model& model);
 	void destroyModel(Model& model);
+	// Hands the model's GPU resources to the retirement queue instead of destroying them now
+	void retireModel(Model& model, FrameDeletionQueue& retireQueue);
 
 private:
 	Device* device = nullptr;
 	TextureManager* textureManager = nullptr;
 	BufferManager* bufferManager = nullptr;
+	GpuResourcePool* resourcePool = nullptr;
 	
 	
+	// Scratch arenas outlive the std::async threads that borrow them, so warm chunks carry over between loads
+	std::mutex scratchMutex;
+	std::vector<std::unique_ptr<ScratchArena>> freeScratchArenas;
+	std::unique_ptr<ScratchArena> acquireScratchArena();
+	void releaseScratchArena(std::unique_ptr<ScratchArena> arena);
+
+	// Next free slot in the model's vertex/index arrays, which are sized once per load
+	struct GeometryCursor {
+		uint32_t vertexOffset = 0;
+		uint32_t indexOffset = 0;
+	};
+
 	void loadNode(const tinygltf::Model& gltfModel, const tinygltf::Node& gltfNode, 
-	              int nodeIndex, Model& model, const glm::mat4& parentTransform);
+	              int nodeIndex, Model& model, const glm::mat4& parentTransform, GeometryCursor& cursor);
 	void loadMesh(const tinygltf::Model& gltfModel, const tinygltf::Mesh& gltfMesh,
-		Model& model, const glm::mat4& worldTransform);
+		Model& model, const glm::mat4& worldTransform, GeometryCursor& cursor);
 	void loadMaterials(const tinygltf::Model& gltfModel, Model& model);
-	void loadTextures(const tinygltf::Model& gltfModel, Model& model);
+	void loadTextures(const tinygltf::Model& gltfModel, Model& model, ScratchArena& scratch);
 	
 	// Texture loading helpers
 	void uploadTextureToGPU(const unsigned char* pixelData, int width, int height,
-	                        LoadedTexture& outTexture);
+	                        LoadedTexture& outTexture, const char* debugName = nullptr);
 	VkSamplerAddressMode getVkWrapMode(int wrapMode);
 	VkFilter getVkFilterMode(int filterMode);
 	
 	glm::mat4 getNodeTransform(const tinygltf::Node& node);
 
-	// Primitive data collected in parallel, then merged
-	struct PrimitiveData {
-		std::vector<Vertex> vertices;
-		std::vector<RayTracingVertex> rtVertices;
-		std::vector<uint32_t> indices;
-		uint32_t vertexCount;
-		uint32_t indexCount;
-	};
-	PrimitiveData loadPrimitiveData(const tinygltf::Model& gltfModel,
-	                                const tinygltf::Primitive& primitive,
-	                                const glm::mat4& worldTransform,
-	                                const glm::mat3& normalMatrix);
+	// Decodes one primitive straight into its slice of the model arrays; safe to run in parallel
+	// with other primitives since every slice is disjoint
+	void writePrimitiveData(const tinygltf::Model& gltfModel,
+	                        const tinygltf::Primitive& primitive,
+	                        const glm::mat4& worldTransform,
+	                        const glm::mat3& normalMatrix,
+	                        Vertex* outVertices,
+	                        RayTracingVertex* outRtVertices,
+	                        uint32_t* outIndices,
+	                        uint32_t vertexOffset,
+	                        Bounds* outBounds);
 };
\ No newline at end of file
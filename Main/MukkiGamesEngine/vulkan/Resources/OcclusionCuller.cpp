@@ -0,0 +1,311 @@
+#include "OcclusionCuller.h"
+#include "../utils/CpuProfiler.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MK_OCCLUSION_SSE 1
+#endif
+
+void OcclusionCuller::init(uint32_t bands)
+{
+	cleanup();
+	bandCount = std::clamp(bands, 1u, MAX_BANDS);
+	stopping = false;
+	for (uint32_t band = 1; band < bandCount; band++) {
+		workers.emplace_back(&OcclusionCuller::workerLoop, this, band);
+	}
+}
+
+void OcclusionCuller::cleanup()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	workReady.notify_all();
+	for (auto& worker : workers) {
+		worker.join();
+	}
+	workers.clear();
+	bandCount = 1;
+}
+
+void OcclusionCuller::begin(const glm::mat4& matrix)
+{
+	viewProj = matrix;
+	triangles.clear();
+	std::fill(depth.begin(), depth.end(), 1.0f);
+	std::fill(tileMaxDepth.begin(), tileMaxDepth.end(), 1.0f);
+}
+
+void OcclusionCuller::addOccluder(const Model& model, const Primitive& primitive, const glm::mat4& modelMatrix)
+{
+	if (primitive.vertexCount == 0 || primitive.indexCount < 3 ||
+		primitive.firstVertex + primitive.vertexCount > model.vertices.size()) {
+		return;
+	}
+
+	// Each vertex goes to clip space once; the indices are absolute, so they are rebased on firstVertex
+	glm::mat4 mvp = viewProj * modelMatrix;
+	clipScratch.resize(primitive.vertexCount);
+	for (uint32_t v = 0; v < primitive.vertexCount; v++) {
+		clipScratch[v] = mvp * glm::vec4(model.vertices[primitive.firstVertex + v].pos, 1.0f);
+	}
+
+	for (uint32_t i = 0; i + 2 < primitive.indexCount; i += 3) {
+		glm::vec4 clip[3];
+		bool inRange = true;
+		for (uint32_t corner = 0; corner < 3; corner++) {
+			uint32_t index = model.indices[primitive.firstIndex + i + corner] - primitive.firstVertex;
+			if (index >= primitive.vertexCount) {
+				inRange = false;
+				break;
+			}
+			clip[corner] = clipScratch[index];
+		}
+		if (!inRange) continue;
+
+		// Entirely beyond one side plane: nothing to draw
+		bool outside = false;
+		for (int axis = 0; axis < 2 && !outside; axis++) {
+			outside = (clip[0][axis] > clip[0].w && clip[1][axis] > clip[1].w && clip[2][axis] > clip[2].w) ||
+				(clip[0][axis] < -clip[0].w && clip[1][axis] < -clip[1].w && clip[2][axis] < -clip[2].w);
+		}
+		if (outside) continue;
+		queueClipped(clip, 3);
+	}
+}
+
+void OcclusionCuller::queueClipped(const glm::vec4* clip, uint32_t count)
+{
+	// Clip against the near plane (z >= 0 in Vulkan clip space); a triangle becomes at most a quad
+	glm::vec4 polygon[4];
+	uint32_t polygonCount = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		const glm::vec4& a = clip[i];
+		const glm::vec4& b = clip[(i + 1) % count];
+		if (a.z >= 0.0f) {
+			polygon[polygonCount++] = a;
+		}
+		if ((a.z >= 0.0f) != (b.z >= 0.0f)) {
+			float t = a.z / (a.z - b.z);
+			polygon[polygonCount++] = a + (b - a) * t;
+		}
+	}
+	if (polygonCount < 3) return;
+
+	glm::vec3 screen[4];
+	for (uint32_t i = 0; i < polygonCount; i++) {
+		float invW = 1.0f / polygon[i].w;
+		screen[i] = glm::vec3((polygon[i].x * invW * 0.5f + 0.5f) * WIDTH,
+			(polygon[i].y * invW * 0.5f + 0.5f) * HEIGHT,
+			polygon[i].z * invW);
+	}
+
+	for (uint32_t i = 1; i + 1 < polygonCount; i++) {
+		ScreenTriangle triangle{ { screen[0], screen[i], screen[i + 1] } };
+		// Occluders are drawn two-sided; the rasterizer wants counter-clockwise area > 0
+		const glm::vec3& a = triangle.v[0];
+		const glm::vec3& b = triangle.v[1];
+		const glm::vec3& c = triangle.v[2];
+		float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+		if (std::abs(area) < 1e-6f) continue;
+		if (area < 0.0f) {
+			std::swap(triangle.v[1], triangle.v[2]);
+		}
+		triangles.push_back(triangle);
+	}
+}
+
+void OcclusionCuller::bandRows(uint32_t band, uint32_t& rowBegin, uint32_t& rowEnd) const
+{
+	// Bands are whole tile rows, so each band also owns its tiles' depth
+	constexpr uint32_t TILE_ROWS = HEIGHT / TILE;
+	rowBegin = TILE_ROWS * band / bandCount * TILE;
+	rowEnd = TILE_ROWS * (band + 1) / bandCount * TILE;
+}
+
+void OcclusionCuller::rasterize()
+{
+	if (bandCount > 1) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			bandsRemaining = bandCount - 1;
+			jobGeneration++;
+		}
+		workReady.notify_all();
+	}
+
+	uint32_t rowBegin, rowEnd;
+	bandRows(0, rowBegin, rowEnd);
+	rasterizeBand(rowBegin, rowEnd);
+
+	if (bandCount > 1) {
+		std::unique_lock<std::mutex> lock(mutex);
+		workDone.wait(lock, [this]() { return bandsRemaining == 0; });
+	}
+}
+
+void OcclusionCuller::workerLoop(uint32_t band)
+{
+	CpuProfiler::get().setThreadName(("Occlusion worker " + std::to_string(band)).c_str());
+	uint64_t seenGeneration = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			workReady.wait(lock, [&]() { return stopping || jobGeneration != seenGeneration; });
+			if (stopping) {
+				return;
+			}
+			seenGeneration = jobGeneration;
+		}
+
+		uint32_t rowBegin, rowEnd;
+		bandRows(band, rowBegin, rowEnd);
+		rasterizeBand(rowBegin, rowEnd);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			bandsRemaining--;
+		}
+		workDone.notify_one();
+	}
+}
+
+void OcclusionCuller::rasterizeBand(uint32_t rowBegin, uint32_t rowEnd)
+{
+	for (const auto& triangle : triangles) {
+		float minY = std::min({ triangle.v[0].y, triangle.v[1].y, triangle.v[2].y });
+		float maxY = std::max({ triangle.v[0].y, triangle.v[1].y, triangle.v[2].y });
+		if (maxY < static_cast<float>(rowBegin) || minY >= static_cast<float>(rowEnd)) continue;
+		drawTriangle(triangle, rowBegin, rowEnd);
+	}
+
+	constexpr uint32_t TILES_X = WIDTH / TILE;
+	for (uint32_t tileY = rowBegin / TILE; tileY < rowEnd / TILE; tileY++) {
+		for (uint32_t tileX = 0; tileX < TILES_X; tileX++) {
+			float farthest = 0.0f;
+			for (uint32_t y = tileY * TILE; y < (tileY + 1) * TILE; y++) {
+				const float* row = &depth[y * WIDTH + tileX * TILE];
+				farthest = std::max(farthest, *std::max_element(row, row + TILE));
+			}
+			tileMaxDepth[tileY * TILES_X + tileX] = farthest;
+		}
+	}
+}
+
+void OcclusionCuller::drawTriangle(const ScreenTriangle& triangle, uint32_t rowBegin, uint32_t rowEnd)
+{
+	const glm::vec3& a = triangle.v[0];
+	const glm::vec3& b = triangle.v[1];
+	const glm::vec3& c = triangle.v[2];
+
+	int x0 = std::max(0, static_cast<int>(std::floor(std::min({ a.x, b.x, c.x }))));
+	int x1 = std::min(static_cast<int>(WIDTH) - 1, static_cast<int>(std::ceil(std::max({ a.x, b.x, c.x }))));
+	int y0 = std::max(static_cast<int>(rowBegin), static_cast<int>(std::floor(std::min({ a.y, b.y, c.y }))));
+	int y1 = std::min(static_cast<int>(rowEnd) - 1, static_cast<int>(std::ceil(std::max({ a.y, b.y, c.y }))));
+	if (x0 > x1 || y0 > y1) return;
+
+	// Edge i faces vertex i; over the area it is that vertex's barycentric weight. Pixels are
+	// sampled at their centers.
+	float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+	float invArea = 1.0f / area;
+	auto edge = [](const glm::vec3& from, const glm::vec3& to, float x, float y) {
+		return (to.x - from.x) * (y - from.y) - (to.y - from.y) * (x - from.x);
+	};
+	float dE0dx = b.y - c.y, dE1dx = c.y - a.y, dE2dx = a.y - b.y;
+	float dZdx = (dE0dx * a.z + dE1dx * b.z + dE2dx * c.z) * invArea;
+
+#if defined(MK_OCCLUSION_SSE)
+	// Four pixels per step from a 4-aligned start; lanes outside the triangle fail the edge tests
+	x0 &= ~3;
+	__m128 lanes = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+	__m128 zero = _mm_setzero_ps();
+	__m128 stepE0 = _mm_set1_ps(4.0f * dE0dx), stepE1 = _mm_set1_ps(4.0f * dE1dx), stepE2 = _mm_set1_ps(4.0f * dE2dx);
+	__m128 stepZ = _mm_set1_ps(4.0f * dZdx);
+#endif
+	for (int y = y0; y <= y1; y++) {
+		float px = x0 + 0.5f, py = y + 0.5f;
+		float e0 = edge(b, c, px, py), e1 = edge(c, a, px, py), e2 = edge(a, b, px, py);
+		float z = (e0 * a.z + e1 * b.z + e2 * c.z) * invArea;
+		float* row = &depth[y * WIDTH];
+#if defined(MK_OCCLUSION_SSE)
+		__m128 ve0 = _mm_add_ps(_mm_set1_ps(e0), _mm_mul_ps(lanes, _mm_set1_ps(dE0dx)));
+		__m128 ve1 = _mm_add_ps(_mm_set1_ps(e1), _mm_mul_ps(lanes, _mm_set1_ps(dE1dx)));
+		__m128 ve2 = _mm_add_ps(_mm_set1_ps(e2), _mm_mul_ps(lanes, _mm_set1_ps(dE2dx)));
+		__m128 vz = _mm_add_ps(_mm_set1_ps(z), _mm_mul_ps(lanes, _mm_set1_ps(dZdx)));
+		for (int x = x0; x <= x1; x += 4) {
+			__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(ve0, zero), _mm_cmpge_ps(ve1, zero)), _mm_cmpge_ps(ve2, zero));
+			if (_mm_movemask_ps(inside)) {
+				__m128 current = _mm_loadu_ps(row + x);
+				__m128 nearest = _mm_min_ps(current, vz);
+				_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+			}
+			ve0 = _mm_add_ps(ve0, stepE0);
+			ve1 = _mm_add_ps(ve1, stepE1);
+			ve2 = _mm_add_ps(ve2, stepE2);
+			vz = _mm_add_ps(vz, stepZ);
+		}
+#else
+		for (int x = x0; x <= x1; x++) {
+			if (e0 >= 0.0f && e1 >= 0.0f && e2 >= 0.0f) {
+				row[x] = std::min(row[x], z);
+			}
+			e0 += dE0dx;
+			e1 += dE1dx;
+			e2 += dE2dx;
+			z += dZdx;
+		}
+#endif
+	}
+}
+
+bool OcclusionCuller::isOccluded(const Aabb& box) const
+{
+	if (!box.isValid()) return false;
+
+	float minX = std::numeric_limits<float>::max(), minY = minX, nearest = minX;
+	float maxX = std::numeric_limits<float>::lowest(), maxY = maxX;
+	for (int corner = 0; corner < 8; corner++) {
+		glm::vec3 position((corner & 1) ? box.max.x : box.min.x, (corner & 2) ? box.max.y : box.min.y,
+			(corner & 4) ? box.max.z : box.min.z);
+		glm::vec4 clip = viewProj * glm::vec4(position, 1.0f);
+		if (clip.z < 0.0f || clip.w <= 1e-6f) return false;
+		float invW = 1.0f / clip.w;
+		float x = (clip.x * invW * 0.5f + 0.5f) * WIDTH;
+		float y = (clip.y * invW * 0.5f + 0.5f) * HEIGHT;
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+		nearest = std::min(nearest, clip.z * invW);
+	}
+	if (maxX < 0.0f || maxY < 0.0f || minX >= WIDTH || minY >= HEIGHT) return false;
+
+	// Every pixel the box touches, clamped to the screen
+	uint32_t x0 = static_cast<uint32_t>(std::max(0.0f, minX));
+	uint32_t x1 = static_cast<uint32_t>(std::min(static_cast<float>(WIDTH - 1), maxX));
+	uint32_t y0 = static_cast<uint32_t>(std::max(0.0f, minY));
+	uint32_t y1 = static_cast<uint32_t>(std::min(static_cast<float>(HEIGHT - 1), maxY));
+
+	constexpr uint32_t TILES_X = WIDTH / TILE;
+	for (uint32_t tileY = y0 / TILE; tileY <= y1 / TILE; tileY++) {
+		for (uint32_t tileX = x0 / TILE; tileX <= x1 / TILE; tileX++) {
+			// The whole tile is nearer than the box
+			if (tileMaxDepth[tileY * TILES_X + tileX] < nearest) continue;
+
+			uint32_t rowBegin = std::max(y0, tileY * TILE), rowEnd = std::min(y1, tileY * TILE + TILE - 1);
+			uint32_t columnBegin = std::max(x0, tileX * TILE), columnEnd = std::min(x1, tileX * TILE + TILE - 1);
+			for (uint32_t y = rowBegin; y <= rowEnd; y++) {
+				for (uint32_t x = columnBegin; x <= columnEnd; x++) {
+					if (depth[y * WIDTH + x] >= nearest) return false;
+				}
+			}
+		}
+	}
+	return true;
+}
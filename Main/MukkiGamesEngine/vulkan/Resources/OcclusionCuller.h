@@ -0,0 +1,72 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ObjectLoader.h"
+#include "SceneBVH.h"
+
+// Software occlusion culling. A few large occluder primitives are rasterized on the CPU into a
+// small depth buffer (nearest occluder depth per pixel, z/w as the GPU would see it), split
+// into horizontal bands that persistent worker threads fill in parallel, four pixels at a time
+// with SSE.
+// Each 8x8 tile then keeps its farthest depth, so a box test can usually reject or accept a
+// tile without looking at its pixels. A box is occluded when every pixel it covers already
+// holds something nearer than the box's nearest corner.
+class OcclusionCuller {
+public:
+	static constexpr uint32_t WIDTH = 256;
+	static constexpr uint32_t HEIGHT = 128;
+	static constexpr uint32_t TILE = 8;
+	// The buffer is small; past this many bands the per-band triangle walk outweighs the split
+	static constexpr uint32_t MAX_BANDS = 8;
+
+	~OcclusionCuller() { cleanup(); }
+
+	// Starts bandCount - 1 worker threads, clamped to [1, MAX_BANDS]; the calling thread fills
+	// the first band
+	void init(uint32_t bandCount);
+	void cleanup();
+
+	// Clears the depth buffer and the queued triangles for a new view
+	void begin(const glm::mat4& viewProj);
+	// Queues the primitive's triangles, moved by modelMatrix and clipped to the near plane
+	void addOccluder(const Model& model, const Primitive& primitive, const glm::mat4& modelMatrix);
+	// Rasterizes the queued triangles over the calling thread and the workers, then builds the
+	// tile depths
+	void rasterize();
+	// Boxes that cross the near plane or leave the screen are never occluded
+	bool isOccluded(const Aabb& box) const;
+
+	uint32_t getTriangleCount() const { return static_cast<uint32_t>(triangles.size()); }
+
+private:
+	// x and y in depth buffer pixels, z the depth
+	struct ScreenTriangle {
+		glm::vec3 v[3];
+	};
+
+	void queueClipped(const glm::vec4* clip, uint32_t count);
+	void rasterizeBand(uint32_t rowBegin, uint32_t rowEnd);
+	void drawTriangle(const ScreenTriangle& triangle, uint32_t rowBegin, uint32_t rowEnd);
+	void bandRows(uint32_t band, uint32_t& rowBegin, uint32_t& rowEnd) const;
+	void workerLoop(uint32_t band);
+
+	glm::mat4 viewProj = glm::mat4(1.0f);
+	std::vector<ScreenTriangle> triangles;
+	std::vector<glm::vec4> clipScratch;
+	std::vector<float> depth = std::vector<float>(WIDTH * HEIGHT, 1.0f);
+	std::vector<float> tileMaxDepth = std::vector<float>((WIDTH / TILE) * (HEIGHT / TILE), 1.0f);
+
+	// Worker i fills band i + 1 whenever jobGeneration moves on
+	std::vector<std::thread> workers;
+	uint32_t bandCount = 1;
+	std::mutex mutex;
+	std::condition_variable workReady;
+	std::condition_variable workDone;
+	uint64_t jobGeneration = 0;
+	uint32_t bandsRemaining = 0;
+	bool stopping = false;
+};
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/// <summary>
+/// 32-bit generational handle: the low 20 bits index a slot in a ResourcePool,
+/// the high 12 bits hold the slot's generation when the handle was issued.
+/// A value of 0 is never issued, so a default-constructed handle is always invalid.
+/// </summary>
+template<typename T>
+struct ResourceHandle
+{
+	static constexpr uint32_t IndexBits = 20;
+	static constexpr uint32_t IndexMask = (1u << IndexBits) - 1;
+	static constexpr uint32_t GenerationMask = (1u << (32 - IndexBits)) - 1;
+
+	uint32_t value = 0;
+
+	ResourceHandle() = default;
+	ResourceHandle(uint32_t index, uint32_t generation)
+		: value((index & IndexMask) | ((generation & GenerationMask) << IndexBits)) {}
+
+	uint32_t index() const { return value & IndexMask; }
+	uint32_t generation() const { return value >> IndexBits; }
+	bool isValid() const { return value != 0; }
+	explicit operator bool() const { return isValid(); }
+
+	bool operator==(const ResourceHandle& other) const { return value == other.value; }
+	bool operator!=(const ResourceHandle& other) const { return value != other.value; }
+};
+
+/// <summary>
+/// Stores resources of one type in a dense array addressed by generational handles.
+/// Lookups are O(1) through a slot table, destroys swap-remove from the dense array so
+/// iteration stays contiguous, and a stale handle (its slot was freed or reused) is
+/// rejected: get() asserts in debug builds and returns nullptr in release.
+/// Not thread-safe; callers serialize mutation.
+/// </summary>
+template<typename T>
+class ResourcePool
+{
+public:
+	using Handle = ResourceHandle<T>;
+
+	Handle create(T&& item)
+	{
+		uint32_t slotIndex;
+		if (!m_freeSlots.empty())
+		{
+			slotIndex = m_freeSlots.back();
+			m_freeSlots.pop_back();
+		}
+		else
+		{
+			slotIndex = static_cast<uint32_t>(m_slots.size());
+			assert(slotIndex <= Handle::IndexMask && "resource pool exhausted");
+			m_slots.push_back({});
+		}
+
+		Slot& slot = m_slots[slotIndex];
+		slot.denseIndex = static_cast<uint32_t>(m_dense.size());
+		m_dense.push_back(std::move(item));
+		m_denseToSlot.push_back(slotIndex);
+		return Handle(slotIndex, slot.generation);
+	}
+
+	bool isAlive(Handle handle) const
+	{
+		if (!handle.isValid() || handle.index() >= m_slots.size())
+			return false;
+		const Slot& slot = m_slots[handle.index()];
+		return slot.denseIndex != InvalidIndex && slot.generation == handle.generation();
+	}
+
+	T* get(Handle handle)
+	{
+		if (!isAlive(handle))
+		{
+			assert(!handle.isValid() && "stale resource handle (use after free)");
+			return nullptr;
+		}
+		return &m_dense[m_slots[handle.index()].denseIndex];
+	}
+
+	const T* get(Handle handle) const
+	{
+		return const_cast<ResourcePool*>(this)->get(handle);
+	}
+
+	/// Remove the resource behind the handle and return it so the caller can release it.
+	/// The slot's generation is bumped, invalidating every copy of the handle.
+	T release(Handle handle)
+	{
+		T* current = get(handle);
+		assert(current && "release() on a dead handle");
+		Slot& slot = m_slots[handle.index()];
+		uint32_t denseIndex = slot.denseIndex;
+		T removed = std::move(*current);
+
+		uint32_t lastIndex = static_cast<uint32_t>(m_dense.size() - 1);
+		if (denseIndex != lastIndex)
+		{
+			m_dense[denseIndex] = std::move(m_dense[lastIndex]);
+			m_denseToSlot[denseIndex] = m_denseToSlot[lastIndex];
+			m_slots[m_denseToSlot[denseIndex]].denseIndex = denseIndex;
+		}
+		m_dense.pop_back();
+		m_denseToSlot.pop_back();
+
+		slot.denseIndex = InvalidIndex;
+		// Skip generation 0 so a recycled slot 0 never produces the null handle
+		slot.generation = (slot.generation + 1) & Handle::GenerationMask;
+		if (slot.generation == 0)
+			slot.generation = 1;
+		m_freeSlots.push_back(handle.index());
+		return removed;
+	}
+
+	/// Visit every live resource in dense order: fn(Handle, T&)
+	template<typename Fn>
+	void forEach(Fn&& fn)
+	{
+		for (size_t i = 0; i < m_dense.size(); i++)
+		{
+			uint32_t slotIndex = m_denseToSlot[i];
+			fn(Handle(slotIndex, m_slots[slotIndex].generation), m_dense[i]);
+		}
+	}
+
+	size_t size() const { return m_dense.size(); }
+	bool empty() const { return m_dense.empty(); }
+
+	typename std::vector<T>::iterator begin() { return m_dense.begin(); }
+	typename std::vector<T>::iterator end() { return m_dense.end(); }
+	typename std::vector<T>::const_iterator begin() const { return m_dense.begin(); }
+	typename std::vector<T>::const_iterator end() const { return m_dense.end(); }
+
+private:
+	static constexpr uint32_t InvalidIndex = 0xFFFFFFFF;
+
+	struct Slot
+	{
+		uint32_t generation = 1;
+		uint32_t denseIndex = InvalidIndex;
+	};
+
+	std::vector<Slot> m_slots;
+	std::vector<uint32_t> m_freeSlots;
+	std::vector<T> m_dense;
+	std::vector<uint32_t> m_denseToSlot;
+};
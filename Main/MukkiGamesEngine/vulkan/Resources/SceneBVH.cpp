@@ -0,0 +1,483 @@
+#include "SceneBVH.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr int SAH_BINS = 12;
+
+Aabb unite(const Aabb& a, const Aabb& b)
+{
+	Aabb result = a;
+	result.expand(b);
+	return result;
+}
+
+// Slab test; returns the entry distance or a negative value for a miss
+float intersectRay(const Aabb& box, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance)
+{
+	glm::vec3 t0 = (box.min - origin) * inverseDirection;
+	glm::vec3 t1 = (box.max - origin) * inverseDirection;
+	glm::vec3 tNear = glm::min(t0, t1);
+	glm::vec3 tFar = glm::max(t0, t1);
+	float entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+	float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+	return entry <= exit ? entry : -1.0f;
+}
+
+}
+
+Aabb Aabb::fromBounds(const Bounds& bounds, const glm::mat4& transform)
+{
+	Aabb box;
+	if (!bounds.isValid()) {
+		return box;
+	}
+	glm::vec3 center = glm::vec3(transform * glm::vec4((bounds.min + bounds.max) * 0.5f, 1.0f));
+	glm::vec3 extent = (bounds.max - bounds.min) * 0.5f;
+	glm::vec3 worldExtent = glm::abs(glm::vec3(transform[0])) * extent.x +
+		glm::abs(glm::vec3(transform[1])) * extent.y +
+		glm::abs(glm::vec3(transform[2])) * extent.z;
+	box.min = center - worldExtent;
+	box.max = center + worldExtent;
+	return box;
+}
+
+float Aabb::surfaceArea() const
+{
+	if (!isValid()) {
+		return 0.0f;
+	}
+	glm::vec3 size = max - min;
+	return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+void Aabb::expand(const Aabb& other)
+{
+	min = glm::min(min, other.min);
+	max = glm::max(max, other.max);
+}
+
+void SceneBVH::clear()
+{
+	nodes.clear();
+	freeNodes.clear();
+	root = INVALID;
+	leafCount = 0;
+	changesSinceBuild = 0;
+}
+
+uint32_t SceneBVH::allocateNode()
+{
+	if (!freeNodes.empty()) {
+		uint32_t index = freeNodes.back();
+		freeNodes.pop_back();
+		nodes[index] = Node{};
+		return index;
+	}
+	nodes.push_back(Node{});
+	return static_cast<uint32_t>(nodes.size() - 1);
+}
+
+void SceneBVH::freeNode(uint32_t index)
+{
+	nodes[index] = Node{};
+	freeNodes.push_back(index);
+}
+
+void SceneBVH::build(const std::vector<Item>& items, std::vector<uint32_t>& outProxies)
+{
+	clear();
+	outProxies.resize(items.size());
+	if (items.empty()) {
+		return;
+	}
+
+	// Leaves first, so a proxy is simply the leaf's node index
+	nodes.reserve(items.size() * 2);
+	std::vector<uint32_t> leaves(items.size());
+	for (size_t i = 0; i < items.size(); i++) {
+		uint32_t leaf = allocateNode();
+		nodes[leaf].box = items[i].box;
+		nodes[leaf].userData = items[i].userData;
+		leaves[i] = leaf;
+		outProxies[i] = leaf;
+	}
+	leafCount = static_cast<uint32_t>(items.size());
+	root = buildRange(leaves, 0, leaves.size());
+}
+
+uint32_t SceneBVH::buildRange(std::vector<uint32_t>& leaves, size_t begin, size_t end)
+{
+	if (end - begin == 1) {
+		return leaves[begin];
+	}
+
+	Aabb bounds;
+	Aabb centroidBounds;
+	for (size_t i = begin; i < end; i++) {
+		const Aabb& box = nodes[leaves[i]].box;
+		bounds.expand(box);
+		glm::vec3 c = box.center();
+		centroidBounds.expand(Aabb{ c, c });
+	}
+
+	// Binned SAH over all three axes; cost = area-weighted leaf counts of both sides
+	int bestAxis = -1;
+	int bestSplit = 0;
+	float bestCost = std::numeric_limits<float>::max();
+	glm::vec3 centroidSize = centroidBounds.max - centroidBounds.min;
+	for (int axis = 0; axis < 3; axis++) {
+		if (centroidSize[axis] <= 0.0f) continue;
+		float scale = SAH_BINS / centroidSize[axis];
+
+		Aabb binBoxes[SAH_BINS];
+		uint32_t binCounts[SAH_BINS] = {};
+		for (size_t i = begin; i < end; i++) {
+			const Aabb& box = nodes[leaves[i]].box;
+			int bin = std::min(SAH_BINS - 1, static_cast<int>((box.center()[axis] - centroidBounds.min[axis]) * scale));
+			binBoxes[bin].expand(box);
+			binCounts[bin]++;
+		}
+
+		// Sweep from the right for the right-hand areas, then from the left for the costs
+		float rightAreas[SAH_BINS] = {};
+		uint32_t rightCounts[SAH_BINS] = {};
+		Aabb rightBox;
+		uint32_t rightCount = 0;
+		for (int bin = SAH_BINS - 1; bin > 0; bin--) {
+			rightBox.expand(binBoxes[bin]);
+			rightCount += binCounts[bin];
+			rightAreas[bin] = rightBox.surfaceArea();
+			rightCounts[bin] = rightCount;
+		}
+		Aabb leftBox;
+		uint32_t leftCount = 0;
+		for (int split = 1; split < SAH_BINS; split++) {
+			leftBox.expand(binBoxes[split - 1]);
+			leftCount += binCounts[split - 1];
+			if (leftCount == 0 || rightCounts[split] == 0) continue;
+			float cost = leftBox.surfaceArea() * leftCount + rightAreas[split] * rightCounts[split];
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = split;
+			}
+		}
+	}
+
+	size_t middle = begin + (end - begin) / 2;
+	if (bestAxis >= 0) {
+		float scale = SAH_BINS / centroidSize[bestAxis];
+		float axisMin = centroidBounds.min[bestAxis];
+		auto split = std::partition(leaves.begin() + begin, leaves.begin() + end, [&](uint32_t leaf) {
+			int bin = std::min(SAH_BINS - 1, static_cast<int>((nodes[leaf].box.center()[bestAxis] - axisMin) * scale));
+			return bin < bestSplit;
+		});
+		middle = static_cast<size_t>(split - leaves.begin());
+	}
+	if (middle == begin || middle == end) {
+		// Every centroid in one spot: any even split is as good as another
+		middle = begin + (end - begin) / 2;
+	}
+
+	uint32_t left = buildRange(leaves, begin, middle);
+	uint32_t right = buildRange(leaves, middle, end);
+	uint32_t node = allocateNode();
+	nodes[node].box = bounds;
+	nodes[node].left = left;
+	nodes[node].right = right;
+	nodes[left].parent = node;
+	nodes[right].parent = node;
+	return node;
+}
+
+uint32_t SceneBVH::insert(const Aabb& box, uint64_t userData)
+{
+	uint32_t leaf = allocateNode();
+	nodes[leaf].box = box;
+	nodes[leaf].userData = userData;
+	leafCount++;
+	changesSinceBuild++;
+
+	if (root == INVALID) {
+		root = leaf;
+		return leaf;
+	}
+
+	// Walk down towards the sibling that grows the tree's surface area the least
+	uint32_t index = root;
+	while (!nodes[index].isLeaf()) {
+		const Node& node = nodes[index];
+		float area = node.box.surfaceArea();
+		float combinedArea = unite(node.box, box).surfaceArea();
+		// Pairing with this node makes a new parent of combinedArea; descending instead still
+		// grows this node by the same amount
+		float siblingCost = 2.0f * combinedArea;
+		float inheritedCost = 2.0f * (combinedArea - area);
+
+		auto descendCost = [&](uint32_t child) {
+			const Aabb& childBox = nodes[child].box;
+			float grown = unite(childBox, box).surfaceArea();
+			return nodes[child].isLeaf() ? grown + inheritedCost : grown - childBox.surfaceArea() + inheritedCost;
+		};
+		float leftCost = descendCost(node.left);
+		float rightCost = descendCost(node.right);
+		if (siblingCost < leftCost && siblingCost < rightCost) {
+			break;
+		}
+		index = leftCost < rightCost ? node.left : node.right;
+	}
+
+	uint32_t sibling = index;
+	uint32_t oldParent = nodes[sibling].parent;
+	uint32_t newParent = allocateNode();
+	nodes[newParent].parent = oldParent;
+	nodes[newParent].box = unite(nodes[sibling].box, box);
+	nodes[newParent].left = sibling;
+	nodes[newParent].right = leaf;
+	// update() marks ancestors only up to the first dirty one and refit only descends into dirty
+	// nodes, so a dirty sibling needs a dirty parent to be refit
+	nodes[newParent].dirty = nodes[sibling].dirty || (oldParent != INVALID && nodes[oldParent].dirty);
+	nodes[sibling].parent = newParent;
+	nodes[leaf].parent = newParent;
+	if (oldParent == INVALID) {
+		root = newParent;
+	}
+	else if (nodes[oldParent].left == sibling) {
+		nodes[oldParent].left = newParent;
+	}
+	else {
+		nodes[oldParent].right = newParent;
+	}
+	refitAncestors(oldParent);
+	return leaf;
+}
+
+void SceneBVH::remove(uint32_t proxy)
+{
+	leafCount--;
+	changesSinceBuild++;
+	if (proxy == root) {
+		freeNode(proxy);
+		root = INVALID;
+		return;
+	}
+
+	// The sibling takes the parent's place
+	uint32_t parent = nodes[proxy].parent;
+	uint32_t grandParent = nodes[parent].parent;
+	uint32_t sibling = nodes[parent].left == proxy ? nodes[parent].right : nodes[parent].left;
+	if (grandParent == INVALID) {
+		root = sibling;
+		nodes[sibling].parent = INVALID;
+	}
+	else {
+		if (nodes[grandParent].left == parent) {
+			nodes[grandParent].left = sibling;
+		}
+		else {
+			nodes[grandParent].right = sibling;
+		}
+		nodes[sibling].parent = grandParent;
+		refitAncestors(grandParent);
+	}
+	freeNode(parent);
+	freeNode(proxy);
+}
+
+void SceneBVH::update(uint32_t proxy, const Aabb& box)
+{
+	nodes[proxy].box = box;
+	for (uint32_t index = nodes[proxy].parent; index != INVALID && !nodes[index].dirty; index = nodes[index].parent) {
+		nodes[index].dirty = true;
+	}
+}
+
+void SceneBVH::refit()
+{
+	if (root != INVALID && nodes[root].dirty) {
+		refitNode(root);
+	}
+}
+
+void SceneBVH::refitNode(uint32_t index)
+{
+	Node& node = nodes[index];
+	if (nodes[node.left].dirty) refitNode(node.left);
+	if (nodes[node.right].dirty) refitNode(node.right);
+	node.box = unite(nodes[node.left].box, nodes[node.right].box);
+	node.dirty = false;
+}
+
+void SceneBVH::refitAncestors(uint32_t index)
+{
+	for (; index != INVALID; index = nodes[index].parent) {
+		Node& node = nodes[index];
+		node.box = unite(nodes[node.left].box, nodes[node.right].box);
+	}
+}
+
+void SceneBVH::collectLeaves(uint32_t index, std::vector<uint64_t>& outUserData) const
+{
+	std::vector<uint32_t> stack = { index };
+	while (!stack.empty()) {
+		const Node& node = nodes[stack.back()];
+		stack.pop_back();
+		if (node.isLeaf()) {
+			outUserData.push_back(node.userData);
+		}
+		else {
+			stack.push_back(node.left);
+			stack.push_back(node.right);
+		}
+	}
+}
+
+void SceneBVH::queryFrustum(const Frustum& frustum, std::vector<uint64_t>& outUserData) const
+{
+	outUserData.clear();
+	if (root == INVALID) {
+		return;
+	}
+
+	std::vector<uint32_t> stack;
+	stack.reserve(64);
+	stack.push_back(root);
+	while (!stack.empty()) {
+		uint32_t index = stack.back();
+		stack.pop_back();
+		const Node& node = nodes[index];
+
+		glm::vec3 center = node.box.center();
+		glm::vec3 extent = (node.box.max - node.box.min) * 0.5f;
+		bool outside = false;
+		bool inside = true;
+		for (const auto& plane : frustum.planes) {
+			float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+			float radius = glm::dot(glm::abs(glm::vec3(plane)), extent);
+			if (distance + radius < 0.0f) {
+				outside = true;
+				break;
+			}
+			if (distance - radius < 0.0f) {
+				inside = false;
+			}
+		}
+		if (outside) continue;
+
+		if (node.isLeaf()) {
+			outUserData.push_back(node.userData);
+		}
+		else if (inside) {
+			collectLeaves(index, outUserData);
+		}
+		else {
+			stack.push_back(node.left);
+			stack.push_back(node.right);
+		}
+	}
+}
+
+void SceneBVH::queryRadius(const glm::vec3& center, float radius, std::vector<uint64_t>& outUserData) const
+{
+	outUserData.clear();
+	if (root == INVALID) {
+		return;
+	}
+
+	float radiusSq = radius * radius;
+	std::vector<uint32_t> stack;
+	stack.reserve(64);
+	stack.push_back(root);
+	while (!stack.empty()) {
+		const Node& node = nodes[stack.back()];
+		stack.pop_back();
+
+		glm::vec3 closest = glm::min(glm::max(center, node.box.min), node.box.max);
+		glm::vec3 d = closest - center;
+		if (glm::dot(d, d) > radiusSq) continue;
+
+		if (node.isLeaf()) {
+			outUserData.push_back(node.userData);
+		}
+		else {
+			stack.push_back(node.left);
+			stack.push_back(node.right);
+		}
+	}
+}
+
+bool SceneBVH::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, const HitTest& hitTest,
+	uint64_t& outUserData, float& outDistance) const
+{
+	if (root == INVALID) {
+		return false;
+	}
+
+	// IEEE division gives +-inf for zero components, which the slab test handles
+	glm::vec3 inverseDirection = glm::vec3(1.0f) / direction;
+	float best = maxDistance;
+	bool hit = false;
+
+	std::vector<uint32_t> stack;
+	stack.reserve(64);
+	stack.push_back(root);
+	while (!stack.empty()) {
+		const Node& node = nodes[stack.back()];
+		stack.pop_back();
+		float entry = intersectRay(node.box, origin, inverseDirection, best);
+		if (entry < 0.0f) continue;
+
+		if (node.isLeaf()) {
+			float distance = hitTest ? hitTest(node.userData, best) : entry;
+			if (distance >= 0.0f && distance < best) {
+				best = distance;
+				outUserData = node.userData;
+				hit = true;
+			}
+			continue;
+		}
+
+		// Nearer child on top of the stack, so later boxes are pruned by its hit
+		float leftEntry = intersectRay(nodes[node.left].box, origin, inverseDirection, best);
+		float rightEntry = intersectRay(nodes[node.right].box, origin, inverseDirection, best);
+		bool leftFirst = leftEntry >= 0.0f && (rightEntry < 0.0f || leftEntry <= rightEntry);
+		if (leftFirst) {
+			if (rightEntry >= 0.0f) stack.push_back(node.right);
+			stack.push_back(node.left);
+		}
+		else {
+			if (leftEntry >= 0.0f) stack.push_back(node.left);
+			if (rightEntry >= 0.0f) stack.push_back(node.right);
+		}
+	}
+
+	if (hit) {
+		outDistance = best;
+	}
+	return hit;
+}
+
+float SceneBVH::getSahCost() const
+{
+	if (root == INVALID || nodes[root].isLeaf()) {
+		return 0.0f;
+	}
+	float rootArea = nodes[root].box.surfaceArea();
+	if (rootArea <= 0.0f) {
+		return 0.0f;
+	}
+	float innerArea = 0.0f;
+	std::vector<uint32_t> stack = { root };
+	while (!stack.empty()) {
+		const Node& node = nodes[stack.back()];
+		stack.pop_back();
+		if (!node.isLeaf()) {
+			innerArea += node.box.surfaceArea();
+			stack.push_back(node.left);
+			stack.push_back(node.right);
+		}
+	}
+	return innerArea / rootArea;
+}
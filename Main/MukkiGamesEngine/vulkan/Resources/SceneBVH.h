@@ -0,0 +1,88 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+#include "ObjectLoader.h"
+#include "FrustumCuller.h"
+
+struct Aabb {
+	glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+	glm::vec3 max = glm::vec3(std::numeric_limits<float>::lowest());
+
+	// Box around model-space bounds moved by transform
+	static Aabb fromBounds(const Bounds& bounds, const glm::mat4& transform);
+
+	bool isValid() const { return min.x <= max.x; }
+	glm::vec3 center() const { return (min + max) * 0.5f; }
+	float surfaceArea() const;
+	void expand(const Aabb& other);
+};
+
+// Dynamic bounding volume hierarchy over world-space boxes (one per primitive instance).
+// build() makes a binned-SAH tree for a whole scene; insert() and remove() change it one
+// leaf at a time, picking the sibling that adds the least surface area. Moving a leaf with
+// update() only marks its ancestors, and refit() then recomputes the marked boxes once, so a
+// frame that moves many objects pays for each inner node once. Incremental inserts degrade
+// the tree over time; needsRebuild() says when a fresh build() is worth it.
+class SceneBVH {
+public:
+	static constexpr uint32_t INVALID = UINT32_MAX;
+
+	struct Item {
+		Aabb box;
+		uint64_t userData = 0;
+	};
+
+	void clear();
+	// Proxies come back in item order and stay valid until removed or the next build/clear
+	void build(const std::vector<Item>& items, std::vector<uint32_t>& outProxies);
+	uint32_t insert(const Aabb& box, uint64_t userData);
+	void remove(uint32_t proxy);
+	void update(uint32_t proxy, const Aabb& box);
+	void refit();
+	bool needsRebuild() const { return leafCount > 64 && changesSinceBuild > leafCount / 2; }
+
+	// Leaves touching the frustum; subtrees entirely inside it are taken without further tests
+	void queryFrustum(const Frustum& frustum, std::vector<uint64_t>& outUserData) const;
+	// Leaves whose box comes within radius of center
+	void queryRadius(const glm::vec3& center, float radius, std::vector<uint64_t>& outUserData) const;
+	// Nearest hit along the ray. hitTest refines a leaf whose box the ray enters (against its
+	// triangles, say) and returns the hit distance, or a negative value for a miss; without it
+	// the box entry distance counts as the hit.
+	using HitTest = std::function<float(uint64_t userData, float maxDistance)>;
+	bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, const HitTest& hitTest,
+		uint64_t& outUserData, float& outDistance) const;
+
+	uint32_t getLeafCount() const { return leafCount; }
+	uint32_t getNodeCount() const { return static_cast<uint32_t>(nodes.size() - freeNodes.size()); }
+	// Sum of inner node areas over the root's; lower traverses faster
+	float getSahCost() const;
+
+private:
+	struct Node {
+		Aabb box;
+		uint64_t userData = 0;
+		uint32_t parent = INVALID;
+		// INVALID for leaves
+		uint32_t left = INVALID;
+		uint32_t right = INVALID;
+		bool dirty = false;
+
+		bool isLeaf() const { return left == INVALID; }
+	};
+
+	uint32_t allocateNode();
+	void freeNode(uint32_t index);
+	uint32_t buildRange(std::vector<uint32_t>& leaves, size_t begin, size_t end);
+	void refitNode(uint32_t index);
+	void refitAncestors(uint32_t index);
+	void collectLeaves(uint32_t index, std::vector<uint64_t>& outUserData) const;
+
+	std::vector<Node> nodes;
+	std::vector<uint32_t> freeNodes;
+	uint32_t root = INVALID;
+	uint32_t leafCount = 0;
+	uint32_t changesSinceBuild = 0;
+};
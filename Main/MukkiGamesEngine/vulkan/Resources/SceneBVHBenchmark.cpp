@@ -0,0 +1,171 @@
+#include "SceneBVHBenchmark.h"
+#include "SceneBVH.h"
+#include "FrustumCuller.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+float msSince(std::chrono::steady_clock::time_point begin)
+{
+	return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+
+struct Instance {
+	Bounds bounds;
+	glm::mat4 model = glm::mat4(1.0f);
+};
+
+nlohmann::json runScene(uint32_t instanceCount)
+{
+	constexpr int QUERY_REPEATS = 100;
+	constexpr int RAY_COUNT = 1000;
+	constexpr int RADIUS_QUERIES = 1000;
+
+	// Constant density: the cube grows with the instance count
+	std::mt19937 rng(instanceCount);
+	float side = 20.0f * std::cbrt(static_cast<float>(instanceCount));
+	std::uniform_real_distribution<float> position(-side * 0.5f, side * 0.5f);
+	std::uniform_real_distribution<float> size(0.25f, 2.0f);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	std::vector<Instance> instances(instanceCount);
+	for (auto& instance : instances) {
+		glm::vec3 halfSize(size(rng), size(rng), size(rng));
+		instance.bounds.min = -halfSize;
+		instance.bounds.max = halfSize;
+		instance.bounds.radius = glm::length(halfSize);
+		instance.model[3] = glm::vec4(position(rng), position(rng), position(rng), 1.0f);
+	}
+
+	std::vector<SceneBVH::Item> items(instanceCount);
+	for (uint32_t i = 0; i < instanceCount; i++) {
+		items[i] = { Aabb::fromBounds(instances[i].bounds, instances[i].model), i };
+	}
+
+	SceneBVH bvh;
+	std::vector<uint32_t> proxies;
+	auto begin = std::chrono::steady_clock::now();
+	bvh.build(items, proxies);
+	float buildMs = msSince(begin);
+	float sahCost = bvh.getSahCost();
+
+	// Refit after moving a tenth of the instances, then all of them
+	auto moveAndRefit = [&](uint32_t stride) {
+		auto refitBegin = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < instanceCount; i += stride) {
+			instances[i].model[3] += glm::vec4(unit(rng), unit(rng), unit(rng), 0.0f);
+			bvh.update(proxies[i], Aabb::fromBounds(instances[i].bounds, instances[i].model));
+		}
+		bvh.refit();
+		return msSince(refitBegin);
+	};
+	float refit10Ms = moveAndRefit(10);
+	float refit100Ms = moveAndRefit(1);
+
+	// A camera on one face of the cube looking across it, as in the renderer (Vulkan y flip)
+	glm::mat4 proj = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, side);
+	proj[1][1] *= -1.0f;
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, side * 0.5f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	Frustum frustum = Frustum::fromViewProjection(proj * view);
+
+	std::vector<uint64_t> results;
+	begin = std::chrono::steady_clock::now();
+	for (int i = 0; i < QUERY_REPEATS; i++) {
+		bvh.queryFrustum(frustum, results);
+	}
+	float frustumQueryMs = msSince(begin) / QUERY_REPEATS;
+	size_t bvhVisible = results.size();
+
+	// The linear path pays for moving every box into the culler each frame, as cullScene does
+	FrustumCuller culler;
+	begin = std::chrono::steady_clock::now();
+	for (int i = 0; i < QUERY_REPEATS; i++) {
+		culler.clear();
+		for (const auto& instance : instances) {
+			culler.add(instance.bounds, instance.model);
+		}
+		culler.cull(frustum);
+	}
+	float linearCullMs = msSince(begin) / QUERY_REPEATS;
+
+	uint32_t rayHits = 0;
+	begin = std::chrono::steady_clock::now();
+	for (int i = 0; i < RAY_COUNT; i++) {
+		glm::vec3 origin(position(rng), position(rng), position(rng));
+		glm::vec3 direction = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.0f, 0.0f, 1e-3f));
+		uint64_t userData = 0;
+		float distance = 0.0f;
+		rayHits += bvh.raycast(origin, direction, side, nullptr, userData, distance) ? 1 : 0;
+	}
+	float raycastUs = msSince(begin) * 1000.0f / RAY_COUNT;
+
+	size_t radiusResults = 0;
+	begin = std::chrono::steady_clock::now();
+	for (int i = 0; i < RADIUS_QUERIES; i++) {
+		bvh.queryRadius(glm::vec3(position(rng), position(rng), position(rng)), 10.0f, results);
+		radiusResults += results.size();
+	}
+	float radiusQueryUs = msSince(begin) * 1000.0f / RADIUS_QUERIES;
+
+	// Churn a hundredth of the instances out and back in
+	uint32_t churnCount = std::max(1u, instanceCount / 100);
+	begin = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < churnCount; i++) {
+		bvh.remove(proxies[i]);
+	}
+	for (uint32_t i = 0; i < churnCount; i++) {
+		proxies[i] = bvh.insert(Aabb::fromBounds(instances[i].bounds, instances[i].model), i);
+	}
+	float insertRemoveUs = msSince(begin) * 1000.0f / (2 * churnCount);
+
+	std::cout << "  " << instanceCount << " instances: build " << buildMs << " ms, refit 10% " << refit10Ms
+		<< " ms / 100% " << refit100Ms << " ms, frustum " << frustumQueryMs << " ms (linear " << linearCullMs
+		<< " ms, " << bvhVisible << " visible), ray " << raycastUs << " us, radius " << radiusQueryUs
+		<< " us, insert/remove " << insertRemoveUs << " us, SAH cost " << sahCost << std::endl;
+
+	return {
+		{ "instances", instanceCount },
+		{ "nodes", bvh.getNodeCount() },
+		{ "buildMs", buildMs },
+		{ "sahCost", sahCost },
+		{ "sahCostAfterChurn", bvh.getSahCost() },
+		{ "refit10PercentMs", refit10Ms },
+		{ "refit100PercentMs", refit100Ms },
+		{ "frustumQueryMs", frustumQueryMs },
+		{ "linearCullMs", linearCullMs },
+		{ "visible", bvhVisible },
+		{ "linearVisible", culler.getVisibleCount() },
+		{ "raycastUs", raycastUs },
+		{ "rayHits", rayHits },
+		{ "radiusQueryUs", radiusQueryUs },
+		{ "radiusResultsPerQuery", static_cast<float>(radiusResults) / RADIUS_QUERIES },
+		{ "insertRemoveUs", insertRemoveUs }
+	};
+}
+
+}
+
+bool runSceneBVHBenchmark(const std::string& outputPath)
+{
+	std::cout << "Scene BVH benchmark:" << std::endl;
+	nlohmann::json scenes = nlohmann::json::array();
+	for (uint32_t instanceCount : { 1000u, 10000u, 100000u }) {
+		scenes.push_back(runScene(instanceCount));
+	}
+
+	std::ofstream file(outputPath);
+	if (!file) {
+		std::cout << "Scene BVH benchmark: failed to open " << outputPath << std::endl;
+		return false;
+	}
+	file << nlohmann::json{ { "scenes", scenes } }.dump(2);
+	std::cout << "Scene BVH benchmark: wrote " << outputPath << std::endl;
+	return true;
+}
@@ -0,0 +1,7 @@
+#pragma once
+#include <string>
+
+// Times SceneBVH build, refit, frustum/ray/radius queries and incremental insert/remove on
+// synthetic scenes of 1k, 10k and 100k primitive instances, next to the linear FrustumCuller
+// for the same frustum. Prints a summary and writes the numbers to outputPath as JSON.
+bool runSceneBVHBenchmark(const std::string& outputPath);
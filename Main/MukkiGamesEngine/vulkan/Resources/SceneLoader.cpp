@@ -143,6 +143,10 @@ void SceneLoader::parseObjects(const nlohmann::json& j)
 				obj.physics.useMeshShape = phys.value("useMeshShape", false);
 			}
 
+			if (objJson.contains("occluder") && objJson["occluder"].is_boolean()) {
+				obj.occluder = objJson["occluder"].get<bool>() ? OccluderMode::Always : OccluderMode::Never;
+			}
+
 			objects.push_back(obj);
 		}
 	}
@@ -29,6 +29,14 @@ struct PhysicsProperties {
 	bool useMeshShape = false;
 };
 
+// Whether an object's opaque primitives occlude others in software occlusion culling; Auto picks
+// large primitives only
+enum class OccluderMode {
+	Auto,
+	Always,
+	Never
+};
+
 struct ShaderConfig {
 	std::string vertexShader = "shader.vert.spv";
 	std::string fragmentShader = "shader.frag.spv";
@@ -41,6 +49,7 @@ struct SceneObject {
 	Transform modelTransform;
 	ShaderConfig shaderConfig;
 	PhysicsProperties physics;
+	OccluderMode occluder = OccluderMode::Auto;
 	bool visible = true;
 	
 
@@ -68,6 +77,7 @@ struct LoadedObject {
 	Model model;
 	Transform transform;
 	PhysicsProperties physics;
+	OccluderMode occluder = OccluderMode::Auto;
 	uint32_t sceneObjectId = 0;
 	bool loaded = false;
 
@@ -75,6 +85,11 @@ struct LoadedObject {
 	uint32_t physicsBodyID = 0xFFFFFFFF;
 	std::unique_ptr<VehiclePhysics> vehicle;
 
+	// One SceneBVH leaf per primitive, numbered like Mesh::primitiveOffset, and the model matrix
+	// the leaves were last placed with
+	std::vector<uint32_t> bvhProxies;
+	glm::mat4 bvhTransform = glm::mat4(1.0f);
+
 	std::vector<VkBuffer> uniformBuffers;
 	std::vector<VkDeviceMemory> uniformBuffersMemory;
 	std::vector<void*> uniformBuffersMapped;
@@ -0,0 +1,83 @@
+#include "ScratchArena.h"
+#include <algorithm>
+#include <cassert>
+
+ScratchArena::ScratchArena(size_t chunkSize)
+	: m_chunkSize(chunkSize)
+{
+}
+
+void* ScratchArena::allocate(size_t size, size_t alignment)
+{
+	assert(alignment != 0 && (alignment & (alignment - 1)) == 0 && "alignment must be a power of two");
+
+	for (;;)
+	{
+		if (m_currentChunk < m_chunks.size())
+		{
+			Chunk& chunk = m_chunks[m_currentChunk];
+			uintptr_t base = reinterpret_cast<uintptr_t>(chunk.data.get());
+			uintptr_t aligned = (base + m_offset + alignment - 1) & ~(uintptr_t)(alignment - 1);
+			size_t alignedOffset = static_cast<size_t>(aligned - base);
+
+			if (alignedOffset + size <= chunk.size)
+			{
+				m_offset = alignedOffset + size;
+				m_peakBytesUsed = std::max(m_peakBytesUsed, getBytesUsed());
+				return chunk.data.get() + alignedOffset;
+			}
+
+			// Reuse a chunk left over from an earlier fill before growing
+			if (m_currentChunk + 1 < m_chunks.size())
+			{
+				m_currentChunk++;
+				m_offset = 0;
+				continue;
+			}
+		}
+
+		// Oversized requests get a dedicated chunk that later fills can reuse
+		Chunk chunk;
+		chunk.size = std::max(m_chunkSize, size + alignment);
+		chunk.data.reset(new unsigned char[chunk.size]);
+		m_chunks.push_back(std::move(chunk));
+		m_chunkAllocations++;
+		m_currentChunk = m_chunks.size() - 1;
+		m_offset = 0;
+	}
+}
+
+void ScratchArena::rewind(Marker marker)
+{
+	assert((marker.chunk < m_currentChunk || (marker.chunk == m_currentChunk && marker.offset <= m_offset)) &&
+		"rewinding forward");
+	m_currentChunk = marker.chunk;
+	m_offset = marker.offset;
+}
+
+void ScratchArena::release()
+{
+	m_chunks.clear();
+	m_currentChunk = 0;
+	m_offset = 0;
+}
+
+size_t ScratchArena::getBytesUsed() const
+{
+	size_t used = m_offset;
+	for (size_t i = 0; i < m_currentChunk && i < m_chunks.size(); i++)
+	{
+		used += m_chunks[i].size;
+	}
+	return used;
+}
+
+size_t ScratchArena::getBytesReserved() const
+{
+	size_t reserved = 0;
+	for (const Chunk& chunk : m_chunks)
+	{
+		reserved += chunk.size;
+	}
+	return reserved;
+}
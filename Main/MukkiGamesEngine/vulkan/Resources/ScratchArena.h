@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+/// <summary>
+/// Monotonic bump allocator for short-lived temporaries (glTF decode buffers, staging copies).
+/// Allocations are carved out of large chunks and never freed individually; reset() or a
+/// Scope rewinds the arena while keeping its chunks, so a warm arena loads the next scene
+/// without touching the heap. An arena belongs to one thread at a time.
+/// Memory is uninitialised and destructors never run, so only trivial types may live here.
+/// </summary>
+class ScratchArena
+{
+public:
+	static constexpr size_t DefaultChunkSize = 4 * 1024 * 1024;
+
+	struct Marker
+	{
+		size_t chunk = 0;
+		size_t offset = 0;
+	};
+
+	/// Rewinds the arena to where it was when the scope was opened.
+	class Scope
+	{
+	public:
+		explicit Scope(ScratchArena& arena) : m_arena(arena), m_marker(arena.getMarker()) {}
+		~Scope() { m_arena.rewind(m_marker); }
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		ScratchArena& m_arena;
+		Marker m_marker;
+	};
+
+	explicit ScratchArena(size_t chunkSize = DefaultChunkSize);
+	~ScratchArena() = default;
+
+	ScratchArena(const ScratchArena&) = delete;
+	ScratchArena& operator=(const ScratchArena&) = delete;
+
+	void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+	template<typename T>
+	T* allocateArray(size_t count)
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "ScratchArena never runs destructors");
+		return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	Marker getMarker() const { return { m_currentChunk, m_offset }; }
+	void rewind(Marker marker);
+
+	/// Rewind to empty, keeping every chunk for reuse.
+	void reset() { rewind({}); }
+
+	/// Give all chunks back to the heap.
+	void release();
+
+	size_t getBytesUsed() const;
+	size_t getBytesReserved() const;
+	size_t getPeakBytesUsed() const { return m_peakBytesUsed; }
+	void resetPeak() { m_peakBytesUsed = getBytesUsed(); }
+	// Number of times the arena had to go to the heap for a new chunk
+	uint64_t getChunkAllocationCount() const { return m_chunkAllocations; }
+
+private:
+	struct Chunk
+	{
+		std::unique_ptr<unsigned char[]> data;
+		size_t size = 0;
+	};
+
+	std::vector<Chunk> m_chunks;
+	size_t m_chunkSize;
+	size_t m_currentChunk = 0;
+	size_t m_offset = 0;
+	size_t m_peakBytesUsed = 0;
+	uint64_t m_chunkAllocations = 0;
+};
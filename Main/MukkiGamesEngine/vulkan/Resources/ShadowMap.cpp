@@ -1,5 +1,6 @@
 #include "ShadowMap.h"
 #include "../utils/utils.h"
+#include "../utils/GpuResourceRegistry.h"
 #include "../objects/vertex.h"
 #include <iostream>
 #include <stdexcept>
@@ -10,7 +11,7 @@ ShadowMap::~ShadowMap()
 	cleanup();
 }
 
-void ShadowMap::init(Device* device, uint32_t shadowMapSize)
+void ShadowMap::init(Device* device, uint32_t shadowMapSize, bool deferPipeline)
 {
 	this->device = device;
 	this->shadowMapSize = shadowMapSize;
@@ -22,7 +23,9 @@ void ShadowMap::init(Device* device, uint32_t shadowMapSize)
 	createShadowFramebuffer();
 	createShaderModules();
 	createPipelineLayout();
-	createPipeline();
+	if (!deferPipeline) {
+		createPipeline();
+	}
 }
 
 void ShadowMap::cleanup()
@@ -31,7 +34,7 @@ void ShadowMap::cleanup()
 	VkDevice vkDev = device->getDevice();
 
 	if (shadowPipeline != VK_NULL_HANDLE) {
-		vkDestroyPipeline(vkDev, shadowPipeline, nullptr);
+		GpuResourceRegistry::destroy(vkDev, shadowPipeline, nullptr);
 		shadowPipeline = VK_NULL_HANDLE;
 	}
 	if (shadowPipelineLayout != VK_NULL_HANDLE) {
@@ -52,19 +55,19 @@ void ShadowMap::cleanup()
 		shadowFramebuffer = VK_NULL_HANDLE;
 	}
 	if (shadowSampler != VK_NULL_HANDLE) {
-		vkDestroySampler(vkDev, shadowSampler, nullptr);
+		GpuResourceRegistry::destroy(vkDev, shadowSampler, nullptr);
 		shadowSampler = VK_NULL_HANDLE;
 	}
 	if (shadowMapImageView != VK_NULL_HANDLE) {
-		vkDestroyImageView(vkDev, shadowMapImageView, nullptr);
+		GpuResourceRegistry::destroy(vkDev, shadowMapImageView, nullptr);
 		shadowMapImageView = VK_NULL_HANDLE;
 	}
 	if (shadowMapDepthImageView != VK_NULL_HANDLE) {
-		vkDestroyImageView(vkDev, shadowMapDepthImageView, nullptr);
+		GpuResourceRegistry::destroy(vkDev, shadowMapDepthImageView, nullptr);
 		shadowMapDepthImageView = VK_NULL_HANDLE;
 	}
 	if (shadowMapDepthImage != VK_NULL_HANDLE) {
-		vkDestroyImage(vkDev, shadowMapDepthImage, nullptr);
+		GpuResourceRegistry::destroy(vkDev, shadowMapDepthImage, nullptr);
 		shadowMapDepthImage = VK_NULL_HANDLE;
 	}
 	if (shadowMapDepthMemory != VK_NULL_HANDLE) {
@@ -72,7 +75,7 @@ void ShadowMap::cleanup()
 		shadowMapDepthMemory = VK_NULL_HANDLE;
 	}
 	if (shadowMapImage != VK_NULL_HANDLE) {
-		vkDestroyImage(vkDev, shadowMapImage, nullptr);
+		GpuResourceRegistry::destroy(vkDev, shadowMapImage, nullptr);
 		shadowMapImage = VK_NULL_HANDLE;
 	}
 	if (shadowMapImageMemory != VK_NULL_HANDLE) {
@@ -146,6 +149,7 @@ void ShadowMap::createShadowImage()
 	}
 
 	vkBindImageMemory(vkDev, shadowMapImage, shadowMapImageMemory, 0);
+	MK_TRACK_GPU_RESOURCE(shadowMapImage, memRequirements.size, "shadowMap.color");
 
 	// Create color image view for the shadow map
 	VkImageViewCreateInfo viewInfo{};
@@ -162,6 +166,7 @@ void ShadowMap::createShadowImage()
 	if (vkCreateImageView(vkDev, &viewInfo, nullptr, &shadowMapImageView) != VK_SUCCESS) {
 		throw std::runtime_error("failed to create shadow map image view!");
 	}
+	MK_TRACK_GPU_RESOURCE(shadowMapImageView, 0, "shadowMap.color");
 
 	std::cout << "Created shadow map: " << shadowMapSize << "x" << shadowMapSize << std::endl;
 }
@@ -206,6 +211,7 @@ void ShadowMap::createDepthImage()
 	}
 
 	vkBindImageMemory(vkDev, shadowMapDepthImage, shadowMapDepthMemory, 0);
+	MK_TRACK_GPU_RESOURCE(shadowMapDepthImage, memRequirements.size, "shadowMap.depth");
 
 	VkImageViewCreateInfo viewInfo{};
 	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -221,6 +227,7 @@ void ShadowMap::createDepthImage()
 	if (vkCreateImageView(vkDev, &viewInfo, nullptr, &shadowMapDepthImageView) != VK_SUCCESS) {
 		throw std::runtime_error("failed to create shadow map depth image view!");
 	}
+	MK_TRACK_GPU_RESOURCE(shadowMapDepthImageView, 0, "shadowMap.depth");
 }
 
 void ShadowMap::createShadowRenderPass()
@@ -264,7 +271,8 @@ void ShadowMap::createShadowRenderPass()
 	subpass.pColorAttachments = &colorAttachmentRef;
 	subpass.pDepthStencilAttachment = &depthAttachmentRef;
 
-	VkSubpassDependency dependency{};
+	std::array<VkSubpassDependency, 2> dependencies{};
+	VkSubpassDependency& dependency = dependencies[0];
 	dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
 	dependency.dstSubpass = 0;
 	dependency.srcStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
@@ -273,14 +281,24 @@ void ShadowMap::createShadowRenderPass()
 	dependency.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
 	dependency.dependencyFlags = 0;
 
+	// The main pass samples the shadow map later in the same command buffer
+	VkSubpassDependency& sampleDependency = dependencies[1];
+	sampleDependency.srcSubpass = 0;
+	sampleDependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+	sampleDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	sampleDependency.dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	sampleDependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	sampleDependency.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	sampleDependency.dependencyFlags = 0;
+
 	VkRenderPassCreateInfo renderPassInfo{};
 	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
 	renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
 	renderPassInfo.pAttachments = attachments.data();
 	renderPassInfo.subpassCount = 1;
 	renderPassInfo.pSubpasses = &subpass;
-	renderPassInfo.dependencyCount = 1;
-	renderPassInfo.pDependencies = &dependency;
+	renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+	renderPassInfo.pDependencies = dependencies.data();
 
 	if (vkCreateRenderPass(device->getDevice(), &renderPassInfo, nullptr, &shadowRenderPass) != VK_SUCCESS) {
 		throw std::runtime_error("failed to create shadow render pass!");
@@ -310,6 +328,7 @@ void ShadowMap::createShadowSampler()
 	if (vkCreateSampler(device->getDevice(), &samplerInfo, nullptr, &shadowSampler) != VK_SUCCESS) {
 		throw std::runtime_error("failed to create shadow sampler!");
 	}
+	MK_TRACK_GPU_RESOURCE(shadowSampler, 0, "shadowMap.sampler");
 }
 
 void ShadowMap::createShadowFramebuffer()
@@ -500,7 +519,8 @@ void ShadowMap::createPipeline()
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 	pipelineInfo.basePipelineIndex = -1;
 
-	if (vkCreateGraphicsPipelines(device->getDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &shadowPipeline) != VK_SUCCESS) {
+	if (vkCreateGraphicsPipelines(device->getDevice(), device->getPipelineCacheHandle(), 1, &pipelineInfo, nullptr, &shadowPipeline) != VK_SUCCESS) {
 		throw std::runtime_error("failed to create shadow pipeline!");
 	}
+	MK_TRACK_GPU_RESOURCE(shadowPipeline, 0, "shadowMap.pipeline");
 }
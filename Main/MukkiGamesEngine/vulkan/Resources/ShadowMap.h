@@ -10,7 +10,10 @@ public:
 	ShadowMap() = default;
 	~ShadowMap();
 
-	void init(Device* device, uint32_t shadowMapSize = 2048);
+	// With deferPipeline the pipeline is left to a later createPipeline call, which may run on
+	// another thread
+	void init(Device* device, uint32_t shadowMapSize = 2048, bool deferPipeline = false);
+	void createPipeline();
 	void cleanup();
 
 	VkImageView getShadowMapImageView() const { return shadowMapImageView; }
@@ -55,5 +58,4 @@ private:
 	void createShadowFramebuffer();
 	void createShaderModules();
 	void createPipelineLayout();
-	void createPipeline();
 };
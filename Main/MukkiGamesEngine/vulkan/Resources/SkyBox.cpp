@@ -1,4 +1,5 @@
 #include "SkyBox.h"
+#include "../utils/GpuResourceRegistry.h"
 #include <cstring>
 #include <array>
 #include <stdexcept>
@@ -11,7 +12,7 @@ SkyBox::~SkyBox() { cleanup(); }
 
 void SkyBox::init(Device* device, TextureManager* textureManager, BufferManager* bufferManager,
 	VkRenderPass renderPass, const std::string& cubemapPath,
-	CubemapLayout layout, uint32_t maxFramesInFlight)
+	CubemapLayout layout, uint32_t maxFramesInFlight, bool deferPipeline)
 {
 	this->device = device;
 	this->textureManager = textureManager;
@@ -28,7 +29,9 @@ void SkyBox::init(Device* device, TextureManager* textureManager, BufferManager*
 	createDescriptorPool();
 	createDescriptorSets();
 	createPipelineLayout();
-	createPipeline(renderPass);
+	if (!deferPipeline) {
+		createPipeline(renderPass);
+	}
 }
 
 void SkyBox::createUniformBuffers()
@@ -133,6 +136,7 @@ void SkyBox::createDescriptorPool()
 	if (vkCreateDescriptorPool(device->getDevice(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
 		throw std::runtime_error("failed to create skybox descriptor pool!");
 	}
+	MK_TRACK_GPU_RESOURCE(descriptorPool, 0, "skybox.descriptorPool");
 }
 
 void SkyBox::createDescriptorSets()
@@ -210,7 +214,7 @@ void SkyBox::cleanup()
 	if (device == nullptr) return;
 
 	for (size_t i = 0; i < maxFramesInFlight; i++) {
-		vkDestroyBuffer(device->getDevice(), uniformBuffers[i], nullptr);
+		GpuResourceRegistry::destroy(device->getDevice(), uniformBuffers[i], nullptr);
 		vkFreeMemory(device->getDevice(), uniformBuffersMemory[i], nullptr);
 	}
 
@@ -220,7 +224,7 @@ void SkyBox::cleanup()
 	textureManager->destroyImageView(cubemapImageView);
 	textureManager->destroyImage(cubemapImage, cubemapImageMemory);
 
-	vkDestroyDescriptorPool(device->getDevice(), descriptorPool, nullptr);
+	GpuResourceRegistry::destroy(device->getDevice(), descriptorPool, nullptr);
 	vkDestroyDescriptorSetLayout(device->getDevice(), descriptorSetLayout, nullptr);
 	vkDestroyPipelineLayout(device->getDevice(), pipelineLayout, nullptr);
 
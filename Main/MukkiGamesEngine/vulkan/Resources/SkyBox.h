@@ -20,9 +20,12 @@ public:
 	SkyBox();
 	~SkyBox();
 
+	// With deferPipeline the pipeline is left to a later createPipeline call, which may run on
+	// another thread
 	void init(Device* device, TextureManager* textureManager, BufferManager* bufferManager,
 		VkRenderPass renderPass, const std::string& cubemapPath,
-		CubemapLayout layout, uint32_t maxFramesInFlight);
+		CubemapLayout layout, uint32_t maxFramesInFlight, bool deferPipeline = false);
+	void createPipeline(VkRenderPass renderPass);
 
 	void updateUniformBuffer(uint32_t currentFrame, const glm::mat4& view);
 	void s_recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t currentFrame);
@@ -36,7 +39,6 @@ private:
 	void createDescriptorSets();
 
 	void createPipelineLayout();
-	void createPipeline(VkRenderPass renderPass);
 
 	Device* device = nullptr;
 	TextureManager* textureManager = nullptr;
@@ -3,6 +3,7 @@
 #include "BufferManager.h"
 #include "../objects/bitmap.h"
 #include "../utils/ect_cubemap.h"
+#include "../utils/GpuResourceRegistry.h"
 #include <stdexcept>
 
 TextureManager::~TextureManager()
@@ -22,7 +23,8 @@ void TextureManager::cleanup()
 }
 void TextureManager::createImage(uint32_t width, uint32_t height, VkFormat format,
 	VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties,
-	VkImage& image, VkDeviceMemory& imageMemory, bool isCubemap)
+	VkImage& image, VkDeviceMemory& imageMemory, bool isCubemap,
+	const char* debugName, const char* file, int line)
 {
 	VkImageCreateInfo imageInfo{};
 	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -57,9 +59,11 @@ void TextureManager::createImage(uint32_t width, uint32_t height, VkFormat forma
 	}
 
 	vkBindImageMemory(device->getDevice(), image, imageMemory, 0);
+	GpuResourceRegistry::get().track(image, memRequirements.size, debugName, file, line);
 
 }
-VkImageView TextureManager::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, bool isCubemap)
+VkImageView TextureManager::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, bool isCubemap,
+	const char* debugName, const char* file, int line)
 {
 	VkImageViewCreateInfo viewInfo{};
 	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -75,6 +79,7 @@ VkImageView TextureManager::createImageView(VkImage image, VkFormat format, VkIm
 	if (vkCreateImageView(device->getDevice(), &viewInfo, nullptr, &imageView) != VK_SUCCESS) {
 		throw std::runtime_error("failed to create image view!");
 	}
+	GpuResourceRegistry::get().track(imageView, 0, debugName, file, line);
 	return imageView;
 }
 
@@ -199,11 +204,12 @@ void TextureManager::createTextureImage(const std::string& filePath, VkImage& te
 	copyBufferToImage(stagingBuffer, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
 	transitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
-	vkDestroyBuffer(device->getDevice(), stagingBuffer, nullptr);
+	GpuResourceRegistry::destroy(device->getDevice(), stagingBuffer, nullptr);
 	vkFreeMemory(device->getDevice(), stagingBufferMemory, nullptr);
 }
 
-void TextureManager::createTextureSampler(VkSampler& sampler, bool isCubemap)
+void TextureManager::createTextureSampler(VkSampler& sampler, bool isCubemap,
+	const char* debugName, const char* file, int line)
 {
 	VkPhysicalDeviceProperties properties{};
 	vkGetPhysicalDeviceProperties(device->getPhysicalDevice(), &properties);
@@ -229,6 +235,7 @@ void TextureManager::createTextureSampler(VkSampler& sampler, bool isCubemap)
 	if (vkCreateSampler(device->getDevice(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
 		throw std::runtime_error("failed to create texture sampler!");
 	}
+	GpuResourceRegistry::get().track(sampler, 0, debugName, file, line);
 }
 
 void TextureManager::createDebugTextureImage(VkImage& textureImage, VkDeviceMemory& textureImageMemory, VkImageView& imageView)
@@ -267,7 +274,7 @@ void TextureManager::createdepthResources(VkImage& depthImage, VkDeviceMemory& d
 {
 	VkFormat depthFormat = findDepthFormat();
 	createImage(width,height,depthFormat, VK_IMAGE_TILING_OPTIMAL,
-		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 		depthImage, depthImageMemory);
 	depthImageView = createImageView(depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
 	transitionImageLayout(depthImage, depthFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
@@ -298,7 +305,7 @@ VkFormat TextureManager::findSupportedFormat(const std::vector<VkFormat>& candid
 void TextureManager::destroyImage(VkImage image, VkDeviceMemory imageMemory)
 {
 	if(image != VK_NULL_HANDLE) {
-		vkDestroyImage(device->getDevice(), image, nullptr);
+		GpuResourceRegistry::destroy(device->getDevice(), image, nullptr);
 	}
 	if(imageMemory != VK_NULL_HANDLE) {
 		vkFreeMemory(device->getDevice(), imageMemory, nullptr);
@@ -307,11 +314,14 @@ void TextureManager::destroyImage(VkImage image, VkDeviceMemory imageMemory)
 }
 void TextureManager::destroySampler(VkSampler sampler)
 {
+	if (sampler != VK_NULL_HANDLE) {
+		GpuResourceRegistry::destroy(device->getDevice(), sampler, nullptr);
+	}
 }
 void TextureManager::destroyImageView(VkImageView imageView)
 {
 	if (imageView != VK_NULL_HANDLE) {
-		vkDestroyImageView(device->getDevice(), imageView, nullptr);
+		GpuResourceRegistry::destroy(device->getDevice(), imageView, nullptr);
 		imageView = VK_NULL_HANDLE;
 	}
 }
@@ -482,6 +492,6 @@ void TextureManager::createCubemapImage(const std::string& filePath,
     transitionImageLayout(cubemapImage, VK_FORMAT_R8G8B8A8_SRGB,
         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, true);
 
-    vkDestroyBuffer(device->getDevice(), stagingBuffer, nullptr);
+    GpuResourceRegistry::destroy(device->getDevice(), stagingBuffer, nullptr);
     vkFreeMemory(device->getDevice(), stagingBufferMemory, nullptr);
 }
@@ -1,6 +1,7 @@
 #pragma once
 #include "vulkan/vulkan.h"
 #include "../Core/VkDevice.h"
+#include "../utils/GpuResourceRegistry.h"
 #include <stb_image.h>
 #include <string>
 #include <array>
@@ -23,15 +24,18 @@ public:
 	void cleanup();
 	void createImage(uint32_t width, uint32_t height, VkFormat format,
 		VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties,
-		VkImage& image, VkDeviceMemory& imageMemory, bool isCubemap = false);
-	VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, bool isCubemap = false);
+		VkImage& image, VkDeviceMemory& imageMemory, bool isCubemap = false,
+		const char* debugName = nullptr, const char* file = MK_CALLER_FILE, int line = MK_CALLER_LINE);
+	VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, bool isCubemap = false,
+		const char* debugName = nullptr, const char* file = MK_CALLER_FILE, int line = MK_CALLER_LINE);
 	void transitionImageLayout(VkImage image, VkFormat format,
 		VkImageLayout oldLayout, VkImageLayout newLayout, bool isCubemap = false);
 	void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, bool isCubemap = false);
 	void createTextureImage(const std::string& filePath, VkImage& textureImage, VkDeviceMemory& textureImageMemory);
 	void createCubemapImage(const std::string& filePath, VkImage& cubemapImage, VkDeviceMemory& cubemapImageMemory,
 		CubemapLayout layout = CubemapLayout::HorizontalCross);
-	void createTextureSampler(VkSampler& sampler, bool isCubemap = false);
+	void createTextureSampler(VkSampler& sampler, bool isCubemap = false,
+		const char* debugName = nullptr, const char* file = MK_CALLER_FILE, int line = MK_CALLER_LINE);
 	void createDebugTextureImage(VkImage& textureImage, VkDeviceMemory& textureImageMemory, VkImageView& imageView);
 	void createdepthResources(VkImage& depthImage, VkDeviceMemory& depthImageMemory, VkImageView& depthImageView, uint32_t width, uint32_t height);
 	void destroyImage(VkImage image, VkDeviceMemory imageMemory);
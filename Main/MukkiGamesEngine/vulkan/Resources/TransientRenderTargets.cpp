@@ -0,0 +1,385 @@
+#include "TransientRenderTargets.h"
+#include "../Core/VkDevice.h"
+#include "../utils/GpuResourceRegistry.h"
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+}
+
+TransientRenderTargets::~TransientRenderTargets()
+{
+	cleanup();
+}
+
+void TransientRenderTargets::init(Device* device, FrameDeletionQueue* retireQueue)
+{
+	this->device = device;
+	this->retireQueue = retireQueue;
+}
+
+void TransientRenderTargets::cleanup()
+{
+	if (!device) {
+		return;
+	}
+	VkDevice vkDev = device->getDevice();
+	for (auto& target : targets) {
+		if (target.view != VK_NULL_HANDLE) {
+			GpuResourceRegistry::destroy(vkDev, target.view, nullptr);
+		}
+		if (target.image != VK_NULL_HANDLE) {
+			GpuResourceRegistry::destroy(vkDev, target.image, nullptr);
+		}
+		target.view = VK_NULL_HANDLE;
+		target.image = VK_NULL_HANDLE;
+	}
+	if (backing != VK_NULL_HANDLE) {
+		GpuResourceRegistry::freeMemory(vkDev, backing, nullptr);
+		backing = VK_NULL_HANDLE;
+	}
+	activePhase = 0;
+	device = nullptr;
+}
+
+TransientRenderTargets::TargetId TransientRenderTargets::declare(const TransientImageDesc& desc)
+{
+	Target target;
+	target.desc = desc;
+	targets.push_back(target);
+	return static_cast<TargetId>(targets.size() - 1);
+}
+
+void TransientRenderTargets::setExtent(VkExtent2D newExtent)
+{
+	if (newExtent.width == extent.width && newExtent.height == extent.height) {
+		return;
+	}
+	releaseBacking();
+	extent = newExtent;
+	activePhase = 0;
+	for (auto& target : targets) {
+		target.size = 0;
+	}
+}
+
+bool TransientRenderTargets::needsActivation(RenderPhaseMask phase) const
+{
+	if (phase != activePhase) {
+		return true;
+	}
+	for (const auto& target : targets) {
+		if ((target.desc.lifetime & phase) && target.image == VK_NULL_HANDLE) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool TransientRenderTargets::activate(RenderPhaseMask phase)
+{
+	activePhase = phase;
+
+	// Targets leaving the phase give their range back; the images are only destroyed once the
+	// frames using them are done, and until then nothing new is written before an acquire
+	// barrier that waits for them
+	bool changed = false;
+	std::vector<size_t> added;
+	std::vector<size_t> live;
+	for (size_t i = 0; i < targets.size(); i++) {
+		Target& target = targets[i];
+		if ((target.desc.lifetime & phase) == 0) {
+			if (target.image != VK_NULL_HANDLE) {
+				retireImage(target);
+				changed = true;
+			}
+			continue;
+		}
+		live.push_back(i);
+		if (target.image == VK_NULL_HANDLE) {
+			added.push_back(i);
+		}
+	}
+
+	if (live.empty()) {
+		releaseMemory();
+		return changed;
+	}
+	if (added.empty()) {
+		return changed;
+	}
+
+	uint32_t memoryTypeBits = ~0u;
+	for (size_t index : added) {
+		createImage(targets[index]);
+	}
+	for (size_t index : live) {
+		memoryTypeBits &= targets[index].memoryTypeBits;
+	}
+
+	// The new targets alias whatever the previous phase left in the free ranges
+	bool fits = backing != VK_NULL_HANDLE && (memoryTypeBits & (1u << backingMemoryType)) != 0 &&
+		placeTargets(added, backingSize);
+	if (fits) {
+		std::cout << "Transient render targets: " << added.size() << " placed in the resident "
+			<< backingSize / (1024 * 1024) << " MB" << std::endl;
+	}
+	else {
+		// Bound images can't move, so every live target starts over in a new allocation
+		for (size_t index : live) {
+			if (targets[index].bound) {
+				retireImage(targets[index]);
+				createImage(targets[index]);
+			}
+		}
+		releaseMemory();
+		added = live;
+		placeTargets(added, ~VkDeviceSize(0));
+
+		backingSize = 0;
+		for (size_t index : added) {
+			backingSize = std::max(backingSize, targets[index].offset + targets[index].size);
+		}
+		backingMemoryType = device->findMemoryType(memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = backingSize;
+		allocInfo.memoryTypeIndex = backingMemoryType;
+
+		if (vkAllocateMemory(device->getDevice(), &allocInfo, nullptr, &backing) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate transient render target memory!");
+		}
+		// The targets alias this allocation, so it carries the bytes and the images report 0
+		MK_TRACK_GPU_RESOURCE(backing, backingSize, "transientRenderTargets.backing");
+		std::cout << "Transient render targets: " << backingSize / (1024 * 1024) << " MB resident ("
+			<< getUnaliasedBytes() / (1024 * 1024) << " MB without aliasing) at "
+			<< extent.width << "x" << extent.height << std::endl;
+	}
+
+	VkDevice vkDev = device->getDevice();
+	for (size_t index : added) {
+		Target& target = targets[index];
+		vkBindImageMemory(vkDev, target.image, backing, target.offset);
+		MK_TRACK_GPU_RESOURCE(target.image, 0, target.desc.name);
+
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = target.image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = target.desc.format;
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		if (vkCreateImageView(vkDev, &viewInfo, nullptr, &target.view) != VK_SUCCESS) {
+			throw std::runtime_error(std::string("failed to create transient image view ") + target.desc.name + "!");
+		}
+		MK_TRACK_GPU_RESOURCE(target.view, 0, target.desc.name);
+		target.bound = true;
+		target.acquirePending = true;
+	}
+	return true;
+}
+
+void TransientRenderTargets::recordAcquires(VkCommandBuffer cmd)
+{
+	for (auto& target : targets) {
+		if (target.acquirePending) {
+			recordAcquire(target, cmd);
+			target.acquirePending = false;
+		}
+	}
+}
+
+bool TransientRenderTargets::canTrim() const
+{
+	VkDeviceSize liveBytes = getLiveBytes();
+	return backing != VK_NULL_HANDLE && liveBytes > 0 && backingSize >= 2 * liveBytes;
+}
+
+void TransientRenderTargets::trim()
+{
+	releaseBacking();
+	activePhase = 0;
+}
+
+VkDeviceSize TransientRenderTargets::getUnaliasedBytes() const
+{
+	VkDeviceSize total = 0;
+	for (const auto& target : targets) {
+		total += target.size;
+	}
+	return total;
+}
+
+VkDeviceSize TransientRenderTargets::getLiveBytes() const
+{
+	VkDeviceSize total = 0;
+	for (const auto& target : targets) {
+		if (target.image != VK_NULL_HANDLE) {
+			total += target.size;
+		}
+	}
+	return total;
+}
+
+void TransientRenderTargets::createImage(Target& target)
+{
+	VkImageCreateInfo imageInfo{};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.extent.width = extent.width;
+	imageInfo.extent.height = extent.height;
+	imageInfo.extent.depth = 1;
+	imageInfo.mipLevels = 1;
+	imageInfo.arrayLayers = 1;
+	imageInfo.format = target.desc.format;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageInfo.usage = target.desc.usage;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	VkDevice vkDev = device->getDevice();
+	if (vkCreateImage(vkDev, &imageInfo, nullptr, &target.image) != VK_SUCCESS) {
+		throw std::runtime_error(std::string("failed to create transient image ") + target.desc.name + "!");
+	}
+
+	VkMemoryRequirements memRequirements;
+	vkGetImageMemoryRequirements(vkDev, target.image, &memRequirements);
+	target.size = memRequirements.size;
+	target.alignment = memRequirements.alignment;
+	target.memoryTypeBits = memRequirements.memoryTypeBits;
+	target.bound = false;
+}
+
+void TransientRenderTargets::retireImage(Target& target)
+{
+	retireQueue->retireImage(device->getDevice(), target.image, VK_NULL_HANDLE, target.view);
+	target.image = VK_NULL_HANDLE;
+	target.view = VK_NULL_HANDLE;
+	target.bound = false;
+	target.acquirePending = false;
+}
+
+bool TransientRenderTargets::placeTargets(const std::vector<size_t>& indices, VkDeviceSize limit)
+{
+	// Largest first, each at the lowest offset clear of the targets already bound or placed
+	std::vector<size_t> order = indices;
+	std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+		return targets[a].size > targets[b].size;
+	});
+
+	std::vector<std::pair<VkDeviceSize, VkDeviceSize>> busy;
+	for (const auto& target : targets) {
+		if (target.bound) {
+			busy.emplace_back(target.offset, target.offset + target.size);
+		}
+	}
+
+	for (size_t index : order) {
+		Target& target = targets[index];
+		std::sort(busy.begin(), busy.end());
+
+		VkDeviceSize candidate = 0;
+		for (const auto& range : busy) {
+			candidate = alignUp(candidate, target.alignment);
+			if (candidate + target.size <= range.first) {
+				break;
+			}
+			candidate = std::max(candidate, range.second);
+		}
+		target.offset = alignUp(candidate, target.alignment);
+		if (target.offset + target.size > limit) {
+			return false;
+		}
+		busy.emplace_back(target.offset, target.offset + target.size);
+	}
+	return true;
+}
+
+void TransientRenderTargets::releaseBacking()
+{
+	for (auto& target : targets) {
+		if (target.image != VK_NULL_HANDLE) {
+			retireImage(target);
+		}
+	}
+	releaseMemory();
+}
+
+void TransientRenderTargets::releaseMemory()
+{
+	if (backing == VK_NULL_HANDLE) {
+		return;
+	}
+	// Retired after the images, so they are destroyed before their memory is freed
+	VkDevice vkDev = device->getDevice();
+	VkDeviceMemory memory = backing;
+	retireQueue->retire([vkDev, memory]() {
+		GpuResourceRegistry::freeMemory(vkDev, memory, nullptr);
+	});
+	backing = VK_NULL_HANDLE;
+	backingSize = 0;
+}
+
+void TransientRenderTargets::recordAcquire(const Target& target, VkCommandBuffer cmd)
+{
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = target.desc.clearOnAcquire ? VK_IMAGE_LAYOUT_GENERAL : target.desc.layout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = target.image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+	// Wait for every earlier write to the range, including through aliasing images
+	barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+	barrier.dstAccessMask = target.desc.clearOnAcquire ? VK_ACCESS_TRANSFER_WRITE_BIT : target.desc.firstAccess;
+
+	vkCmdPipelineBarrier(
+		cmd,
+		VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+		target.desc.clearOnAcquire ? VK_PIPELINE_STAGE_TRANSFER_BIT : target.desc.firstStage,
+		0,
+		0, nullptr,
+		0, nullptr,
+		1, &barrier
+	);
+
+	if (!target.desc.clearOnAcquire) {
+		return;
+	}
+
+	VkClearColorValue clearValue = { 0.0f, 0.0f, 0.0f, 0.0f };
+	vkCmdClearColorImage(cmd, target.image, VK_IMAGE_LAYOUT_GENERAL, &clearValue, 1, &barrier.subresourceRange);
+
+	barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+	barrier.newLayout = target.desc.layout;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = target.desc.firstAccess;
+
+	vkCmdPipelineBarrier(
+		cmd,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		target.desc.firstStage,
+		0,
+		0, nullptr,
+		0, nullptr,
+		1, &barrier
+	);
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <vector>
+#include "DeletionQueue.h"
+
+class Device;
+
+// One bit per render phase (the application maps its render modes onto these)
+using RenderPhaseMask = uint32_t;
+
+// Swapchain-sized image that only has to exist while certain render phases are active
+struct TransientImageDesc {
+	const char* name = "";
+	VkFormat format = VK_FORMAT_UNDEFINED;
+	VkImageUsageFlags usage = 0;
+	// Phases during which the image is live; targets with disjoint lifetimes share memory
+	RenderPhaseMask lifetime = 0;
+	// Layout and first access once the image becomes live (its contents are undefined then)
+	VkImageLayout layout = VK_IMAGE_LAYOUT_GENERAL;
+	VkPipelineStageFlags firstStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+	VkAccessFlags firstAccess = 0;
+	// Zero the image when it becomes live (accumulation targets)
+	bool clearOnAcquire = false;
+};
+
+// Render targets declared up front with phase lifetimes. Only the targets live in the active
+// phase have images and memory. On a phase change the targets that leave give their range of
+// the allocation back, and the phase's new targets are placed into the free ranges when they
+// fit, so phases with disjoint targets alias each other; when they don't fit, every live target
+// moves to a new allocation sized for the phase. Becoming live always starts from
+// VK_IMAGE_LAYOUT_UNDEFINED behind a full memory barrier, since the range may have been
+// written through an aliasing image.
+class TransientRenderTargets {
+public:
+	using TargetId = uint32_t;
+
+	TransientRenderTargets() = default;
+	~TransientRenderTargets();
+
+	TransientRenderTargets(const TransientRenderTargets&) = delete;
+	TransientRenderTargets& operator=(const TransientRenderTargets&) = delete;
+
+	void init(Device* device, FrameDeletionQueue* retireQueue);
+	// Destroys resident images immediately; the device must be idle
+	void cleanup();
+
+	TargetId declare(const TransientImageDesc& desc);
+
+	// Retires the backing memory; the next activate() recreates it at the new size
+	void setExtent(VkExtent2D extent);
+	VkExtent2D getExtent() const { return extent; }
+
+	// True if activate(phase) would have anything to do
+	bool needsActivation(RenderPhaseMask phase) const;
+	// Makes the phase's targets resident and retires the images of targets that left it; the
+	// acquire barriers and clears wait for recordAcquires(). Returns true when image handles
+	// changed and descriptors referencing them must be rewritten.
+	bool activate(RenderPhaseMask phase);
+	// Records the acquire barriers/clears of the targets made live since the last call
+	void recordAcquires(VkCommandBuffer cmd);
+
+	// True when the allocation is at least twice what the active phase's targets need, as after
+	// moving from a larger phase into a smaller one
+	bool canTrim() const;
+	// Retires everything; the next activate() allocates exactly what the phase needs
+	void trim();
+
+	VkImage getImage(TargetId id) const { return targets[id].image; }
+	VkImageView getImageView(TargetId id) const { return targets[id].view; }
+	// Live in the active phase; false means the image handles are null or hold undefined data
+	bool isLive(TargetId id) const { return targets[id].image != VK_NULL_HANDLE; }
+
+	// Bytes currently allocated for render targets (0 while no phase needs them)
+	VkDeviceSize getResidentBytes() const { return backing != VK_NULL_HANDLE ? backingSize : 0; }
+	// What one dedicated allocation per target would cost at the current extent, counting the
+	// targets created since the extent was set
+	VkDeviceSize getUnaliasedBytes() const;
+	size_t getTargetCount() const { return targets.size(); }
+
+private:
+	struct Target {
+		TransientImageDesc desc;
+		VkImage image = VK_NULL_HANDLE;
+		VkImageView view = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		VkDeviceSize alignment = 0;
+		uint32_t memoryTypeBits = 0;
+		// Bound to the backing at offset
+		bool bound = false;
+		bool acquirePending = false;
+	};
+
+	void createImage(Target& target);
+	void retireImage(Target& target);
+	// Places the targets at the lowest offsets clear of every other bound target; false when one
+	// would end past limit
+	bool placeTargets(const std::vector<size_t>& indices, VkDeviceSize limit);
+	VkDeviceSize getLiveBytes() const;
+	// Retires every image, then the memory
+	void releaseBacking();
+	void releaseMemory();
+	void recordAcquire(const Target& target, VkCommandBuffer cmd);
+
+	Device* device = nullptr;
+	FrameDeletionQueue* retireQueue = nullptr;
+	std::vector<Target> targets;
+	VkExtent2D extent{};
+	VkDeviceMemory backing = VK_NULL_HANDLE;
+	VkDeviceSize backingSize = 0;
+	uint32_t backingMemoryType = 0;
+	RenderPhaseMask activePhase = 0;
+};
@@ -6,6 +6,7 @@
 #include "objects/vertex.h"
 #include "pipeline/computePipeline.h"
 #include "utils/utils.h"
+#include "utils/GpuResourceRegistry.h"
 
 VulkanPipeline::VulkanPipeline(Device* device, const std::string& vertShaderPath, const std::string& fragShaderPath, const PipelineConfigInfo& configInfo)
 	: device(device)
@@ -17,7 +18,7 @@ VulkanPipeline::~VulkanPipeline()
 {
 	vkDestroyShaderModule(device->getDevice(), vertShaderModule, nullptr);
 	vkDestroyShaderModule(device->getDevice(), fragShaderModule, nullptr);
-	vkDestroyPipeline(device->getDevice(), graphicsPipeline, nullptr);
+	GpuResourceRegistry::destroy(device->getDevice(), graphicsPipeline, nullptr);
 }
 
 void VulkanPipeline::bind(VkCommandBuffer commandBuffer)
@@ -196,9 +197,10 @@ void VulkanPipeline::createGraphicsPipeline(const std::string& vertShaderPath, c
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 	pipelineInfo.basePipelineIndex = -1;
 
-	if (vkCreateGraphicsPipelines(device->getDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
+	if (vkCreateGraphicsPipelines(device->getDevice(), device->getPipelineCacheHandle(), 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
 		throw std::runtime_error("failed to create graphics pipeline!");
 	}
+	MK_TRACK_GPU_RESOURCE(graphicsPipeline, 0, "graphics.pipeline");
 }
 
 VkShaderModule VulkanPipeline::createShaderModule(const std::vector<char>& code) {
@@ -1,5 +1,6 @@
 #include "computePipeline.h"
 #include "../utils/utils.h"
+#include "../utils/GpuResourceRegistry.h"
 #include <stdexcept>
 #include <fstream>
 
@@ -51,9 +52,10 @@ void ComputePipeline::createComputePipeline(Device* device, const std::string& c
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 	pipelineInfo.basePipelineIndex = -1;
 
-	if (vkCreateComputePipelines(device->getDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &computePipeline) != VK_SUCCESS) {
+	if (vkCreateComputePipelines(device->getDevice(), device->getPipelineCacheHandle(), 1, &pipelineInfo, nullptr, &computePipeline) != VK_SUCCESS) {
 		throw std::runtime_error("failed to create compute pipeline!");
 	}
+	MK_TRACK_GPU_RESOURCE(computePipeline, 0, "compute.pipeline");
 
 	// Clean up shader module after pipeline creation
 	vkDestroyShaderModule(device->getDevice(), computeShaderModule, nullptr);
@@ -87,6 +89,8 @@ void ComputePipeline::createDescriptorPool(Device* device, uint32_t maxSets)
 
 	VkDescriptorPoolCreateInfo poolInfo{};
 	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	// Sets replaced on a resize are freed one by one once the frames using them are done
+	poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
 	poolInfo.poolSizeCount = 1;
 	poolInfo.pPoolSizes = &poolSize;
 	poolInfo.maxSets = maxSets;
@@ -94,6 +98,7 @@ void ComputePipeline::createDescriptorPool(Device* device, uint32_t maxSets)
 	if (vkCreateDescriptorPool(device->getDevice(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
 		throw std::runtime_error("failed to create compute descriptor pool!");
 	}
+	MK_TRACK_GPU_RESOURCE(descriptorPool, 0, "compute.descriptorPool");
 }
 
 void ComputePipeline::createDescriptorSets(Device* device, VkImageView outputImageView)
@@ -124,15 +129,10 @@ void ComputePipeline::createDescriptorSets(Device* device, VkImageView outputIma
 	vkUpdateDescriptorSets(device->getDevice(), 1, &descriptorWrite, 0, nullptr);
 }
 
-void ComputePipeline::resetDesciriptorPool(Device* device)
-{
-	vkResetDescriptorPool(device->getDevice(), descriptorPool, 0);
-}
-
 void ComputePipeline::cleanup(Device* device)
 {
 	if (computePipeline != VK_NULL_HANDLE) {
-		vkDestroyPipeline(device->getDevice(), computePipeline, nullptr);
+		GpuResourceRegistry::destroy(device->getDevice(), computePipeline, nullptr);
 		computePipeline = VK_NULL_HANDLE;
 	}
 	if (pipelineLayout != VK_NULL_HANDLE) {
@@ -140,7 +140,7 @@ void ComputePipeline::cleanup(Device* device)
 		pipelineLayout = VK_NULL_HANDLE;
 	}
 	if (descriptorPool != VK_NULL_HANDLE) {
-		vkDestroyDescriptorPool(device->getDevice(), descriptorPool, nullptr);
+		GpuResourceRegistry::destroy(device->getDevice(), descriptorPool, nullptr);
 		
 		descriptorPool = VK_NULL_HANDLE;
 	}
@@ -22,12 +22,12 @@ public:
 	void createDescriptorSetLayout(Device* device);
 	void createDescriptorPool(Device* device, uint32_t maxSets);
 	void createDescriptorSets(Device* device, VkImageView outputImageView);
-	void resetDesciriptorPool(Device* device);
 	void cleanup(Device* device);
 
 	VkPipeline getPipeline() const { return computePipeline; }
 	VkPipelineLayout getPipelineLayout() const { return pipelineLayout; }
 	VkDescriptorSet getDescriptorSet() const { return computeDescriptorSets; }
+	VkDescriptorPool getDescriptorPool() const { return descriptorPool; }
 
 private:
 	VkShaderModule createShaderModule(Device* device, const std::vector<char>& code);
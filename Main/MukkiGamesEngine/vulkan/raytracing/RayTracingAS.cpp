@@ -1,17 +1,20 @@
 #include "RayTracingAS.h"
 #include "../Core/VkDevice.h"
+#include "../utils/GpuResourceRegistry.h"
 #include "../CommandBufferManager.h"
 #include "../Resources/SceneObject.h"
+#include "../Resources/DeletionQueue.h"
 #include <stdexcept>
 #include <array>
 
 RayTracingAS::RayTracingAS() = default;
 RayTracingAS::~RayTracingAS() { cleanup(); }
 
-void RayTracingAS::init(Device* device, CommandBufferManager* commandBufferManager)
+void RayTracingAS::init(Device* device, CommandBufferManager* commandBufferManager, GpuResourcePool* resourcePool)
 {
     this->device = device;
     this->commandBufferManager = commandBufferManager;
+    this->resourcePool = resourcePool;
 
     vkCreateAccelerationStructureKHRFunc = reinterpret_cast<PFN_vkCreateAccelerationStructureKHR>(
         vkGetDeviceProcAddr(device->getDevice(), "vkCreateAccelerationStructureKHR"));
@@ -43,7 +46,7 @@ void RayTracingAS::cleanup()
 void RayTracingAS::buildBLAS(const Model& model)
 {
 	for (auto& blas : blases) {
-		destroyAccelerationStructure(blas);
+		retireAccelerationStructure(blas);
 	}
 	blases.clear();
 	buildBLASForModel(model);
@@ -57,11 +60,17 @@ void RayTracingAS::buildBLASWithoutClear(const Model& model)
 void RayTracingAS::clearBLAS()
 {
 	for (auto& blas : blases) {
-		destroyAccelerationStructure(blas);
+		retireAccelerationStructure(blas);
 	}
 	blases.clear();
 }
 
+void RayTracingAS::release()
+{
+	clearBLAS();
+	retireAccelerationStructure(tlas);
+}
+
 void RayTracingAS::buildTLAS(const Model& model)
 {
 	buildTLASFromModel(model);
@@ -105,6 +114,7 @@ void RayTracingAS::createAccelerationStructureBuffer(VkDeviceSize size, Accelera
     }
 
     vkBindBufferMemory(device->getDevice(), as.buffer, as.memory, 0);
+    MK_TRACK_GPU_RESOURCE(as.buffer, memoryRequirements.size, "accelerationStructure");
 }
 
 void RayTracingAS::destroyAccelerationStructure(AccelerationStructure& as)
@@ -114,7 +124,7 @@ void RayTracingAS::destroyAccelerationStructure(AccelerationStructure& as)
         as.handle = VK_NULL_HANDLE;
     }
     if (as.buffer != VK_NULL_HANDLE) {
-        vkDestroyBuffer(device->getDevice(), as.buffer, nullptr);
+        GpuResourceRegistry::destroy(device->getDevice(), as.buffer, nullptr);
         as.buffer = VK_NULL_HANDLE;
     }
     if (as.memory != VK_NULL_HANDLE) {
@@ -124,19 +134,45 @@ void RayTracingAS::destroyAccelerationStructure(AccelerationStructure& as)
     as.deviceAddress = 0;
 }
 
+void RayTracingAS::retireAccelerationStructure(AccelerationStructure& as)
+{
+    if (!retireQueue) {
+        destroyAccelerationStructure(as);
+        return;
+    }
+
+    VkDevice vkDev = device->getDevice();
+    PFN_vkDestroyAccelerationStructureKHR destroyFunc = vkDestroyAccelerationStructureKHRFunc;
+    VkAccelerationStructureKHR handle = as.handle;
+    if (handle != VK_NULL_HANDLE) {
+        retireQueue->retire([vkDev, destroyFunc, handle]() {
+            destroyFunc(vkDev, handle, nullptr);
+        });
+    }
+    retireQueue->retireBuffer(vkDev, as.buffer, as.memory);
+
+    as.handle = VK_NULL_HANDLE;
+    as.buffer = VK_NULL_HANDLE;
+    as.memory = VK_NULL_HANDLE;
+    as.deviceAddress = 0;
+}
+
 void RayTracingAS::buildBLASForModel(const Model& model)
 {
-    if (model.vertexBuffer == VK_NULL_HANDLE || model.indexBuffer == VK_NULL_HANDLE || model.meshes.empty()) {
+    VkBuffer vertexBuffer = resourcePool->getVkBuffer(model.vertexBuffer);
+    VkBuffer indexBuffer = resourcePool->getVkBuffer(model.indexBuffer);
+    VkBuffer rtVertexBuffer = resourcePool->getVkBuffer(model.rtVertexBuffer);
+    if (vertexBuffer == VK_NULL_HANDLE || indexBuffer == VK_NULL_HANDLE || model.meshes.empty()) {
         return;
     }
 
     size_t startIdx = blases.size();
     blases.resize(startIdx + model.meshes.size());
 
-    VkDeviceAddress vertexAddress = getBufferDeviceAddress(model.rtVertexBuffer != VK_NULL_HANDLE
-		? model.rtVertexBuffer
-		: model.vertexBuffer);
-    VkDeviceAddress indexAddress = getBufferDeviceAddress(model.indexBuffer);
+    VkDeviceAddress vertexAddress = getBufferDeviceAddress(rtVertexBuffer != VK_NULL_HANDLE
+		? rtVertexBuffer
+		: vertexBuffer);
+    VkDeviceAddress indexAddress = getBufferDeviceAddress(indexBuffer);
 
     for (size_t meshIndex = 0; meshIndex < model.meshes.size(); ++meshIndex) {
         const auto& mesh = model.meshes[meshIndex];
@@ -154,7 +190,7 @@ void RayTracingAS::buildBLASForModel(const Model& model)
             triangles.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR;
             triangles.vertexFormat = VK_FORMAT_R32G32B32_SFLOAT;
             triangles.vertexData.deviceAddress = vertexAddress;
-            triangles.vertexStride = model.rtVertexBuffer != VK_NULL_HANDLE
+            triangles.vertexStride = rtVertexBuffer != VK_NULL_HANDLE
 				? sizeof(RayTracingVertex)
 				: sizeof(Vertex);
             triangles.maxVertex = primitive.vertexCount > 0
@@ -238,7 +274,7 @@ void RayTracingAS::buildBLASForModel(const Model& model)
         vkCmdBuildAccelerationStructuresKHRFunc(commandBuffer, 1, &buildInfo, rangePtrs.data());
         commandBufferManager->endSingleTimeCommands(commandBuffer);
 
-        vkDestroyBuffer(device->getDevice(), scratchBuffer, nullptr);
+        GpuResourceRegistry::destroy(device->getDevice(), scratchBuffer, nullptr);
         vkFreeMemory(device->getDevice(), scratchMemory, nullptr);
 
         VkAccelerationStructureDeviceAddressInfoKHR addressInfo{};
@@ -254,7 +290,7 @@ void RayTracingAS::buildTLASFromModel(const Model& model)
         return;
     }
 
-    destroyAccelerationStructure(tlas);
+    retireAccelerationStructure(tlas);
 
     std::vector<VkAccelerationStructureInstanceKHR> instances;
     instances.reserve(model.nodes.size());
@@ -360,9 +396,9 @@ void RayTracingAS::buildTLASFromModel(const Model& model)
     vkCmdBuildAccelerationStructuresKHRFunc(commandBuffer, 1, &buildInfo, &rangePtr);
     commandBufferManager->endSingleTimeCommands(commandBuffer);
 
-    vkDestroyBuffer(device->getDevice(), instanceBuffer, nullptr);
+    GpuResourceRegistry::destroy(device->getDevice(), instanceBuffer, nullptr);
     vkFreeMemory(device->getDevice(), instanceMemory, nullptr);
-    vkDestroyBuffer(device->getDevice(), scratchBuffer, nullptr);
+    GpuResourceRegistry::destroy(device->getDevice(), scratchBuffer, nullptr);
     vkFreeMemory(device->getDevice(), scratchMemory, nullptr);
 
     VkAccelerationStructureDeviceAddressInfoKHR addressInfo{};
@@ -375,7 +411,7 @@ void RayTracingAS::buildTLASAll(const std::vector<LoadedObject>& loadedObjects,
 {
     if (blases.empty()) return;
 
-    destroyAccelerationStructure(tlas);
+    retireAccelerationStructure(tlas);
 
     std::vector<VkAccelerationStructureInstanceKHR> instances;
     uint32_t currentMeshIdx = 0;
@@ -480,9 +516,9 @@ void RayTracingAS::buildTLASAll(const std::vector<LoadedObject>& loadedObjects,
     vkCmdBuildAccelerationStructuresKHRFunc(commandBuffer, 1, &buildInfo, &rangePtr);
     commandBufferManager->endSingleTimeCommands(commandBuffer);
 
-    vkDestroyBuffer(device->getDevice(), instanceBuffer, nullptr);
+    GpuResourceRegistry::destroy(device->getDevice(), instanceBuffer, nullptr);
     vkFreeMemory(device->getDevice(), instanceMemory, nullptr);
-    vkDestroyBuffer(device->getDevice(), scratchBuffer, nullptr);
+    GpuResourceRegistry::destroy(device->getDevice(), scratchBuffer, nullptr);
     vkFreeMemory(device->getDevice(), scratchMemory, nullptr);
 
     VkAccelerationStructureDeviceAddressInfoKHR addressInfo{};
@@ -5,6 +5,8 @@
 
 class Device;
 class CommandBufferManager;
+class FrameDeletionQueue;
+class GpuResourcePool;
 struct LoadedObject;
 
 struct AccelerationStructure {
@@ -19,7 +21,7 @@ public:
     RayTracingAS();
     ~RayTracingAS();
 
-    void init(Device* device, CommandBufferManager* commandBufferManager);
+    void init(Device* device, CommandBufferManager* commandBufferManager, GpuResourcePool* resourcePool);
     void cleanup();
 
     void buildBLAS(const Model& model);
@@ -27,12 +29,18 @@ public:
     void buildTLAS(const Model& model);
     void buildTLASAll(const std::vector<LoadedObject>& loadedObjects, uint32_t globalMeshOffset);
     void clearBLAS();
+    // Drops every BLAS and the TLAS, through the retire queue when one is set
+    void release();
+    // When set, structures replaced at runtime are retired through the queue instead of destroyed immediately
+    void setRetireQueue(FrameDeletionQueue* queue) { retireQueue = queue; }
 
     const AccelerationStructure& getTLAS() const { return tlas; }
 
 private:
     Device* device = nullptr;
     CommandBufferManager* commandBufferManager = nullptr;
+    FrameDeletionQueue* retireQueue = nullptr;
+    GpuResourcePool* resourcePool = nullptr;
     PFN_vkCreateAccelerationStructureKHR vkCreateAccelerationStructureKHRFunc = nullptr;
     PFN_vkDestroyAccelerationStructureKHR vkDestroyAccelerationStructureKHRFunc = nullptr;
     PFN_vkGetAccelerationStructureBuildSizesKHR vkGetAccelerationStructureBuildSizesKHRFunc = nullptr;
@@ -45,6 +53,7 @@ private:
     VkDeviceAddress getBufferDeviceAddress(VkBuffer buffer) const;
     void createAccelerationStructureBuffer(VkDeviceSize size, AccelerationStructure& as);
     void destroyAccelerationStructure(AccelerationStructure& as);
+    void retireAccelerationStructure(AccelerationStructure& as);
     void buildBLASForModel(const Model& model);
     void buildTLASFromModel(const Model& model);
 };
@@ -1,5 +1,6 @@
 #include "RayTracingPipeline.h"
 #include "../Core/VkDevice.h"
+#include "../utils/GpuResourceRegistry.h"
 #include "../utils/utils.h"
 #include <stdexcept>
 #include <array>
@@ -20,7 +21,7 @@ void RayTracingPipeline::init(Device* device)
 void RayTracingPipeline::cleanup()
 {
     if (pipeline != VK_NULL_HANDLE) {
-        vkDestroyPipeline(device->getDevice(), pipeline, nullptr);
+        GpuResourceRegistry::destroy(device->getDevice(), pipeline, nullptr);
         pipeline = VK_NULL_HANDLE;
     }
     if (pipelineLayout != VK_NULL_HANDLE) {
@@ -28,7 +29,7 @@ void RayTracingPipeline::cleanup()
         pipelineLayout = VK_NULL_HANDLE;
     }
     if (sbt.buffer != VK_NULL_HANDLE) {
-        vkDestroyBuffer(device->getDevice(), sbt.buffer, nullptr);
+        GpuResourceRegistry::destroy(device->getDevice(), sbt.buffer, nullptr);
         sbt.buffer = VK_NULL_HANDLE;
     }
     if (sbt.memory != VK_NULL_HANDLE) {
@@ -141,9 +142,10 @@ void RayTracingPipeline::createPipeline(VkDescriptorSetLayout descriptorSetLayou
         throw std::runtime_error("failed to load vkCreateRayTracingPipelinesKHR");
     }
 
-    if (vkCreateRayTracingPipelinesKHRFunc(device->getDevice(), VK_NULL_HANDLE, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+    if (vkCreateRayTracingPipelinesKHRFunc(device->getDevice(), VK_NULL_HANDLE, device->getPipelineCacheHandle(), 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
         throw std::runtime_error("failed to create ray tracing pipeline!");
     }
+    MK_TRACK_GPU_RESOURCE(pipeline, 0, "rayTracing.pipeline");
 
     vkDestroyShaderModule(device->getDevice(), rgenModule, nullptr);
     vkDestroyShaderModule(device->getDevice(), rmissModule, nullptr);
@@ -1,5 +1,8 @@
 #include "uiManager.h"
+#include "../utils/GpuResourceRegistry.h"
 #include "uiThemes.h"
+#include <algorithm>
+#include <cfloat>
 #include <stdexcept>
 #include <glm/gtc/type_ptr.hpp>
 
@@ -52,6 +55,7 @@ void UIManager::createDescriptorPool(const UIRenderData& renderData)
 	if (vkCreateDescriptorPool(renderData.device, &poolInfo, nullptr, &imguiPool) != VK_SUCCESS) {
 		throw std::runtime_error("Failed to create ImGui descriptor pool!");
 	}
+	MK_TRACK_GPU_RESOURCE(imguiPool, 0, "imgui.descriptorPool");
 }
 
 void UIManager::init(const UIRenderData& renderData, EngineWindow* window)
@@ -77,7 +81,11 @@ void UIManager::init(const UIRenderData& renderData, EngineWindow* window)
 	// Or: ImGui::StyleColorsLight();
 	setUpMainTheme(ImGui::GetStyle());
 	// Setup Platform/Renderer backends
-	ImGui_ImplGlfw_InitForVulkan(window->getGLFWwindow(), true);
+	hasWindow = window != nullptr;
+	displayExtent = renderData.displayExtent;
+	if (hasWindow) {
+		ImGui_ImplGlfw_InitForVulkan(window->getGLFWwindow(), true);
+	}
 
 	ImGui_ImplVulkan_InitInfo initInfo{};
 	initInfo.Instance = renderData.instance;
@@ -138,7 +146,14 @@ void UIManager::newFrame()
 	if (!initialized) return;
 
 	ImGui_ImplVulkan_NewFrame();
-	ImGui_ImplGlfw_NewFrame();
+	if (hasWindow) {
+		ImGui_ImplGlfw_NewFrame();
+	}
+	else {
+		ImGuiIO& io = ImGui::GetIO();
+		io.DisplaySize = ImVec2(static_cast<float>(displayExtent.width), static_cast<float>(displayExtent.height));
+		io.DeltaTime = 1.0f / 60.0f;
+	}
 	ImGui::NewFrame();
 
 }
@@ -148,6 +163,9 @@ void UIManager::render(VkCommandBuffer commandBuffer)
 	if (!initialized) return;
 
 	ImGui::Render();
+	if (!hasWindow) {
+		return;
+	}
 	ImDrawData* drawData = ImGui::GetDrawData();
 	ImGui_ImplVulkan_RenderDrawData(drawData, commandBuffer);
 }
@@ -157,11 +175,13 @@ void UIManager::cleanup()
 	if (!initialized) return;
 
 	ImGui_ImplVulkan_Shutdown();
-	ImGui_ImplGlfw_Shutdown();
+	if (hasWindow) {
+		ImGui_ImplGlfw_Shutdown();
+	}
 	ImGui::DestroyContext();
 
 	if (imguiPool != VK_NULL_HANDLE) {
-		vkDestroyDescriptorPool(device, imguiPool, nullptr);
+		GpuResourceRegistry::destroy(device, imguiPool, nullptr);
 		imguiPool = VK_NULL_HANDLE;
 	}
 
@@ -695,3 +715,415 @@ void UIManager::renderRayTracingControls(bool& resetAccumulation)
 
 	ImGui::End();
 }
+
+void UIManager::renderMemoryStats(uint64_t renderTargetBytes, uint64_t renderTargetUnaliasedBytes,
+	size_t bufferCount, size_t textureCount, size_t peakResidentBytes)
+{
+	const float mb = 1.0f / (1024.0f * 1024.0f);
+	ImGui::Begin("Memory", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+	ImGui::Text("Render targets: %.1f MB resident", renderTargetBytes * mb);
+	ImGui::Text("Without aliasing: %.1f MB", renderTargetUnaliasedBytes * mb);
+	ImGui::Separator();
+	ImGui::Text("Model buffers: %zu", bufferCount);
+	ImGui::Text("Model textures: %zu", textureCount);
+	ImGui::Text("Peak RSS: %.1f MB", peakResidentBytes * mb);
+	ImGui::End();
+}
+
+void UIManager::renderGpuResources(GpuResourceRegistry& registry)
+{
+	const float mb = 1.0f / (1024.0f * 1024.0f);
+	const VkObjectType types[] = {
+		VK_OBJECT_TYPE_BUFFER, VK_OBJECT_TYPE_IMAGE, VK_OBJECT_TYPE_IMAGE_VIEW,
+		VK_OBJECT_TYPE_SAMPLER, VK_OBJECT_TYPE_PIPELINE, VK_OBJECT_TYPE_DESCRIPTOR_POOL,
+		VK_OBJECT_TYPE_DEVICE_MEMORY
+	};
+
+	ImGui::Begin("GPU Resources");
+
+	GpuResourceRegistry::Totals total = registry.getTotals();
+	ImGui::Text("Live objects: %zu (%.1f MB)", total.count, total.bytes * mb);
+	for (VkObjectType type : types) {
+		GpuResourceRegistry::Totals totals = registry.getTotals(type);
+		ImGui::BulletText("%s: %zu (%.1f MB)", GpuResourceRegistry::typeName(type), totals.count, totals.bytes * mb);
+	}
+
+	GpuResourceRegistry::Totals sinceBaseline = registry.getTotalsSinceBaseline();
+	ImGui::Separator();
+	ImGui::Text("Since baseline: %zu (%.1f MB)", sinceBaseline.count, sinceBaseline.bytes * mb);
+	if (ImGui::Button("Mark Baseline")) {
+		registry.markBaseline();
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Log to Console")) {
+		registry.logLiveObjects("live");
+	}
+	ImGui::Checkbox("Only since baseline", &gpuResourcesSinceBaselineOnly);
+
+	if (ImGui::BeginTable("gpuResources", 4,
+		ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_ScrollY | ImGuiTableFlags_Resizable,
+		ImVec2(0.0f, 300.0f))) {
+		ImGui::TableSetupScrollFreeze(0, 1);
+		ImGui::TableSetupColumn("Name");
+		ImGui::TableSetupColumn("Type");
+		ImGui::TableSetupColumn("KB");
+		ImGui::TableSetupColumn("Created at");
+		ImGui::TableHeadersRow();
+
+		uint64_t baseline = registry.getBaseline();
+		for (const auto& entry : registry.snapshot()) {
+			if (gpuResourcesSinceBaselineOnly && entry.serial < baseline) {
+				continue;
+			}
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(entry.name.c_str());
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(GpuResourceRegistry::typeName(entry.type));
+			ImGui::TableNextColumn();
+			ImGui::Text("%llu", static_cast<unsigned long long>(entry.size / 1024));
+			ImGui::TableNextColumn();
+			ImGui::Text("%s:%d", entry.file, entry.line);
+		}
+		ImGui::EndTable();
+	}
+
+	ImGui::End();
+}
+
+void UIManager::renderFramePacing(int& framesInFlight, int maxFramesInFlight, float cpuWaitMs, float gpuBusyMs)
+{
+	ImGui::Begin("Frame Pacing", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+	ImGui::SliderInt("Frames in flight", &framesInFlight, 1, maxFramesInFlight);
+	ImGui::Text("CPU wait: %.3f ms", cpuWaitMs);
+	ImGui::Text("GPU busy: %.3f ms", gpuBusyMs);
+	// A CPU that keeps waiting on the GPU is GPU bound; extra frames in flight only add latency
+	ImGui::TextDisabled(cpuWaitMs > 0.5f ? "GPU bound" : "CPU bound");
+	ImGui::End();
+}
+
+void UIManager::renderRenderGraphStats(uint32_t passCount, uint32_t culledPasses, uint32_t barrierCount,
+	uint32_t transientImages, uint32_t physicalImages)
+{
+	ImGui::Begin("Render Graph", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+	ImGui::Text("Passes: %u (%u culled)", passCount, culledPasses);
+	ImGui::Text("Barriers: %u", barrierCount);
+	ImGui::Text("Transient images: %u on %u physical", transientImages, physicalImages);
+	ImGui::End();
+}
+
+void UIManager::renderCullingStats(bool& enabled, bool& useBVH, uint32_t primitiveCount, uint32_t visibleCount,
+	uint32_t objectsCulled, uint32_t objectCount, float cullMs, uint32_t shadowCasters, uint32_t shadowCastersDrawn,
+	float bvhSyncMs)
+{
+	ImGui::Begin("Culling", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+	ImGui::Checkbox("Frustum culling", &enabled);
+	ImGui::Checkbox("Use scene BVH", &useBVH);
+	if (enabled) {
+		ImGui::Text("Primitives: %u visible, %u culled", visibleCount, primitiveCount - visibleCount);
+		ImGui::Text("Objects culled whole: %u of %u", objectsCulled, objectCount);
+		ImGui::Text("Cull time: %.3f ms (%s)", cullMs, useBVH ? "BVH" : "linear");
+	}
+	else {
+		ImGui::Text("Primitives: %u, all drawn", primitiveCount);
+	}
+	if (useBVH) {
+		ImGui::Text("Shadow casters: %u drawn of %u", shadowCastersDrawn, shadowCasters);
+	}
+	ImGui::Text("BVH update: %.3f ms", bvhSyncMs);
+	ImGui::End();
+}
+
+void UIManager::renderOcclusionStats(bool& enabled, uint32_t occluderCount, uint32_t occludersDrawn, uint32_t triangleCount,
+	uint32_t occludedPrimitives, uint32_t occludedObjects, float rasterMs, float testMs)
+{
+	ImGui::Begin("Occlusion", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+	ImGui::Checkbox("Occlusion culling", &enabled);
+	if (enabled) {
+		ImGui::Text("Occluders: %u in view of %u (%u triangles)", occludersDrawn, occluderCount, triangleCount);
+		ImGui::Text("Occluded: %u primitives, %u whole objects", occludedPrimitives, occludedObjects);
+		ImGui::Text("Rasterize: %.3f ms, test: %.3f ms", rasterMs, testMs);
+	}
+	ImGui::End();
+}
+
+void UIManager::renderDrawRecording(int& threadCount, int maxThreads, int& drawCopies, uint32_t drawCount, float recordMs,
+	bool sweepRunning, const std::vector<float>& sweepResults, bool& startSweep)
+{
+	ImGui::Begin("Draw Recording", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+	ImGui::SliderInt("Threads", &threadCount, 1, maxThreads);
+	ImGui::SliderInt("Synthetic copies", &drawCopies, 1, 1000);
+	ImGui::Text("Object draws: %u", drawCount);
+	ImGui::Text("Record time: %.3f ms", recordMs);
+
+	if (sweepRunning) {
+		ImGui::TextDisabled("Sweeping thread counts...");
+	}
+	else if (ImGui::Button("Measure 1..N threads")) {
+		startSweep = true;
+	}
+	for (size_t i = 0; i < sweepResults.size(); i++) {
+		float speedup = sweepResults[0] / (sweepResults[i] > 0.0f ? sweepResults[i] : 0.0001f);
+		ImGui::Text("%zu threads: %.3f ms (%.2fx)", i + 1, sweepResults[i], speedup);
+	}
+	ImGui::End();
+}
+
+void UIManager::renderDrawSorting(bool& enabled, uint32_t drawCount, float buildMs, uint32_t modelPipelines,
+	uint32_t modelDescriptorSets, uint32_t modelVertexBuffers, uint32_t sortedPipelines,
+	uint32_t sortedDescriptorSets, uint32_t sortedVertexBuffers)
+{
+	ImGui::Begin("Draw Sorting", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+	ImGui::Checkbox("Sort draws by pipeline + material", &enabled);
+	if (!enabled) {
+		ImGui::TextDisabled("Drawing object by object");
+		ImGui::End();
+		return;
+	}
+	ImGui::Text("Draws: %u", drawCount);
+	ImGui::Text("Build + sort: %.3f ms", buildMs);
+	if (ImGui::BeginTable("drawBinds", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders)) {
+		ImGui::TableSetupColumn("Binds");
+		ImGui::TableSetupColumn("Per model");
+		ImGui::TableSetupColumn("Sorted");
+		ImGui::TableHeadersRow();
+		const char* names[] = { "Pipeline", "Descriptor set", "Vertex buffer" };
+		uint32_t before[] = { modelPipelines, modelDescriptorSets, modelVertexBuffers };
+		uint32_t after[] = { sortedPipelines, sortedDescriptorSets, sortedVertexBuffers };
+		for (int i = 0; i < 3; i++) {
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(names[i]);
+			ImGui::TableNextColumn();
+			ImGui::Text("%u", before[i]);
+			ImGui::TableNextColumn();
+			ImGui::Text("%u", after[i]);
+		}
+		ImGui::EndTable();
+	}
+	ImGui::End();
+}
+
+void UIManager::renderGpuDriven(bool available, bool& enabled, bool& hizOcclusion, bool hizActive, uint32_t instanceCount,
+	uint32_t groupCount, float updateMs, bool sweepRunning, const std::vector<PerfSweeps::ScalingResult>& sweepResults,
+	bool& startSweep)
+{
+	ImGui::Begin("GPU Driven", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+	if (!available) {
+		ImGui::TextDisabled("Indirect count draws not supported");
+		ImGui::End();
+		return;
+	}
+	ImGui::Checkbox("GPU culling + indirect draws", &enabled);
+	ImGui::Checkbox("Hi-Z occlusion", &hizOcclusion);
+	ImGui::Text("Hi-Z: %s", hizActive ? "active" : "waiting for pyramid");
+	ImGui::Text("Instances: %u", instanceCount);
+	ImGui::Text("Indirect draws: %u", groupCount);
+	ImGui::Text("CPU update: %.3f ms", updateMs);
+
+	if (sweepRunning) {
+		ImGui::TextDisabled("Sweeping object counts...");
+	}
+	else if (ImGui::Button("Measure CPU vs GPU scaling")) {
+		startSweep = true;
+	}
+	for (const PerfSweeps::ScalingResult& result : sweepResults) {
+		if (result.groups == 0) continue;
+		ImGui::Text("%u objects: CPU %.3f ms, GPU %.3f ms", result.objects, result.cpuPathMs, result.gpuDrivenMs);
+		ImGui::Text("  transforms %.3f ms (%.2f us/object), %u draws %.3f ms (%.2f us/draw)", result.transformMs,
+			result.transformMs * 1000.0f / std::max(result.objects, 1u), result.groups, result.drawMs,
+			result.drawMs * 1000.0f / std::max(result.groups, 1u));
+	}
+	ImGui::End();
+}
+
+void UIManager::renderGpuProfiler(GpuProfiler& profiler)
+{
+	ImGui::Begin("GPU Profiler");
+
+	bool paused = profiler.isPaused();
+	if (ImGui::Checkbox("Pause", &paused)) {
+		profiler.setPaused(paused);
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Export CSV")) {
+		profiler.exportCsv("gpu_profile.csv");
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Export JSON")) {
+		profiler.exportJson("gpu_profile.json");
+	}
+
+	const auto& history = profiler.getHistory();
+	if (history.empty()) {
+		ImGui::TextDisabled("No GPU timings yet");
+		ImGui::End();
+		return;
+	}
+
+	const GpuProfiler::Frame& latest = history.back();
+	std::vector<float> totals;
+	totals.reserve(history.size());
+	for (const auto& frame : history) {
+		totals.push_back(frame.totalMs);
+	}
+	ImGui::Text("Frame %llu: %.3f ms", static_cast<unsigned long long>(latest.frameNumber), latest.totalMs);
+	ImGui::PlotLines("##gpuFrameTimes", totals.data(), static_cast<int>(totals.size()), 0, nullptr,
+		0.0f, FLT_MAX, ImVec2(ImGui::GetContentRegionAvail().x, 50.0f));
+
+	if (ImGui::BeginTable("gpuZones", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders)) {
+		ImGui::TableSetupColumn("Pass");
+		ImGui::TableSetupColumn("Last ms");
+		ImGui::TableSetupColumn("Avg ms");
+		ImGui::TableSetupColumn("Max ms");
+		ImGui::TableHeadersRow();
+		for (const auto& stats : profiler.computeStats()) {
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::Text("%*s%s", static_cast<int>(stats.depth * 2), "", stats.name.c_str());
+			ImGui::TableNextColumn();
+			ImGui::Text("%.3f", stats.lastMs);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.3f", stats.averageMs);
+			ImGui::TableSetColumnIndex(3);
+			ImGui::Text("%.3f", stats.maxMs);
+		}
+		ImGui::EndTable();
+	}
+
+	// Flame graph of the latest frame: graphics zones by nesting depth, async compute below
+	uint32_t graphicsRows = 0;
+	uint32_t computeRows = 0;
+	for (const auto& zone : latest.zones) {
+		uint32_t& rows = zone.asyncCompute ? computeRows : graphicsRows;
+		rows = std::max(rows, zone.depth + 1);
+	}
+
+	const float rowHeight = ImGui::GetTextLineHeight() + 4.0f;
+	ImVec2 origin = ImGui::GetCursorScreenPos();
+	float width = std::max(ImGui::GetContentRegionAvail().x, 100.0f);
+	float msToPixels = latest.totalMs > 0.0f ? width / latest.totalMs : 0.0f;
+	ImDrawList* drawList = ImGui::GetWindowDrawList();
+	for (const auto& zone : latest.zones) {
+		uint32_t row = zone.asyncCompute ? graphicsRows + zone.depth : zone.depth;
+		ImVec2 min(origin.x + zone.startMs * msToPixels, origin.y + row * rowHeight);
+		ImVec2 max(min.x + std::max(zone.durationMs * msToPixels, 1.0f), min.y + rowHeight - 1.0f);
+
+		size_t hash = std::hash<std::string>{}(zone.name);
+		ImU32 color = IM_COL32(80 + (hash & 0x7F), 80 + ((hash >> 8) & 0x7F), 80 + ((hash >> 16) & 0x7F), 255);
+		drawList->AddRectFilled(min, max, color);
+		if (ImGui::CalcTextSize(zone.name.c_str()).x < max.x - min.x - 4.0f) {
+			drawList->AddText(ImVec2(min.x + 2.0f, min.y + 2.0f), IM_COL32_WHITE, zone.name.c_str());
+		}
+		if (ImGui::IsMouseHoveringRect(min, max)) {
+			ImGui::SetTooltip("%s%s\n%.3f ms (starts at %.3f ms)", zone.name.c_str(),
+				zone.asyncCompute ? " (async compute)" : "", zone.durationMs, zone.startMs);
+		}
+	}
+	ImGui::Dummy(ImVec2(width, (graphicsRows + computeRows) * rowHeight));
+
+	ImGui::End();
+}
+
+void UIManager::renderCpuProfiler(CpuProfiler& profiler, const GpuProfiler& gpuProfiler)
+{
+	ImGui::Begin("CPU Profiler");
+
+	bool paused = profiler.isPaused();
+	if (ImGui::Checkbox("Pause", &paused)) {
+		profiler.setPaused(paused);
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Export Chrome trace")) {
+		profiler.exportChromeTrace("frame_trace.json", &gpuProfiler);
+	}
+	if (!gpuProfiler.isCalibrated()) {
+		ImGui::SameLine();
+		ImGui::TextDisabled("(no GPU clock calibration, CPU only)");
+	}
+
+	const auto& threads = profiler.getLastFrame();
+	uint64_t frameStart = profiler.getLastFrameStart();
+	float frameMs = (profiler.getLastFrameEnd() - frameStart) / 1000000.0f;
+	if (threads.empty() || frameMs <= 0.0f) {
+		ImGui::TextDisabled("No CPU zones yet");
+		ImGui::End();
+		return;
+	}
+	ImGui::Text("Frame %llu: %.3f ms", static_cast<unsigned long long>(profiler.getLastFrameNumber()), frameMs);
+
+	// One lane per thread, zones stacked by nesting depth inside it
+	const float rowHeight = ImGui::GetTextLineHeight() + 4.0f;
+	const float labelWidth = 120.0f;
+	ImVec2 origin = ImGui::GetCursorScreenPos();
+	float width = std::max(ImGui::GetContentRegionAvail().x - labelWidth, 100.0f);
+	float msToPixels = width / frameMs;
+	ImDrawList* drawList = ImGui::GetWindowDrawList();
+	float laneY = origin.y;
+	for (const auto& thread : threads) {
+		uint32_t rows = 1;
+		for (const auto& event : thread.events) {
+			rows = std::max(rows, event.depth + 1);
+		}
+		drawList->AddText(ImVec2(origin.x, laneY + 2.0f), IM_COL32_WHITE, thread.name.c_str());
+
+		for (const auto& event : thread.events) {
+			// Zones that began in the previous frame are clipped to the frame start
+			float startMs = event.startNs > frameStart ? (event.startNs - frameStart) / 1000000.0f : 0.0f;
+			float endMs = (event.endNs - frameStart) / 1000000.0f;
+			ImVec2 min(origin.x + labelWidth + startMs * msToPixels, laneY + event.depth * rowHeight);
+			ImVec2 max(min.x + std::max((endMs - startMs) * msToPixels, 1.0f), min.y + rowHeight - 1.0f);
+
+			size_t hash = std::hash<std::string>{}(event.name);
+			ImU32 color = IM_COL32(80 + (hash & 0x7F), 80 + ((hash >> 8) & 0x7F), 80 + ((hash >> 16) & 0x7F), 255);
+			drawList->AddRectFilled(min, max, color);
+			if (ImGui::CalcTextSize(event.name).x < max.x - min.x - 4.0f) {
+				drawList->AddText(ImVec2(min.x + 2.0f, min.y + 2.0f), IM_COL32_WHITE, event.name);
+			}
+			if (ImGui::IsMouseHoveringRect(min, max)) {
+				ImGui::SetTooltip("%s\n%.3f ms (starts at %.3f ms)", event.name,
+					(event.endNs - event.startNs) / 1000000.0f, startMs);
+			}
+		}
+		laneY += rows * rowHeight + 4.0f;
+	}
+	ImGui::Dummy(ImVec2(labelWidth + width, laneY - origin.y));
+
+	ImGui::End();
+}
+
+void UIManager::renderAsyncCompute(bool available, bool& enabled, float graphicsMs, float computeMs, float overlapMs)
+{
+	ImGui::Begin("Async Compute", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+	if (!available) {
+		ImGui::TextDisabled("No dedicated compute queue on this GPU");
+		ImGui::End();
+		return;
+	}
+	ImGui::Checkbox("Dispatch on compute queue", &enabled);
+	ImGui::Text("Graphics queue: %.3f ms", graphicsMs);
+	ImGui::Text("Compute queue: %.3f ms", computeMs);
+	// Share of the compute work hidden behind the next frame's graphics work
+	float hidden = computeMs > 0.0f ? std::min(overlapMs / computeMs, 1.0f) * 100.0f : 0.0f;
+	ImGui::Text("Overlap: %.3f ms (%.0f%%)", overlapMs, hidden);
+	ImGui::End();
+}
+
+void UIManager::renderPresentSettings(int& presentMode, const bool* supported, float& targetFps, bool& justInTimeInput,
+	float inputLatencyMs, float limiterWaitMs)
+{
+	static const char* modeNames[] = { "FIFO (vsync)", "Mailbox", "Immediate", "FIFO relaxed" };
+
+	ImGui::Begin("Present & Latency", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+	for (int i = 0; i < 4; i++) {
+		ImGui::BeginDisabled(!supported[i]);
+		ImGui::RadioButton(modeNames[i], &presentMode, i);
+		ImGui::EndDisabled();
+	}
+	ImGui::SliderFloat("FPS limit", &targetFps, 0.0f, 360.0f, targetFps > 0.0f ? "%.0f" : "off");
+	ImGui::Text("Limiter wait: %.3f ms", limiterWaitMs);
+	ImGui::Checkbox("Just-in-time input", &justInTimeInput);
+	// Input sample to GPU completion as seen by the CPU; scan-out comes on top of this
+	ImGui::Text("Input latency: %.2f ms", inputLatencyMs);
+	ImGui::End();
+}
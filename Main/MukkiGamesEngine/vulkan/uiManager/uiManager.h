@@ -9,6 +9,10 @@
 #include "../Core/VkDevice.h"
 #include "../Core/EngineWindow.h"
 #include "../objects/lights.h"
+#include "../utils/GpuResourceRegistry.h"
+#include "../utils/GpuProfiler.h"
+#include "../utils/CpuProfiler.h"
+#include "../Core/PerfSweeps.h"
 
 #include "../Physics/PhysicsDebugRenderer.h"
 struct UIRenderData {
@@ -22,6 +26,8 @@ struct UIRenderData {
 	VkDescriptorPool descriptorPool;
 	uint32_t imageCount;
 	uint32_t minImageCount;
+	// UI size when there is no window to take it from (headless)
+	VkExtent2D displayExtent;
 };
 struct ModelTransform {
 	glm::vec3 rotation = glm::vec3(1.0f);
@@ -36,6 +42,8 @@ public:
 	UIManager();
 	~UIManager();
 
+	// window may be null (headless): the UI is then still built every frame but never drawn,
+	// so offscreen captures do not depend on timings shown in the panels
 	void init(const UIRenderData& renderData, EngineWindow* window);
 	void newFrame();
 	void render(VkCommandBuffer commandBuffer);
@@ -59,6 +67,34 @@ public:
 	int getSelectedLight() const { return selectedLightIndex; }
 	void renderSceneLoader(bool& loadSceneFlag, const std::vector<std::string>& scenes, int sceneNum, const std::function<void(int)>& onLoad);
 	void renderRayTracingControls(bool& resetAccumulation);
+	void renderMemoryStats(uint64_t renderTargetBytes, uint64_t renderTargetUnaliasedBytes,
+		size_t bufferCount, size_t textureCount, size_t peakResidentBytes);
+	void renderGpuResources(GpuResourceRegistry& registry);
+	void renderGpuProfiler(GpuProfiler& profiler);
+	void renderCpuProfiler(CpuProfiler& profiler, const GpuProfiler& gpuProfiler);
+	void renderFramePacing(int& framesInFlight, int maxFramesInFlight, float cpuWaitMs, float gpuBusyMs);
+	void renderRenderGraphStats(uint32_t passCount, uint32_t culledPasses, uint32_t barrierCount,
+		uint32_t transientImages, uint32_t physicalImages);
+	// Counts are per copy of the scene; primitives of culled objects count as culled
+	void renderCullingStats(bool& enabled, bool& useBVH, uint32_t primitiveCount, uint32_t visibleCount,
+		uint32_t objectsCulled, uint32_t objectCount, float cullMs, uint32_t shadowCasters, uint32_t shadowCastersDrawn,
+		float bvhSyncMs);
+	void renderOcclusionStats(bool& enabled, uint32_t occluderCount, uint32_t occludersDrawn, uint32_t triangleCount,
+		uint32_t occludedPrimitives, uint32_t occludedObjects, float rasterMs, float testMs);
+	void renderDrawRecording(int& threadCount, int maxThreads, int& drawCopies, uint32_t drawCount, float recordMs,
+		bool sweepRunning, const std::vector<float>& sweepResults, bool& startSweep);
+	// Binds per frame: as the per-model path would issue them, and as the sorted draw list did
+	void renderDrawSorting(bool& enabled, uint32_t drawCount, float buildMs, uint32_t modelPipelines,
+		uint32_t modelDescriptorSets, uint32_t modelVertexBuffers, uint32_t sortedPipelines,
+		uint32_t sortedDescriptorSets, uint32_t sortedVertexBuffers);
+	// sweepResults has one entry per object count; the last may still miss its GPU-driven half
+	void renderGpuDriven(bool available, bool& enabled, bool& hizOcclusion, bool hizActive, uint32_t instanceCount,
+		uint32_t groupCount, float updateMs, bool sweepRunning, const std::vector<PerfSweeps::ScalingResult>& sweepResults,
+		bool& startSweep);
+	void renderAsyncCompute(bool available, bool& enabled, float graphicsMs, float computeMs, float overlapMs);
+	// presentMode indexes FIFO, MAILBOX, IMMEDIATE, FIFO_RELAXED; supported has one entry per mode
+	void renderPresentSettings(int& presentMode, const bool* supported, float& targetFps, bool& justInTimeInput,
+		float inputLatencyMs, float limiterWaitMs);
 	void renderPhysicsDebug(int bodyCount, const std::vector<std::string>& objectNames,
 		const std::vector<glm::vec3>& bodyPositions, const std::vector<float>& speeds,
 		const std::vector<float>& rpms, const std::vector<int>& gears);
@@ -68,8 +104,11 @@ private:
 	VkDevice device = VK_NULL_HANDLE;
 	VkDescriptorPool imguiPool = VK_NULL_HANDLE;
 	bool initialized = false;
+	bool hasWindow = false;
+	VkExtent2D displayExtent{};
 	int selectedLightIndex = -1;
 	int selectedSceneIndex = 0;
+	bool gpuResourcesSinceBaselineOnly = false;
 	ImGuizmo::OPERATION currentGizmoOperation = ImGuizmo::TRANSLATE;
 	ImGuizmo::MODE currentGizmoMode = ImGuizmo::WORLD;
 	void createDescriptorPool(const UIRenderData& renderData);
@@ -0,0 +1,148 @@
+#include "CpuProfiler.h"
+#include "GpuProfiler.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+CpuProfiler& CpuProfiler::get()
+{
+	static CpuProfiler profiler;
+	return profiler;
+}
+
+uint64_t CpuProfiler::now()
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+CpuProfiler::ThreadBuffer& CpuProfiler::threadBuffer()
+{
+	thread_local ThreadBuffer* buffer = get().registerThread();
+	return *buffer;
+}
+
+CpuProfiler::ThreadBuffer* CpuProfiler::registerThread()
+{
+	// Buffers outlive their threads so the export still sees finished workers
+	auto buffer = std::make_unique<ThreadBuffer>();
+	buffer->events = std::make_unique<CpuZoneEvent[]>(EVENTS_PER_THREAD);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	buffer->index = static_cast<uint32_t>(threads.size());
+	buffer->name = "Thread " + std::to_string(buffer->index);
+	threads.push_back(std::move(buffer));
+	return threads.back().get();
+}
+
+void CpuProfiler::setThreadName(const char* name)
+{
+	ThreadBuffer& buffer = threadBuffer();
+	std::lock_guard<std::mutex> lock(mutex);
+	buffer.name = name;
+}
+
+void CpuProfiler::markFrame(uint64_t frameNumber)
+{
+	uint64_t time = now();
+	if (frameStart != 0 && !paused) {
+		lastFrame = collect(frameStart, time);
+		lastFrameStart = frameStart;
+		lastFrameEnd = time;
+		lastFrameNumber = this->frameNumber;
+	}
+	frameStart = time;
+	this->frameNumber = frameNumber;
+}
+
+std::vector<CpuProfiler::ThreadEvents> CpuProfiler::collect(uint64_t fromNs, uint64_t toNs) const
+{
+	std::vector<ThreadEvents> result;
+	std::lock_guard<std::mutex> lock(mutex);
+	for (const auto& thread : threads) {
+		ThreadEvents entry;
+		entry.threadIndex = thread->index;
+		entry.name = thread->name;
+
+		// Zones are pushed when they end, so walking back from the newest one can stop at the
+		// first zone that ended before the range
+		uint64_t written = thread->written.load(std::memory_order_acquire);
+		uint64_t oldest = written > EVENTS_PER_THREAD ? written - EVENTS_PER_THREAD : 0;
+		for (uint64_t i = written; i-- > oldest;) {
+			CpuZoneEvent event = thread->events[i % EVENTS_PER_THREAD];
+			if (event.endNs < fromNs) {
+				break;
+			}
+			if (event.endNs < toNs) {
+				entry.events.push_back(event);
+			}
+		}
+
+		// Entries the owner wrapped around onto while they were copied are torn
+		uint64_t after = thread->written.load(std::memory_order_acquire);
+		if (after > EVENTS_PER_THREAD) {
+			uint64_t overwritten = after - EVENTS_PER_THREAD;
+			uint64_t kept = written > overwritten ? written - overwritten : 0;
+			entry.events.resize(std::min<uint64_t>(entry.events.size(), kept));
+		}
+
+		std::reverse(entry.events.begin(), entry.events.end());
+		if (!entry.events.empty()) {
+			result.push_back(std::move(entry));
+		}
+	}
+	return result;
+}
+
+bool CpuProfiler::exportChromeTrace(const std::string& path, const GpuProfiler* gpu) const
+{
+	std::ofstream file(path);
+	if (!file) {
+		std::cout << "CPU profiler: failed to open " << path << std::endl;
+		return false;
+	}
+
+	std::vector<ThreadEvents> threadEvents = collect(0, UINT64_MAX);
+	nlohmann::json events = nlohmann::json::array();
+	const int cpuProcess = 1;
+	const int gpuProcess = 2;
+
+	events.push_back({ { "ph", "M" }, { "pid", cpuProcess }, { "name", "process_name" }, { "args", { { "name", "CPU" } } } });
+	size_t zoneCount = 0;
+	for (const auto& thread : threadEvents) {
+		events.push_back({ { "ph", "M" }, { "pid", cpuProcess }, { "tid", thread.threadIndex },
+			{ "name", "thread_name" }, { "args", { { "name", thread.name } } } });
+		for (const auto& event : thread.events) {
+			events.push_back({
+				{ "ph", "X" }, { "pid", cpuProcess }, { "tid", thread.threadIndex }, { "name", event.name },
+				{ "ts", event.startNs / 1000.0 }, { "dur", (event.endNs - event.startNs) / 1000.0 }
+			});
+			zoneCount++;
+		}
+	}
+
+	// GPU passes on the CPU timeline, one track per queue
+	if (gpu && gpu->isCalibrated()) {
+		events.push_back({ { "ph", "M" }, { "pid", gpuProcess }, { "name", "process_name" }, { "args", { { "name", "GPU" } } } });
+		events.push_back({ { "ph", "M" }, { "pid", gpuProcess }, { "tid", 0 }, { "name", "thread_name" },
+			{ "args", { { "name", "Graphics queue" } } } });
+		events.push_back({ { "ph", "M" }, { "pid", gpuProcess }, { "tid", 1 }, { "name", "thread_name" },
+			{ "args", { { "name", "Async compute queue" } } } });
+		for (const auto& frame : gpu->getHistory()) {
+			for (const auto& zone : frame.zones) {
+				double startNs = frame.cpuStartNs + zone.startMs * 1000000.0;
+				events.push_back({
+					{ "ph", "X" }, { "pid", gpuProcess }, { "tid", zone.asyncCompute ? 1 : 0 }, { "name", zone.name },
+					{ "ts", startNs / 1000.0 }, { "dur", zone.durationMs * 1000.0 },
+					{ "args", { { "frame", frame.frameNumber } } }
+				});
+			}
+		}
+	}
+
+	file << nlohmann::json{ { "traceEvents", events }, { "displayTimeUnit", "ms" } }.dump();
+	std::cout << "CPU profiler: wrote " << zoneCount << " zones to " << path << std::endl;
+	return true;
+}
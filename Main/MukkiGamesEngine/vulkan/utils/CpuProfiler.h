@@ -0,0 +1,124 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class GpuProfiler;
+
+struct CpuZoneEvent {
+	// String literal; zones never copy their names
+	const char* name = "";
+	uint64_t startNs = 0;
+	uint64_t endNs = 0;
+	uint32_t depth = 0;
+};
+
+// Scoped CPU zones (MK_ZONE) recorded into one ring buffer per thread. A zone costs two clock
+// reads and a store into the calling thread's own buffer, with no lock and no allocation, so
+// it stays enabled in release builds. Readers copy a range out of a ring and drop whatever
+// the owning thread overwrote in the meantime.
+//
+// Defining MUKKI_DISABLE_CPU_PROFILER compiles MK_ZONE to nothing.
+class CpuProfiler {
+public:
+	static constexpr uint64_t EVENTS_PER_THREAD = 16384;
+
+	struct ThreadBuffer {
+		uint32_t index = 0;
+		// Written under the profiler mutex
+		std::string name;
+		uint32_t depth = 0;
+		std::atomic<uint64_t> written{ 0 };
+		std::unique_ptr<CpuZoneEvent[]> events;
+
+		void push(const CpuZoneEvent& event)
+		{
+			uint64_t index = written.load(std::memory_order_relaxed);
+			events[index % EVENTS_PER_THREAD] = event;
+			written.store(index + 1, std::memory_order_release);
+		}
+	};
+
+	struct ThreadEvents {
+		uint32_t threadIndex = 0;
+		std::string name;
+		std::vector<CpuZoneEvent> events;
+	};
+
+	static CpuProfiler& get();
+	// Monotonic nanoseconds; the timebase of every zone
+	static uint64_t now();
+	// The calling thread's buffer, registered on first use
+	static ThreadBuffer& threadBuffer();
+
+	// Names the calling thread in the timeline and in the trace
+	void setThreadName(const char* name);
+
+	// Called by the main loop at the start of every frame; captures the zones of the frame that
+	// just ended for the timeline view unless paused
+	void markFrame(uint64_t frameNumber);
+	void setPaused(bool paused) { this->paused = paused; }
+	bool isPaused() const { return paused; }
+
+	const std::vector<ThreadEvents>& getLastFrame() const { return lastFrame; }
+	uint64_t getLastFrameStart() const { return lastFrameStart; }
+	uint64_t getLastFrameEnd() const { return lastFrameEnd; }
+	uint64_t getLastFrameNumber() const { return lastFrameNumber; }
+
+	// Every zone still held in the rings, plus the GPU passes when gpu is calibrated, as a
+	// Chrome trace (chrome://tracing, Perfetto)
+	bool exportChromeTrace(const std::string& path, const GpuProfiler* gpu) const;
+
+private:
+	CpuProfiler() = default;
+	ThreadBuffer* registerThread();
+	// Zones that ended in [fromNs, toNs), read backwards from each ring's newest entry
+	std::vector<ThreadEvents> collect(uint64_t fromNs, uint64_t toNs) const;
+
+	mutable std::mutex mutex;
+	std::vector<std::unique_ptr<ThreadBuffer>> threads;
+
+	bool paused = false;
+	uint64_t frameStart = 0;
+	uint64_t frameNumber = 0;
+	std::vector<ThreadEvents> lastFrame;
+	uint64_t lastFrameStart = 0;
+	uint64_t lastFrameEnd = 0;
+	uint64_t lastFrameNumber = 0;
+};
+
+class CpuZone {
+public:
+	explicit CpuZone(const char* name)
+		: buffer(CpuProfiler::threadBuffer())
+	{
+		event.name = name;
+		event.depth = buffer.depth++;
+		event.startNs = CpuProfiler::now();
+	}
+
+	~CpuZone()
+	{
+		event.endNs = CpuProfiler::now();
+		buffer.depth--;
+		buffer.push(event);
+	}
+
+	CpuZone(const CpuZone&) = delete;
+	CpuZone& operator=(const CpuZone&) = delete;
+
+private:
+	CpuProfiler::ThreadBuffer& buffer;
+	CpuZoneEvent event;
+};
+
+#define MK_ZONE_CONCAT_INNER(a, b) a##b
+#define MK_ZONE_CONCAT(a, b) MK_ZONE_CONCAT_INNER(a, b)
+#ifdef MUKKI_DISABLE_CPU_PROFILER
+#define MK_ZONE(name) ((void)0)
+#else
+#define MK_ZONE(name) CpuZone MK_ZONE_CONCAT(mkZone, __LINE__)(name)
+#endif
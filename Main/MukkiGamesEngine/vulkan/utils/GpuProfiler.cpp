@@ -0,0 +1,297 @@
+#include "GpuProfiler.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+void GpuProfiler::init(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t graphicsFamily, uint32_t computeFamily,
+	uint32_t frameSlots)
+{
+	this->device = device;
+	slots.assign(frameSlots, Slot{});
+
+	uint32_t familyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> families(familyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+
+	VkPhysicalDeviceProperties properties{};
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+	uint32_t validBits = graphicsFamily < familyCount ? families[graphicsFamily].timestampValidBits : 0;
+	if (validBits == 0 || properties.limits.timestampPeriod <= 0.0f) {
+		std::cout << "GPU profiler: graphics queue has no timestamp support, profiler disabled" << std::endl;
+		return;
+	}
+	timestampPeriod = properties.limits.timestampPeriod;
+	timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+	computeTimestamps = computeFamily < familyCount && families[computeFamily].timestampValidBits > 0;
+
+	VkQueryPoolCreateInfo queryInfo{};
+	queryInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	queryInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	// Plus one query for the clock calibration
+	queryInfo.queryCount = frameSlots * MAX_ZONES * 2 + 1;
+	if (vkCreateQueryPool(device, &queryInfo, nullptr, &queryPool) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create GPU profiler query pool!");
+	}
+}
+
+void GpuProfiler::cleanup()
+{
+	if (queryPool != VK_NULL_HANDLE) {
+		vkDestroyQueryPool(device, queryPool, nullptr);
+		queryPool = VK_NULL_HANDLE;
+	}
+	slots.clear();
+	history.clear();
+	calibrated = false;
+	device = VK_NULL_HANDLE;
+}
+
+void GpuProfiler::beginFrame(uint32_t slot, uint64_t frameNumber)
+{
+	if (queryPool == VK_NULL_HANDLE) {
+		return;
+	}
+	currentSlot = slot;
+	openZones = 0;
+
+	Slot& current = slots[slot];
+	if (current.recorded) {
+		collect(current, slot);
+	}
+	current.frameNumber = frameNumber;
+	current.recorded = false;
+	current.zones.clear();
+}
+
+void GpuProfiler::resetQueries(VkCommandBuffer commandBuffer)
+{
+	if (queryPool == VK_NULL_HANDLE) {
+		return;
+	}
+	vkCmdResetQueryPool(commandBuffer, queryPool, currentSlot * MAX_ZONES * 2, MAX_ZONES * 2);
+	slots[currentSlot].recorded = true;
+}
+
+uint32_t GpuProfiler::beginZone(VkCommandBuffer commandBuffer, const char* name, bool asyncCompute)
+{
+	uint32_t zone = reserveZone(name, asyncCompute);
+	writeBegin(commandBuffer, zone);
+	return zone;
+}
+
+void GpuProfiler::endZone(VkCommandBuffer commandBuffer, uint32_t zone)
+{
+	writeEnd(commandBuffer, zone);
+	closeZone(zone);
+}
+
+uint32_t GpuProfiler::reserveZone(const char* name, bool asyncCompute)
+{
+	if (queryPool == VK_NULL_HANDLE || (asyncCompute && !computeTimestamps)) {
+		return INVALID_ZONE;
+	}
+	Slot& slot = slots[currentSlot];
+	if (slot.zones.size() >= MAX_ZONES) {
+		return INVALID_ZONE;
+	}
+
+	Zone zone;
+	zone.name = name;
+	zone.depth = openZones++;
+	zone.asyncCompute = asyncCompute;
+	slot.zones.push_back(std::move(zone));
+	return static_cast<uint32_t>(slot.zones.size() - 1);
+}
+
+void GpuProfiler::closeZone(uint32_t zone)
+{
+	if (zone != INVALID_ZONE && openZones > 0) {
+		openZones--;
+	}
+}
+
+bool GpuProfiler::canWrite(uint32_t zone) const
+{
+	return queryPool != VK_NULL_HANDLE && zone != INVALID_ZONE;
+}
+
+void GpuProfiler::writeBegin(VkCommandBuffer commandBuffer, uint32_t zone) const
+{
+	if (!canWrite(zone)) {
+		return;
+	}
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool,
+		(currentSlot * MAX_ZONES + zone) * 2);
+}
+
+void GpuProfiler::writeEnd(VkCommandBuffer commandBuffer, uint32_t zone) const
+{
+	if (!canWrite(zone)) {
+		return;
+	}
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool,
+		(currentSlot * MAX_ZONES + zone) * 2 + 1);
+}
+
+void GpuProfiler::writeCalibration(VkCommandBuffer commandBuffer) const
+{
+	if (queryPool == VK_NULL_HANDLE) {
+		return;
+	}
+	uint32_t query = static_cast<uint32_t>(slots.size()) * MAX_ZONES * 2;
+	vkCmdResetQueryPool(commandBuffer, queryPool, query, 1);
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, query);
+}
+
+void GpuProfiler::finishCalibration(uint64_t cpuBeforeNs, uint64_t cpuAfterNs)
+{
+	if (queryPool == VK_NULL_HANDLE) {
+		return;
+	}
+	uint64_t timestamp = 0;
+	uint32_t query = static_cast<uint32_t>(slots.size()) * MAX_ZONES * 2;
+	if (vkGetQueryPoolResults(device, queryPool, query, 1, sizeof(timestamp), &timestamp, sizeof(uint64_t),
+		VK_QUERY_RESULT_64_BIT) != VK_SUCCESS) {
+		return;
+	}
+	double cpuMidpointNs = (static_cast<double>(cpuBeforeNs) + static_cast<double>(cpuAfterNs)) * 0.5;
+	gpuToCpuOffsetNs = cpuMidpointNs - static_cast<double>(timestamp & timestampMask) * timestampPeriod;
+	calibrated = true;
+}
+
+void GpuProfiler::collect(Slot& slot, uint32_t slotIndex)
+{
+	if (slot.zones.empty() || paused) {
+		return;
+	}
+
+	// Value and availability per query; the frame completed, so nothing here waits
+	uint32_t queryCount = static_cast<uint32_t>(slot.zones.size()) * 2;
+	std::vector<uint64_t> results(queryCount * 2);
+	VkResult result = vkGetQueryPoolResults(device, queryPool, slotIndex * MAX_ZONES * 2, queryCount,
+		results.size() * sizeof(uint64_t), results.data(), 2 * sizeof(uint64_t),
+		VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+	if (result != VK_SUCCESS && result != VK_NOT_READY) {
+		return;
+	}
+
+	uint64_t frameStart = UINT64_MAX;
+	uint64_t frameEnd = 0;
+	for (uint32_t i = 0; i < queryCount; i += 2) {
+		if (results[i * 2 + 1] && results[(i + 1) * 2 + 1]) {
+			frameStart = std::min(frameStart, results[i * 2] & timestampMask);
+			frameEnd = std::max(frameEnd, results[(i + 1) * 2] & timestampMask);
+		}
+	}
+	if (frameStart == UINT64_MAX) {
+		return;
+	}
+
+	const double toMs = timestampPeriod / 1000000.0;
+	Frame frame;
+	frame.frameNumber = slot.frameNumber;
+	frame.totalMs = static_cast<float>((frameEnd - frameStart) * toMs);
+	if (calibrated) {
+		frame.cpuStartNs = static_cast<double>(frameStart) * timestampPeriod + gpuToCpuOffsetNs;
+	}
+	for (size_t z = 0; z < slot.zones.size(); z++) {
+		uint64_t begin = results[z * 4];
+		uint64_t end = results[z * 4 + 2];
+		if (!results[z * 4 + 1] || !results[z * 4 + 3]) {
+			// Zone was reserved but its commands were never recorded (culled, empty list)
+			continue;
+		}
+		Zone zone = slot.zones[z];
+		begin &= timestampMask;
+		end &= timestampMask;
+		zone.startMs = static_cast<float>((begin - frameStart) * toMs);
+		zone.durationMs = end > begin ? static_cast<float>((end - begin) * toMs) : 0.0f;
+		frame.zones.push_back(std::move(zone));
+	}
+
+	history.push_back(std::move(frame));
+	if (history.size() > HISTORY_FRAMES) {
+		history.pop_front();
+	}
+}
+
+std::vector<GpuProfiler::ZoneStats> GpuProfiler::computeStats() const
+{
+	std::vector<ZoneStats> stats;
+	if (history.empty()) {
+		return stats;
+	}
+
+	for (const auto& zone : history.back().zones) {
+		ZoneStats entry;
+		entry.name = zone.name;
+		entry.depth = zone.depth;
+		entry.lastMs = zone.durationMs;
+
+		uint32_t samples = 0;
+		for (const auto& frame : history) {
+			for (const auto& other : frame.zones) {
+				if (other.name == zone.name && other.depth == zone.depth) {
+					entry.averageMs += other.durationMs;
+					entry.maxMs = std::max(entry.maxMs, other.durationMs);
+					samples++;
+				}
+			}
+		}
+		entry.averageMs /= std::max(samples, 1u);
+		stats.push_back(std::move(entry));
+	}
+	return stats;
+}
+
+bool GpuProfiler::exportCsv(const std::string& path) const
+{
+	std::ofstream file(path);
+	if (!file) {
+		std::cout << "GPU profiler: failed to open " << path << std::endl;
+		return false;
+	}
+
+	file << "frame,zone,depth,queue,start_ms,duration_ms\n";
+	for (const auto& frame : history) {
+		for (const auto& zone : frame.zones) {
+			file << frame.frameNumber << ',' << zone.name << ',' << zone.depth << ','
+				<< (zone.asyncCompute ? "compute" : "graphics") << ','
+				<< zone.startMs << ',' << zone.durationMs << '\n';
+		}
+	}
+	std::cout << "GPU profiler: wrote " << history.size() << " frames to " << path << std::endl;
+	return true;
+}
+
+bool GpuProfiler::exportJson(const std::string& path) const
+{
+	std::ofstream file(path);
+	if (!file) {
+		std::cout << "GPU profiler: failed to open " << path << std::endl;
+		return false;
+	}
+
+	nlohmann::json frames = nlohmann::json::array();
+	for (const auto& frame : history) {
+		nlohmann::json zones = nlohmann::json::array();
+		for (const auto& zone : frame.zones) {
+			zones.push_back({
+				{ "name", zone.name },
+				{ "depth", zone.depth },
+				{ "queue", zone.asyncCompute ? "compute" : "graphics" },
+				{ "startMs", zone.startMs },
+				{ "durationMs", zone.durationMs }
+			});
+		}
+		frames.push_back({ { "frame", frame.frameNumber }, { "totalMs", frame.totalMs }, { "zones", zones } });
+	}
+
+	file << nlohmann::json{ { "timestampPeriodNs", timestampPeriod }, { "frames", frames } }.dump(2);
+	std::cout << "GPU profiler: wrote " << history.size() << " frames to " << path << std::endl;
+	return true;
+}
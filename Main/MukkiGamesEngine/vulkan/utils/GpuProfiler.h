@@ -0,0 +1,111 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+// Per-pass GPU timings from timestamp queries. Every frame slot owns a range of one query
+// pool; its results are read when the frame pacer hands the slot out again, at which point the
+// GPU has finished with it, so the readback never stalls. Zones opened while another zone is
+// open nest under it, which is what the flame graph draws.
+//
+// Zones are reserved on the recording thread that owns the frame; the timestamps themselves
+// can be written from any thread into any command buffer of that frame (secondaries included).
+class GpuProfiler {
+public:
+	static constexpr uint32_t MAX_ZONES = 64;
+	static constexpr uint32_t INVALID_ZONE = UINT32_MAX;
+	// Completed frames kept for the rolling averages and the export
+	static constexpr size_t HISTORY_FRAMES = 240;
+
+	struct Zone {
+		std::string name;
+		uint32_t depth = 0;
+		bool asyncCompute = false;
+		// Relative to the earliest timestamp of the frame
+		float startMs = 0.0f;
+		float durationMs = 0.0f;
+	};
+
+	struct Frame {
+		uint64_t frameNumber = 0;
+		float totalMs = 0.0f;
+		// Earliest timestamp of the frame on the CpuProfiler::now() clock; 0 until calibrated
+		double cpuStartNs = 0.0;
+		std::vector<Zone> zones;
+	};
+
+	struct ZoneStats {
+		std::string name;
+		uint32_t depth = 0;
+		float lastMs = 0.0f;
+		float averageMs = 0.0f;
+		float maxMs = 0.0f;
+	};
+
+	// computeFamily is the async compute family, VK_QUEUE_FAMILY_IGNORED without one
+	void init(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t graphicsFamily, uint32_t computeFamily,
+		uint32_t frameSlots);
+	void cleanup();
+
+	void setPaused(bool paused) { this->paused = paused; }
+	bool isPaused() const { return paused; }
+
+	// After the frame pacer freed the slot: collects the slot's previous frame
+	void beginFrame(uint32_t slot, uint64_t frameNumber);
+	// First command of the frame's graphics command buffer, outside any render pass
+	void resetQueries(VkCommandBuffer commandBuffer);
+
+	// Reserve and write in one go, for zones recorded on the current thread
+	uint32_t beginZone(VkCommandBuffer commandBuffer, const char* name, bool asyncCompute = false);
+	void endZone(VkCommandBuffer commandBuffer, uint32_t zone);
+
+	// For zones written from worker threads: reserve on the frame's thread, then write the
+	// begin/end timestamps into the worker's command buffers. closeZone ends the nesting
+	// scope once the zone's recording is done; zones close in reverse reservation order.
+	uint32_t reserveZone(const char* name, bool asyncCompute = false);
+	void closeZone(uint32_t zone);
+	void writeBegin(VkCommandBuffer commandBuffer, uint32_t zone) const;
+	void writeEnd(VkCommandBuffer commandBuffer, uint32_t zone) const;
+
+	// Maps device timestamps onto the CPU clock for the merged trace: write the calibration
+	// timestamp into a graphics command buffer, submit and wait for it between cpuBeforeNs
+	// and cpuAfterNs, then finish. The midpoint is taken as the GPU time, so the mapping is
+	// off by up to half the submit round trip.
+	void writeCalibration(VkCommandBuffer commandBuffer) const;
+	void finishCalibration(uint64_t cpuBeforeNs, uint64_t cpuAfterNs);
+	bool isCalibrated() const { return calibrated; }
+
+	const std::deque<Frame>& getHistory() const { return history; }
+	// One entry per zone name of the latest frame, averaged over the history
+	std::vector<ZoneStats> computeStats() const;
+
+	bool exportCsv(const std::string& path) const;
+	bool exportJson(const std::string& path) const;
+
+private:
+	struct Slot {
+		uint64_t frameNumber = 0;
+		bool recorded = false;
+		std::vector<Zone> zones;
+	};
+
+	bool canWrite(uint32_t zone) const;
+	void collect(Slot& slot, uint32_t slotIndex);
+
+	VkDevice device = VK_NULL_HANDLE;
+	VkQueryPool queryPool = VK_NULL_HANDLE;
+	float timestampPeriod = 0.0f;
+	uint64_t timestampMask = ~0ull;
+	bool computeTimestamps = false;
+	bool paused = false;
+	bool calibrated = false;
+	// CPU nanoseconds at device timestamp 0
+	double gpuToCpuOffsetNs = 0.0;
+
+	std::vector<Slot> slots;
+	uint32_t currentSlot = 0;
+	uint32_t openZones = 0;
+	std::deque<Frame> history;
+};
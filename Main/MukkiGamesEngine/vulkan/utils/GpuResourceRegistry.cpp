@@ -0,0 +1,247 @@
+#include "GpuResourceRegistry.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+const char* baseName(const char* path)
+{
+	const char* name = path;
+	for (const char* c = path; *c; c++) {
+		if (*c == '/' || *c == '\\') {
+			name = c + 1;
+		}
+	}
+	return name;
+}
+
+}
+
+GpuResourceRegistry& GpuResourceRegistry::get()
+{
+	static GpuResourceRegistry registry;
+	return registry;
+}
+
+void GpuResourceRegistry::init(VkInstance instance, VkDevice device, bool debugUtilsEnabled)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	this->device = device;
+	setObjectName = nullptr;
+	if (debugUtilsEnabled) {
+		setObjectName = reinterpret_cast<PFN_vkSetDebugUtilsObjectNameEXT>(
+			vkGetInstanceProcAddr(instance, "vkSetDebugUtilsObjectNameEXT"));
+	}
+}
+
+size_t GpuResourceRegistry::reportLeaks()
+{
+	logLiveObjects("still alive at device destruction");
+
+	std::lock_guard<std::mutex> lock(mutex);
+	size_t leaked = live.size();
+	live.clear();
+	device = VK_NULL_HANDLE;
+	setObjectName = nullptr;
+	return leaked;
+}
+
+void GpuResourceRegistry::logLiveObjects(const char* header) const
+{
+	std::vector<Entry> entries = snapshot();
+	if (entries.empty()) {
+		std::cout << "GPU resource registry: no objects " << header << std::endl;
+		return;
+	}
+
+	VkDeviceSize bytes = 0;
+	for (const auto& entry : entries) {
+		bytes += entry.size;
+	}
+	std::cout << "GPU resource registry: " << entries.size() << " objects ("
+		<< bytes / 1024 << " KB) " << header << ":" << std::endl;
+	for (const auto& entry : entries) {
+		std::cout << "  " << typeName(entry.type) << " '" << entry.name << "' "
+			<< entry.size / 1024 << " KB, created at " << baseName(entry.file) << ":" << entry.line
+			<< std::endl;
+	}
+}
+
+void GpuResourceRegistry::trackObject(VkObjectType type, uint64_t handle, VkDeviceSize size, const char* name, const char* file, int line)
+{
+	if (handle == 0) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = live.find({ type, handle });
+	if (it != live.end()) {
+		it->second.references++;
+		return;
+	}
+
+	Entry entry;
+	entry.type = type;
+	entry.handle = handle;
+	entry.size = size;
+	entry.file = file;
+	entry.line = line;
+	entry.serial = nextSerial++;
+	if (name && name[0] != '\0') {
+		entry.name = name;
+	}
+	else {
+		entry.name = std::string(baseName(file)) + ":" + std::to_string(line);
+	}
+
+	if (setObjectName) {
+		VkDebugUtilsObjectNameInfoEXT nameInfo{};
+		nameInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT;
+		nameInfo.objectType = type;
+		nameInfo.objectHandle = handle;
+		nameInfo.pObjectName = entry.name.c_str();
+		setObjectName(device, &nameInfo);
+	}
+
+	live.emplace(std::make_pair(type, handle), std::move(entry));
+}
+
+void GpuResourceRegistry::untrackObject(VkObjectType type, uint64_t handle)
+{
+	if (handle == 0) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = live.find({ type, handle });
+	if (it == live.end()) {
+		return;
+	}
+	if (--it->second.references == 0) {
+		live.erase(it);
+	}
+}
+
+void GpuResourceRegistry::destroy(VkDevice device, VkBuffer buffer, const VkAllocationCallbacks* allocator)
+{
+	get().untrack(buffer);
+	vkDestroyBuffer(device, buffer, allocator);
+}
+
+void GpuResourceRegistry::destroy(VkDevice device, VkImage image, const VkAllocationCallbacks* allocator)
+{
+	get().untrack(image);
+	vkDestroyImage(device, image, allocator);
+}
+
+void GpuResourceRegistry::destroy(VkDevice device, VkImageView view, const VkAllocationCallbacks* allocator)
+{
+	get().untrack(view);
+	vkDestroyImageView(device, view, allocator);
+}
+
+void GpuResourceRegistry::destroy(VkDevice device, VkSampler sampler, const VkAllocationCallbacks* allocator)
+{
+	get().untrack(sampler);
+	vkDestroySampler(device, sampler, allocator);
+}
+
+void GpuResourceRegistry::destroy(VkDevice device, VkPipeline pipeline, const VkAllocationCallbacks* allocator)
+{
+	get().untrack(pipeline);
+	vkDestroyPipeline(device, pipeline, allocator);
+}
+
+void GpuResourceRegistry::destroy(VkDevice device, VkDescriptorPool pool, const VkAllocationCallbacks* allocator)
+{
+	get().untrack(pool);
+	vkDestroyDescriptorPool(device, pool, allocator);
+}
+
+void GpuResourceRegistry::freeMemory(VkDevice device, VkDeviceMemory memory, const VkAllocationCallbacks* allocator)
+{
+	get().untrack(memory);
+	vkFreeMemory(device, memory, allocator);
+}
+
+std::vector<GpuResourceRegistry::Entry> GpuResourceRegistry::snapshot() const
+{
+	std::vector<Entry> entries;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		entries.reserve(live.size());
+		for (const auto& pair : live) {
+			entries.push_back(pair.second);
+		}
+	}
+	std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+		if (a.size != b.size) {
+			return a.size > b.size;
+		}
+		return a.serial < b.serial;
+	});
+	return entries;
+}
+
+GpuResourceRegistry::Totals GpuResourceRegistry::getTotals() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	Totals totals;
+	for (const auto& pair : live) {
+		totals.count++;
+		totals.bytes += pair.second.size;
+	}
+	return totals;
+}
+
+GpuResourceRegistry::Totals GpuResourceRegistry::getTotals(VkObjectType type) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	Totals totals;
+	for (const auto& pair : live) {
+		if (pair.first.first == type) {
+			totals.count++;
+			totals.bytes += pair.second.size;
+		}
+	}
+	return totals;
+}
+
+void GpuResourceRegistry::markBaseline()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	baseline = nextSerial;
+}
+
+GpuResourceRegistry::Totals GpuResourceRegistry::getTotalsSinceBaseline() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	Totals totals;
+	for (const auto& pair : live) {
+		if (pair.second.serial >= baseline) {
+			totals.count++;
+			totals.bytes += pair.second.size;
+		}
+	}
+	return totals;
+}
+
+uint64_t GpuResourceRegistry::getBaseline() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return baseline;
+}
+
+const char* GpuResourceRegistry::typeName(VkObjectType type)
+{
+	switch (type) {
+	case VK_OBJECT_TYPE_BUFFER: return "Buffer";
+	case VK_OBJECT_TYPE_IMAGE: return "Image";
+	case VK_OBJECT_TYPE_IMAGE_VIEW: return "ImageView";
+	case VK_OBJECT_TYPE_SAMPLER: return "Sampler";
+	case VK_OBJECT_TYPE_PIPELINE: return "Pipeline";
+	case VK_OBJECT_TYPE_DESCRIPTOR_POOL: return "DescriptorPool";
+	case VK_OBJECT_TYPE_DEVICE_MEMORY: return "DeviceMemory";
+	default: return "Unknown";
+	}
+}
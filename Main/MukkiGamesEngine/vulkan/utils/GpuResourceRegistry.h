@@ -0,0 +1,112 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Process-wide list of live buffers, images, views, samplers, pipelines and descriptor pools.
+// Creation sites register objects with their source location, size and a debug name (also
+// given to the driver through VK_EXT_debug_utils when the instance enables it); destruction
+// goes through GpuResourceRegistry::destroy so nothing can be freed without being forgotten.
+// Whatever is still registered when the device is destroyed is reported as a leak.
+class GpuResourceRegistry {
+public:
+	struct Entry {
+		VkObjectType type = VK_OBJECT_TYPE_UNKNOWN;
+		uint64_t handle = 0;
+		// Bytes of device memory bound to the object (0 for views, samplers, pipelines, pools)
+		VkDeviceSize size = 0;
+		std::string name;
+		const char* file = "";
+		int line = 0;
+		// Creation order, compared against the baseline to find objects that outlived a reload
+		uint64_t serial = 0;
+		// Drivers may hand out the same non-dispatchable handle for identical objects (samplers)
+		uint32_t references = 1;
+	};
+
+	struct Totals {
+		size_t count = 0;
+		VkDeviceSize bytes = 0;
+	};
+
+	static GpuResourceRegistry& get();
+
+	// Names objects through VK_EXT_debug_utils from now on when debugUtilsEnabled is set
+	void init(VkInstance instance, VkDevice device, bool debugUtilsEnabled);
+	// Logs every object still registered and forgets them; called right before vkDestroyDevice
+	size_t reportLeaks();
+	// Logs the live list without changing it
+	void logLiveObjects(const char* header) const;
+
+	template<typename Handle>
+	void track(Handle handle, VkDeviceSize size, const char* name, const char* file, int line)
+	{
+		trackObject(objectTypeOf(handle), toKey(handle), size, name, file, line);
+	}
+
+	template<typename Handle>
+	void untrack(Handle handle)
+	{
+		untrackObject(objectTypeOf(handle), toKey(handle));
+	}
+
+	// Untrack and destroy; drop-in replacements for the matching vkDestroy* calls
+	static void destroy(VkDevice device, VkBuffer buffer, const VkAllocationCallbacks* allocator);
+	static void destroy(VkDevice device, VkImage image, const VkAllocationCallbacks* allocator);
+	static void destroy(VkDevice device, VkImageView view, const VkAllocationCallbacks* allocator);
+	static void destroy(VkDevice device, VkSampler sampler, const VkAllocationCallbacks* allocator);
+	static void destroy(VkDevice device, VkPipeline pipeline, const VkAllocationCallbacks* allocator);
+	static void destroy(VkDevice device, VkDescriptorPool pool, const VkAllocationCallbacks* allocator);
+	// For allocations shared by several objects, tracked on their own (the objects then report 0)
+	static void freeMemory(VkDevice device, VkDeviceMemory memory, const VkAllocationCallbacks* allocator);
+
+	// Copy of the live list, largest first
+	std::vector<Entry> snapshot() const;
+	Totals getTotals() const;
+	Totals getTotals(VkObjectType type) const;
+
+	// Objects created after the baseline show up as "new"; mark it before a scene reload and
+	// anything new that survives the next reload is growth
+	void markBaseline();
+	Totals getTotalsSinceBaseline() const;
+	uint64_t getBaseline() const;
+
+	static const char* typeName(VkObjectType type);
+
+private:
+	GpuResourceRegistry() = default;
+
+	static VkObjectType objectTypeOf(VkBuffer) { return VK_OBJECT_TYPE_BUFFER; }
+	static VkObjectType objectTypeOf(VkImage) { return VK_OBJECT_TYPE_IMAGE; }
+	static VkObjectType objectTypeOf(VkImageView) { return VK_OBJECT_TYPE_IMAGE_VIEW; }
+	static VkObjectType objectTypeOf(VkSampler) { return VK_OBJECT_TYPE_SAMPLER; }
+	static VkObjectType objectTypeOf(VkPipeline) { return VK_OBJECT_TYPE_PIPELINE; }
+	static VkObjectType objectTypeOf(VkDescriptorPool) { return VK_OBJECT_TYPE_DESCRIPTOR_POOL; }
+	static VkObjectType objectTypeOf(VkDeviceMemory) { return VK_OBJECT_TYPE_DEVICE_MEMORY; }
+
+	template<typename Handle>
+	static uint64_t toKey(Handle handle) { return (uint64_t)handle; }
+
+	void trackObject(VkObjectType type, uint64_t handle, VkDeviceSize size, const char* name, const char* file, int line);
+	void untrackObject(VkObjectType type, uint64_t handle);
+
+	mutable std::mutex mutex;
+	std::map<std::pair<VkObjectType, uint64_t>, Entry> live;
+	uint64_t nextSerial = 1;
+	uint64_t baseline = 0;
+	VkDevice device = VK_NULL_HANDLE;
+	PFN_vkSetDebugUtilsObjectNameEXT setObjectName = nullptr;
+};
+
+// Registers a freshly created object with the current source location
+#define MK_TRACK_GPU_RESOURCE(handle, size, name) \
+	GpuResourceRegistry::get().track((handle), (size), (name), __FILE__, __LINE__)
+
+// Default arguments for creation helpers so entries carry the helper's caller rather than the
+// helper itself (std::source_location would need C++20)
+#define MK_CALLER_FILE __builtin_FILE()
+#define MK_CALLER_LINE __builtin_LINE()
@@ -0,0 +1,90 @@
+#include "ImageCompare.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+struct PpmImage {
+	uint32_t width = 0;
+	uint32_t height = 0;
+	std::vector<uint8_t> pixels;
+};
+
+// Binary PPM with a maxval of 255, as written by the readback; comments are not supported
+bool loadPpm(const std::string& path, PpmImage& image)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		std::cout << "Golden compare: failed to open " << path << std::endl;
+		return false;
+	}
+
+	std::string magic;
+	uint32_t maxValue = 0;
+	file >> magic >> image.width >> image.height >> maxValue;
+	if (!file || magic != "P6" || maxValue != 255) {
+		std::cout << "Golden compare: " << path << " is not an 8-bit binary PPM" << std::endl;
+		return false;
+	}
+	// Exactly one whitespace character separates the header from the pixels
+	file.get();
+
+	image.pixels.resize(static_cast<size_t>(image.width) * image.height * 3);
+	file.read(reinterpret_cast<char*>(image.pixels.data()), static_cast<std::streamsize>(image.pixels.size()));
+	if (!file) {
+		std::cout << "Golden compare: " << path << " is truncated" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+}
+
+bool compareToGolden(const std::string& imagePath, const std::string& goldenPath, int tolerance, float maxMismatchPercent)
+{
+	PpmImage image;
+	PpmImage golden;
+	if (!loadPpm(imagePath, image) || !loadPpm(goldenPath, golden)) {
+		return false;
+	}
+	if (image.width != golden.width || image.height != golden.height) {
+		std::cout << "Golden compare: " << imagePath << " is " << image.width << "x" << image.height << ", "
+			<< goldenPath << " is " << golden.width << "x" << golden.height << std::endl;
+		return false;
+	}
+
+	uint64_t mismatched = 0;
+	int maxDifference = 0;
+	uint32_t firstX = 0;
+	uint32_t firstY = 0;
+	size_t pixelCount = static_cast<size_t>(image.width) * image.height;
+	for (size_t i = 0; i < pixelCount; i++) {
+		int pixelDifference = 0;
+		for (size_t c = 0; c < 3; c++) {
+			pixelDifference = std::max(pixelDifference, std::abs(image.pixels[i * 3 + c] - golden.pixels[i * 3 + c]));
+		}
+		maxDifference = std::max(maxDifference, pixelDifference);
+		if (pixelDifference > tolerance) {
+			if (mismatched == 0) {
+				firstX = static_cast<uint32_t>(i % image.width);
+				firstY = static_cast<uint32_t>(i / image.width);
+			}
+			mismatched++;
+		}
+	}
+
+	float mismatchPercent = pixelCount > 0 ? 100.0f * static_cast<float>(mismatched) / static_cast<float>(pixelCount) : 0.0f;
+	bool matches = mismatchPercent <= maxMismatchPercent;
+	std::cout << "Golden compare: " << (matches ? "match" : "MISMATCH") << " against " << goldenPath << ", "
+		<< mismatched << " of " << pixelCount << " pixels (" << mismatchPercent << "%) differ by more than "
+		<< tolerance << ", largest difference " << maxDifference;
+	if (mismatched > 0) {
+		std::cout << ", first at " << firstX << "," << firstY;
+	}
+	std::cout << std::endl;
+	return matches;
+}
@@ -0,0 +1,7 @@
+#pragma once
+#include <string>
+
+// Compares a headless readback (binary PPM) against a golden image of the same size. A pixel
+// mismatches when any channel differs by more than tolerance; the images match when at most
+// maxMismatchPercent of the pixels do. Prints the result; false on a mismatch or unreadable file.
+bool compareToGolden(const std::string& imagePath, const std::string& goldenPath, int tolerance, float maxMismatchPercent);
@@ -0,0 +1,89 @@
+#include "MemoryStats.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#ifdef MUKKI_TRACK_ALLOCATIONS
+static std::atomic<uint64_t> g_allocationCount{ 0 };
+static std::atomic<uint64_t> g_allocatedBytes{ 0 };
+
+static void* trackedAlloc(size_t size)
+{
+	g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+	g_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+	void* ptr = std::malloc(size ? size : 1);
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void* operator new(size_t size) { return trackedAlloc(size); }
+void* operator new[](size_t size) { return trackedAlloc(size); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+#endif
+
+namespace MemoryStats
+{
+
+bool isAllocationTrackingEnabled()
+{
+#ifdef MUKKI_TRACK_ALLOCATIONS
+	return true;
+#else
+	return false;
+#endif
+}
+
+uint64_t getAllocationCount()
+{
+#ifdef MUKKI_TRACK_ALLOCATIONS
+	return g_allocationCount.load(std::memory_order_relaxed);
+#else
+	return 0;
+#endif
+}
+
+uint64_t getAllocatedBytes()
+{
+#ifdef MUKKI_TRACK_ALLOCATIONS
+	return g_allocatedBytes.load(std::memory_order_relaxed);
+#else
+	return 0;
+#endif
+}
+
+size_t getPeakResidentBytes()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters{};
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		return static_cast<size_t>(counters.PeakWorkingSetSize);
+	}
+	return 0;
+#else
+	struct rusage usage{};
+	if (getrusage(RUSAGE_SELF, &usage) != 0) {
+		return 0;
+	}
+#ifdef __APPLE__
+	return static_cast<size_t>(usage.ru_maxrss);
+#else
+	// Linux reports kilobytes
+	return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+} // namespace MemoryStats
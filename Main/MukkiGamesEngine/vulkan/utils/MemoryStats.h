@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Process-level memory counters used to compare load-time behaviour between builds.
+// Heap allocation counting replaces the global operator new and is only compiled in
+// when MUKKI_TRACK_ALLOCATIONS is defined (CMake option of the same name).
+namespace MemoryStats
+{
+	bool isAllocationTrackingEnabled();
+
+	// Heap allocations made by the whole process since startup (0 when tracking is off)
+	uint64_t getAllocationCount();
+	uint64_t getAllocatedBytes();
+
+	// Peak resident set size of the process, 0 if the platform query fails
+	size_t getPeakResidentBytes();
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Bounded single-producer single-consumer queue. push() is only called from one thread and
+// pop() from one other thread; neither blocks or allocates. Capacity must be a power of two.
+template<typename T, size_t Capacity>
+class SpscQueue {
+	static_assert((Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+	// Returns false when the queue is full; the item is dropped
+	bool push(const T& item)
+	{
+		size_t tail = writeIndex.load(std::memory_order_relaxed);
+		if (tail - readIndex.load(std::memory_order_acquire) == Capacity) {
+			return false;
+		}
+		items[tail & (Capacity - 1)] = item;
+		writeIndex.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool pop(T& item)
+	{
+		size_t head = readIndex.load(std::memory_order_relaxed);
+		if (head == writeIndex.load(std::memory_order_acquire)) {
+			return false;
+		}
+		item = items[head & (Capacity - 1)];
+		readIndex.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	std::array<T, Capacity> items{};
+	// Producer and consumer indices live on separate cache lines
+	alignas(64) std::atomic<size_t> writeIndex{ 0 };
+	alignas(64) std::atomic<size_t> readIndex{ 0 };
+};